@@ -0,0 +1,114 @@
+/*
+ *  forkstorm -- process table scaling benchmark
+ *
+ *  Measures how fast processes can be created, signalled and reaped while
+ *  the process table is crowded:
+ *
+ *	forkstorm duration [ children ]
+ *
+ *  The benchmark first starts the given number of children (default 100),
+ *  which just sleep until they are killed. While they are alive it keeps
+ *  forking a child, sending it a signal and waiting for it, with a wait
+ *  for that particular pid so that the other children are in the way. The
+ *  number of such rounds is counted. Run with different numbers of
+ *  children, the result shows whether fork, kill and waitpid get slower as
+ *  the number of processes grows.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "timeit.c"
+
+int children, duration;
+pid_t *pids, victim;
+unsigned long iter;
+
+void reap(void)
+{
+	int i;
+
+	for (i = 0; i < children; i++)
+		kill(pids[i], SIGKILL);
+	if (victim > 0)
+		kill(victim, SIGKILL);
+	while (wait(NULL) > 0)
+		;
+}
+
+void report(int sig)
+{
+	reap();
+
+	/* Starting the sleepers is not part of the test. */
+	fprintf(stderr,"COUNT|%lu|1|lps\n", iter);
+	fprintf(stderr,"TIME|%d.0\n", duration);
+	exit(0);
+}
+
+pid_t sleeper(void)
+{
+	pid_t pid;
+
+	if ((pid = fork()) < 0) {
+		perror("fork");
+		return -1;
+	}
+	if (pid == 0) {
+		for (;;)
+			pause();
+	}
+
+	return pid;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, status;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ children ]\n", argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	children = argc > 2 ? atoi(argv[2]) : 100;
+
+	if (children < 0) {
+		fprintf(stderr,"%s: children must not be negative\n", argv[0]);
+		exit(1);
+	}
+
+	if ((pids = calloc(children + 1, sizeof(pid_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+
+	for (i = 0; i < children; i++) {
+		if ((pids[i] = sleeper()) < 0) {
+			children = i;
+			break;
+		}
+	}
+
+	iter = 0;
+	wake_me(duration, report);
+
+	for (;;) {
+		if ((victim = sleeper()) < 0) {
+			reap();
+			exit(1);
+		}
+		kill(victim, SIGKILL);
+		while (waitpid(victim, &status, 0) < 0) {
+			if (errno != EINTR) {
+				perror("waitpid");
+				exit(1);
+			}
+		}
+		iter++;
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ *  fsfrag -- multi-writer file system fragmentation benchmark
+ *
+ *  A number of files are grown at the same time, by appending one buffer
+ *  to each of them in turn, as concurrent writers (log files, downloads,
+ *  parallel builds) would. The files are then read back one after another,
+ *  over and over, until the time is up. If the file system interleaves the
+ *  zones of the files, the sequential read-back turns into many short,
+ *  seeking transfers; if it keeps each file contiguous, read-back runs at
+ *  close to the disk's streaming rate.
+ *
+ *  The total amount of data should exceed the file system's block cache, so
+ *  that the read-back actually goes to the disk.
+ *
+ *  Usage: fsfrag duration [ files [ kbytes_per_file [ bufsize [ dir ] ] ] ]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "timeit.c"
+
+#define MAX_FILES	64
+#define MAX_BUFSIZE	65536
+
+char buf[MAX_BUFSIZE];
+char name[MAX_FILES][1024];
+int nfiles, duration;
+unsigned long kbytes_read;
+
+void cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < nfiles; i++)
+		unlink(name[i]);
+}
+
+void report(int sig)
+{
+	cleanup();
+
+	/* Writing the files is not part of the test. */
+	fprintf(stderr,"COUNT|%lu|1|KBps\n", kbytes_read);
+	fprintf(stderr,"TIME|%d.0\n", duration);
+	exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+	char *dir = ".";
+	int fd[MAX_FILES];
+	int kbytes = 4096, bufsize = 4096;
+	long left, bytes;
+	ssize_t r;
+	int i;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ files [ kbytes_per_file "
+			"[ bufsize [ dir ] ] ] ]\n", argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	nfiles = argc > 2 ? atoi(argv[2]) : 4;
+	if (argc > 3) kbytes = atoi(argv[3]);
+	if (argc > 4) bufsize = atoi(argv[4]);
+	if (argc > 5) dir = argv[5];
+
+	if (nfiles < 1 || nfiles > MAX_FILES || kbytes < 1 ||
+	    bufsize < 512 || bufsize > MAX_BUFSIZE) {
+		fprintf(stderr,"%s: files must be 1 to %d, bufsize 512 to %d\n",
+			argv[0], MAX_FILES, MAX_BUFSIZE);
+		exit(1);
+	}
+
+	memset(buf, 'f', bufsize);
+
+	for (i = 0; i < nfiles; i++) {
+		snprintf(name[i], sizeof(name[i]), "%s/fsfrag.%d.%d", dir,
+			(int) getpid(), i);
+		if ((fd[i] = open(name[i], O_RDWR | O_CREAT | O_TRUNC,
+		    0600)) < 0) {
+			fprintf(stderr,"open %s failed, error %d\n", name[i],
+				errno);
+			nfiles = i;
+			cleanup();
+			exit(1);
+		}
+	}
+
+	/* Grow all files in lock step. */
+	for (left = (long) kbytes * 1024; left > 0; left -= bufsize) {
+		for (i = 0; i < nfiles; i++) {
+			if (write(fd[i], buf, bufsize) != bufsize) {
+				fprintf(stderr,"write failed, error %d\n",
+					errno);
+				cleanup();
+				exit(1);
+			}
+		}
+	}
+	sync();
+
+	/* Read the files back, one at a time. */
+	kbytes_read = 0;
+	wake_me(duration, report);
+
+	for (;;) {
+		for (i = 0; i < nfiles; i++) {
+			lseek(fd[i], 0, SEEK_SET);
+			for (bytes = 0; (r = read(fd[i], buf, bufsize)) > 0; ) {
+				if ((bytes += r) >= 1024) {
+					kbytes_read += bytes / 1024;
+					bytes %= 1024;
+				}
+			}
+			if (r < 0) {
+				fprintf(stderr,"read failed, error %d\n",
+					errno);
+				cleanup();
+				exit(1);
+			}
+		}
+	}
+}
@@ -0,0 +1,177 @@
+/*
+ *  netpps -- UDP packets-per-second benchmark
+ *
+ *  Measures how many small UDP datagrams per second the network stack can
+ *  receive. To exercise the NIC driver and its receive path, run it as a
+ *  receiver and flood it from a peer on the other side of the link, such as
+ *  the host end of a tap device, or another instance run as a sender:
+ *
+ *	netpps duration recv [ size ]		(receiver)
+ *	netpps duration send address [ size ]	(sender)
+ *	netpps duration [ local [ size ] ]	(both, over loopback)
+ *
+ *  In the default "local" mode a sender to 127.0.0.1 is forked, which
+ *  measures the stack without a driver in the path. The receiver starts
+ *  timing at the first datagram and counts the datagrams received; the
+ *  sender counts the datagrams sent. Datagrams are 'size' bytes long
+ *  (default 18, the least that fills a minimum ethernet frame).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "timeit.c"
+
+#define PORT		5001
+#define MAX_SIZE	1472	/* largest datagram in one ethernet frame */
+
+char buf[MAX_SIZE];
+unsigned long iter;
+pid_t child;
+
+void report(int sig)
+{
+	if (child > 0) {
+		kill(child, SIGKILL);
+		waitpid(child, NULL, 0);
+	}
+
+	fprintf(stderr,"COUNT|%lu|1|pps\n", iter);
+	exit(0);
+}
+
+int udp_socket(int port)
+{
+	struct sockaddr_in sin;
+	int fd;
+
+	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+		fprintf(stderr,"socket failed, error %d\n", errno);
+		exit(1);
+	}
+
+	if (port != 0) {
+		memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_ANY);
+		sin.sin_port = htons(port);
+		if (bind(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+			fprintf(stderr,"bind failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+
+	return fd;
+}
+
+void sender(const char *addr, int duration, int size)
+{
+	struct sockaddr_in sin;
+	int fd;
+
+	fd = udp_socket(0);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = inet_addr(addr);
+	sin.sin_port = htons(PORT);
+
+	/* A local sender runs until the receiver kills it. */
+	iter = 0;
+	if (duration > 0)
+		wake_me(duration, report);
+
+	for (;;) {
+		if (sendto(fd, buf, size, 0, (struct sockaddr *) &sin,
+		    sizeof(sin)) == size)
+			iter++;
+		else if (errno != EINTR && errno != ENOBUFS) {
+			fprintf(stderr,"sendto failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+}
+
+void receiver(int fd, int duration)
+{
+	/* Wait for the first datagram before starting the clock. */
+	if (recv(fd, buf, sizeof(buf), 0) < 0) {
+		fprintf(stderr,"recv failed, error %d\n", errno);
+		exit(1);
+	}
+
+	iter = 0;
+	wake_me(duration, report);
+
+	for (;;) {
+		if (recv(fd, buf, sizeof(buf), 0) >= 0)
+			iter++;
+		else if (errno != EINTR) {
+			fprintf(stderr,"recv failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	char *mode, *addr = NULL;
+	int duration, size, fd, n;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ local | recv | "
+			"send address ] [ size ]\n", argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	mode = argc > 2 ? argv[2] : "local";
+	n = 3;
+	if (!strcmp(mode, "send")) {
+		if (argc < 4) {
+			fprintf(stderr,"%s: send needs an address\n", argv[0]);
+			exit(1);
+		}
+		addr = argv[n++];
+	} else if (strcmp(mode, "local") && strcmp(mode, "recv")) {
+		fprintf(stderr,"%s: unknown mode %s\n", argv[0], mode);
+		exit(1);
+	}
+	size = argc > n ? atoi(argv[n]) : 18;
+
+	if (size < 1 || size > MAX_SIZE) {
+		fprintf(stderr,"%s: size must be 1 to %d\n", argv[0], MAX_SIZE);
+		exit(1);
+	}
+
+	memset(buf, 'n', size);
+
+	if (addr != NULL)
+		sender(addr, duration, size);
+
+	/* Bind before forking, so that the local sender cannot race us. */
+	fd = udp_socket(PORT);
+
+	if (!strcmp(mode, "local")) {
+		if ((child = fork()) < 0) {
+			fprintf(stderr,"fork failed, error %d\n", errno);
+			exit(1);
+		}
+		if (child == 0) {
+			close(fd);
+			sender("127.0.0.1", 0, size);
+		}
+	}
+
+	receiver(fd, duration);
+
+	return 0;
+}
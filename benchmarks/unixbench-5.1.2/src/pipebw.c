@@ -0,0 +1,114 @@
+/*
+ *  pipebw -- pipe bandwidth benchmark
+ *
+ *  Measures how many bytes per second a pipe carries between two processes,
+ *  unlike pipe.c, which writes and reads in a single process:
+ *
+ *	pipebw duration [ size [ capacity ] ]
+ *
+ *  A child writes blocks of the given size (default 64 KB) into the pipe as
+ *  fast as it can; the parent reads them and counts the kilobytes received.
+ *  If a capacity is given, the capacity of the pipe is set first, to see how
+ *  it affects the number of times writer and reader have to wait for each
+ *  other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "timeit.c"
+
+#define MAX_SIZE	(1024 * 1024)	/* largest single write */
+
+char buf[MAX_SIZE];
+unsigned long kbytes;
+pid_t child;
+
+void report(int sig)
+{
+	kill(child, SIGKILL);
+	waitpid(child, NULL, 0);
+
+	fprintf(stderr,"COUNT|%lu|1|KBps\n", kbytes);
+	exit(0);
+}
+
+int main(int argc, char *argv[])
+{
+	int duration, size, capacity, fds[2];
+	ssize_t r, bytes;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ size [ capacity ] ]\n",
+			argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	size = argc > 2 ? atoi(argv[2]) : 65536;
+	capacity = argc > 3 ? atoi(argv[3]) : 0;
+
+	if (size < 1 || size > MAX_SIZE) {
+		fprintf(stderr,"%s: size must be 1 to %d\n", argv[0], MAX_SIZE);
+		exit(1);
+	}
+
+	memset(buf, 'p', size);
+
+	if (pipe(fds) < 0) {
+		fprintf(stderr,"pipe failed, error %d\n", errno);
+		exit(1);
+	}
+
+	if (capacity > 0) {
+#ifdef F_SETPIPE_SZ
+		if ((r = fcntl(fds[1], F_SETPIPE_SZ, capacity)) < 0) {
+			fprintf(stderr,"F_SETPIPE_SZ failed, error %d\n",
+				errno);
+			exit(1);
+		}
+		printf("pipe capacity is %d bytes\n", (int) r);
+#else
+		fprintf(stderr,"%s: cannot set the pipe capacity\n", argv[0]);
+		exit(1);
+#endif
+	}
+
+	if ((child = fork()) < 0) {
+		fprintf(stderr,"fork failed, error %d\n", errno);
+		exit(1);
+	}
+	if (child == 0) {
+		/* The writer runs until the reader kills it. */
+		close(fds[0]);
+		for (;;) {
+			if (write(fds[1], buf, size) < 0 && errno != EINTR) {
+				fprintf(stderr,"write failed, error %d\n",
+					errno);
+				exit(1);
+			}
+		}
+	}
+	close(fds[1]);
+
+	kbytes = 0;
+	wake_me(duration, report);
+
+	for (bytes = 0;;) {
+		if ((r = read(fds[0], buf, sizeof(buf))) > 0) {
+			if ((bytes += r) >= 1024) {
+				kbytes += bytes / 1024;
+				bytes %= 1024;
+			}
+		} else if (r == 0 || errno != EINTR) {
+			fprintf(stderr,"read failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ *  spawnrate -- parallel process creation benchmark
+ *
+ *  Measures how many programs can be started per second when several
+ *  processes keep spawning at the same time, as a parallel build does:
+ *
+ *	spawnrate duration [ procs [ program ] ]
+ *
+ *  Each of the given number of processes (default 4) forks and execs a
+ *  program over and over, and waits for it to exit. The program is the
+ *  benchmark itself by default, which exits right away when it is started
+ *  with a duration of 0, as execl does; another program may be given,
+ *  which is started without arguments. The total number of completed
+ *  spawns is counted. With one process this measures the same as execl
+ *  and spawn together; with more processes it shows whether exec scales.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "timeit.c"
+
+char self[256];
+unsigned long iter;
+int fds[2];
+
+void spawner_report(int sig)
+{
+	write(fds[1], &iter, sizeof(iter));
+	_exit(0);
+}
+
+void spawner(char *prog)
+{
+	int status;
+	pid_t pid;
+
+	for (;;) {
+		if ((pid = fork()) < 0) {
+			perror("fork");
+			exit(1);
+		}
+		if (pid == 0) {
+			if (prog == self)
+				execl(prog, prog, "0", (char *) NULL);
+			else
+				execl(prog, prog, (char *) NULL);
+			_exit(127);
+		}
+
+		while (waitpid(pid, &status, 0) < 0) {
+			if (errno != EINTR) {
+				perror("waitpid");
+				exit(1);
+			}
+		}
+		if (!WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+			fprintf(stderr,"spawnrate: cannot exec %s\n", prog);
+			exit(1);
+		}
+		iter++;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int duration, procs, i;
+	char *prog, *dir;
+	unsigned long count, total;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ procs [ program ] ]\n",
+			argv[0]);
+		exit(1);
+	}
+
+	/* one of the spawned copies */
+	if ((duration = atoi(argv[1])) == 0)
+		exit(0);
+
+	procs = argc > 2 ? atoi(argv[2]) : 4;
+	if ((dir = getenv("UB_BINDIR")) != NULL)
+		snprintf(self, sizeof(self), "%s/spawnrate", dir);
+	else
+		strlcpy(self, argv[0], sizeof(self));
+	prog = argc > 3 ? argv[3] : self;
+
+	if (procs < 1) {
+		fprintf(stderr,"%s: procs must be positive\n", argv[0]);
+		exit(1);
+	}
+
+	if (pipe(fds) != 0) {
+		perror("pipe");
+		exit(1);
+	}
+
+	for (i = 0; i < procs; i++) {
+		switch (fork()) {
+		case -1:
+			perror("fork");
+			exit(1);
+		case 0:
+			close(fds[0]);
+			iter = 0;
+			wake_me(duration, spawner_report);
+			spawner(prog);
+		}
+	}
+	close(fds[1]);
+
+	total = 0;
+	for (i = 0; i < procs; i++) {
+		if (read(fds[0], &count, sizeof(count)) != sizeof(count)) {
+			fprintf(stderr,"%s: a spawner failed\n", argv[0]);
+			exit(1);
+		}
+		total += count;
+	}
+	while (wait(NULL) > 0)
+		;
+
+	fprintf(stderr,"COUNT|%lu|1|lps\n", total);
+
+	return 0;
+}
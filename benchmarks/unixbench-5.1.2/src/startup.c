@@ -0,0 +1,138 @@
+/*
+ *  startup -- command startup latency benchmark
+ *
+ *  Measures how fast short-lived commands of the kind found in shell
+ *  pipelines can be started, run and reaped:
+ *
+ *	startup duration [ command ... ]
+ *
+ *  Each command is a single argument holding the program and its arguments
+ *  separated by spaces, e.g. "/bin/ls /". The commands are run one after
+ *  the other, with their output sent to /dev/null, until the time is up.
+ *  The number of commands run is counted, and the number of runs of each
+ *  command is logged; give a single command to see what it costs alone.
+ *  Without commands, a few common ones are run. For dynamically linked
+ *  commands, running the benchmark once after "ldconfig -r" and once after
+ *  "ldconfig" shows what the library links in /lib save.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "timeit.c"
+
+#define MAXARGS		16
+
+char *defaults[] = {
+	"/bin/echo hello",
+	"/bin/cat /etc/motd",
+	"/bin/ls /",
+	"/usr/bin/wc /etc/passwd",
+	"/usr/bin/uname -a",
+	"/bin/date",
+};
+
+char **list;
+int ncmds;
+unsigned long *runs, iter;
+
+void report(int sig)
+{
+	int i;
+
+	for (i = 0; i < ncmds; i++)
+		printf("%-30s %6lu runs\n", list[i], runs[i]);
+
+	fprintf(stderr,"COUNT|%lu|1|lps\n", iter);
+	exit(0);
+}
+
+void run(char **args)
+{
+	int status, fd;
+	pid_t pid;
+
+	if ((pid = fork()) < 0) {
+		perror("fork");
+		exit(1);
+	}
+	if (pid == 0) {
+		if ((fd = open("/dev/null", O_WRONLY)) >= 0) {
+			dup2(fd, 1);
+			dup2(fd, 2);
+		}
+		execv(args[0], args);
+		_exit(127);
+	}
+
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			perror("waitpid");
+			exit(1);
+		}
+	}
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+		fprintf(stderr,"startup: cannot exec %s\n", args[0]);
+		exit(1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int duration, i, n;
+	char ***cmds, *p;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ command ... ]\n", argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+
+	if (argc > 2) {
+		list = &argv[2];
+		ncmds = argc - 2;
+	} else {
+		list = defaults;
+		ncmds = sizeof(defaults) / sizeof(defaults[0]);
+	}
+
+	cmds = malloc(ncmds * sizeof(char **));
+	runs = calloc(ncmds, sizeof(unsigned long));
+	if (cmds == NULL || runs == NULL) {
+		fprintf(stderr,"%s: out of memory\n", argv[0]);
+		exit(1);
+	}
+
+	/* Split each command into its arguments. */
+	for (i = 0; i < ncmds; i++) {
+		if ((cmds[i] = malloc((MAXARGS + 1) * sizeof(char *))) == NULL ||
+		    (p = strdup(list[i])) == NULL) {
+			fprintf(stderr,"%s: out of memory\n", argv[0]);
+			exit(1);
+		}
+		for (n = 0; n < MAXARGS &&
+		    (cmds[i][n] = strsep(&p, " ")) != NULL; )
+			if (*cmds[i][n] != '\0') n++;
+		cmds[i][n] = NULL;
+		if (n == 0) {
+			fprintf(stderr,"%s: empty command\n", argv[0]);
+			exit(1);
+		}
+	}
+
+	iter = 0;
+	wake_me(duration, report);
+
+	for (;;) {
+		for (i = 0; i < ncmds; i++) {
+			run(cmds[i]);
+			runs[i]++;
+			iter++;
+		}
+	}
+}
@@ -0,0 +1,213 @@
+/*
+ *  tcpthru -- TCP bulk throughput benchmark
+ *
+ *  Measures how many bytes per second one TCP connection can carry. Run it as
+ *  a receiver and connect to it from a peer, or from another instance run as
+ *  a sender:
+ *
+ *	tcpthru duration recv [ bufsize ]		(receiver)
+ *	tcpthru duration send address [ bufsize ]	(sender)
+ *	tcpthru duration [ local [ bufsize ] ]		(both, over loopback)
+ *
+ *  In the default "local" mode a sender to 127.0.0.1 is forked. 'bufsize'
+ *  sets the socket send and receive buffer sizes, which bound the amount of
+ *  data in flight. To see how window scaling and the buffer size matter on a
+ *  long fat link, start the lwip server with "lodelay=<ms>" to delay every
+ *  packet on the loopback interface, and compare runs with different buffer
+ *  sizes. The receiver starts timing at the first data and counts the
+ *  kilobytes received; the sender counts the kilobytes sent.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "timeit.c"
+
+#define PORT		5001
+#define SIZE		8192	/* bytes per write */
+#define MAX_SIZE	65536	/* bytes per read */
+
+char buf[MAX_SIZE];
+unsigned long kbytes;
+pid_t child;
+
+void report(int sig)
+{
+	if (child > 0) {
+		kill(child, SIGKILL);
+		waitpid(child, NULL, 0);
+	}
+
+	fprintf(stderr,"COUNT|%lu|1|KBps\n", kbytes);
+	exit(0);
+}
+
+int tcp_socket(int bufsize)
+{
+	int fd;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		fprintf(stderr,"socket failed, error %d\n", errno);
+		exit(1);
+	}
+
+	if (bufsize != 0 &&
+	    (setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufsize,
+		sizeof(bufsize)) < 0 ||
+	    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize,
+		sizeof(bufsize)) < 0)) {
+		fprintf(stderr,"setsockopt failed, error %d\n", errno);
+		exit(1);
+	}
+
+	return fd;
+}
+
+void count(ssize_t r)
+{
+	static ssize_t bytes;
+
+	if ((bytes += r) >= 1024) {
+		kbytes += bytes / 1024;
+		bytes %= 1024;
+	}
+}
+
+void sender(const char *addr, int duration, int bufsize)
+{
+	struct sockaddr_in sin;
+	ssize_t r;
+	int fd;
+
+	fd = tcp_socket(bufsize);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = inet_addr(addr);
+	sin.sin_port = htons(PORT);
+
+	if (connect(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+		fprintf(stderr,"connect failed, error %d\n", errno);
+		exit(1);
+	}
+
+	/* A local sender runs until the receiver kills it; another one
+	 * stops early if the receiver closes the connection first.
+	 */
+	signal(SIGPIPE, SIG_IGN);
+	kbytes = 0;
+	if (duration > 0)
+		wake_me(duration, report);
+
+	for (;;) {
+		if ((r = write(fd, buf, SIZE)) >= 0)
+			count(r);
+		else if (errno == EPIPE || errno == ECONNRESET)
+			report(0);
+		else if (errno != EINTR) {
+			fprintf(stderr,"write failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+}
+
+void receiver(int lfd, int duration)
+{
+	ssize_t r;
+	int fd;
+
+	if ((fd = accept(lfd, NULL, NULL)) < 0) {
+		fprintf(stderr,"accept failed, error %d\n", errno);
+		exit(1);
+	}
+
+	/* Wait for the first data before starting the clock. */
+	if (read(fd, buf, sizeof(buf)) <= 0) {
+		fprintf(stderr,"read failed, error %d\n", errno);
+		exit(1);
+	}
+
+	kbytes = 0;
+	wake_me(duration, report);
+
+	for (;;) {
+		if ((r = read(fd, buf, sizeof(buf))) > 0)
+			count(r);
+		else if (r == 0 || errno != EINTR) {
+			fprintf(stderr,"read failed, error %d\n", errno);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in sin;
+	char *mode, *addr = NULL;
+	int duration, bufsize, fd, n;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ local | recv | "
+			"send address ] [ bufsize ]\n", argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	mode = argc > 2 ? argv[2] : "local";
+	n = 3;
+	if (!strcmp(mode, "send")) {
+		if (argc < 4) {
+			fprintf(stderr,"%s: send needs an address\n", argv[0]);
+			exit(1);
+		}
+		addr = argv[n++];
+	} else if (strcmp(mode, "local") && strcmp(mode, "recv")) {
+		fprintf(stderr,"%s: unknown mode %s\n", argv[0], mode);
+		exit(1);
+	}
+	bufsize = argc > n ? atoi(argv[n]) : 0;
+
+	memset(buf, 't', SIZE);
+
+	if (addr != NULL)
+		sender(addr, duration, bufsize);
+
+	/* Listen before forking, so that the local sender cannot race us. The
+	 * buffer sizes are set on the listening socket, so that the connection
+	 * inherits them before its window scale is negotiated.
+	 */
+	fd = tcp_socket(bufsize);
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_ANY);
+	sin.sin_port = htons(PORT);
+	if (bind(fd, (struct sockaddr *) &sin, sizeof(sin)) < 0 ||
+	    listen(fd, 1) < 0) {
+		fprintf(stderr,"bind/listen failed, error %d\n", errno);
+		exit(1);
+	}
+
+	if (!strcmp(mode, "local")) {
+		if ((child = fork()) < 0) {
+			fprintf(stderr,"fork failed, error %d\n", errno);
+			exit(1);
+		}
+		if (child == 0) {
+			close(fd);
+			sender("127.0.0.1", 0, bufsize);
+		}
+	}
+
+	receiver(fd, duration);
+
+	return 0;
+}
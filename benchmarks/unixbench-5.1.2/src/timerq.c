@@ -0,0 +1,102 @@
+/*
+ *  timerq -- timer queue benchmark
+ *
+ *  Measures how fast the timers library sets, cancels and runs watchdog
+ *  timers when many of them are active at once, as in a server that keeps
+ *  a timeout for every connection:
+ *
+ *	timerq duration [ timers [ range ] ]
+ *
+ *  The given number of timers (default 10000) is armed at random times up
+ *  to 'range' ticks ahead (default 6000). Then the clock is moved on one
+ *  tick at a time. On every tick a few timers are rearmed and a few are
+ *  cancelled and armed again, and the timers that expire arm themselves
+ *  anew, so that the number of active timers stays the same. The number of
+ *  timer operations is counted. No real time passes between ticks; only the
+ *  cost of the queue itself is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <timers.h>
+#include "timeit.c"
+
+#define CHURN		8	/* rearms and cancels per tick */
+
+timers_t queue;
+timer_t *timer;
+clock_t ticks;
+int range;
+unsigned long ops;
+
+void report(int sig)
+{
+	fprintf(stderr,"COUNT|%lu|1|ops\n", ops);
+	exit(0);
+}
+
+void expired(timer_t *tp)
+{
+	tmrs_settimer(&queue, tp, ticks + 1 + random() % range, expired,
+		NULL);
+	ops += 2;
+}
+
+int main(int argc, char *argv[])
+{
+	int duration, count;
+	clock_t next;
+	int c, i;
+
+	if (argc < 2) {
+		fprintf(stderr,"Usage: %s duration [ timers [ range ] ]\n",
+			argv[0]);
+		exit(1);
+	}
+
+	duration = atoi(argv[1]);
+	count = argc > 2 ? atoi(argv[2]) : 10000;
+	range = argc > 3 ? atoi(argv[3]) : 6000;
+
+	if (count < 1 || range < 1) {
+		fprintf(stderr,"%s: timers and range must be positive\n",
+			argv[0]);
+		exit(1);
+	}
+
+	if ((timer = malloc(count * sizeof(timer_t))) == NULL) {
+		fprintf(stderr,"%s: out of memory\n", argv[0]);
+		exit(1);
+	}
+
+	srandom(1);
+	ticks = 1;
+	ops = 0;
+
+	wake_me(duration, report);
+
+	for (i = 0; i < count; i++) {
+		tmr_inittimer(&timer[i]);
+		tmrs_settimer(&queue, &timer[i], ticks + 1 + random() % range,
+			expired, &next);
+		ops++;
+	}
+
+	for (;;) {
+		for (c = 0; c < CHURN; c++) {
+			i = random() % count;
+			tmrs_settimer(&queue, &timer[i],
+				ticks + 1 + random() % range, expired, &next);
+			i = random() % count;
+			tmrs_clrtimer(&queue, &timer[i], &next);
+			tmrs_settimer(&queue, &timer[i],
+				ticks + 1 + random() % range, expired, &next);
+		}
+		ops += 3 * CHURN;
+
+		ticks++;
+		tmrs_exptimers(&queue, ticks, &next);
+		ops++;
+	}
+}
@@ -0,0 +1,585 @@
+/* IPC trace command line tool */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <minix/config.h>
+#include <minix/const.h>
+#include <minix/com.h>
+#include <minix/endpoint.h>
+#include <minix/ipctrace.h>
+
+#define ITRACE_MAGIC	0x49545231	/* "ITR1" */
+#define ITBUF_SIZE	1024		/* entries fetched at once */
+#define MAX_DEPTH	8		/* deepest critical path shown */
+
+/* Trace file header. The entries of all cpus follow it. */
+struct itrace_hdr {
+  u32_t magic;
+  u32_t cpus;
+  u64_t freq;
+};
+
+/* A SENDREC request, and its reply. */
+struct request {
+  endpoint_t client;
+  endpoint_t server;
+  int type;
+  u64_t sent;			/* client sent the request */
+  u64_t received;		/* server received it; 0 if not yet */
+  u64_t replied;		/* server sent the reply; 0 if not yet */
+  u64_t done;			/* client received the reply; 0 if not yet */
+};
+
+/* Latency totals for one kind of request. */
+struct req_stat {
+  endpoint_t server;
+  int type;
+  unsigned int count;
+  u64_t queue, service, reply, total, max;
+};
+
+/* Per process slot state while going through the trace. */
+struct slot {
+  endpoint_t ep;		/* endpoint the state below belongs to */
+  int req;			/* outstanding request, or -1 */
+  u64_t kcall;			/* start of current kernel call, or 0 */
+  int call;			/* number of current kernel call */
+};
+
+static struct {
+  unsigned int count;
+  u64_t total, max;
+} kcall_stat[NR_SYS_CALLS];
+
+static ipctrace_entry buf[ITBUF_SIZE];
+static ipctrace_entry *entries;
+static size_t nr_entries;
+static struct request *reqs;
+static size_t nr_reqs, max_reqs;
+static struct req_stat *stats;
+static size_t nr_stats, max_stats;
+static struct slot slots[NR_TASKS + NR_PROCS];
+static u64_t freq;
+
+static void usage(char *name)
+{
+  printf("usage:\n"
+    "%s start\n"
+    "%s stop <file>\n"
+    "%s dump <file>\n"
+    "%s report <file>\n",
+    name, name, name, name);
+
+  exit(EXIT_FAILURE);
+}
+
+static void itrace_start(void)
+{
+  if (ipctrace(ITR_START, 0, NULL, NULL, 0) < 0) {
+	perror("ipctrace(ITR_START)");
+	exit(EXIT_FAILURE);
+  }
+}
+
+static void itrace_stop(char *file)
+{
+  struct itrace_hdr hdr;
+  ipctrace_info info;
+  unsigned int cpu, lost;
+  ssize_t size;
+  int r, outfd;
+
+  if ((outfd = open(file, O_CREAT|O_TRUNC|O_WRONLY, 0600)) < 0) {
+	perror("file open");
+	exit(EXIT_FAILURE);
+  }
+
+  /* The rings can still be read after tracing was stopped before. */
+  if (ipctrace(ITR_STOP, 0, NULL, NULL, 0) < 0 && errno != EBUSY) {
+	perror("ipctrace(ITR_STOP)");
+	exit(EXIT_FAILURE);
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = ITRACE_MAGIC;
+  if (write(outfd, (char *) &hdr, sizeof(hdr)) != sizeof(hdr)) {
+	perror("write");
+	exit(EXIT_FAILURE);
+  }
+
+  lost = 0;
+  hdr.cpus = 1;
+  for (cpu = 0; cpu < hdr.cpus; cpu++) {
+	do {
+		if ((r = ipctrace(ITR_GET, cpu, &info, buf,
+		    ITBUF_SIZE)) < 0) {
+			perror("ipctrace(ITR_GET)");
+			exit(EXIT_FAILURE);
+		}
+
+		hdr.cpus = info.cpus;
+		if (cpu == 0) hdr.freq = info.freq;
+		lost += info.lost;
+
+		size = info.count * sizeof(buf[0]);
+		if ((r = write(outfd, (char *) buf, size)) != size) {
+			if (r < 0) perror("write");
+			else fputs("short write\n", stderr);
+			exit(EXIT_FAILURE);
+		}
+	} while (info.count > 0);
+  }
+
+  if (lseek(outfd, 0, SEEK_SET) != 0 ||
+      write(outfd, (char *) &hdr, sizeof(hdr)) != sizeof(hdr)) {
+	perror("write");
+	exit(EXIT_FAILURE);
+  }
+
+  if (lost > 0)
+	fprintf(stderr, "%u entries were lost; trace a shorter interval\n",
+		lost);
+
+  close(outfd);
+}
+
+static int cmp_entry(const void *a, const void *b)
+{
+  const ipctrace_entry *ea = a, *eb = b;
+
+  if (ea->tsc < eb->tsc) return -1;
+  if (ea->tsc > eb->tsc) return 1;
+  return 0;
+}
+
+static void load(char *file)
+{
+  struct itrace_hdr hdr;
+  size_t max;
+  ssize_t r;
+  int infd;
+
+  if ((infd = open(file, O_RDONLY)) < 0) {
+	perror("open");
+	exit(EXIT_FAILURE);
+  }
+
+  if (read(infd, (char *) &hdr, sizeof(hdr)) != sizeof(hdr) ||
+      hdr.magic != ITRACE_MAGIC) {
+	fprintf(stderr, "%s: not an IPC trace\n", file);
+	exit(EXIT_FAILURE);
+  }
+  freq = hdr.freq;
+
+  max = 0;
+  for (;;) {
+	if (nr_entries == max) {
+		max = max ? max * 2 : ITBUF_SIZE;
+		entries = realloc(entries, max * sizeof(entries[0]));
+		if (entries == NULL) {
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	r = read(infd, (char *) &entries[nr_entries],
+		(max - nr_entries) * sizeof(entries[0]));
+	if (r <= 0) break;
+
+	nr_entries += r / sizeof(entries[0]);
+  }
+
+  if (r < 0) perror("read");
+
+  close(infd);
+
+  /* The cpus recorded separately; merge them into one timeline. This
+   * assumes that the cycle counters of all cpus are in sync.
+   */
+  qsort(entries, nr_entries, sizeof(entries[0]), cmp_entry);
+}
+
+static double usecs(u64_t cycles)
+{
+  if (freq == 0) return 0.0;
+
+  return (double) cycles * 1000000.0 / (double) freq;
+}
+
+static const char *ep_name(endpoint_t ep)
+{
+  static char name[16];
+
+  switch (ep) {
+  case KERNEL:		return "kernel";
+  case SYSTEM:		return "system";
+  case CLOCK:		return "clock";
+  case IDLE:		return "idle";
+  case PM_PROC_NR:	return "pm";
+  case VFS_PROC_NR:	return "vfs";
+  case RS_PROC_NR:	return "rs";
+  case MEM_PROC_NR:	return "memory";
+  case LOG_PROC_NR:	return "log";
+  case TTY_PROC_NR:	return "tty";
+  case DS_PROC_NR:	return "ds";
+  case MFS_PROC_NR:	return "mfs";
+  case VM_PROC_NR:	return "vm";
+  case PFS_PROC_NR:	return "pfs";
+  case SCHED_PROC_NR:	return "sched";
+  case INIT_PROC_NR:	return "init";
+  }
+
+  snprintf(name, sizeof(name), "%d", ep);
+  return name;
+}
+
+static const char *event_name(int event)
+{
+  switch (event) {
+  case ITE_SEND:	return "SEND";
+  case ITE_RECEIVE:	return "RECEIVE";
+  case ITE_NOTIFY:	return "NOTIFY";
+  case ITE_KCALL:	return "KCALL";
+  case ITE_KDONE:	return "KDONE";
+  }
+
+  return "?";
+}
+
+static void itrace_dump(char *file)
+{
+  ipctrace_entry *e;
+  size_t i;
+
+  load(file);
+
+  for (i = 0; i < nr_entries; i++) {
+	e = &entries[i];
+
+	printf("%12.1f %-8s %8s", usecs(e->tsc - entries[0].tsc),
+		event_name(e->event), ep_name(e->src));
+	printf(" -> %-8s type %d%s%s%s\n", ep_name(e->dst), e->type,
+		(e->flags & ITF_SENDREC) ? " sendrec" : "",
+		(e->flags & ITF_ASYNC) ? " async" : "",
+		(e->flags & ITF_NONBLOCK) ? " nonblock" : "");
+  }
+}
+
+static struct slot *get_slot(endpoint_t ep)
+{
+  struct slot *sp;
+  int p;
+
+  p = _ENDPOINT_P(ep) + NR_TASKS;
+  if (p < 0 || p >= NR_TASKS + NR_PROCS)
+	return NULL;
+
+  sp = &slots[p];
+  if (sp->ep != ep) {
+	/* The slot was reused since; forget the old process. */
+	sp->ep = ep;
+	sp->req = -1;
+	sp->kcall = 0;
+  }
+
+  return sp;
+}
+
+static void add_request(endpoint_t client, endpoint_t server, int type,
+	u64_t sent)
+{
+  struct request *rp;
+
+  if (nr_reqs == max_reqs) {
+	max_reqs = max_reqs ? max_reqs * 2 : 1024;
+	reqs = realloc(reqs, max_reqs * sizeof(reqs[0]));
+	if (reqs == NULL) {
+		perror("realloc");
+		exit(EXIT_FAILURE);
+	}
+  }
+
+  rp = &reqs[nr_reqs++];
+  memset(rp, 0, sizeof(*rp));
+  rp->client = client;
+  rp->server = server;
+  rp->type = type;
+  rp->sent = sent;
+}
+
+static void add_stat(struct request *rp)
+{
+  struct req_stat *st;
+  u64_t total;
+  size_t i;
+
+  for (i = 0; i < nr_stats; i++)
+	if (stats[i].server == rp->server && stats[i].type == rp->type)
+		break;
+
+  if (i == nr_stats) {
+	if (nr_stats == max_stats) {
+		max_stats = max_stats ? max_stats * 2 : 64;
+		stats = realloc(stats, max_stats * sizeof(stats[0]));
+		if (stats == NULL) {
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memset(&stats[nr_stats], 0, sizeof(stats[0]));
+	stats[nr_stats].server = rp->server;
+	stats[nr_stats].type = rp->type;
+	nr_stats++;
+  }
+
+  st = &stats[i];
+  total = rp->done - rp->sent;
+  st->count++;
+  st->queue += rp->received - rp->sent;
+  st->service += rp->replied - rp->received;
+  st->reply += rp->done - rp->replied;
+  st->total += total;
+  if (total > st->max) st->max = total;
+}
+
+static void analyze(void)
+{
+/* Match every SENDREC request with its delivery, the reply from the server
+ * and the delivery of that reply, and time all kernel calls.
+ */
+  ipctrace_entry *e;
+  struct request *rp;
+  struct slot *sp;
+  u64_t t;
+  size_t i;
+  int call;
+
+  for (i = 0; i < NR_TASKS + NR_PROCS; i++) {
+	slots[i].ep = NONE;
+	slots[i].req = -1;
+  }
+
+  for (i = 0; i < nr_entries; i++) {
+	e = &entries[i];
+
+	switch (e->event) {
+	case ITE_SEND:
+		if ((sp = get_slot(e->src)) == NULL) break;
+
+		if (e->flags & ITF_SENDREC) {
+			sp->req = nr_reqs;
+			add_request(e->src, e->dst, e->type, e->tsc);
+			break;
+		}
+
+		/* Is this the server replying to an outstanding request? */
+		if ((sp = get_slot(e->dst)) == NULL || sp->req < 0) break;
+		rp = &reqs[sp->req];
+		if (rp->server == e->src && rp->received != 0 &&
+		    rp->replied == 0)
+			rp->replied = e->tsc;
+		break;
+
+	case ITE_RECEIVE:
+		if (e->flags & ITF_SENDREC) {
+			if ((sp = get_slot(e->src)) == NULL || sp->req < 0)
+				break;
+			rp = &reqs[sp->req];
+			if (rp->server == e->dst && rp->received == 0)
+				rp->received = e->tsc;
+			break;
+		}
+
+		if ((sp = get_slot(e->dst)) == NULL || sp->req < 0) break;
+		rp = &reqs[sp->req];
+		if (rp->server == e->src && rp->replied != 0) {
+			rp->done = e->tsc;
+			sp->req = -1;
+			add_stat(rp);
+		}
+		break;
+
+	case ITE_KCALL:
+		if ((sp = get_slot(e->src)) == NULL) break;
+		sp->kcall = e->tsc;
+		sp->call = e->type - KERNEL_CALL;
+		break;
+
+	case ITE_KDONE:
+		if ((sp = get_slot(e->src)) == NULL || sp->kcall == 0) break;
+		call = sp->call;
+		if (call >= 0 && call < NR_SYS_CALLS) {
+			t = e->tsc - sp->kcall;
+			kcall_stat[call].count++;
+			kcall_stat[call].total += t;
+			if (t > kcall_stat[call].max)
+				kcall_stat[call].max = t;
+		}
+		sp->kcall = 0;
+		break;
+	}
+  }
+}
+
+static void kcall_time(endpoint_t ep, u64_t from, u64_t to,
+	unsigned int *count, u64_t *total)
+{
+/* Add up the kernel calls made by 'ep' within the given interval. */
+  u64_t start;
+  size_t i;
+
+  *count = 0;
+  *total = 0;
+  start = 0;
+
+  for (i = 0; i < nr_entries && entries[i].tsc <= to; i++) {
+	if (entries[i].tsc < from || entries[i].src != ep) continue;
+
+	if (entries[i].event == ITE_KCALL)
+		start = entries[i].tsc;
+	else if (entries[i].event == ITE_KDONE && start != 0) {
+		(*count)++;
+		*total += entries[i].tsc - start;
+		start = 0;
+	}
+  }
+}
+
+static void print_path(struct request *rp, int depth)
+{
+/* Print a request, and the requests its server made while serving it. These
+ * nested requests make up its service time, apart from the kernel calls
+ * and the server's own work.
+ */
+  struct request *cp;
+  unsigned int kcalls;
+  u64_t nested, ktime;
+  size_t i;
+
+  printf("%*s%s -> %s type %d: total %.1f us"
+	" (queue %.1f, service %.1f, reply %.1f)\n",
+	depth * 2, "", ep_name(rp->client), ep_name(rp->server), rp->type,
+	usecs(rp->done - rp->sent), usecs(rp->received - rp->sent),
+	usecs(rp->replied - rp->received), usecs(rp->done - rp->replied));
+
+  nested = 0;
+  for (i = 0; i < nr_reqs; i++) {
+	cp = &reqs[i];
+	if (cp->client != rp->server || cp->done == 0 ||
+	    cp->sent < rp->received || cp->done > rp->replied)
+		continue;
+
+	if (depth + 1 < MAX_DEPTH)
+		print_path(cp, depth + 1);
+	nested += cp->done - cp->sent;
+  }
+
+  kcall_time(rp->server, rp->received, rp->replied, &kcalls, &ktime);
+  if (kcalls > 0)
+	printf("%*s%s: %u kernel calls, %.1f us\n", depth * 2 + 2, "",
+		ep_name(rp->server), kcalls, usecs(ktime));
+
+  if (rp->replied - rp->received >= nested + ktime)
+	printf("%*s%s: own work %.1f us\n", depth * 2 + 2, "",
+		ep_name(rp->server),
+		usecs(rp->replied - rp->received - nested - ktime));
+}
+
+static int cmp_stat(const void *a, const void *b)
+{
+  const struct req_stat *sa = a, *sb = b;
+
+  if (sa->total > sb->total) return -1;
+  if (sa->total < sb->total) return 1;
+  return 0;
+}
+
+static void itrace_report(char *file)
+{
+  struct req_stat *st;
+  struct request *slowest;
+  size_t i, pending;
+
+  load(file);
+  analyze();
+
+  if (freq == 0)
+	printf("cycle counter frequency unknown; times are not valid\n");
+
+  /* Request latency breakdown, by total time spent. */
+  qsort(stats, nr_stats, sizeof(stats[0]), cmp_stat);
+
+  printf("%-8s %6s %8s %10s %10s %10s %10s %10s\n", "server", "type",
+	"count", "queue", "service", "reply", "avg(us)", "max(us)");
+  for (i = 0; i < nr_stats; i++) {
+	st = &stats[i];
+	printf("%-8s %6d %8u %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+		ep_name(st->server), st->type, st->count,
+		usecs(st->queue) / st->count, usecs(st->service) / st->count,
+		usecs(st->reply) / st->count, usecs(st->total) / st->count,
+		usecs(st->max));
+  }
+
+  printf("\n%-8s %8s %10s %10s\n", "kcall", "count", "avg(us)", "max(us)");
+  for (i = 0; i < NR_SYS_CALLS; i++) {
+	if (kcall_stat[i].count == 0) continue;
+	printf("%-8u %8u %10.1f %10.1f\n", (unsigned int) i,
+		kcall_stat[i].count,
+		usecs(kcall_stat[i].total) / kcall_stat[i].count,
+		usecs(kcall_stat[i].max));
+  }
+
+  /* Critical path of the slowest request. */
+  slowest = NULL;
+  pending = 0;
+  for (i = 0; i < nr_reqs; i++) {
+	if (reqs[i].done == 0) {
+		pending++;
+		continue;
+	}
+	if (slowest == NULL ||
+	    reqs[i].done - reqs[i].sent > slowest->done - slowest->sent)
+		slowest = &reqs[i];
+  }
+
+  printf("\n%lu requests, %lu not finished within the trace\n",
+	(unsigned long) nr_reqs, (unsigned long) pending);
+
+  if (slowest != NULL) {
+	printf("\ncritical path of the slowest request:\n");
+	print_path(slowest, 1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  char *name = argv[0];
+
+  if (argc < 2) usage(name);
+
+  if (!strcmp(argv[1], "start")) {
+	itrace_start();
+  }
+  else if (!strcmp(argv[1], "stop")) {
+	if (argc < 3) usage(name);
+
+	itrace_stop(argv[2]);
+  }
+  else if (!strcmp(argv[1], "dump")) {
+	if (argc < 3) usage(name);
+
+	itrace_dump(argv[2]);
+  }
+  else if (!strcmp(argv[1], "report")) {
+	if (argc < 3) usage(name);
+
+	itrace_report(argv[2]);
+  }
+  else usage(name);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# ldconfig - link shared libraries into the first library directory
+#
+# The dynamic linker searches the default library directories in turn, and
+# every directory that does not hold a library costs it a failed open.  For
+# every shared library in the other default directories that is not in the
+# first one, ldconfig puts a symbolic link to it in the first directory, so
+# that the first open finds it.  Links made by an earlier run are removed
+# first, so that libraries that went away or moved are not left behind.
+
+FIRST=/lib
+DIRS="/usr/lib /libexec"
+
+case "$1" in
+-r)	remove=1
+	;;
+"")	remove=
+	;;
+*)	echo "Usage: ldconfig [-r]" >&2
+	exit 1
+esac
+
+# Our links are the symbolic links in $FIRST that point into $DIRS.
+for lib in $FIRST/*.so $FIRST/*.so.*
+do
+	test -h $lib || continue
+	target=`readlink $lib`
+	for dir in $DIRS
+	do
+		case "$target" in
+		$dir/*)	rm -f $lib
+		esac
+	done
+done
+
+test "$remove" && exit 0
+
+for dir in $DIRS
+do
+	for lib in $dir/*.so $dir/*.so.*
+	do
+		test -f $lib || continue
+		name=${lib##*/}
+		test -f $FIRST/$name || test -h $FIRST/$name ||
+			ln -s $lib $FIRST/$name || exit 1
+	done
+done
+exit 0
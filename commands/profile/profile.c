@@ -24,6 +24,7 @@
 #define EOUTFILE		4
 #define EFREQ			5
 #define EACTION			6
+#define EDEPTH			7
 
 #define START			1
 #define STOP			2
@@ -51,6 +52,7 @@ int mem_size = 0;
 int mem_used = 0;
 int freq = 0;
 int intr_type = PROF_RTC;
+int depth = 0;
 char *outfile = "";
 char *mem_ptr;
 int outfile_fd, npipe_fd;
@@ -105,6 +107,10 @@ int main(int argc, char *argv[])
 			printf("Output filename missing.\n");
 			return 1;
 			break;
+		case EDEPTH:
+			printf("Incorrect call stack depth.\n");
+			return 1;
+			break;
 		default:
 			break;
 	}
@@ -118,12 +124,20 @@ int main(int argc, char *argv[])
 		printf("Incorrect frequency.\n");
 		return 1;
 	}
+	if (action == START && intr_type == PROF_NMI && depth > 0) {
+		printf("Call stacks are only taken with --rtc.\n");
+		return 1;
+	}
 
         printf("Statistical Profiling:\n");
 	printf("  profile start [--rtc | --nmi] "
 			"[-m memsize] [-o outfile] [-f frequency]\n");
+	printf("                [-d depth]\n");
         printf("  profile stop\n\n");
 	printf("   --rtc is default, --nmi allows kernel profiling\n");
+	printf("   -d takes call stacks of up to depth frames (max %u),\n",
+		SPROF_STACK_MAX);
+	printf("      also of user processes; --rtc only\n");
         printf("Call Profiling:\n");
 	printf("  profile get   [-m memsize] [-o outfile]\n");
         printf("  profile reset\n\n");
@@ -184,6 +198,11 @@ int handle_args(int argc, char *argv[])
 		if (--argc == 0) return ESYNTAX;
 		outfile = *++argv;
 	} else
+	if (strcmp(*argv, "-d") == 0) {
+		if (--argc == 0) return ESYNTAX;
+		if (sscanf(*++argv, "%u", &depth) != 1 ||
+			depth > SPROF_STACK_MAX) return EDEPTH;
+	} else
 	if (strcmp(*argv, "--rtc") == 0) {
 		intr_type = PROF_RTC;
 	} else
@@ -247,7 +266,8 @@ int start()
 
   if (alloc_mem()) return 1;
 
-  if (sprofile(PROF_START, mem_size, freq, intr_type, &sprof_info, mem_ptr)) {
+  if (sprofile(PROF_START, mem_size, freq,
+		intr_type | (depth << PROF_DEPTH_SHIFT), &sprof_info, mem_ptr)) {
 	perror("sprofile");
 	fprintf(stderr, "Error starting profiling.\n");
 	return 1;
@@ -13,6 +13,8 @@
 
 #define ENDPOINT_HASHTAB_SIZE 1024
 
+#define STACK_HASHTAB_SIZE 4096
+
 #define DEBUG 0
 
 #define NM "/usr/pkg/bin/nm"
@@ -23,6 +25,15 @@ static const char *default_binaries[] = {
 	"drivers/",
 };
 
+/* installed binaries, for user processes in call stack traces */
+static const char *installed_binaries[] = {
+	"/bin/",
+	"/sbin/",
+	"/usr/bin/",
+	"/usr/sbin/",
+	"/service/",
+};
+
 static const char *src_path = "/usr/src";
 
 /* types */
@@ -35,6 +46,11 @@ static const char *src_path = "/usr/src";
 
 #define SYMBOL_SIZE_MAX 0x100000
 
+#define STACK_STRING_SIZE 1024
+
+#define RECORD_SIZE_MAX (sizeof(union sprof_record) + \
+	sizeof(struct sprof_stack) + SPROF_STACK_MAX * sizeof(void *))
+
 #define PC_MAP_L1_SIZE 0x10000
 #define PC_MAP_L2_SIZE 0x10000
 
@@ -69,6 +85,7 @@ struct binary_info {
 
 struct endpoint_info {
 	endpoint_t endpoint;
+	char name[PROC_NAME_LEN];
 	struct binary_info *binary;
 	struct endpoint_info *hashtab_next;
 	struct endpoint_info *next;
@@ -80,6 +97,13 @@ union sprof_record {
 	struct sprof_proc proc;
 };
 
+struct stack_count {
+	struct stack_count *next;
+	struct stack_count *hashtab_next;
+	int samples;
+	char *stack;
+};
+
 /* global variables */
 static struct binary_info *binaries;
 static struct binary_info *binary_hashtab[BINARY_HASHTAB_SIZE];
@@ -87,11 +111,16 @@ static struct endpoint_info *endpoint_hashtab[ENDPOINT_HASHTAB_SIZE];
 static struct endpoint_info *endpoints;
 static double minimum_perc = 1.0;
 static struct sprof_info_s sprof_info;
+static int stack_depth;
+static struct stack_count *stacks;
+static struct stack_count *stack_hashtab[STACK_HASHTAB_SIZE];
 
 /* prototypes */
 static struct binary_info *binary_add(const char *path);
 static struct binary_info *binary_find(const char *name);
 static struct binary_info *binary_hashtab_get(const char *name);
+static const char *binary_symbol(const struct binary_info *binary,
+	unsigned long addr);
 static struct binary_info **binary_hashtab_get_ptr(const char *name);
 static void binary_load_pc_map(struct binary_info *binary_info);
 static const char *binary_name(const char *path);
@@ -105,6 +134,7 @@ static void *malloc_checked(size_t size);
 static unsigned name_hash(const char *name);
 static float percent(int value, int percent_of);
 static void print_diff(void);
+static void print_folded(void);
 static void print_report(void);
 static void print_report_overall(void);
 static void print_report_per_binary(const struct binary_info *binary);
@@ -122,7 +152,11 @@ static size_t sample_process(const union sprof_record *data, size_t size,
 static struct binary_info *sample_load_binary(const struct sprof_proc *sample);
 static void sample_store(struct binary_info *binary,
 	const struct sprof_sample *sample);
+static void stack_store(const struct endpoint_info *epinfo, const void *pc,
+	void *const *frames, int depth);
 static char *strdup_checked(const char *s);
+static struct symbol_count *symbol_find(const struct binary_info *binary,
+	unsigned long addr);
 static void usage(const char *argv0);
 
 #define MALLOC_CHECKED(type, count) \
@@ -140,7 +174,7 @@ static void usage(const char *argv0);
 #endif
 
 int main(int argc, char **argv) {
-	int opt, sprofdiff = 0;
+	int opt, sprofdiff = 0, folded = 0;
 
 #ifdef DEBUG
 	/* disable buffering so the output mixes correctly */
@@ -149,7 +183,7 @@ int main(int argc, char **argv) {
 #endif
 
 	/* parse arguments */
-	while ((opt = getopt(argc, argv, "b:dp:s:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:dfp:s:")) != -1) {
 		switch (opt) {
 		case 'b':
 			/* additional binary specified */
@@ -159,6 +193,10 @@ int main(int argc, char **argv) {
 			/* generate output for sprofdiff */
 			sprofdiff = 1;
 			break;
+		case 'f':
+			/* generate folded call stacks */
+			folded = 1;
+			break;
 		case 'p':
 			/* minimum percentage specified */
 			minimum_perc = atof(optarg);
@@ -188,6 +226,8 @@ int main(int argc, char **argv) {
 	/* print report */
 	if (sprofdiff) {
 		print_diff();
+	} else if (folded) {
+		print_folded();
 	} else {
 		print_report();
 	}
@@ -293,6 +333,16 @@ static struct binary_info *binary_find(const char *name) {
 		return binary_add(strdup_checked(path));
 	}
 
+	/* user processes run installed binaries */
+	for (i = 0; i < LENGTHOF(installed_binaries); i++) {
+		snprintf(path, sizeof(path), "%s%.*s", installed_binaries[i],
+			PROC_NAME_LEN, name);
+		dprintf("checking whether \"%s\" exists\n", path);
+		if (access(path, R_OK) < 0) continue;
+
+		return binary_add(strdup_checked(path));
+	}
+
 	/* not found */
 	return NULL;
 }
@@ -301,6 +351,14 @@ static struct binary_info *binary_hashtab_get(const char *name) {
 	return *binary_hashtab_get_ptr(name);
 }
 
+static const char *binary_symbol(const struct binary_info *binary,
+	unsigned long addr) {
+	struct symbol_count *symbol;
+
+	symbol = symbol_find(binary, addr);
+	return symbol ? symbol->name : "[unknown]";
+}
+
 static struct binary_info **binary_hashtab_get_ptr(const char *name) {
 	struct binary_info *binary, **ptr;
 
@@ -513,6 +571,12 @@ static void load_trace(const char *path) {
 		fprintf(stderr, "error: totals missing in file \"%s\"\n", path);
 		exit(1);
 	}
+	stack_depth = sprof_info_perfile.stack_depth;
+	if (stack_depth < 0 || stack_depth > SPROF_STACK_MAX) {
+		fprintf(stderr, "error: file \"%s\" has invalid call stack "
+			"depth %d\n", path, stack_depth);
+		exit(1);
+	}
 
 	/* read and store samples */
 	samples_read = 0;
@@ -520,7 +584,7 @@ static void load_trace(const char *path) {
 	bufsize = 0;
 	for (;;) {
 		/* enough left in the buffer? */
-		if (bufsize - bufindex < sizeof(union sprof_record)) {
+		if (bufsize - bufindex < RECORD_SIZE_MAX) {
 			/* not enough, read some more */
 			memmove(buffer, buffer + bufindex, bufsize - bufindex);
 			bufsize -= bufindex;
@@ -533,7 +597,7 @@ static void load_trace(const char *path) {
 		}
 
 		/* process sample record (either struct sprof_sample or
-		 * struct sprof_proc)
+		 * struct sprof_proc, a sample possibly with its call stack)
 		 */
 		bufindex += sample_process(
 			(const union sprof_record *) (buffer + bufindex),
@@ -611,6 +675,21 @@ static void print_diff(void) {
 	}
 }
 
+static void print_folded(void) {
+	const struct stack_count *stack;
+
+	/* print one line per distinct call stack, outermost frame first and
+	 * frames separated by semicolons, as expected by flame graph tools
+	 */
+	if (!stacks) {
+		fprintf(stderr, "warning: no call stacks in trace, use "
+			"profile start -d to take them\n");
+	}
+	for (stack = stacks; stack; stack = stack->next) {
+		printf("%s %d\n", stack->stack, stack->samples);
+	}
+}
+
 static void print_report(void) {
 	/* print out human-readable analysis */
 	printf("Showing processes and functions using at least %3.0f%% "
@@ -904,6 +983,9 @@ static void read_to_whitespace(FILE *file, char *buffer, size_t size) {
 static size_t sample_process(const union sprof_record *data, size_t size,
 	int *samples_read) {
 	struct endpoint_info *epinfo, **ptr;
+	const struct sprof_stack *stack;
+	void *frames[SPROF_STACK_MAX];
+	size_t record_size;
 
 	assert(data);
 	assert(samples_read);
@@ -923,9 +1005,34 @@ static size_t sample_process(const union sprof_record *data, size_t size,
 
 		/* endpoint known, store sample */
 		if (size < sizeof(data->sample)) goto error;
-		sample_store(epinfo->binary, &data->sample);
-		(*samples_read)++;
-		return sizeof(data->sample);
+		if (stack_depth == 0) {
+			sample_store(epinfo->binary, &data->sample);
+			(*samples_read)++;
+			return sizeof(data->sample);
+		}
+
+		/* the sample is followed by its call stack */
+		record_size = sizeof(data->sample) + sizeof(*stack);
+		if (size < record_size) goto error;
+		stack = (const struct sprof_stack *)
+			((const char *) data + sizeof(data->sample));
+		if (stack->depth > stack_depth) {
+			fprintf(stderr, "error: call stack of depth %u exceeds "
+				"maximum of %d, trace is corrupt\n",
+				stack->depth, stack_depth);
+			exit(1);
+		}
+		record_size += stack->depth * sizeof(void *);
+		if (size < record_size) goto error;
+		memcpy(frames, stack + 1, stack->depth * sizeof(void *));
+
+		/* user processes only appear in call stacks */
+		if (!(stack->flags & SPROF_STACK_USER)) {
+			sample_store(epinfo->binary, &data->sample);
+			(*samples_read)++;
+		}
+		stack_store(epinfo, data->sample.pc, frames, stack->depth);
+		return record_size;
 	}
 
 	/* endpoint not known, add it */
@@ -938,6 +1045,7 @@ static size_t sample_process(const union sprof_record *data, size_t size,
 
 	/* fetch binary based on process name in sample */
 	if (size < sizeof(data->proc)) goto error;
+	strncpy(epinfo->name, data->proc.name, sizeof(epinfo->name));
 	epinfo->binary = sample_load_binary(&data->proc);
 	return sizeof(data->proc);
 
@@ -971,22 +1079,11 @@ static struct binary_info *sample_load_binary(
 
 static void sample_store(struct binary_info *binary,
 	const struct sprof_sample *sample) {
-	unsigned long index_l1;
-	struct pc_map_l2 *pc_map_l2;
 	struct symbol_count *symbol;
 
 	if (!binary || !binary->pc_map) return;
 
-	/* find the applicable symbol (two-level lookup) */
-	index_l1 = (unsigned long) sample->pc / PC_MAP_L2_SIZE;
-	assert(index_l1 < PC_MAP_L1_SIZE);
-	pc_map_l2 = binary->pc_map->l1[index_l1];
-	if (pc_map_l2) {
-		symbol = pc_map_l2->l2[(unsigned long) sample->pc % PC_MAP_L2_SIZE];
-	} else {
-		symbol = NULL;
-	}
-
+	symbol = symbol_find(binary, (unsigned long) sample->pc);
 	if (symbol) {
 		assert(symbol->samples >= 0);
 		symbol->samples++;
@@ -1002,6 +1099,49 @@ static void sample_store(struct binary_info *binary,
 	}
 }
 
+static void stack_store(const struct endpoint_info *epinfo, const void *pc,
+	void *const *frames, int depth) {
+	char buffer[STACK_STRING_SIZE];
+	struct stack_count *stack, **ptr;
+	unsigned long addr;
+	unsigned hash;
+	size_t len;
+	int i;
+
+	/* build the folded stack; frames hold return addresses, so look up
+	 * the byte before each to find the call site
+	 */
+	len = snprintf(buffer, sizeof(buffer), "%.*s",
+		PROC_NAME_LEN, epinfo->name);
+	for (i = depth; i >= 0 && len < sizeof(buffer); i--) {
+		if (i > 0) {
+			addr = (unsigned long) frames[i - 1] - 1;
+		} else {
+			addr = (unsigned long) pc;
+		}
+		len += snprintf(buffer + len, sizeof(buffer) - len, ";%s",
+			binary_symbol(epinfo->binary, addr));
+	}
+
+	/* count it */
+	hash = 0;
+	for (i = 0; buffer[i]; i++) {
+		hash = hash * 31 + buffer[i];
+	}
+	ptr = &stack_hashtab[hash % STACK_HASHTAB_SIZE];
+	while ((stack = *ptr) && strcmp(stack->stack, buffer) != 0) {
+		ptr = &stack->hashtab_next;
+	}
+	if (!stack) {
+		*ptr = stack = MALLOC_CHECKED(struct stack_count, 1);
+		memset(stack, 0, sizeof(*stack));
+		stack->stack = strdup_checked(buffer);
+		stack->next = stacks;
+		stacks = stack;
+	}
+	stack->samples++;
+}
+
 static char *strdup_checked(const char *s) {
 	char *p;
 	if (!s) return NULL;
@@ -1014,9 +1154,23 @@ static char *strdup_checked(const char *s) {
 	return p;
 }
 
+static struct symbol_count *symbol_find(const struct binary_info *binary,
+	unsigned long addr) {
+	unsigned long index_l1;
+	struct pc_map_l2 *pc_map_l2;
+
+	if (!binary || !binary->pc_map) return NULL;
+
+	/* find the applicable symbol (two-level lookup) */
+	index_l1 = addr / PC_MAP_L2_SIZE;
+	if (index_l1 >= PC_MAP_L1_SIZE) return NULL;
+	pc_map_l2 = binary->pc_map->l1[index_l1];
+	return pc_map_l2 ? pc_map_l2->l2[addr % PC_MAP_L2_SIZE] : NULL;
+}
+
 static void usage(const char *argv0) {
 	printf("usage:\n");
-	printf("  %s [-d] [-p percentage] [-s src-tree-path] "
+	printf("  %s [-d | -f] [-p percentage] [-s src-tree-path] "
 		"[-b binary]... file...\n", argv0);
 	printf("\n");
 	printf("sprofalyze aggregates one or more sprofile traces and");
@@ -1024,6 +1178,8 @@ static void usage(const char *argv0) {
 	printf("\n");
 	printf("arguments:\n");
 	printf("-d generates output that can be compared using sprofdiff\n");
+	printf("-f prints folded call stacks for flame graph tools; needs\n");
+	printf("   a trace taken with profile start -d\n");
 	printf("-p specifies the cut-off percentage below which binaries\n");
 	printf("   and functions will not be displayed\n");
 	printf("-s specifies the root of the source tree where sprofalyze\n");
@@ -17,6 +17,19 @@
  * It does not implement transparent failure recovery, power management, or
  * port multiplier support.
  */
+/*
+ * On HBAs that support it, command completion coalescing (CCC) is used for
+ * ports with NCQ devices. For such ports, the per-command completion
+ * interrupts are masked, and the HBA instead raises a single CCC interrupt
+ * after a configurable number of completions or after a configurable timeout,
+ * whichever comes first. All completed commands on all coalescing ports are
+ * then finished in one go. Error and hot-plug interrupts are never coalesced.
+ *
+ * For each port, the driver keeps histograms of command latencies, of the
+ * number of outstanding commands at issue time, and of the number of commands
+ * finished per interrupt. These are printed whenever the device is fully
+ * closed, if the verbosity level is at least V_INFO.
+ */
 /*
  * An AHCI controller exposes a number of ports (up to 32), each of which may
  * or may not have one device attached (port multipliers are not supported).
@@ -115,6 +128,7 @@
 #include <machine/pci.h>
 #include <sys/ioc_disk.h>
 #include <sys/mman.h>
+#include <minix/minlib.h>
 #include <assert.h>
 
 #include "ahci.h"
@@ -128,6 +142,9 @@ static struct {
 	int nr_cmds;		/* maximum number of commands per port */
 	int has_ncq;		/* NCQ support flag */
 	int has_clo;		/* CLO support flag */
+	int has_ccc;		/* CCC support (and use) flag */
+	u32_t ccc_mask;		/* interrupt status bit used for CCC */
+	u32_t ccc_ports;	/* mask of ports using CCC */
 
 	int irq;		/* IRQ number */
 	int hook_id;		/* IRQ hook ID */
@@ -180,7 +197,14 @@ static struct port_state {
 		thread_id_t tid;/* ID of the worker thread */
 		timer_t timer;	/* timer associated with each request */
 		int result;	/* success/failure result of the commands */
+		u64_t start;	/* TSC value at the time of issuing */
 	} cmd_info[NR_CMDS];
+
+	struct {
+		u32_t lat_hist[NR_LAT_BUCKETS];	/* command latencies (log2 us) */
+		u32_t depth_hist[NR_CMDS + 1];	/* pending commands at issue */
+		u32_t batch_hist[NR_CMDS + 1];	/* commands finished at once */
+	} stats;
 } port_state[NR_PORTS];
 
 #define port_read(ps, r)	((ps)->reg[r])
@@ -199,6 +223,10 @@ static clock_t ahci_command_timeout;
 static clock_t ahci_transfer_timeout;
 static clock_t ahci_flush_timeout;
 
+/* Command completion coalescing values. */
+static unsigned int ahci_ccc_count;
+static unsigned int ahci_ccc_timeout;
+
 /* Timeout environment variable names and default values. */
 static struct {
 	char *name;				/* environment variable name */
@@ -897,6 +925,64 @@ static void port_set_cmd(struct port_state *ps, int cmd, cmd_fis_t *fis,
 	cl[2] = ps->ct_phys[cmd];
 }
 
+/*===========================================================================*
+ *				port_stat_latency			     *
+ *===========================================================================*/
+static void port_stat_latency(struct port_state *ps, int cmd)
+{
+	/* Add the latency of a command that just completed to the latency
+	 * histogram of the port.
+	 */
+	u64_t now;
+	u32_t micros;
+	int bucket;
+
+	read_tsc_64(&now);
+
+	micros = tsc_64_to_micros(sub64(now, ps->cmd_info[cmd].start));
+
+	for (bucket = 0; bucket < NR_LAT_BUCKETS - 1; bucket++)
+		if (micros < (1UL << bucket))
+			break;
+
+	ps->stats.lat_hist[bucket]++;
+}
+
+/*===========================================================================*
+ *				port_print_stats			     *
+ *===========================================================================*/
+static void port_print_stats(struct port_state *ps)
+{
+	/* Print the histograms of the given port, and reset them afterwards.
+	 */
+	int i;
+
+	if (ahci_verbose >= V_INFO) {
+		printf("%s: queue depth at issue:", ahci_portname(ps));
+		for (i = 1; i <= NR_CMDS; i++)
+			if (ps->stats.depth_hist[i] > 0)
+				printf(" %d:%u", i, ps->stats.depth_hist[i]);
+		printf("\n");
+
+		printf("%s: commands per interrupt:", ahci_portname(ps));
+		for (i = 1; i <= NR_CMDS; i++)
+			if (ps->stats.batch_hist[i] > 0)
+				printf(" %d:%u", i, ps->stats.batch_hist[i]);
+		printf("\n");
+
+		printf("%s: latency (us):", ahci_portname(ps));
+		for (i = 0; i < NR_LAT_BUCKETS - 1; i++)
+			if (ps->stats.lat_hist[i] > 0)
+				printf(" <%lu:%u", 1UL << i, ps->stats.lat_hist[i]);
+		if (ps->stats.lat_hist[i] > 0)
+			printf(" >=%lu:%u", 1UL << (i - 1),
+				ps->stats.lat_hist[i]);
+		printf("\n");
+	}
+
+	memset(&ps->stats, 0, sizeof(ps->stats));
+}
+
 /*===========================================================================*
  *				port_finish_cmd				     *
  *===========================================================================*/
@@ -913,6 +999,9 @@ static void port_finish_cmd(struct port_state *ps, int cmd, int result)
 	/* Update the command result, and clear it from the pending list. */
 	ps->cmd_info[cmd].result = result;
 
+	if (result == RESULT_SUCCESS)
+		port_stat_latency(ps, cmd);
+
 	assert(ps->pend_mask & (1 << cmd));
 	ps->pend_mask &= ~(1 << cmd);
 
@@ -946,7 +1035,7 @@ static void port_check_cmds(struct port_state *ps)
 	/* Check what commands have completed, and finish them.
 	 */
 	u32_t mask, done;
-	int i;
+	int i, count;
 
 	/* See which commands have completed. */
 	if (ps->flags & FLAG_NCQ_MODE)
@@ -957,9 +1046,16 @@ static void port_check_cmds(struct port_state *ps)
 	/* Wake up threads corresponding to completed commands. */
 	done = ps->pend_mask & ~mask;
 
-	for (i = 0; i < ps->queue_depth; i++)
-		if (done & (1 << i))
+	for (i = count = 0; i < ps->queue_depth; i++) {
+		if (done & (1 << i)) {
 			port_finish_cmd(ps, i, RESULT_SUCCESS);
+
+			count++;
+		}
+	}
+
+	if (count > 0)
+		ps->stats.batch_hist[count]++;
 }
 
 /*===========================================================================*
@@ -1218,6 +1314,65 @@ static ssize_t port_transfer(struct port_state *ps, u64_t pos, u64_t eof,
 	return size;
 }
 
+/*===========================================================================*
+ *				ahci_set_ccc				     *
+ *===========================================================================*/
+static void ahci_set_ccc(void)
+{
+	/* Program command completion coalescing for the current set of
+	 * coalescing ports. The HBA requires that coalescing be disabled while
+	 * its parameters are being changed.
+	 */
+	u32_t ctl;
+
+	ctl = hba_read(AHCI_HBA_CCC_CTL);
+	hba_write(AHCI_HBA_CCC_CTL, ctl & ~AHCI_HBA_CCC_CTL_EN);
+
+	hba_write(AHCI_HBA_CCC_PORTS, hba_state.ccc_ports);
+
+	if (hba_state.ccc_ports == 0)
+		return;
+
+	ctl = (ahci_ccc_timeout << AHCI_HBA_CCC_CTL_TV_SHIFT) |
+		(ahci_ccc_count << AHCI_HBA_CCC_CTL_CC_SHIFT);
+
+	hba_write(AHCI_HBA_CCC_CTL, ctl);
+	hba_write(AHCI_HBA_CCC_CTL, ctl | AHCI_HBA_CCC_CTL_EN);
+}
+
+/*===========================================================================*
+ *				port_set_ccc				     *
+ *===========================================================================*/
+static void port_set_ccc(struct port_state *ps, int enable)
+{
+	/* Start or stop using command completion coalescing for the given
+	 * port. When starting, mask the port's own completion interrupts, so
+	 * that completions are signaled through the CCC interrupt only. When
+	 * stopping, the caller is responsible for resetting the PxIE mask.
+	 */
+	u32_t bit;
+
+	if (!hba_state.has_ccc || enable == !!(ps->flags & FLAG_CCC))
+		return;
+
+	bit = 1 << (ps - port_state);
+
+	if (enable) {
+		ps->flags |= FLAG_CCC;
+		hba_state.ccc_ports |= bit;
+
+		port_write(ps, AHCI_PORT_IE, AHCI_PORT_IE_CCC);
+	} else {
+		ps->flags &= ~FLAG_CCC;
+		hba_state.ccc_ports &= ~bit;
+	}
+
+	dprintf(V_INFO, ("%s: %s completion coalescing\n", ahci_portname(ps),
+		enable ? "using" : "not using"));
+
+	ahci_set_ccc();
+}
+
 /*===========================================================================*
  *				port_hardreset				     *
  *===========================================================================*/
@@ -1413,6 +1568,10 @@ static void port_id_check(struct port_state *ps, int success)
 	/* The device has been identified successfully, and hence usable. */
 	ps->state = STATE_GOOD_DEV;
 
+	/* NCQ devices benefit from having their completions coalesced. */
+	if (ps->flags & FLAG_HAS_NCQ)
+		port_set_ccc(ps, TRUE);
+
 	/* Print some information about the device. */
 	if (ahci_verbose >= V_INFO) {
 		printf("%s: ATA%s, ", ahci_portname(ps),
@@ -1468,6 +1627,12 @@ static void port_connect(struct port_state *ps)
 		return;
 	}
 
+	/* Stop coalescing completions for the port, if it was, so that the
+	 * HBA's set of coalescing ports does not keep it after its flag is
+	 * cleared below. Identification turns it back on if appropriate.
+	 */
+	port_set_ccc(ps, FALSE);
+
 	/* Clear all state flags except the busy flag, which may be relevant if
 	 * a BDEV_OPEN call is waiting for the device to become ready; the
 	 * barrier flag, which prevents access to the device until it is
@@ -1504,6 +1669,8 @@ static void port_disconnect(struct port_state *ps)
 
 	dprintf(V_INFO, ("%s: device disconnected\n", ahci_portname(ps)));
 
+	port_set_ccc(ps, FALSE);
+
 	ps->state = STATE_NO_DEV;
 	port_write(ps, AHCI_PORT_IE, AHCI_PORT_IE_PCE);
 	ps->flags &= ~FLAG_BUSY;
@@ -1816,6 +1983,16 @@ static void port_issue(struct port_state *ps, int cmd, clock_t timeout)
 	/* Issue a command to the port, and set a timer to trigger a timeout
 	 * if the command takes too long to complete.
 	 */
+	u32_t mask;
+	int depth;
+
+	/* Account for the number of commands that will be outstanding. */
+	for (mask = ps->pend_mask, depth = 1; mask != 0; depth++)
+		mask &= mask - 1;
+
+	ps->stats.depth_hist[depth]++;
+
+	read_tsc_64(&ps->cmd_info[cmd].start);
 
 	/* Set the corresponding NCQ command bit, if applicable. */
 	if (ps->flags & FLAG_HAS_NCQ)
@@ -2117,22 +2294,36 @@ static void ahci_init(int devind)
 	hba_write(AHCI_HBA_GHC, ghc | AHCI_HBA_GHC_AE | AHCI_HBA_GHC_IE);
 
 	/* Limit the maximum number of commands to the controller's value. */
-	/* Note that we currently use only one command anyway. */
 	cap = hba_read(AHCI_HBA_CAP);
 	hba_state.has_ncq = !!(cap & AHCI_HBA_CAP_SNCQ);
 	hba_state.has_clo = !!(cap & AHCI_HBA_CAP_SCLO);
 	hba_state.nr_cmds = MIN(NR_CMDS,
 		((cap >> AHCI_HBA_CAP_NCS_SHIFT) & AHCI_HBA_CAP_NCS_MASK) + 1);
 
+	/* Use command completion coalescing if supported and not disabled.
+	 * Coalescing is enabled per port, once an NCQ device is identified.
+	 */
+	hba_state.has_ccc = (cap & AHCI_HBA_CAP_CCCS) && ahci_ccc_count > 0;
+	hba_state.ccc_ports = 0;
+	if (hba_state.has_ccc) {
+		hba_state.ccc_mask = 1 << ((hba_read(AHCI_HBA_CCC_CTL) >>
+			AHCI_HBA_CCC_CTL_INT_SHIFT) &
+			AHCI_HBA_CCC_CTL_INT_MASK);
+
+		ahci_set_ccc();
+	}
+	else hba_state.ccc_mask = 0;
+
 	dprintf(V_INFO, ("AHCI%u: HBA v%d.%d%d, %ld ports, %ld commands, "
-		"%s queuing, IRQ %d\n",
+		"%s queuing, %s coalescing, IRQ %d\n",
 		ahci_instance,
 		(int) (hba_read(AHCI_HBA_VS) >> 16),
 		(int) ((hba_read(AHCI_HBA_VS) >> 8) & 0xFF),
 		(int) (hba_read(AHCI_HBA_VS) & 0xFF),
 		((cap >> AHCI_HBA_CAP_NP_SHIFT) & AHCI_HBA_CAP_NP_MASK) + 1,
 		((cap >> AHCI_HBA_CAP_NCS_SHIFT) & AHCI_HBA_CAP_NCS_MASK) + 1,
-		hba_state.has_ncq ? "supports" : "no", hba_state.irq));
+		hba_state.has_ncq ? "supports" : "no",
+		hba_state.has_ccc ? "completion" : "no", hba_state.irq));
 
 	dprintf(V_INFO, ("AHCI%u: CAP %08x, CAP2 %08x, PI %08x\n",
 		ahci_instance, cap, hba_read(AHCI_HBA_CAP2),
@@ -2206,8 +2397,17 @@ static void ahci_intr(unsigned int UNUSED(mask))
 	/* Handle an interrupt for each port that has the interrupt bit set. */
 	mask = hba_read(AHCI_HBA_IS);
 
+	/* A coalesced interrupt means that any number of commands may have
+	 * completed on any of the coalescing ports. Finish them all at once.
+	 */
+	if (mask & hba_state.ccc_mask) {
+		for (port = 0; port < hba_state.nr_ports; port++)
+			if (hba_state.ccc_ports & (1 << port))
+				port_check_cmds(&port_state[port]);
+	}
+
 	for (port = 0; port < hba_state.nr_ports; port++) {
-		if (mask & (1 << port)) {
+		if ((mask & ~hba_state.ccc_mask) & (1 << port)) {
 			ps = &port_state[port];
 
 			port_intr(ps);
@@ -2260,6 +2460,17 @@ static void ahci_get_params(void)
 		*ahci_timevar[i].ptr = millis_to_hz(v);
 	}
 
+	/* Initialize command completion coalescing values. */
+	v = CCC_COUNT;
+	(void) env_parse("ahci_ccc_count", "d", 0, &v, 0,
+		AHCI_HBA_CCC_CTL_CC_MASK);
+	ahci_ccc_count = (unsigned int) v;
+
+	v = CCC_TIMEOUT;
+	(void) env_parse("ahci_ccc_timeout", "d", 0, &v, 1,
+		AHCI_HBA_CCC_CTL_TV_MASK);
+	ahci_ccc_timeout = (unsigned int) v;
+
 	ahci_device_delay = millis_to_hz(DEVICE_DELAY);
 	ahci_device_checks = (ahci_device_timeout + ahci_device_delay - 1) /
 		ahci_device_delay;
@@ -2572,6 +2783,8 @@ static int ahci_close(dev_t minor)
 	 */
 	blockdriver_mt_set_workers(ps->device, 1);
 
+	port_print_stats(ps);
+
 	if (ps->state == STATE_GOOD_DEV && !(ps->flags & FLAG_BARRIER)) {
 		dprintf(V_INFO, ("%s: flushing write cache\n",
 			ahci_portname(ps)));
@@ -21,6 +21,10 @@
 /* Other hardcoded time values. */
 #define DEVICE_DELAY		100	/* time between device checks (ms) */
 
+/* Command completion coalescing values that can be set with options. */
+#define CCC_COUNT		8	/* completions per interrupt (0=off) */
+#define CCC_TIMEOUT		1	/* max. interrupt delay (ms) */
+
 /* Generic FIS layout. */
 #define ATA_FIS_TYPE			0	/* FIS Type */
 #define 	ATA_FIS_TYPE_H2D	0x27	/* Register - Host to Device */
@@ -84,7 +88,7 @@
 #define ATA_ID_DMADIR_DMADIR	0x8000		/* DMADIR required */
 #define ATA_ID_DMADIR_DMA	0x0400		/* DMA supported (DMADIR) */
 #define ATA_ID_QDEPTH		75		/* NCQ queue depth */
-#define ATA_ID_QDEPTH_MASK	0x000F		/* NCQ queue depth mask */
+#define ATA_ID_QDEPTH_MASK	0x001F		/* NCQ queue depth mask */
 #define ATA_ID_SATA_CAP		76		/* SATA capabilities */
 #define ATA_ID_SATA_CAP_NCQ	0x0100		/* NCQ support */
 #define ATA_ID_SUP0		82		/* Features supported (1/3) */
@@ -149,6 +153,7 @@
 #define AHCI_HBA_CAP	0		/* Host Capabilities */
 #define 	AHCI_HBA_CAP_SNCQ	(1L << 30)	/* Native Cmd Queuing */
 #define 	AHCI_HBA_CAP_SCLO	(1L << 24)	/* Cmd List Override */
+#define 	AHCI_HBA_CAP_CCCS	(1L <<  7)	/* Cmd Compl Coalescing */
 #define 	AHCI_HBA_CAP_NCS_SHIFT	8		/* Nr of Cmd Slots */
 #define 	AHCI_HBA_CAP_NCS_MASK	0x1FL
 #define 	AHCI_HBA_CAP_NP_SHIFT	0		/* Nr of Ports */
@@ -160,6 +165,15 @@
 #define AHCI_HBA_IS	2		/* Interrupt Status */
 #define AHCI_HBA_PI	3		/* Ports Implemented */
 #define AHCI_HBA_VS	4		/* Version */
+#define AHCI_HBA_CCC_CTL	5	/* Cmd Compl Coalescing Control */
+#define 	AHCI_HBA_CCC_CTL_TV_SHIFT	16	/* Timeout Value */
+#define 	AHCI_HBA_CCC_CTL_TV_MASK	0xFFFFL
+#define 	AHCI_HBA_CCC_CTL_CC_SHIFT	8	/* Command Completions */
+#define 	AHCI_HBA_CCC_CTL_CC_MASK	0xFFL
+#define 	AHCI_HBA_CCC_CTL_INT_SHIFT	3	/* Interrupt */
+#define 	AHCI_HBA_CCC_CTL_INT_MASK	0x1FL
+#define 	AHCI_HBA_CCC_CTL_EN	(1L <<  0)	/* Enable */
+#define AHCI_HBA_CCC_PORTS	6	/* Cmd Compl Coalescing Ports */
 #define AHCI_HBA_CAP2	9		/* Host Capabilities Extended */
 
 /* Port constants. */
@@ -188,6 +202,9 @@
 #define 	AHCI_PORT_IE_PRCE	AHCI_PORT_IS_PRCS
 #define 	AHCI_PORT_IE_PCE	AHCI_PORT_IS_PCS
 #define 	AHCI_PORT_IE_NONE	0L
+#define 	AHCI_PORT_IE_CCC	(AHCI_PORT_IE_MASK & \
+	~(AHCI_PORT_IS_DHRS | AHCI_PORT_IS_PSS | AHCI_PORT_IS_SDBS))
+					/* completions through CCC */
 #define AHCI_PORT_CMD	6		/* Command and Status */
 #define 	AHCI_PORT_CMD_CR	(1L << 15)	/* Cmd List Running */
 #define 	AHCI_PORT_CMD_FR	(1L << 14)	/* FIS Recv Running */
@@ -298,6 +315,13 @@ enum {
 #define FLAG_HAS_FUA		0x00000400	/* is WRITE DMA FUA EX sup.? */
 #define FLAG_HAS_NCQ		0x00000800	/* is NCQ supported? */
 #define FLAG_NCQ_MODE		0x00001000	/* issuing NCQ commands? */
+#define FLAG_CCC		0x00002000	/* using CCC for completions? */
+
+/* Number of buckets in the per-port latency histogram. Bucket N counts the
+ * commands that completed in less than 2^N microseconds; the last bucket
+ * counts all slower commands.
+ */
+#define NR_LAT_BUCKETS		24
 
 /* Mapping between devices and ports. */
 #define NO_PORT		-1	/* this device maps to no port */
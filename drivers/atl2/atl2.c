@@ -1041,6 +1041,7 @@ static void atl2_conf(message *m)
 
 	m->m_type = DL_CONF_REPLY;
 	m->DL_STAT = OK;
+	m->DL_CAPS = DL_NOCAPS;
 
 	if ((r = send(m->m_source, m)) != OK)
 		printf("ATL2: unable to send reply (%d)\n", r);
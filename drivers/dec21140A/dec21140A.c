@@ -247,6 +247,7 @@ static void do_conf(const message * mp)
 
   reply_mess.m_type = DL_CONF_REPLY;
   reply_mess.DL_STAT = r;
+  reply_mess.DL_CAPS = DL_NOCAPS;
   if(r == OK){
     *(ether_addr_t *) reply_mess.DL_HWADDR = dep->de_address;
   }
@@ -530,6 +530,7 @@ static void do_init(message *mp)
 		dp_confaddr(dep);
 		reply_mess.m_type = DL_CONF_REPLY;
 		reply_mess.DL_STAT = OK;
+		reply_mess.DL_CAPS = DL_NOCAPS;
 		*(ether_addr_t *) reply_mess.DL_HWADDR = dep->de_address;
 		mess_reply(mp, &reply_mess);
 		return;
@@ -550,6 +551,7 @@ static void do_init(message *mp)
 
 	reply_mess.m_type = DL_CONF_REPLY;
 	reply_mess.DL_STAT = OK;
+	reply_mess.DL_CAPS = DL_NOCAPS;
 	*(ether_addr_t *) reply_mess.DL_HWADDR = dep->de_address;
 
 	mess_reply(mp, &reply_mess);
@@ -32,7 +32,10 @@ static void e1000_init_addr(e1000_t *e);
 static void e1000_init_buf(e1000_t *e);
 static void e1000_reset_hw(e1000_t *e);
 static void e1000_writev_s(message *mp, int from_int);
+static int e1000_map_tx(e1000_t *e, iovec_s_t *iovec, int count,
+	struct vumap_phys *phys);
 static void e1000_readv_s(message *mp, int from_int);
+static void e1000_readv_m(message *mp, int from_int);
 static void e1000_getstat_s(message *mp);
 static void e1000_interrupt(message *mp);
 static int e1000_link_changed(e1000_t *e);
@@ -93,6 +96,7 @@ int main(int argc, char *argv[])
 	{
 	    case DL_WRITEV_S:   e1000_writev_s(&m, FALSE);	break;
 	    case DL_READV_S:    e1000_readv_s(&m, FALSE);	break;
+	    case DL_READV_M:    e1000_readv_m(&m, FALSE);	break;
 	    case DL_CONF:	e1000_init(&m);			break;
 	    case DL_GETSTAT_S:  e1000_getstat_s(&m);		break;
 	    default:
@@ -196,6 +200,7 @@ static void e1000_init(message *mp)
     /* Reply back to INET. */
     reply_mess.m_type  = DL_CONF_REPLY;
     reply_mess.DL_STAT = OK;
+    reply_mess.DL_CAPS = DL_CAP_READV_M;
     *(ether_addr_t *) reply_mess.DL_HWADDR = e->address;
     mess_reply(mp, &reply_mess);
 }
@@ -537,6 +542,7 @@ e1000_t *e;
 	{
 	    panic("failed to allocate TX buffers");
 	}
+	e->tx_buffer_p = tx_buff_p;
 	/* Setup transmit descriptors. */
 	for (i = 0; i < E1000_TXDESC_NR; i++)
 	{
@@ -590,7 +596,8 @@ int from_int;
     e1000_t *e = &e1000_state;
     e1000_tx_desc_t *desc;
     iovec_s_t iovec[E1000_IOVEC_NR];
-    int r, head, tail, i, bytes = 0, size;
+    struct vumap_phys phys[E1000_IOVEC_NR];
+    int r, head, tail, i, bytes = 0, size, pcount;
 
     E1000_DEBUG(3, ("e1000: writev_s(%p,%d)\n", mp, from_int));
 
@@ -627,8 +634,35 @@ int from_int;
 	E1000_DEBUG(4, ("%s: head=%d, tail=%d\n",
 	                 e->name, head, tail));
 
+	/*
+	 * The client does not reuse its buffers before we report the packet
+	 * sent, which we only do once the card is done with the descriptors.
+	 * Let the card fetch large packets straight from the client then.
+	 */
+	if ((pcount = e1000_map_tx(e, iovec, e->tx_message.DL_COUNT,
+				   phys)) > 0)
+	{
+	    for (i = 0; i < pcount; i++)
+	    {
+		desc->buffer  = phys[i].vp_addr;
+		desc->status  = 0;
+		desc->command = 0;
+		desc->length  = phys[i].vp_size;
+
+		/* Marks End-of-Packet. */
+		if (i == pcount - 1)
+		{
+		    desc->command = E1000_TX_CMD_EOP |
+				    E1000_TX_CMD_FCS |
+				    E1000_TX_CMD_RS;
+		}
+		tail   = (tail + 1) % e->tx_desc_count;
+		bytes +=  phys[i].vp_size;
+		desc   = &e->tx_desc[tail];
+	    }
+	}
 	/* Loop vector elements. */
-	for (i = 0; i < e->tx_message.DL_COUNT; i++)
+	else for (i = 0; i < e->tx_message.DL_COUNT; i++)
 	{
 	    size = iovec[i].iov_size < (E1000_IOBUF_SIZE - bytes) ?
 		   iovec[i].iov_size : (E1000_IOBUF_SIZE - bytes);
@@ -645,6 +679,7 @@ int from_int;
 		panic("sys_safecopyfrom() failed: %d", r);
 	    }
 	    /* Mark this descriptor ready. */
+	    desc->buffer  = e->tx_buffer_p + (tail * E1000_IOBUF_SIZE);
 	    desc->status  = 0;
 	    desc->command = 0;
 	    desc->length  = size;
@@ -673,6 +708,47 @@ int from_int;
     reply(e);
 }
 
+/*===========================================================================*
+ *				e1000_map_tx				     *
+ *===========================================================================*/
+static int e1000_map_tx(e, iovec, count, phys)
+e1000_t *e;
+iovec_s_t *iovec;
+int count;
+struct vumap_phys *phys;
+{
+    struct vumap_vir vir[E1000_IOVEC_NR];
+    size_t total = 0, mapped = 0;
+    int i, r, pcount = E1000_IOVEC_NR;
+
+    /*
+     * Look up the physical pages of a packet to transmit. Return the number
+     * of pieces, or zero if the packet should be copied instead.
+     */
+    for (i = 0; i < count; i++)
+    {
+	vir[i].vv_grant = iovec[i].iov_grant;
+	vir[i].vv_size  = iovec[i].iov_size;
+	total += iovec[i].iov_size;
+    }
+    if (total < E1000_ZEROCOPY_MIN || total > E1000_IOBUF_SIZE)
+    {
+	return 0;
+    }
+    if ((r = sys_vumap(e->tx_message.m_source, vir, count, 0, VUA_READ,
+		       phys, &pcount)) != OK)
+    {
+	E1000_DEBUG(3, ("%s: sys_vumap() failed: %d\n", e->name, r));
+	return 0;
+    }
+    /* All of the packet must fit in the physical vector. */
+    for (i = 0; i < pcount; i++)
+    {
+	mapped += phys[i].vp_size;
+    }
+    return mapped == total ? pcount : 0;
+}
+
 /*===========================================================================*
  *				e1000_readv_s				     *
  *===========================================================================*/
@@ -694,6 +770,7 @@ int from_int;
 	e->client     = mp->m_source;
 	e->status    |= E1000_READING;
 	e->rx_size    = 0;
+	e->rx_multi   = FALSE;
 	
 	assert(e->rx_message.DL_COUNT > 0);
 	assert(e->rx_message.DL_COUNT < E1000_IOVEC_NR);
@@ -762,6 +839,76 @@ int from_int;
     reply(e);
 }
 
+/*===========================================================================*
+ *				e1000_readv_m				     *
+ *===========================================================================*/
+static void e1000_readv_m(mp, from_int)
+message *mp;
+int from_int;
+{
+    e1000_t *e = &e1000_state;
+    e1000_rx_desc_t *desc;
+    iovec_s_t *iov;
+    int r, tail, cur, size;
+
+    E1000_DEBUG(3, ("e1000: readv_m(%p,%d)\n", mp, from_int));
+
+    /* Are we called from the interrupt handler? */
+    if (!from_int)
+    {
+	e->rx_message = *mp;
+	e->client     = mp->m_source;
+	e->status    |= E1000_READING;
+	e->rx_multi   = TRUE;
+
+	if ((r = netdriver_batch_init(&e->rx_batch, mp)) != OK)
+	{
+	    panic("netdriver_batch_init() failed: %d", r);
+	}
+    }
+    if (e->status & E1000_READING)
+    {
+	/*
+	 * Hand over as many received packets as there are buffers.
+	 */
+	tail = e1000_reg_read(e, E1000_REG_RDT);
+
+	while ((iov = netdriver_batch_next(&e->rx_batch)) != NULL)
+	{
+	    cur  = (tail + 1) % e->rx_desc_count;
+	    desc = &e->rx_desc[cur];
+
+	    if (!(desc->status & E1000_RX_STATUS_EOP))
+		break;
+
+	    size = iov->iov_size < desc->length ?
+		   iov->iov_size : desc->length;
+
+	    if ((r = sys_safecopyto(e->rx_message.m_source, iov->iov_grant,
+				    0, (vir_bytes) e->rx_buffer +
+				    (cur * E1000_IOBUF_SIZE), size)) != OK)
+	    {
+		panic("sys_safecopyto() failed: %d", r);
+	    }
+	    netdriver_batch_fill(&e->rx_batch, size >= ETH_MIN_PACK_SIZE ?
+				 size : ETH_MIN_PACK_SIZE);
+	    desc->status = 0;
+	    tail = cur;
+	}
+	if (e->rx_batch.nb_filled > 0)
+	{
+	    E1000_DEBUG(2, ("e1000: got %d packets\n",
+			    e->rx_batch.nb_filled));
+
+	    e->status |= E1000_RECEIVED;
+
+	    /* Give all handled descriptors back to the card at once. */
+	    e1000_reg_write(e, E1000_REG_RDT, tail);
+	}
+    }
+    reply(e);
+}
+
 /*===========================================================================*
  *				e1000_getstat_s				     *
  *===========================================================================*/
@@ -826,7 +973,12 @@ message *mp;
 	    e1000_link_changed(e);
 
 	if (cause & (E1000_REG_ICR_RXO | E1000_REG_ICR_RXT))
-	    e1000_readv_s(&e->rx_message, TRUE);
+	{
+	    if (e->rx_multi)
+		e1000_readv_m(&e->rx_message, TRUE);
+	    else
+		e1000_readv_s(&e->rx_message, TRUE);
+	}
 	
 	if ((cause & E1000_REG_ICR_TXQE) ||
 	    (cause & E1000_REG_ICR_TXDW))
@@ -1166,8 +1318,11 @@ e1000_t *e;
 	e->status & E1000_RECEIVED)
     {
 	msg.DL_FLAGS |= DL_PACK_RECV;
-	msg.DL_COUNT = e->rx_size >= ETH_MIN_PACK_SIZE ?
-		       e->rx_size  : ETH_MIN_PACK_SIZE;
+	if (e->rx_multi)
+	    msg.DL_COUNT = netdriver_batch_finish(&e->rx_batch);
+	else
+	    msg.DL_COUNT = e->rx_size >= ETH_MIN_PACK_SIZE ?
+			   e->rx_size  : ETH_MIN_PACK_SIZE;
 
         /* Clear flags. */
 	e->status &= ~(E1000_READING | E1000_RECEIVED);
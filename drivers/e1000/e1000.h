@@ -44,6 +44,9 @@
 /** Size of each I/O buffer per descriptor. */
 #define E1000_IOBUF_SIZE 2048
 
+/** Smallest packet sent from client memory rather than copied. */
+#define E1000_ZEROCOPY_MIN 256
+
 /** Debug verbosity. */
 #define E1000_VERBOSE 1
 
@@ -164,12 +167,15 @@ typedef struct e1000
     phys_bytes tx_desc_p;	  /**< Physical Transmit Descriptor Address. */
     int tx_desc_count;		  /**< Number of Transmit Descriptors. */
     char *tx_buffer;		  /**< Transmit buffer returned by malloc(). */
+    phys_bytes tx_buffer_p;	  /**< Physical Transmit Buffer Address. */
     int tx_buffer_size;		  /**< Size of the transmit buffer. */
 
     int client;                   /**< Process ID being served by e1000. */
     message rx_message;		  /**< Read message received from client. */
     message tx_message;		  /**< Write message received from client. */
     size_t rx_size;		  /**< Size of one packet received. */
+    int rx_multi;		  /**< Pending read is a DL_READV_M. */
+    struct netdriver_batch rx_batch; /**< Buffers of a DL_READV_M. */
 }
 e1000_t;
 
@@ -391,6 +391,7 @@ message *mp;
 
 	reply_mess.m_type = DL_CONF_REPLY;
 	reply_mess.DL_STAT = OK;
+	reply_mess.DL_CAPS = DL_NOCAPS;
 	*(ether_addr_t *) reply_mess.DL_HWADDR = fp->fxp_address;
 
 	mess_reply(mp, &reply_mess);
@@ -463,6 +463,7 @@ static void or_init (message * mp) {
 	/* reply the caller that the configuration succeeded */
 	reply.m_type = DL_CONF_REPLY;
 	reply.DL_STAT = OK;
+	reply.DL_CAPS = DL_NOCAPS;
 	*(ether_addr_t *) reply.DL_HWADDR = orp->or_address;
 	mess_reply (mp, &reply);
 }
@@ -34,6 +34,17 @@ static const char *const name = "virtio-net";
 
 enum queue {RX_Q, TX_Q, CTRL_Q};
 
+/* With multiqueue, receive queue N is RX_Q + 2 * N; all packets are still
+ * sent on TX_Q, so that the host never reorders them.
+ */
+#ifdef CONFIG_SMP
+#define MQ_SUPPORT		1
+#define MAX_QUEUE_PAIRS		4
+#else
+#define MQ_SUPPORT		0
+#define MAX_QUEUE_PAIRS		1
+#endif
+
 /* Number of packets to work with */
 /* TODO: This should be an argument to the driver and possibly also
  *       depend on the queue sizes offered by this device.
@@ -43,6 +54,13 @@ enum queue {RX_Q, TX_Q, CTRL_Q};
 #define MAX_PACK_SIZE		ETH_MAX_PACK_SIZE
 /* Buffer size needed for the payload of BUF_PACKETS */
 #define PACKET_BUF_SZ		(BUF_PACKETS * MAX_PACK_SIZE)
+/* Smaller packets are copied rather than sent from client memory */
+#define ZEROCOPY_MIN		256
+/* Maximum size of a packet the host segments for us */
+#define MAX_TSO_SIZE		DL_TSO_MAX
+/* Offset of the checksum field in a TCP and a UDP header */
+#define TCP_CSUM_OFF		16
+#define UDP_CSUM_OFF		6
 
 struct packet {
 	int idx;
@@ -50,6 +68,10 @@ struct packet {
 	phys_bytes phdr;
 	char *vdata;
 	phys_bytes pdata;
+	int slot;		/* DL_READV_M slot received into, or -1 */
+	int tx_client;		/* sending straight from client memory */
+	int tx_done;		/* ... and the host is done with it */
+	int csum_ok;		/* received with known good checksums */
 	STAILQ_ENTRY(packet) next;
 };
 
@@ -60,6 +82,8 @@ static struct virtio_net_hdr *hdrs_vir;
 static phys_bytes hdrs_phys;
 static struct packet *packets;
 static int in_rx;
+static int in_rxq[MAX_QUEUE_PAIRS];
+static int rx_queues = 1;
 static int started;
 
 /* Packets on this list can be given to the host */
@@ -68,11 +92,37 @@ static STAILQ_HEAD(free_list, packet) free_list;
 /* Packets on this list are to be given to inet */
 static STAILQ_HEAD(recv_list, packet) recv_list;
 
+/* Packets sent from client memory, in the order they were sent */
+static STAILQ_HEAD(tx_list, packet) tx_list;
+
 /* State about pending inet messages */
 static int rx_pending;
 static message pending_rx_msg;
+static int rx_multi;
+static struct netdriver_batch rx_batch;
 static int tx_pending;
 static message pending_tx_msg;
+static endpoint_t client = NONE;
+
+/* State about client buffers handed to the device. Once a client uses
+ * DL_READV_M, the device receives into its buffers rather than ours.
+ */
+static int rx_zc;		/* receiving into client buffers */
+static u32_t rx_held;		/* client slots in the RX queue */
+static u32_t rx_ready;		/* client slots received into, unreported */
+static u32_t rx_csum;		/* ... of which the checksums are good */
+static int tx_hold;		/* client lets us keep sent buffers */
+static int tx_freed;		/* held client packets done, unreported */
+
+/* Offloads negotiated with the host, and whether the client uses them */
+static int tx_csum;		/* host completes TCP, UDP checksums */
+static int tx_tso;		/* host segments TCP/IPv4 packets */
+static int rx_csum_valid;	/* host tells which checksums are good */
+static int offload_req;		/* client sets DL_OFFLOAD */
+#ifdef CONFIG_SMP
+static int mq_pairs;		/* queue pairs to ask the host for */
+static int ctrl_q = CTRL_Q;
+#endif
 
 /* Various state data */
 static u8_t virtio_net_mac[6];
@@ -85,18 +135,35 @@ static int virtio_net_probe(int skip);
 static int virtio_net_config(void);
 static int virtio_net_alloc_bufs(void);
 static void virtio_net_init_queues(void);
-
+static int virtio_net_has(int bit);
+static void virtio_net_start(void);
+static void virtio_net_reset(void);
+#ifdef CONFIG_SMP
+static int virtio_net_set_pairs(int pairs);
+#endif
+
+static int virtio_net_rx_queue(void);
 static void virtio_net_refill_rx_queue(void);
+static int virtio_net_csum_complete(u8_t *data, size_t size,
+				    struct virtio_net_hdr *vhdr);
+static void virtio_net_rx_csum(struct packet *p);
 static void virtio_net_check_queues(void);
 static void virtio_net_check_pending(void);
 
 static void virtio_net_fetch_iovec(iovec_s_t *iov, message *m);
-static int virtio_net_cpy_to_user(message *m);
+static int virtio_net_cpy_to_user(message *m, int *csum_ok);
+static int virtio_net_post_client(iovec_s_t *iov);
+static int virtio_net_fill_batch(void);
+static size_t virtio_net_tx_offload(message *m, struct virtio_net_hdr *vhdr);
+static int virtio_net_map_from_user(message *m, iovec_s_t *iov,
+				    struct vumap_phys *phys, int *cnt,
+				    size_t max);
 static int virtio_net_cpy_from_user(message *m);
 
 static void virtio_net_intr(message *m);
 static void virtio_net_write(message *m);
 static void virtio_net_read(message *m);
+static void virtio_net_read_m(message *m);
 static void virtio_net_conf(message *m);
 static void virtio_net_getstat(message *m);
 
@@ -109,15 +176,31 @@ static int sef_cb_init_fresh(int type, sef_init_info_t *info);
 static void sef_cb_signal_handler(int signo);
 
 
-/* TODO: Features are pretty much ignored */
+/* The control channel is only used to set up multiqueue. Mergeable receive
+ * buffers are not asked for: without guest TSO every frame fits the one
+ * MAX_PACK_SIZE buffer we queue for it, so merging would only add a field to
+ * each header.
+ */
 struct virtio_feature netf[] = {
-	{ "partial csum",	VIRTIO_NET_F_CSUM,	0,	0	},
+	{ "partial csum",	VIRTIO_NET_F_CSUM,	0,	1	},
+	{ "guest partial csum",	VIRTIO_NET_F_GUEST_CSUM, 0,	1	},
 	{ "given mac",		VIRTIO_NET_F_MAC,	0,	0	},
+	{ "host tso4",		VIRTIO_NET_F_HOST_TSO4,	0,	1	},
 	{ "status ",		VIRTIO_NET_F_STATUS,	0,	0	},
-	{ "control channel",	VIRTIO_NET_F_CTRL_VQ,	0,	0	},
-	{ "control channel rx",	VIRTIO_NET_F_CTRL_RX,	0,	0	}
+	{ "control channel",	VIRTIO_NET_F_CTRL_VQ,	0,	MQ_SUPPORT },
+	{ "control channel rx",	VIRTIO_NET_F_CTRL_RX,	0,	0	},
+	{ "mergeable rx bufs",	VIRTIO_NET_F_MRG_RXBUF,	0,	0	},
+	{ "multiqueue",		VIRTIO_NET_F_MQ,	0,	MQ_SUPPORT }
 };
 
+static int
+virtio_net_has(int bit)
+{
+	/* Was the feature negotiated, rather than just offered? */
+	return virtio_host_supports(net_dev, bit) &&
+	       virtio_guest_supports(net_dev, bit);
+}
+
 static int
 virtio_net_probe(int skip)
 {
@@ -133,6 +216,24 @@ virtio_net_probe(int skip)
 	if (virtio_host_supports(net_dev, VIRTIO_NET_F_CTRL_VQ))
 		queues += 1;
 
+#ifdef CONFIG_SMP
+	/* With multiqueue, the control queue comes after all the queue
+	 * pairs the host has, even if we use only some of them.
+	 */
+	if (virtio_net_has(VIRTIO_NET_F_MQ) &&
+	    virtio_net_has(VIRTIO_NET_F_CTRL_VQ)) {
+		mq_pairs = virtio_sread16(net_dev, 8);
+		if (mq_pairs >= VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN &&
+		    mq_pairs <= 4 * MAX_QUEUE_PAIRS) {
+			ctrl_q = 2 * mq_pairs;
+			queues = ctrl_q + 1;
+			if (mq_pairs > MAX_QUEUE_PAIRS)
+				mq_pairs = MAX_QUEUE_PAIRS;
+		} else
+			mq_pairs = 0;
+	}
+#endif
+
 	if (virtio_alloc_queues(net_dev, queues) != OK) {
 		virtio_free_device(net_dev);
 		return ENOMEM;
@@ -174,9 +275,70 @@ virtio_net_config(void)
 	if (virtio_host_supports(net_dev, VIRTIO_NET_F_CTRL_RX))
 		dput(("Host supports control channel for RX"));
 
+	tx_csum = virtio_net_has(VIRTIO_NET_F_CSUM);
+	tx_tso = tx_csum && virtio_net_has(VIRTIO_NET_F_HOST_TSO4);
+	rx_csum_valid = virtio_net_has(VIRTIO_NET_F_GUEST_CSUM);
+
+	dput(("Offloads: tx csum %d, tso %d, rx csum %d", tx_csum, tx_tso,
+	      rx_csum_valid));
+
 	return OK;
 }
 
+#ifdef CONFIG_SMP
+static int
+virtio_net_set_pairs(int pairs)
+{
+	/* Ask the host to spread received flows over the given number of
+	 * queue pairs. The control queue is polled for the answer, as
+	 * this is done only once, when the device starts.
+	 */
+	struct mq_cmd {
+		struct virtio_net_ctrl_hdr hdr;
+		struct virtio_net_ctrl_mq mq;
+		virtio_net_ctrl_ack ack;
+	} __attribute__((packed)) *cmd;
+	struct vumap_phys phys[2];
+	phys_bytes cmd_phys;
+	void *data;
+	int i, r;
+
+	if ((cmd = alloc_contig(sizeof(*cmd), 0, &cmd_phys)) == NULL)
+		return ENOMEM;
+
+	cmd->hdr.class = VIRTIO_NET_CTRL_MQ;
+	cmd->hdr.cmd = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+	cmd->mq.virtqueue_pairs = pairs;
+	cmd->ack = VIRTIO_NET_ERR;
+
+	phys[0].vp_addr = cmd_phys;
+	assert(!(phys[0].vp_addr & 1));
+	phys[0].vp_size = sizeof(cmd->hdr) + sizeof(cmd->mq);
+
+	/* The host writes the ack */
+	phys[1].vp_addr = cmd_phys + offsetof(struct mq_cmd, ack);
+	assert(!(phys[1].vp_addr & 1));
+	phys[1].vp_addr |= 1;
+	phys[1].vp_size = sizeof(cmd->ack);
+
+	virtio_to_queue(net_dev, ctrl_q, phys, 2, cmd);
+
+	for (i = 0; i < 1000; i++) {
+		if (virtio_from_queue(net_dev, ctrl_q, &data) == 0)
+			break;
+		micro_delay(1000);
+	}
+
+	/* If the host never answered, it may still write the ack later */
+	if (i == 1000)
+		return EIO;
+
+	r = cmd->ack == VIRTIO_NET_OK ? OK : EIO;
+	free_contig(cmd, sizeof(*cmd));
+	return r;
+}
+#endif
+
 static int
 virtio_net_alloc_bufs(void)
 {
@@ -214,6 +376,7 @@ virtio_net_init_queues(void)
 	int i;
 	STAILQ_INIT(&free_list);
 	STAILQ_INIT(&recv_list);
+	STAILQ_INIT(&tx_list);
 
 	for (i = 0; i < BUF_PACKETS; i++) {
 		packets[i].idx = i;
@@ -221,16 +384,85 @@ virtio_net_init_queues(void)
 		packets[i].phdr = hdrs_phys + i * sizeof(hdrs_vir[i]);
 		packets[i].vdata = data_vir + i * MAX_PACK_SIZE;
 		packets[i].pdata = data_phys + i * MAX_PACK_SIZE;
+		packets[i].slot = -1;
+		packets[i].tx_client = 0;
+		packets[i].tx_done = 0;
 		STAILQ_INSERT_HEAD(&free_list, &packets[i], next);
 	}
 }
 
+static void
+virtio_net_start(void)
+{
+	/* Let the device go, with as many receive queues as it can use */
+	virtio_device_ready(net_dev);
+#ifdef CONFIG_SMP
+	rx_queues = 1;
+	if (mq_pairs > 1) {
+		if (virtio_net_set_pairs(mq_pairs) == OK)
+			rx_queues = mq_pairs;
+		else
+			dput(("Could not enable multiqueue"));
+	}
+#endif
+	virtio_irq_enable(net_dev);
+}
+
+static void
+virtio_net_reset(void)
+{
+	/* Take back all buffers given to the device. Client buffers may be
+	 * in the queues, and the device could write into them or read from
+	 * them after the client is gone. A single buffer cannot be taken
+	 * back, so the device is reset and started again with empty queues.
+	 * Client packets that were being sent count as done.
+	 */
+	struct packet *p;
+
+	STAILQ_FOREACH(p, &tx_list, next)
+		tx_freed++;
+
+	virtio_restart_device(net_dev);
+
+	memset(data_vir, 0, PACKET_BUF_SZ);
+	memset(hdrs_vir, 0, BUF_PACKETS * sizeof(hdrs_vir[0]));
+	virtio_net_init_queues();
+
+	in_rx = 0;
+	memset(in_rxq, 0, sizeof(in_rxq));
+	rx_held = 0;
+	rx_ready = 0;
+	rx_csum = 0;
+
+	virtio_net_start();
+}
+
+static int
+virtio_net_rx_queue(void)
+{
+	/* Pick the receive queue with the fewest buffers, so that a queue
+	 * the host steers many packets to is refilled first.
+	 */
+	int i, q = 0;
+
+	for (i = 1; i < rx_queues; i++)
+		if (in_rxq[i] < in_rxq[q])
+			q = i;
+
+	in_rxq[q]++;
+	return RX_Q + 2 * q;
+}
+
 static void
 virtio_net_refill_rx_queue(void)
 {
 	struct vumap_phys phys[2];
 	struct packet *p;
 
+	/* The client provides the receive buffers now */
+	if (rx_zc)
+		return;
+
 	while ((in_rx < BUF_PACKETS / 2) && !STAILQ_EMPTY(&free_list)) {
 
 		/* peek */
@@ -250,7 +482,7 @@ virtio_net_refill_rx_queue(void)
 		phys[0].vp_addr |= 1;
 		phys[1].vp_addr |= 1;
 
-		virtio_to_queue(net_dev, RX_Q, phys, 2, p);
+		virtio_to_queue(net_dev, virtio_net_rx_queue(), phys, 2, p);
 		in_rx++;
 
 	}
@@ -261,26 +493,148 @@ virtio_net_refill_rx_queue(void)
 	}
 }
 
+static int
+virtio_net_csum_complete(u8_t *data, size_t size, struct virtio_net_hdr *vhdr)
+{
+	/* The host left the checksum of a received packet partial: the
+	 * field at csum_start + csum_offset holds the sum of the pseudo
+	 * header only. Sum the rest of the packet, which ends where its
+	 * IP header says, into it. Return 1 if that could be done.
+	 */
+	size_t end, i;
+	u32_t sum;
+
+	if (size < ETH_HDR_SIZE + 4 ||
+	    ((data[12] << 8) | data[13]) != ETH_IP_PROTO)
+		return 0;
+
+	end = ETH_HDR_SIZE + ((data[ETH_HDR_SIZE + 2] << 8) |
+			      data[ETH_HDR_SIZE + 3]);
+
+	if (end > size || vhdr->csum_start + vhdr->csum_offset + 2 > end)
+		return 0;
+
+	for (i = vhdr->csum_start, sum = 0; i + 1 < end; i += 2)
+		sum += (data[i] << 8) | data[i + 1];
+	if (i < end)
+		sum += data[i] << 8;
+
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	sum = ~sum & 0xffff;
+
+	/* For UDP, zero means no checksum; 0xffff is the same sum */
+	if (sum == 0)
+		sum = 0xffff;
+
+	data[vhdr->csum_start + vhdr->csum_offset] = sum >> 8;
+	data[vhdr->csum_start + vhdr->csum_offset + 1] = sum & 0xff;
+
+	return 1;
+}
+
+static void
+virtio_net_rx_csum(struct packet *p)
+{
+	/* Find out from its header if the checksums of a received packet
+	 * are good, completing them first if the host left them partial.
+	 * For a packet in a client buffer, the work is done on a copy in
+	 * our own buffer, and the checksum is copied back.
+	 */
+	iovec_s_t *iov;
+	size_t size, off;
+	int r;
+
+	p->csum_ok = 0;
+
+	if (p->vhdr->flags & VIRTIO_NET_HDR_F_DATA_VALID) {
+		p->csum_ok = 1;
+		return;
+	}
+
+	if (!(p->vhdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM))
+		return;
+
+	if (p->slot < 0) {
+		p->csum_ok = virtio_net_csum_complete((u8_t *)p->vdata,
+						      MAX_PACK_SIZE, p->vhdr);
+		return;
+	}
+
+	iov = &rx_batch.nb_iovec[p->slot];
+	size = MAX_PACK_SIZE > iov->iov_size ? iov->iov_size : MAX_PACK_SIZE;
+
+	r = sys_safecopyfrom(rx_batch.nb_client, iov->iov_grant, 0,
+			     (vir_bytes) p->vdata, size);
+	if (r != OK || !virtio_net_csum_complete((u8_t *)p->vdata, size,
+						 p->vhdr))
+		return;
+
+	off = p->vhdr->csum_start + p->vhdr->csum_offset;
+	r = sys_safecopyto(rx_batch.nb_client, iov->iov_grant, off,
+			   (vir_bytes) p->vdata + off, 2);
+	memset(p->vdata, 0, size);
+
+	p->csum_ok = (r == OK);
+}
+
 static void
 virtio_net_check_queues(void)
 {
 	struct packet *p;
+	int q;
 
-	/* Put the received packets into the recv list */
-	while (virtio_from_queue(net_dev, RX_Q, (void **)&p) == 0) {
-		STAILQ_INSERT_TAIL(&recv_list, p, next);
-		in_rx--;
-		virtio_net_stats.ets_packetR++;
+	/* Put the received packets into the recv list, or mark the
+	 * client buffers they were received into as ready.
+	 */
+	for (q = 0; q < rx_queues; q++) {
+		while (virtio_from_queue(net_dev, RX_Q + 2 * q,
+					 (void **)&p) == 0) {
+			virtio_net_stats.ets_packetR++;
+			in_rxq[q]--;
+
+			if (p->slot < 0) {
+				virtio_net_rx_csum(p);
+				STAILQ_INSERT_TAIL(&recv_list, p, next);
+				in_rx--;
+				continue;
+			}
+
+			rx_held &= ~(1UL << p->slot);
+			if (rx_zc) {
+				virtio_net_rx_csum(p);
+				rx_ready |= 1UL << p->slot;
+				if (p->csum_ok)
+					rx_csum |= 1UL << p->slot;
+			}
+			p->slot = -1;
+			memset(p->vhdr, 0, sizeof(*p->vhdr));
+			STAILQ_INSERT_HEAD(&free_list, p, next);
+		}
 	}
 
 	/* Packets from the TX queue just indicated they are free to
 	 * be reused now. inet already knows about them as being sent.
+	 * Packets sent from its own memory are given back to it in the
+	 * order they were sent.
 	 */
 	while (virtio_from_queue(net_dev, TX_Q, (void **)&p) == 0) {
 		memset(p->vhdr, 0, sizeof(*p->vhdr));
+		virtio_net_stats.ets_packetT++;
+		if (p->tx_client) {
+			p->tx_done = 1;
+			continue;
+		}
 		memset(p->vdata, 0, MAX_PACK_SIZE);
 		STAILQ_INSERT_HEAD(&free_list, p, next);
-		virtio_net_stats.ets_packetT++;
+	}
+
+	while ((p = STAILQ_FIRST(&tx_list)) != NULL && p->tx_done) {
+		STAILQ_REMOVE_HEAD(&tx_list, next);
+		p->tx_client = 0;
+		p->tx_done = 0;
+		STAILQ_INSERT_HEAD(&free_list, p, next);
+		tx_freed++;
 	}
 }
 
@@ -294,19 +648,37 @@ virtio_net_check_pending(void)
 	reply.m_type = DL_TASK_REPLY;
 	reply.DL_FLAGS = DL_NOFLAGS;
 	reply.DL_COUNT = 0;
+	reply.DL_RXCSUM = 0;
+	reply.DL_TXDONE = 0;
 
 	/* Pending read and something in recv_list? */
-	if (!STAILQ_EMPTY(&recv_list) && rx_pending) {
+	if (rx_pending && rx_multi &&
+	    (rx_ready != 0 || !STAILQ_EMPTY(&recv_list))) {
+		dst = pending_rx_msg.m_source;
+		if ((reply.DL_COUNT = virtio_net_fill_batch()) > 0) {
+			reply.DL_FLAGS |= DL_PACK_RECV;
+			reply.DL_RXCSUM = rx_batch.nb_csum;
+			rx_pending = 0;
+		}
+	} else if (!STAILQ_EMPTY(&recv_list) && rx_pending) {
 		dst = pending_rx_msg.m_source;
-		reply.DL_COUNT = virtio_net_cpy_to_user(&pending_rx_msg);
+		reply.DL_COUNT = virtio_net_cpy_to_user(&pending_rx_msg,
+							&reply.DL_RXCSUM);
 		reply.DL_FLAGS |= DL_PACK_RECV;
 		rx_pending = 0;
 	}
 
+	/* Sent from client memory, which the client may reuse now? */
+	if (tx_freed > 0) {
+		dst = client;
+		reply.DL_FLAGS |= DL_PACK_DONE;
+		reply.DL_TXDONE = tx_freed;
+		tx_freed = 0;
+	}
+
 	if (!STAILQ_EMPTY(&free_list) && tx_pending) {
 		dst = pending_tx_msg.m_source;
-		virtio_net_cpy_from_user(&pending_tx_msg);
-		reply.DL_FLAGS |= DL_PACK_SEND;
+		reply.DL_FLAGS |= virtio_net_cpy_from_user(&pending_tx_msg);
 		tx_pending = 0;
 	}
 
@@ -328,7 +700,7 @@ virtio_net_fetch_iovec(iovec_s_t *iov, message *m)
 }
 
 static int
-virtio_net_cpy_to_user(message *m)
+virtio_net_cpy_to_user(message *m, int *csum_ok)
 {
 	/* Hmm, this looks so similar to cpy_from_user... TODO */
 	int i, r, size, ivsz;
@@ -363,6 +735,8 @@ virtio_net_cpy_to_user(message *m)
 	if (left != 0)
 		dput(("Uhm... left=%d", left));
 
+	*csum_ok = p->csum_ok;
+
 	/* Clean the packet */
 	memset(p->vhdr, 0, sizeof(*p->vhdr));
 	memset(p->vdata, 0, MAX_PACK_SIZE);
@@ -371,6 +745,119 @@ virtio_net_cpy_to_user(message *m)
 	return bytes;
 }
 
+static int
+virtio_net_post_client(iovec_s_t *iov)
+{
+	/* Hand a client buffer of the current batch to the RX queue, so
+	 * the host puts a packet straight into it.
+	 */
+	struct vumap_vir vir;
+	struct vumap_phys phys[3];
+	struct packet *p;
+	size_t size;
+	int i, r, cnt = 2;
+
+	/* We still need one of our packets for the header */
+	if (STAILQ_EMPTY(&free_list))
+		return ENOMEM;
+
+	vir.vv_grant = iov->iov_grant;
+	vir.vv_size = MAX_PACK_SIZE > iov->iov_size ? iov->iov_size :
+						      MAX_PACK_SIZE;
+
+	r = sys_vumap(rx_batch.nb_client, &vir, 1, 0, VUA_WRITE, &phys[1],
+		      &cnt);
+	if (r != OK)
+		return r;
+
+	for (i = 1, size = 0; i <= cnt; i++) {
+		if (phys[i].vp_addr & 1)
+			return EINVAL;
+		size += phys[i].vp_size;
+	}
+
+	if (size != vir.vv_size)
+		return EINVAL;
+
+	p = STAILQ_FIRST(&free_list);
+	STAILQ_REMOVE_HEAD(&free_list, next);
+	p->slot = iov - rx_batch.nb_iovec;
+
+	phys[0].vp_addr = p->phdr;
+	assert(!(phys[0].vp_addr & 1));
+	phys[0].vp_size = sizeof(struct virtio_net_hdr);
+
+	/* RX queue needs write */
+	for (i = 0; i <= cnt; i++)
+		phys[i].vp_addr |= 1;
+
+	virtio_to_queue(net_dev, virtio_net_rx_queue(), phys, 1 + cnt, p);
+
+	rx_held |= 1UL << p->slot;
+	netdriver_batch_hold(&rx_batch, p->slot);
+
+	return OK;
+}
+
+static int
+virtio_net_fill_batch(void)
+{
+	/* Report the client buffers the host received into, copy packets
+	 * from our own buffers into free client buffers, hand the rest of
+	 * them to the host, and return the number of packets.
+	 */
+	int i, r, size;
+	iovec_s_t *iov;
+	struct packet *p;
+
+	for (i = 0; i < rx_batch.nb_count; i++) {
+		size = MAX_PACK_SIZE > rx_batch.nb_iovec[i].iov_size ?
+			rx_batch.nb_iovec[i].iov_size : MAX_PACK_SIZE;
+
+		if (rx_ready & (1UL << i)) {
+			netdriver_batch_set(&rx_batch, i, size);
+			if (rx_csum & (1UL << i))
+				netdriver_batch_csum(&rx_batch, i);
+		} else if (rx_held & (1UL << i))
+			netdriver_batch_hold(&rx_batch, i);
+	}
+	rx_ready = 0;
+	rx_csum = 0;
+
+	while ((iov = netdriver_batch_next(&rx_batch)) != NULL) {
+		if (STAILQ_EMPTY(&recv_list)) {
+			/* If this fails, the buffer is left for copying */
+			if (virtio_net_post_client(iov) != OK)
+				break;
+			continue;
+		}
+
+		p = STAILQ_FIRST(&recv_list);
+		STAILQ_REMOVE_HEAD(&recv_list, next);
+
+		size = MAX_PACK_SIZE > iov->iov_size ? iov->iov_size :
+						       MAX_PACK_SIZE;
+		r = sys_safecopyto(rx_batch.nb_client, iov->iov_grant, 0,
+				   (vir_bytes) p->vdata, size);
+
+		if (r != OK)
+			panic("%s: copy to %d failed (%d)", name,
+							    rx_batch.nb_client,
+							    r);
+
+		netdriver_batch_fill(&rx_batch, size);
+		if (p->csum_ok)
+			netdriver_batch_csum(&rx_batch, rx_batch.nb_cur);
+
+		/* Clean the packet */
+		memset(p->vhdr, 0, sizeof(*p->vhdr));
+		memset(p->vdata, 0, MAX_PACK_SIZE);
+		STAILQ_INSERT_HEAD(&free_list, p, next);
+	}
+
+	return netdriver_batch_finish(&rx_batch);
+}
+
 static int
 sys_easy_vsafecopy_from(endpoint_t src_proc, iovec_s_t *iov, int count,
 			vir_bytes dst, size_t max, size_t *copied)
@@ -410,17 +897,87 @@ sys_easy_vsafecopy_from(endpoint_t src_proc, iovec_s_t *iov, int count,
 	return OK;
 }
 
+static size_t
+virtio_net_tx_offload(message *m, struct virtio_net_hdr *vhdr)
+{
+	/* Fill in the header of a packet to send with the offloads the
+	 * client asked for, and return the largest size the packet may
+	 * have then.
+	 */
+	if (!offload_req || !tx_csum ||
+	    !(m->DL_OFFLOAD & (DL_OFL_TCPCSUM | DL_OFL_UDPCSUM)))
+		return MAX_PACK_SIZE;
+
+	vhdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+	vhdr->csum_start = m->DL_L4OFF;
+
+	if (m->DL_OFFLOAD & DL_OFL_UDPCSUM) {
+		vhdr->csum_offset = UDP_CSUM_OFF;
+		return MAX_PACK_SIZE;
+	}
+
+	vhdr->csum_offset = TCP_CSUM_OFF;
+
+	if (!tx_tso || !(m->DL_OFFLOAD & DL_OFL_TSO4))
+		return MAX_PACK_SIZE;
+
+	/* The host only takes the header length as a hint */
+	vhdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+	vhdr->gso_size = m->DL_MSS;
+	vhdr->hdr_len = m->DL_L4OFF + 20;
+
+	return MAX_TSO_SIZE;
+}
+
+static int
+virtio_net_map_from_user(message *m, iovec_s_t *iov, struct vumap_phys *phys,
+			 int *cnt, size_t max)
+{
+	/* Look up the physical pages of a packet to send, and return its
+	 * size, or zero if the packet should be copied instead.
+	 */
+	struct vumap_vir vir[NR_IOREQS];
+	size_t size, bytes = 0;
+	int i, r;
+
+	for (i = 0; i < m->DL_COUNT; i++) {
+		vir[i].vv_grant = iov[i].iov_grant;
+		vir[i].vv_size = iov[i].iov_size;
+		bytes += iov[i].iov_size;
+	}
+
+	if (bytes < ZEROCOPY_MIN || bytes > max)
+		return 0;
+
+	*cnt = NR_IOREQS;
+	r = sys_vumap(m->m_source, vir, m->DL_COUNT, 0, VUA_READ, phys, cnt);
+	if (r != OK)
+		return 0;
+
+	/* The lowest bit of an address is taken by the write flag */
+	for (i = 0, size = 0; i < *cnt; i++) {
+		if (phys[i].vp_addr & 1)
+			return 0;
+		size += phys[i].vp_size;
+	}
+
+	return size == bytes ? bytes : 0;
+}
+
 static int
 virtio_net_cpy_from_user(message *m)
 {
 	/* Put user bytes into a a free packet buffer and
 	 * then forward this packet to the TX queue.
+	 * Large packets are sent from user memory directly
+	 * instead, if the client lets us hold on to it.
+	 * Return the flags to reply with.
 	 */
-	int r;
+	int r, i, cnt;
 	iovec_s_t iovec[NR_IOREQS];
-	struct vumap_phys phys[2];
+	struct vumap_phys phys[NR_IOREQS + 1];
 	struct packet *p;
-	size_t bytes;
+	size_t bytes, max;
 
 	/* This should only be called if free_list has some entries */
 	assert(!STAILQ_EMPTY(&free_list));
@@ -430,6 +987,31 @@ virtio_net_cpy_from_user(message *m)
 
 	virtio_net_fetch_iovec(iovec, m);
 
+	phys[0].vp_addr = p->phdr;
+	assert(!(phys[0].vp_addr & 1));
+	phys[0].vp_size = sizeof(struct virtio_net_hdr);
+
+	max = virtio_net_tx_offload(m, p->vhdr);
+
+	if (tx_hold && virtio_net_map_from_user(m, iovec, &phys[1], &cnt,
+						max) > 0) {
+		p->tx_client = 1;
+		STAILQ_INSERT_TAIL(&tx_list, p, next);
+		virtio_to_queue(net_dev, TX_Q, phys, 1 + cnt, p);
+		return DL_PACK_SEND | DL_PACK_HELD;
+	}
+
+	/* Packets to be segmented by the host do not fit our buffers */
+	for (i = 0, bytes = 0; i < m->DL_COUNT; i++)
+		bytes += iovec[i].iov_size;
+
+	if (bytes > MAX_PACK_SIZE) {
+		virtio_net_stats.ets_sendErr++;
+		memset(p->vhdr, 0, sizeof(*p->vhdr));
+		STAILQ_INSERT_HEAD(&free_list, p, next);
+		return DL_PACK_SEND | DL_PACK_ERROR;
+	}
+
 	r = sys_easy_vsafecopy_from(m->m_source, iovec, m->DL_COUNT,
 				    (vir_bytes)p->vdata, MAX_PACK_SIZE,
 				    &bytes);
@@ -437,15 +1019,11 @@ virtio_net_cpy_from_user(message *m)
 	if (r != OK)
 		panic("%s: copy from %d failed", name, m->m_source);
 
-
-	phys[0].vp_addr = p->phdr;
-	assert(!(phys[0].vp_addr & 1));
-	phys[0].vp_size = sizeof(struct virtio_net_hdr);
 	phys[1].vp_addr = p->pdata;
 	assert(!(phys[1].vp_addr & 1));
 	phys[1].vp_size = bytes;
 	virtio_to_queue(net_dev, TX_Q, phys, 2, p);
-	return bytes;
+	return DL_PACK_SEND;
 }
 
 static void
@@ -475,12 +1053,12 @@ virtio_net_write(message *m)
 	reply.m_type = DL_TASK_REPLY;
 	reply.DL_FLAGS = DL_NOFLAGS;
 	reply.DL_COUNT = 0;
-
+	reply.DL_RXCSUM = 0;
+	reply.DL_TXDONE = 0;
 
 	if (!STAILQ_EMPTY(&free_list)) {
 		/* free_list contains at least one  packet, use it */
-		reply.DL_COUNT = virtio_net_cpy_from_user(m);
-		reply.DL_FLAGS = DL_PACK_SEND;
+		reply.DL_FLAGS = virtio_net_cpy_from_user(m);
 	} else {
 		pending_tx_msg = *m;
 		tx_pending = 1;
@@ -499,10 +1077,19 @@ virtio_net_read(message *m)
 	reply.m_type = DL_TASK_REPLY;
 	reply.DL_FLAGS = DL_NOFLAGS;
 	reply.DL_COUNT = 0;
+	reply.DL_RXCSUM = 0;
+
+	/* Buffers still held from DL_READV_M requests are taken back */
+	if (rx_held != 0)
+		virtio_net_reset();
+	rx_multi = 0;
+	rx_zc = 0;
+	rx_ready = 0;
+	rx_csum = 0;
 
 	if (!STAILQ_EMPTY(&recv_list)) {
 		/* recv_list contains at least one  packet, copy it */
-		reply.DL_COUNT = virtio_net_cpy_to_user(m);
+		reply.DL_COUNT = virtio_net_cpy_to_user(m, &reply.DL_RXCSUM);
 		reply.DL_FLAGS = DL_PACK_RECV;
 	} else {
 		rx_pending = 1;
@@ -513,6 +1100,38 @@ virtio_net_read(message *m)
 		panic("%s: send to %d failed (%d)", name, m->m_source, r);
 }
 
+static void
+virtio_net_read_m(message *m)
+{
+	int r;
+	message reply;
+
+	reply.m_type = DL_TASK_REPLY;
+	reply.DL_FLAGS = DL_NOFLAGS;
+	reply.DL_COUNT = 0;
+	reply.DL_RXCSUM = 0;
+
+	if ((r = netdriver_batch_init(&rx_batch, m)) != OK)
+		panic("%s: batch from %d failed (%d)", name, m->m_source, r);
+
+	rx_multi = 1;
+	rx_zc = 1;
+
+	/* Copy all packets received so far that fit, and let the host
+	 * receive into the remaining buffers.
+	 */
+	if ((reply.DL_COUNT = virtio_net_fill_batch()) > 0) {
+		reply.DL_FLAGS = DL_PACK_RECV;
+		reply.DL_RXCSUM = rx_batch.nb_csum;
+	} else {
+		rx_pending = 1;
+		pending_rx_msg = *m;
+	}
+
+	if ((r = send(m->m_source, &reply)) != OK)
+		panic("%s: send to %d failed (%d)", name, m->m_source, r);
+}
+
 static void
 virtio_net_conf(message *m)
 {
@@ -526,9 +1145,28 @@ virtio_net_conf(message *m)
 	 */
 	if (!started) {
 		started = 1;
-		virtio_device_ready(net_dev);
-		virtio_irq_enable(net_dev);
+		virtio_net_start();
+	}
+
+	/* A new client, after the previous one went away. Its buffers
+	 * must not be used anymore, and its requests are forgotten.
+	 */
+	if (client != NONE && m->m_source != client) {
+		if (rx_held != 0 || !STAILQ_EMPTY(&tx_list))
+			virtio_net_reset();
+		tx_freed = 0;
+		rx_pending = 0;
+		tx_pending = 0;
+		rx_multi = 0;
+		rx_zc = 0;
 	}
+	client = m->m_source;
+
+	/* The client tells us whether it fills in DL_OFFLOAD, and whether
+	 * it lets us send from its buffers after replying.
+	 */
+	offload_req = !!(m->DL_MODE & DL_OFFLOAD_REQ);
+	tx_hold = !!(m->DL_MODE & DL_TXHOLD_REQ);
 
 	/* Prepare reply */
 	for (i = 0; i < sizeof(virtio_net_mac); i++)
@@ -536,6 +1174,13 @@ virtio_net_conf(message *m)
 
 	reply.m_type = DL_CONF_REPLY;
 	reply.DL_STAT = OK;
+	reply.DL_CAPS = DL_CAP_READV_M;
+	if (tx_csum)
+		reply.DL_CAPS |= DL_CAP_TXCSUM;
+	if (tx_tso)
+		reply.DL_CAPS |= DL_CAP_TSO4;
+	if (rx_csum_valid)
+		reply.DL_CAPS |= DL_CAP_RXCSUM;
 	reply.DL_COUNT = 0;
 
 	if ((r = send(m->m_source, &reply)) != OK)
@@ -581,6 +1226,9 @@ virtio_net_msg(message *m)
 	case DL_READV_S:
 		virtio_net_read(m);
 		break;
+	case DL_READV_M:
+		virtio_net_read_m(m);
+		break;
 	case DL_CONF:
 		virtio_net_conf(m);
 		break;
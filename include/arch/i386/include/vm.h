@@ -85,6 +85,7 @@ i386/vm.h
 #define CPUID1_ECX_SSSE3	(1L << 9)
 #define CPUID1_ECX_SSE4_1	(1L << 19)
 #define CPUID1_ECX_SSE4_2	(1L << 20)
+#define CPUID1_ECX_TSC_DEADLINE	(1L << 24)	/* APIC timer TSC deadline mode */
 
 #define CPUID_EF_EDX_SYSENTER	(1L << 11)	/* Intel SYSENTER */
 
@@ -28,4 +28,7 @@ void _loadname(const char *_name, message *_msgptr);
 int _len(const char *_s);
 void _begsig(int _dummy);
 
+struct timespec;
+int _minix_clock_read(clockid_t _clock_id, struct timespec *_ts);
+
 #endif /* _LIB_H */
@@ -59,6 +59,8 @@
 #define ITIMER		  64
 #define GETMCONTEXT       67
 #define SETMCONTEXT       68
+#define KQUEUE		  69	/* to VFS */
+#define KEVENT		  70	/* to VFS */
 
 /* Posix signal handling. */
 #define SIGACTION	  71
@@ -70,6 +72,7 @@
 #define REBOOT		  76
 #define SVRCTL		  77
 #define SYSUNAME	  78
+#define PREAD		  79	/* to VFS */
 #define GETDENTS	  80	/* to VFS */
 #define LLSEEK		  81	/* to VFS */
 #define FSTATFS	 	  82	/* to VFS */
@@ -87,6 +90,7 @@
 #define FTRUNCATE	  94	/* to VFS */
 #define FCHMOD		  95	/* to VFS */
 #define FCHOWN		  96	/* to VFS */
+#define PWRITE		  97	/* to VFS */
 #define SPROF             98    /* to PM */
 #define CPROF             99    /* to PM */
 
@@ -94,9 +98,12 @@
 #define PM_NEWEXEC	100	/* from VFS or RS to PM: new exec */
 #define SRV_FORK  	101	/* to PM: special fork call for RS */
 #define EXEC_RESTART	102	/* to PM: final part of exec for RS */
+#define IPCTRACE	103	/* to PM: start/stop/get IPC tracing */
 #define GETPROCNR	104	/* to PM */
 #define ISSETUGID	106	/* to PM: ask if process is tainted */
 #define GETEPINFO_O	107	/* to PM: get pid/uid/gid of an endpoint */
+#define READV		108	/* to VFS: readv() and preadv() */
+#define WRITEV		109	/* to VFS: writev() and pwritev() */
 #define SRV_KILL  	111	/* to PM: special kill call for RS */
 
 #define GCOV_FLUSH	112	/* flush gcov data from server to gcov files */
@@ -257,6 +257,7 @@
 #define DL_GETSTAT_S	(DL_RQ_BASE + 1)
 #define DL_WRITEV_S	(DL_RQ_BASE + 2)
 #define DL_READV_S	(DL_RQ_BASE + 3)
+#define DL_READV_M	(DL_RQ_BASE + 4)	/* receive a batch of packets */
 
 /* Message type for data link layer replies. */
 #define DL_CONF_REPLY	(DL_RS_BASE + 0)
@@ -270,17 +271,69 @@
 #define DL_GRANT	m2_l2
 #define DL_STAT		m3_i1
 #define DL_HWADDR	m3_ca1
+#define DL_CAPS		m3_i2	/* DL_CONF_REPLY: driver capabilities */
+#define DL_OFFLOAD	m2_i1	/* DL_WRITEV_S: offload requests */
+#define DL_L4OFF	m2_i2	/* DL_WRITEV_S: offset of the L4 header */
+#define DL_MSS		m2_s1	/* DL_WRITEV_S: segment size for TSO */
+#define DL_RXCSUM	m2_i1	/* DL_TASK_REPLY: packets with good checksums */
+#define DL_TXDONE	m2_i2	/* DL_TASK_REPLY: held packets now done with */
 
 /* Bits in 'DL_FLAGS' field of DL replies. */
 #  define DL_NOFLAGS		0x00
 #  define DL_PACK_SEND		0x01
 #  define DL_PACK_RECV		0x02
+#  define DL_PACK_HELD		0x04	/* DL_PACK_SEND buffer still in use */
+#  define DL_PACK_DONE		0x08	/* DL_TXDONE is set */
+#  define DL_PACK_ERROR		0x10	/* DL_PACK_SEND packet was dropped */
 
 /* Bits in 'DL_MODE' field of DL requests. */
 #  define DL_NOMODE		0x0
 #  define DL_PROMISC_REQ	0x1
 #  define DL_MULTI_REQ		0x2
 #  define DL_BROAD_REQ		0x4
+#  define DL_OFFLOAD_REQ	0x8	/* DL_OFFLOAD is set in DL_WRITEV_S */
+#  define DL_TXHOLD_REQ		0x10	/* client accepts DL_PACK_HELD */
+
+/* Bits in 'DL_CAPS' field of DL_CONF_REPLY. */
+#  define DL_NOCAPS		0x00
+#  define DL_CAP_READV_M	0x01	/* driver accepts DL_READV_M */
+#  define DL_CAP_TXCSUM		0x02	/* device completes TCP/UDP checksums */
+#  define DL_CAP_RXCSUM		0x04	/* driver sets DL_RXCSUM */
+#  define DL_CAP_TSO4		0x08	/* device segments TCP/IPv4 packets */
+
+/* Bits in 'DL_OFFLOAD' field of DL_WRITEV_S. The packet's TCP (or, with
+ * DL_OFL_UDPCSUM, UDP) checksum field holds the checksum of the pseudo header
+ * only; the device computes the rest over the data from DL_L4OFF on. With
+ * DL_OFL_TSO4 as well, the packet may be larger than the MTU, up to
+ * DL_TSO_MAX bytes, and the device splits it into segments of DL_MSS bytes.
+ */
+#  define DL_OFL_NONE		0x00
+#  define DL_OFL_TCPCSUM	0x01
+#  define DL_OFL_TSO4		0x02
+#  define DL_OFL_UDPCSUM	0x04
+#define DL_TSO_MAX		0x10000
+
+/* In a DL_TASK_REPLY with DL_PACK_RECV, a driver with DL_CAP_RXCSUM sets bit
+ * N of DL_RXCSUM if the checksums of the packet in DL_READV_M slot N (or of
+ * the DL_READV_S packet, for bit 0) are known to be good.
+ */
+
+/* A DL_READV_M request grants (read and write) a vector of at most
+ * DL_READV_M_MAX buffers, one whole packet each. The driver fills one or more
+ * of them, stores each packet's size in its iov_size and zero in that of every
+ * other buffer, and replies with DL_PACK_RECV set and the number of packets in
+ * DL_COUNT. A driver may keep buffers it did not fill, to let the device
+ * receive into them directly; the client must offer such buffers again,
+ * unchanged and in the same slots, in its next DL_READV_M request.
+ */
+#define DL_READV_M_MAX		32
+
+/* A client that sets DL_TXHOLD_REQ in DL_CONF lets the driver acknowledge a
+ * DL_WRITEV_S while the device is still reading the packet from the client's
+ * buffer; the reply then has DL_PACK_HELD set along with DL_PACK_SEND. The
+ * client must leave such buffers alone until a later reply with DL_PACK_DONE
+ * tells it that the oldest DL_TXDONE of them are no longer in use.
+ */
 
 /*===========================================================================*
  *                  SYSTASK request types and field names                    *
@@ -336,6 +389,7 @@
 
 #  define SYS_STIME      (KERNEL_CALL + 39)	/* sys_stime() */
 #  define SYS_SETTIME    (KERNEL_CALL + 40)	/* sys_settime() */
+#  define SYS_IPCTRACE   (KERNEL_CALL + 41)	/* sys_ipctrace() */
 
 #  define SYS_VMCTL      (KERNEL_CALL + 43)	/* sys_vmctl() */
 #  define SYS_SYSCTL     (KERNEL_CALL + 44)	/* sys_sysctl() */
@@ -588,6 +642,14 @@
 #define PROF_CTL_PTR   m7_p1    /* location of info struct */
 #define PROF_MEM_PTR   m7_p2    /* location of profiling data */
 
+/* Field names for SYS_IPCTRACE. */
+#define ITR_ACTION	m7_i1	/* start/stop/get */
+#define ITR_CPU		m7_i2	/* cpu whose ring to get */
+#define ITR_SIZE	m7_i3	/* number of entries that fit in buffer */
+#define ITR_ENDPT	m7_i4	/* endpoint of caller */
+#define ITR_INFO_PTR	m7_p1	/* location of info struct */
+#define ITR_BUF_PTR	m7_p2	/* location of entry buffer */
+
 /* Field names for SYS_READBIOS. */
 #define RDB_SIZE	m2_i1
 #define RDB_ADDR	m2_l1
@@ -878,6 +940,7 @@
 #	define SI_WHAT		m1_i1
 #	define SI_WHERE		m1_p1
 #	define SI_SIZE		m1_i2
+#	define SI_GEN		m1_i3	/* generation seen last (delta) */
 
 /* PM field names */
 /* BRK */
@@ -901,6 +964,26 @@
 #define SEL_ERRORFDS   m8_p3
 #define SEL_TIMEOUT    m8_p4
 
+/* Field names for PREAD, PWRITE, READV and WRITEV (FS). */
+#define PRW_FD		m2_i1	/* file descriptor */
+#define PRW_NBYTES	m2_i2	/* number of bytes (PREAD, PWRITE) */
+#define PRW_IOVCNT	m2_i2	/* number of iovec entries (READV, WRITEV) */
+#define PRW_FLAGS	m2_i3	/* PRW_* flags (READV, WRITEV) */
+#define PRW_BUFFER	m2_p1	/* buffer, or array of struct iovec */
+#define PRW_POS_LO	m2_l1	/* file position, low 32 bits */
+#define PRW_POS_HI	m2_l2	/* file position, high 32 bits */
+
+/* Bits in 'PRW_FLAGS' field of READV and WRITEV requests. */
+#define PRW_AT_POS	0x01	/* use PRW_POS instead of the file position */
+
+/* Field names for KEVENT (FS). */
+#define KEV_FD		m1_i1	/* kqueue file descriptor */
+#define KEV_NCHANGES	m1_i2	/* number of entries in change list */
+#define KEV_NEVENTS	m1_i3	/* number of entries in event list */
+#define KEV_CHANGELIST	m1_p1	/* changes to apply */
+#define KEV_EVENTLIST	m1_p2	/* buffer for returned events */
+#define KEV_TIMEOUT	m1_p3	/* timeout as a struct timespec, or NULL */
+
 /* Field names for the fstatvfs call */
 #define FSTATVFS_FD m1_i1
 #define FSTATVFS_BUF m1_p1
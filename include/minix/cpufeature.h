@@ -24,6 +24,7 @@
 #define _CPUF_I386_MTRR		15
 #define _CPUF_I386_SYSENTER	16	/* Intel SYSENTER instrs */
 #define _CPUF_I386_SYSCALL	17	/* AMD SYSCALL instrs */
+#define _CPUF_I386_TSC_DEADLINE	18	/* APIC timer TSC deadline mode */
 
 int _cpufeature(int featureno);
 
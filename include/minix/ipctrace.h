@@ -0,0 +1,50 @@
+#ifndef _MINIX_IPCTRACE_H
+#define _MINIX_IPCTRACE_H
+
+#include <minix/type.h>
+
+/* Actions for ipctrace(). */
+#define ITR_START	1	/* clear all rings and start tracing */
+#define ITR_STOP	2	/* stop tracing */
+#define ITR_GET		3	/* take the oldest entries from a cpu's ring */
+
+/* Events. */
+#define ITE_SEND	1	/* message sent, delivered or queued */
+#define ITE_RECEIVE	2	/* message delivered to the receiver */
+#define ITE_NOTIFY	3	/* notification sent */
+#define ITE_KCALL	4	/* kernel call started */
+#define ITE_KDONE	5	/* kernel call finished */
+
+/* Event flags. */
+#define ITF_SENDREC	0x01	/* request half of a SENDREC */
+#define ITF_ASYNC	0x02	/* asynchronous message (SENDA) */
+#define ITF_NONBLOCK	0x04	/* nonblocking send */
+
+/* IPC trace entry. For messages, 'type' is the message type. For kernel
+ * calls, 'src' is the caller, 'dst' is SYSTEM and 'type' is the call number
+ * or, for ITE_KDONE, the result.
+ */
+typedef struct {
+  u64_t tsc;			/* cycle counter of the recording cpu */
+  endpoint_t src;		/* sender */
+  endpoint_t dst;		/* receiver */
+  i32_t type;			/* message type, call number or result */
+  u16_t event;			/* one of ITE_xxx */
+  u16_t flags;			/* ITF_xxx flags */
+} ipctrace_entry;		/* (24 bytes) */
+
+/* Information about one cpu's ring, filled in by ITR_GET. */
+typedef struct {
+  u32_t cpus;			/* number of cpus, each with its own ring */
+  u32_t count;			/* number of entries copied out */
+  u32_t lost;			/* entries overwritten since the last get */
+  u64_t freq;			/* cycle counter frequency (Hz) */
+} ipctrace_info;
+
+/* Number of entries in the ring of each cpu. */
+#define IPCTRACE_RING	8192
+
+int ipctrace(int action, int cpu, ipctrace_info *info, ipctrace_entry *buf,
+	size_t count);
+
+#endif /* _MINIX_IPCTRACE_H */
@@ -20,6 +20,8 @@ struct buf {
   char lmfs_dirt;              /* BP_CLEAN or BP_DIRTY */
   char lmfs_count;             /* number of users of this buffer */
   unsigned int lmfs_bytes;     /* Number of bytes allocated in bp */
+  unsigned int lmfs_dirtied;   /* writeback round in which it became dirty */
+  char lmfs_wbfail;            /* timed writeback failed, leave to sync */
 };
 
 int fs_lookup_credentials(vfs_ucred_t *credentials,
@@ -35,6 +37,7 @@ int lmfs_bytes(struct buf *bp);
 int lmfs_bufs_in_use(void);
 int lmfs_nr_bufs(void);
 void lmfs_flushall(void);
+void lmfs_writeback(unsigned int age);
 int lmfs_fs_block_size(void);
 void lmfs_may_use_vmcache(int); 
 void lmfs_set_blocksize(int blocksize, int major); 
@@ -43,6 +46,7 @@ int lmfs_rdwt_err(void);
 void lmfs_buf_pool(int new_nr_bufs);
 struct buf *lmfs_get_block(dev_t dev, block_t block,int only_search);
 void lmfs_invalidate(dev_t device);
+void lmfs_discard(struct buf *bp);
 void lmfs_put_block(struct buf *bp, int block_type);
 void lmfs_rw_scattered(dev_t, struct buf **, int, int);
 
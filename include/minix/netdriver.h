@@ -5,9 +5,31 @@
 
 #include <minix/endpoint.h>
 #include <minix/ipc.h>
+#include <minix/com.h>
+#include <minix/type.h>
+
+/* State of a batched receive (DL_READV_M) request. */
+struct netdriver_batch {
+  endpoint_t nb_client;			/* endpoint that sent the request */
+  cp_grant_id_t nb_grant;		/* grant for the buffer vector */
+  int nb_count;				/* number of buffers offered */
+  int nb_filled;			/* number of buffers filled so far */
+  int nb_cur;				/* buffer last returned by _next */
+  u32_t nb_done;			/* bitmap of filled buffers */
+  u32_t nb_held;			/* bitmap of buffers the driver keeps */
+  u32_t nb_csum;			/* bitmap of packets with good checksums */
+  iovec_s_t nb_iovec[DL_READV_M_MAX];	/* the buffers */
+};
 
 /* Functions defined by netdriver.c: */
 void netdriver_announce(void);
 int netdriver_receive(endpoint_t src, message *m_ptr, int *status_ptr);
+int netdriver_batch_init(struct netdriver_batch *nb, const message *m_ptr);
+iovec_s_t *netdriver_batch_next(struct netdriver_batch *nb);
+void netdriver_batch_fill(struct netdriver_batch *nb, size_t size);
+void netdriver_batch_set(struct netdriver_batch *nb, int slot, size_t size);
+void netdriver_batch_hold(struct netdriver_batch *nb, int slot);
+void netdriver_batch_csum(struct netdriver_batch *nb, int slot);
+int netdriver_batch_finish(struct netdriver_batch *nb);
 
 #endif /* _MINIX_NETDRIVER_H */
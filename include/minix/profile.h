@@ -15,6 +15,18 @@
 #define PROF_RTC	0 /* RTC based profiling */
 #define PROF_NMI	1 /* NMI based profiling, profiles kernel too */
 
+/* The interrupt type may carry a call stack depth in its upper bits. With a
+ * nonzero depth, every sample is followed by a struct sprof_stack and that
+ * many return addresses at most, and user processes are sampled as well.
+ * Stacks are found by following frame pointers, so only code built with
+ * frame pointers yields complete stacks. Only RTC based profiling supports
+ * call stacks.
+ */
+#define PROF_TYPE_MASK		0xff
+#define PROF_DEPTH_SHIFT	8
+#define PROF_DEPTH(type)	(((type) >> PROF_DEPTH_SHIFT) & 0xff)
+#define SPROF_STACK_MAX		32	/* maximum call stack depth */
+
 /* Info struct to be copied to from kernel to user program. */
 struct sprof_info_s {
   int mem_used;
@@ -22,6 +34,7 @@ struct sprof_info_s {
   int idle_samples;
   int system_samples;
   int user_samples;
+  int stack_depth;	/* call stack depth, 0 if no stacks were taken */
 };
 
 /* What a profiling sample looks like (used for sizeof()). */
@@ -35,6 +48,16 @@ struct sprof_proc {
 	char		name[PROC_NAME_LEN];
 };
 
+/* Follows each sample when call stacks are taken, and is followed by 'depth'
+ * return addresses, innermost first.
+ */
+struct sprof_stack {
+	unsigned short	depth;
+	unsigned short	flags;
+};
+
+#define SPROF_STACK_USER	0x01	/* sample of a user process */
+
 #  define PROF_GET         2    /* get call profiling tables */
 #  define PROF_RESET       3    /* reset call profiling tables */
 
@@ -6,6 +6,25 @@
 #include <minix/type.h>
 
 int getsysinfo(endpoint_t who, int what, void *where, size_t size);
+int getsysinfo_delta(endpoint_t who, int what, void *where, size_t size,
+	int *gen);
+
+/* A table that can be retrieved in deltas. Every entry of the table has an
+ * int field holding its generation. The exporting server calls
+ * sysinfo_delta_touch() whenever it changes an entry, which gives the entry
+ * the next generation.
+ */
+struct sysinfo_delta {
+  void *sd_table;		/* the table itself */
+  size_t sd_size;		/* size of an entry */
+  int sd_count;			/* number of entries */
+  size_t sd_genoff;		/* offset of the generation in an entry */
+  int sd_seq;			/* latest generation handed out */
+};
+
+void sysinfo_delta_touch(struct sysinfo_delta *sd, int slot);
+int sysinfo_delta_copy(struct sysinfo_delta *sd, endpoint_t who,
+	vir_bytes where, size_t size, int gen);
 
 /* What system info to retrieve with sysgetinfo(). */
 #define SI_PROC_TAB	   2	/* copy of entire process table */
@@ -14,6 +33,7 @@ int getsysinfo(endpoint_t who, int what, void *where, size_t size);
 #define SI_CALL_STATS	   9	/* system call statistics */
 #define SI_PROCPUB_TAB	   11	/* copy of public entries of process table */
 #define SI_VMNT_TAB        12   /* get vmnt table */
+#define SI_PROC_DELTA	   13	/* changed entries of process table */
 
 #endif
 
@@ -238,6 +238,8 @@ int sys_sprof(int action, int size, int freq, int type, endpoint_t
 int sys_cprof(int action, int size, endpoint_t endpt, void *ctl_ptr,
 	void *mem_ptr);
 int sys_profbuf(void *ctl_ptr, void *mem_ptr);
+int sys_ipctrace(int action, int cpu, endpoint_t endpt, void *info_ptr,
+	void *buf_ptr, int size);
 
 /* machine context */
 int sys_getmcontext(endpoint_t proc, mcontext_t *mcp);
@@ -159,6 +159,24 @@ struct k_randomness {
   } bin[RANDOM_SOURCES];
 };
 
+/* The time, as published by the kernel in a page mapped into every process,
+ * so that it can be read without a system call. The kernel makes 'seq' odd
+ * while it updates the other fields; a reader must retry if it finds 'seq'
+ * odd, or changed after reading the fields.
+ */
+struct kclockinfo {
+	u32_t seq;		/* update sequence number */
+	u32_t hz;		/* clock ticks per second */
+	u32_t uptime;		/* monotonic ticks since boot */
+	u32_t realtime;		/* wall time in ticks since boot */
+	time_t boottime;	/* wall time at boot, in seconds */
+	u64_t tsc;		/* cycle counter at the last update */
+	u32_t tsc_mult;		/* nanoseconds per cycle, scaled */
+	u32_t tsc_limit;	/* max. nanoseconds to add from the counter */
+} __packed;
+
+#define KCLOCK_TSC_SHIFT	24	/* ns = cycles * tsc_mult >> shift */
+
 struct minix_kerninfo {
 	/* Binaries will depend on the offsets etc. in this
 	 * structure, so it can't be changed willy-nilly. In
@@ -176,9 +194,11 @@ struct minix_kerninfo {
 	struct kmessages	*kmessages;
 	struct loadinfo		*loadinfo;
 	struct minix_ipcvecs	*minix_ipcvecs;
+	struct kclockinfo	*kclockinfo;
 } __packed;
 
 #define MINIX_KIF_IPCVECS	(1L << 0)
+#define MINIX_KIF_CLOCKINFO	(1L << 1)
 
 #endif /* _TYPE_H */
 
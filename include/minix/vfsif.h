@@ -16,6 +16,7 @@
 #define REQ_GRANT2		m9_l1 
 #define REQ_GRANT3		m9_l3
 #define REQ_INODE_NR		m9_l1
+#define REQ_IOVCNT		m9_s2
 #define REQ_MEM_SIZE		m9_l5
 #define REQ_MODE		m9_s3
 #define REQ_MODTIME		m9_l3
@@ -66,6 +67,11 @@
 					 * and struct ucred size in m9_s4 (as
 					 * opposed to a REQ_UID). */
 
+/* Largest amount of data a pipe can hold. VFS limits the capacity of each
+ * pipe; the FS serving pipes must be able to hold this much.
+ */
+#define PIPE_MAX_SIZE		(1024 * 1024)
+
 /* VFS/FS error messages */
 #define EENTERMOUNT              (-301)
 #define ELEAVEMOUNT              (-302)
@@ -115,8 +121,10 @@ typedef struct {
 #define REQ_GETDENTS	(VFS_BASE + 31)
 #define REQ_STATVFS	(VFS_BASE + 32)
 #define REQ_PEEK	(VFS_BASE + 33)
+#define REQ_READV	(VFS_BASE + 34)	/* REQ_GRANT is for an iovec_s_t array */
+#define REQ_WRITEV	(VFS_BASE + 35)
 
-#define NREQS			    34
+#define NREQS			    36
 
 #define IS_VFS_RQ(type) (((type) & ~0xff) == VFS_BASE)
 
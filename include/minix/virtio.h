@@ -66,6 +66,12 @@ void virtio_device_ready(struct virtio_device *dev);
 /* Unregister the IRQ and reset the device */
 void virtio_reset_device(struct virtio_device *dev);
 
+/* Reset the device and set it up again with the same features and empty
+ * queues. Whatever was in the queues is forgotten. Call virtio_device_ready()
+ * afterwards.
+ */
+void virtio_restart_device(struct virtio_device *dev);
+
 /* Free the memory used by all queues */
 void virtio_free_queues(struct virtio_device *dev);
 
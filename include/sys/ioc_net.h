@@ -92,6 +92,12 @@ struct msg_control
 #define NWIOGUDSRCVBUF	 _IOR('n', 94, size_t)            /* SO_RCVBUF */
 #define NWIOSUDSRCVBUF	 _IOW('n', 95, size_t)            /* SO_RCVBUF */
 
+/* setsockopt/getsockopt for TCP sockets */
+#define NWIOGTCPSNDBUF	 _IOR('n', 96, size_t)            /* SO_SNDBUF */
+#define NWIOSTCPSNDBUF	 _IOW('n', 97, size_t)            /* SO_SNDBUF */
+#define NWIOGTCPRCVBUF	 _IOR('n', 98, size_t)            /* SO_RCVBUF */
+#define NWIOSTCPRCVBUF	 _IOW('n', 99, size_t)            /* SO_RCVBUF */
+
 #endif /* _NET__IOCTL_H */
 
 /*
@@ -1,6 +1,6 @@
 /* This library provides generic watchdog timer management functionality.
  * The functions operate on a timer queue provided by the caller. Note that
- * the timers must use absolute time to allow sorting. The library provides:
+ * the timers must use absolute time. The library provides:
  *
  *    tmrs_settimer:     (re)set a new watchdog timer in the timers queue 
  *    tmrs_clrtimer:     remove a timer from both the timers queue 
@@ -33,11 +33,33 @@ typedef union { int ta_int; long ta_long; void *ta_ptr; } tmr_arg_t;
 typedef struct timer
 {
   struct timer	*tmr_next;	/* next in a timer chain */
+  struct timer	**tmr_prev;	/* link that points to this timer */
   clock_t 	tmr_exp_time;	/* expiration time */
   tmr_func_t	tmr_func;	/* function to call when expired */
   tmr_arg_t	tmr_arg;	/* random argument */
 } timer_t;
 
+/* A timers queue is a hierarchical timing wheel, so that setting and
+ * clearing a timer take constant time no matter how many timers there are.
+ * Level 0 has a slot for each of the next TMRS_SLOTS clock ticks; each slot
+ * of a higher level covers a whole turn of the level below it. When a level
+ * turns over, the timers in the next slot of the level above are spread out
+ * over the levels below. A zeroed timers_t is an empty queue.
+ */
+#define TMRS_BITS	5
+#define TMRS_SLOTS	(1 << TMRS_BITS)	/* slots per level */
+#define TMRS_LEVELS	6			/* levels in a wheel */
+
+typedef struct timers
+{
+  clock_t	tmrs_now;	/* clock tick the wheel is at */
+  clock_t	tmrs_head;	/* earliest expiration time, if known */
+  int		tmrs_stale;	/* set if tmrs_head must be looked up */
+  int		tmrs_count;	/* number of timers in the queue */
+  u32_t		tmrs_busy[TMRS_LEVELS];	/* bitmaps of slots in use */
+  timer_t	*tmrs_slot[TMRS_LEVELS][TMRS_SLOTS];
+} timers_t;
+
 /* Used when the timer is not active. */
 #define TMR_NEVER    ((clock_t) -1 < 0) ? ((clock_t) LONG_MAX) : ((clock_t) -1)
 #undef TMR_NEVER
@@ -52,15 +74,16 @@ typedef struct timer
  * will be broken.
  */
 #define tmr_inittimer(tp) (void)((tp)->tmr_exp_time = TMR_NEVER, \
-	(tp)->tmr_next = NULL)
+	(tp)->tmr_next = NULL, (tp)->tmr_prev = NULL)
 
 /* The following generic timer management functions are available. They
- * can be used to operate on the lists of timers. Adding a timer to a list 
- * automatically takes care of removing it.
+ * can be used to operate on queues of timers. Adding a timer to a queue
+ * automatically takes care of removing it. The earliest expiration time
+ * they return is 0 if the queue is empty.
  */
-clock_t tmrs_clrtimer(timer_t **tmrs, timer_t *tp, clock_t *new_head);
-void tmrs_exptimers(timer_t **tmrs, clock_t now, clock_t *new_head);
-clock_t tmrs_settimer(timer_t **tmrs, timer_t *tp, clock_t exp_time,
+clock_t tmrs_clrtimer(timers_t *tmrs, timer_t *tp, clock_t *new_head);
+void tmrs_exptimers(timers_t *tmrs, clock_t now, clock_t *new_head);
+clock_t tmrs_settimer(timers_t *tmrs, timer_t *tp, clock_t exp_time,
 	tmr_func_t watchdog, clock_t *new_head);
 
 #define PRINT_STATS(cum_spenttime, cum_instances) {		\
@@ -42,6 +42,27 @@ void arch_timer_int_handler(void)
 	omap3_timer_int_handler();
 }
 
+void arch_stamp_clockinfo(struct kclockinfo *ci)
+{
+	/* The frequency of the free running counter isn't known, so the
+	 * time has clock tick resolution.
+	 */
+	ci->tsc = 0;
+	ci->tsc_mult = 0;
+	ci->tsc_limit = 0;
+}
+
+int arch_timer_sleep(clock_t UNUSED(ticks))
+{
+	/* The timer is periodic; the clock keeps ticking while idle. */
+	return EINVAL;
+}
+
+clock_t arch_timer_wake(clock_t UNUSED(ticks))
+{
+	return 0;
+}
+
 void cycles_accounting_init(void)
 {
 	read_tsc_64(get_cpu_var_ptr(cpu, tsc_ctr_switch));
@@ -102,8 +123,10 @@ void context_stop_idle(void)
 
 	context_stop(get_cpulocal_var_ptr(idle_proc));
 
-	if (is_idle)
+	if (is_idle) {
+		tickless_leave();
 		restart_local_timer();
+	}
 #if SPROFILE
 	if (sprofiling)
 		get_cpulocal_var(idle_interrupted) = 1;
@@ -754,11 +754,13 @@ int arch_phys_map_reply(const int index, const vir_bytes addr)
 		ASSIGN(machine);
 		ASSIGN(kmessages);
 		ASSIGN(loadinfo);
+		ASSIGN(kclockinfo);
 
 		/* adjust the pointers of the functions and the struct
 		 * itself to the user-accessible mapping
 		 */
 		minix_kerninfo.kerninfo_magic = KERNINFO_MAGIC;
+		minix_kerninfo.ki_flags |= MINIX_KIF_CLOCKINFO;
 		minix_kerninfo.minix_feature_flags = minix_feature_flags;
 		minix_kerninfo_user = (vir_bytes) FIXEDPTR(&minix_kerninfo);
 
@@ -93,6 +93,7 @@
 
 #define IA32_APIC_BASE	0x1b
 #define IA32_APIC_BASE_ENABLE_BIT	11
+#define IA32_TSC_DEADLINE	0x6e0
 
 /* FIXME we should spread the irqs across as many priority levels as possible
  * due to buggy hw */
@@ -530,19 +531,52 @@ void lapic_set_timer_one_shot(const u32_t usec)
 {
 	/* sleep in micro seconds */
 	u32_t lvtt;
-	u32_t ticks_per_us;
+	u32_t ticks_per_us, count;
 	const u8_t cpu = cpuid;
 
 	ticks_per_us = (lapic_bus_freq[cpu] / 1000000) * config_apic_timer_x;
 
-	lapic_write(LAPIC_TIMER_ICR, usec * ticks_per_us);
+	/* the longest sleep the counter can hold */
+	if (usec > 0xffffffff / ticks_per_us)
+		count = 0xffffffff;
+	else
+		count = usec * ticks_per_us;
 
 	lvtt = APIC_TDCR_1;
 	lapic_write(LAPIC_TIMER_DCR, lvtt);
 
-	/* configure timer as one-shot */
+	/* configure timer as one-shot, before the count is set, as leaving
+	 * TSC deadline mode disarms the timer
+	 */
 	lvtt = APIC_TIMER_INT_VECTOR;
 	lapic_write(LAPIC_LVTTR, lvtt);
+
+	lapic_write(LAPIC_TIMER_ICR, count);
+}
+
+void lapic_set_timer_deadline(u64_t deadline)
+{
+	/* go off when the cycle counter reaches the deadline; right away if
+	 * it is in the past already
+	 */
+	assert(lapic_tsc_deadline);
+
+	lapic_write(LAPIC_LVTTR, APIC_LVTT_TSC_DEADLINE | APIC_TIMER_INT_VECTOR);
+	ia32_msr_write(IA32_TSC_DEADLINE, ex64hi(deadline), ex64lo(deadline));
+}
+
+int lapic_timer_expired(void)
+{
+	u32_t hi, lo;
+
+	/* a deadline reads as zero once it has passed */
+	if ((lapic_read(LAPIC_LVTTR) & APIC_LVTT_MODE_MASK) ==
+			APIC_LVTT_TSC_DEADLINE) {
+		ia32_msr_read(IA32_TSC_DEADLINE, &hi, &lo);
+		return hi == 0 && lo == 0;
+	}
+
+	return lapic_read(LAPIC_TIMER_CCR) == 0;
 }
 
 void lapic_set_timer_periodic(const unsigned freq)
@@ -687,6 +721,7 @@ int lapic_enable(unsigned cpu)
 			"cannot calibrate LAPIC timer\n");
 		return 0;
 	}
+	lapic_tsc_deadline = _cpufeature(_CPUF_I386_TSC_DEADLINE) ? 1 : 0;
 
 	if (!lapic_enable_in_msr())
 		return 0;
@@ -18,6 +18,8 @@
 #define APIC_LVTT_DS_PENDING	(1 << 12)
 #define APIC_LVTT_MASK		(1 << 16)
 #define APIC_LVTT_TM		(1 << 17)
+#define APIC_LVTT_TSC_DEADLINE	(2 << 17)
+#define APIC_LVTT_MODE_MASK	(3 << 17)
 
 #define APIC_LVT_IIPP_MASK	0x00002000
 #define APIC_LVT_IIPP_AH	0x00002000
@@ -101,6 +103,7 @@ EXTERN vir_bytes lapic_addr;
 EXTERN vir_bytes lapic_eoi_addr;
 EXTERN int ioapic_enabled;
 EXTERN int bsp_lapic_id;
+EXTERN int lapic_tsc_deadline; /* timer can go off at a cycle count */
 
 #define MAX_NR_IOAPICS		32
 #define MAX_IOAPIC_IRQS		64
@@ -154,6 +157,8 @@ int apic_single_cpu_init(void);
 
 void lapic_set_timer_periodic(const unsigned freq);
 void lapic_set_timer_one_shot(const u32_t value);
+void lapic_set_timer_deadline(u64_t deadline);
+int lapic_timer_expired(void);
 void lapic_stop_timer(void);
 void lapic_restart_timer(void);
 
@@ -41,6 +41,9 @@ static u64_t tsc0, tsc1;
 
 static unsigned tsc_per_ms[CONFIG_MAX_CPUS];
 
+/* The boot cpu's cycle counter at its last tick, and cycles per tick. */
+static u64_t tick_tsc, tick_cycles;
+
 /*===========================================================================*
  *				init_8235A_timer			     *
  *===========================================================================*/
@@ -70,6 +73,89 @@ void stop_8253A_timer(void)
 
 void arch_timer_int_handler(void)
 {
+	if (cpu_is_bsp(cpuid))
+		read_tsc_64(&tick_tsc);
+}
+
+int arch_timer_sleep(clock_t ticks)
+{
+	/* Only the local APIC timer can be told to go off later than the
+	 * next tick. Its deadline is set in cycles, so a slowed down APIC
+	 * timer would not be honoured.
+	 */
+#ifdef USE_APIC
+	u64_t deadline, tsc;
+
+	if (!lapic_addr || config_apic_timer_x != 1 || is_zero64(tick_tsc))
+		return EINVAL;
+
+	if (is_zero64(tick_cycles))
+		tick_cycles = div64u64(cpu_get_freq(cpuid), system_hz);
+
+	deadline = add64(tick_tsc, mul64(tick_cycles, cvu64(ticks)));
+
+	if (lapic_tsc_deadline) {
+		lapic_set_timer_deadline(deadline);
+	} else {
+		/* a one-shot count; if it goes off early, the time that
+		 * passed is still accounted for correctly
+		 */
+		read_tsc_64(&tsc);
+		if (cmp64(deadline, tsc) <= 0)
+			return EINVAL;
+		lapic_set_timer_one_shot(div64u(sub64(deadline, tsc),
+			tsc_per_ms[cpuid] / 1000));
+	}
+
+	return OK;
+#else
+	return EINVAL;
+#endif
+}
+
+clock_t arch_timer_wake(clock_t ticks)
+{
+	/* The boot cpu was to sleep for 'ticks' ticks. If its timer went off,
+	 * the last of them is counted by the timer interrupt; otherwise the
+	 * timer is set to go off on the next tick after the time passed.
+	 */
+#ifdef USE_APIC
+	u64_t tsc;
+	clock_t passed;
+
+	read_tsc_64(&tsc);
+	passed = ex64lo(div64(sub64(tsc, tick_tsc), tick_cycles));
+
+	if (passed >= ticks || lapic_timer_expired())
+		return (passed < ticks) ? passed : ticks - 1;
+
+	tick_tsc = add64(tick_tsc, mul64(tick_cycles, cvu64(passed)));
+	lapic_set_timer_one_shot(div64u(sub64(add64(tick_tsc, tick_cycles),
+		tsc), tsc_per_ms[cpuid] / 1000) + 1);
+
+	return passed;
+#else
+	return 0;
+#endif
+}
+
+void arch_stamp_clockinfo(struct kclockinfo *ci)
+{
+	u64_t hz;
+
+	/* The boot cpu keeps the time, so it is mostly its cycle counter
+	 * that is read here. The frequency doesn't change after boot.
+	 */
+	read_tsc_64(&ci->tsc);
+
+	hz = cpu_get_freq(cpuid);
+	if (ci->tsc_mult == 0 && cmp64u(hz, 0) != 0) {
+		ci->tsc_mult = cv64u(div64(mul64u(1000000000,
+			1 << KCLOCK_TSC_SHIFT), hz));
+	}
+
+	/* never run ahead of the next tick */
+	ci->tsc_limit = 1000000000 / system_hz - 1;
 }
 
 static int calib_cpu_handler(irq_hook_t * UNUSED(hook))
@@ -319,8 +405,10 @@ void context_stop_idle(void)
 
 	context_stop(get_cpulocal_var_ptr(idle_proc));
 
-	if (is_idle)
+	if (is_idle) {
+		tickless_leave();
 		restart_local_timer();
+	}
 #if SPROFILE
 	if (sprofiling)
 		get_cpulocal_var(idle_interrupted) = 1;
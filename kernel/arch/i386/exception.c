@@ -114,6 +114,7 @@ static void pagefault( struct proc *pr,
 
 	/* Don't schedule this process until pagefault is handled. */
 	RTS_SET(pr, RTS_PAGEFAULT);
+	pr->p_ipcstat.pagefaults++;
 
 	/* tell Vm about the pagefault */
 	m_pagefault.m_source = pr->p_endpoint;
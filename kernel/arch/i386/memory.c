@@ -929,6 +929,7 @@ int arch_phys_map_reply(const int index, const vir_bytes addr)
 		ASSIGN(machine);
 		ASSIGN(kmessages);
 		ASSIGN(loadinfo);
+		ASSIGN(kclockinfo);
 
 		/* select the right set of IPC routines to map into processes */
 		if(minix_feature_flags & MKF_I386_INTEL_SYSENTER) {
@@ -955,6 +956,7 @@ int arch_phys_map_reply(const int index, const vir_bytes addr)
 		FIXPTR(minix_kerninfo.minix_ipcvecs);
 
 		minix_kerninfo.kerninfo_magic = KERNINFO_MAGIC;
+		minix_kerninfo.ki_flags |= MINIX_KIF_CLOCKINFO;
 		minix_kerninfo.minix_feature_flags = minix_feature_flags;
 		minix_kerninfo_user = (vir_bytes) FIXEDPTR(&minix_kerninfo);
 
@@ -22,6 +22,9 @@
  *   set_realtime:	set wall time since boot in clock ticks
  *   set_adjtime_delta:	set the number of ticks to adjust realtime
  *   get_monotonic:	get monotonic time since boot in clock ticks
+ *   update_clockinfo:	publish the time in the user-mapped clock page
+ *   tickless_enter:	stop the clock ticking while the boot cpu is idle
+ *   tickless_leave:	catch up with the ticks missed while idle
  *   set_timer:		set a watchdog timer (+)
  *   reset_timer:	reset a watchdog timer (+)
  *   read_clock:	read the counter of channel 0 of the 8253A timer
@@ -42,9 +45,14 @@
 #include "watchdog.h"
 #endif
 
+#if SPROFILE
+#include "profile.h"
+#endif
+
 /* Function prototype for PRIVATE functions.
  */ 
 static void load_update(void);
+static void clock_advance(clock_t ticks);
 
 /* The CLOCK's timers queue. The functions in <timers.h> operate on this. 
  * Each system process possesses a single synchronous alarm timer. If other 
@@ -53,7 +61,7 @@ static void load_update(void);
  * via (re)set_timer().
  * When a timer expires its watchdog function is run by the CLOCK task. 
  */
-static timer_t *clock_timers;	/* queue of CLOCK timers */
+static timers_t clock_timers;	/* queue of CLOCK timers */
 static clock_t next_timeout;	/* monotonic time that next timer expires */
 
 /* The time is incremented by the interrupt handler on each clock tick.
@@ -69,6 +77,11 @@ static clock_t realtime = 0;
  */
 static clock_t adjtime_delta = 0;
 
+/* While the boot cpu is idle, its clock does not tick until the next timer
+ * is due. This is the number of ticks it was set to sleep for, or 0.
+ */
+static volatile clock_t tickless_ticks = 0;
+
 /*
  * The boot processor's timer interrupt handler. In addition to non-boot cpus
  * it keeps real time and notifies the clock task if need be.
@@ -94,20 +107,8 @@ int timer_int_handler(void)
 	watchdog_local_timer_ticks++;
 #endif
 
-	if (cpu_is_bsp(cpuid)) {
-		monotonic++;
-
-		/* if adjtime_delta has ticks remaining, apply one to realtime.
-		 * limit changes to every other interrupt.
-		 */
-		if (adjtime_delta != 0 && monotonic & 0x1) {
-			/* go forward or stay behind */
-			realtime += (adjtime_delta > 0) ? 2 : 0;
-			adjtime_delta += (adjtime_delta > 0) ? -1 : +1;
-		} else {
-			realtime++;
-		}
-	}
+	if (cpu_is_bsp(cpuid))
+		clock_advance(1);
 
 	/* Update user and system accounting times. Charge the current process
 	 * for user time. If the current process is not billable, that is, if a
@@ -158,9 +159,10 @@ int timer_int_handler(void)
 	if (cpu_is_bsp(cpuid)) {
 		/* if a timer expired, notify the clock task */
 		if ((next_timeout <= monotonic)) {
-			tmrs_exptimers(&clock_timers, monotonic, NULL);
-			next_timeout = (clock_timers == NULL) ?
-				TMR_NEVER : clock_timers->tmr_exp_time;
+			tmrs_exptimers(&clock_timers, monotonic,
+				&next_timeout);
+			if (next_timeout == 0)
+				next_timeout = TMR_NEVER;
 		}
 
 #ifdef DEBUG_SERIAL
@@ -175,6 +177,121 @@ int timer_int_handler(void)
 	return(1);					/* reenable interrupts */
 }
 
+/*===========================================================================*
+ *				clock_advance				     *
+ *===========================================================================*/
+static void clock_advance(clock_t ticks)
+{
+/* Move the boot cpu's notion of time on by the given number of ticks. This
+ * is one, except after the clock was stopped while idle.
+ */
+	while (ticks-- > 0) {
+		monotonic++;
+
+		/* if adjtime_delta has ticks remaining, apply one to realtime.
+		 * limit changes to every other interrupt.
+		 */
+		if (adjtime_delta != 0 && monotonic & 0x1) {
+			/* go forward or stay behind */
+			realtime += (adjtime_delta > 0) ? 2 : 0;
+			adjtime_delta += (adjtime_delta > 0) ? -1 : +1;
+		} else {
+			realtime++;
+		}
+	}
+
+	update_clockinfo();
+}
+
+/*===========================================================================*
+ *				tickless_enter				     *
+ *===========================================================================*/
+void tickless_enter(void)
+{
+/* The boot cpu is about to halt. Rather than waking it up on every tick for
+ * nothing, let its timer go off when the next kernel timer is due. The time
+ * in the clock page is only kept up to date by the ticks, so this is done
+ * only while all other cpus are idle as well; they wake the boot cpu up as
+ * soon as one of them has work.
+ */
+	clock_t ticks;
+#ifdef CONFIG_SMP
+	unsigned cpu;
+#endif
+
+	assert(cpu_is_bsp(cpuid));
+
+	if (config_no_tickless)
+		goto tick;
+#if SPROFILE
+	if (sprofiling)
+		goto tick;
+#endif
+
+#ifdef CONFIG_SMP
+	/* Tell the others before looking at them, see tickless_leave(). */
+	tickless_ticks = TMR_NEVER;
+	for (cpu = 0; cpu < ncpus; cpu++) {
+		if (!cpu_is_bsp(cpu) && !get_cpu_var(cpu, cpu_is_idle))
+			goto tick;
+	}
+#endif
+
+	/* Sleep until the next timer is due, but wake up every now and then
+	 * anyway, so that the cycle counter arithmetic stays within bounds.
+	 */
+	ticks = next_timeout - monotonic;
+	if (next_timeout == TMR_NEVER || ticks > TICKLESS_MAX_TICKS)
+		ticks = TICKLESS_MAX_TICKS;
+	if (ticks < 2 || arch_timer_sleep(ticks) != OK)
+		goto tick;
+
+	tickless_ticks = ticks;
+	return;
+
+tick:
+	tickless_ticks = 0;
+	restart_local_timer();
+}
+
+/*===========================================================================*
+ *				tickless_leave				     *
+ *===========================================================================*/
+void tickless_leave(void)
+{
+/* A cpu leaves the idle state. If it is the boot cpu and its clock had been
+ * stopped, account for the ticks that went by in the meantime. Any other
+ * cpu wakes a sleeping boot cpu up, as it may need the time or the kernel
+ * timers from now on, and waits until the boot cpu has caught up, lest its
+ * processes read the time from before the boot cpu went to sleep. The boot
+ * cpu needs the kernel lock to catch up.
+ */
+	clock_t ticks;
+
+#ifdef CONFIG_SMP
+	if (!cpu_is_bsp(cpuid)) {
+		if (tickless_ticks != 0) {
+			smp_schedule(bsp_cpu_id);
+			BKL_UNLOCK();
+			while (tickless_ticks != 0)
+				arch_pause();
+			BKL_LOCK();
+		}
+		return;
+	}
+#endif
+
+	if ((ticks = tickless_ticks) == 0)
+		return;
+	tickless_ticks = 0;
+
+	/* The tick on which the timer goes off is counted by the timer
+	 * interrupt handler, which runs next if it did.
+	 */
+	if ((ticks = arch_timer_wake(ticks)) > 0)
+		clock_advance(ticks);
+}
+
 /*===========================================================================*
  *				get_realtime				     *
  *===========================================================================*/
@@ -190,6 +307,7 @@ clock_t get_realtime(void)
 void set_realtime(clock_t newrealtime)
 {
   realtime = newrealtime;
+  update_clockinfo();
 }
 
 /*===========================================================================*
@@ -209,6 +327,28 @@ clock_t get_monotonic(void)
   return(monotonic);
 }
 
+/*===========================================================================*
+ *				update_clockinfo			     *
+ *===========================================================================*/
+void update_clockinfo(void)
+{
+/* Publish the current time in the clock page that is mapped into every
+ * process, so that gettimeofday() and clock_gettime() need no system call.
+ * Readers retry while the sequence number is odd or changes under them.
+ */
+  kclockinfo.seq++;
+  __insn_barrier();
+
+  kclockinfo.hz = system_hz;
+  kclockinfo.uptime = monotonic;
+  kclockinfo.realtime = realtime;
+  kclockinfo.boottime = boottime;
+  arch_stamp_clockinfo(&kclockinfo);
+
+  __insn_barrier();
+  kclockinfo.seq++;
+}
+
 /*===========================================================================*
  *				set_timer				     *
  *===========================================================================*/
@@ -220,8 +360,7 @@ tmr_func_t watchdog;		/* watchdog to be called */
 /* Insert the new timer in the active timers list. Always update the 
  * next timeout time by setting it to the front of the active list.
  */
-  tmrs_settimer(&clock_timers, tp, exp_time, watchdog, NULL);
-  next_timeout = clock_timers->tmr_exp_time;
+  tmrs_settimer(&clock_timers, tp, exp_time, watchdog, &next_timeout);
 }
 
 /*===========================================================================*
@@ -234,9 +373,9 @@ struct timer *tp;		/* pointer to timer structure */
  * active and expired lists. Always update the next timeout time by setting
  * it to the front of the active list.
  */
-  tmrs_clrtimer(&clock_timers, tp, NULL);
-  next_timeout = (clock_timers == NULL) ? 
-	TMR_NEVER : clock_timers->tmr_exp_time;
+  tmrs_clrtimer(&clock_timers, tp, &next_timeout);
+  if (next_timeout == 0)
+	next_timeout = TMR_NEVER;
 }
 
 /*===========================================================================*
@@ -244,7 +383,7 @@ struct timer *tp;		/* pointer to timer structure */
  *===========================================================================*/
 static void load_update(void)
 {
-	u16_t slot;
+	u16_t slot, last;
 	int enqueued = 0, q;
 	struct proc *p;
 	struct proc **rdy_head;
@@ -257,7 +396,12 @@ static void load_update(void)
 	 */
 	slot = (monotonic / system_hz / _LOAD_UNIT_SECS) % _LOAD_HISTORY;
 	if(slot != kloadinfo.proc_last_slot) {
-		kloadinfo.proc_load_history[slot] = 0;
+		/* Clear the slots passed over while the clock did not tick. */
+		last = kloadinfo.proc_last_slot;
+		do {
+			last = (last + 1) % _LOAD_HISTORY;
+			kloadinfo.proc_load_history[last] = 0;
+		} while (last != slot);
 		kloadinfo.proc_last_slot = slot;
 	}
 
@@ -280,6 +424,9 @@ int boot_cpu_init_timer(unsigned freq)
 	if (init_local_timer(freq))
 		return -1;
 
+	/* the cycle counter frequency is known now */
+	update_clockinfo();
+
 	if (register_local_timer_handler(
 				(irq_handler_t) timer_int_handler))
 		return -1;
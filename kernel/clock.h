@@ -15,6 +15,16 @@ void stop_local_timer(void);
 /* let the time tick again with the original settings after it was stopped */
 void restart_local_timer(void);
 int register_local_timer_handler(irq_handler_t handler);
+/* fill in the cycle counter fields of the user-mapped clock page */
+void arch_stamp_clockinfo(struct kclockinfo *ci);
+
+/* The longest the boot cpu's clock is stopped for while idle. */
+#define TICKLESS_MAX_TICKS	(system_hz * 10)
+
+/* let the boot cpu's timer go off 'ticks' ticks after the last one */
+int arch_timer_sleep(clock_t ticks);
+/* rearm the timer after waking up early; return the whole ticks missed */
+clock_t arch_timer_wake(clock_t ticks);
 
 u64_t ms_2_cpu_time(unsigned ms);
 unsigned cpu_time_2_ms(u64_t cpu_time);
@@ -42,6 +42,7 @@
 #define USE_PHYSCOPY  	   1 	/* copy using physical addressing */
 #define USE_MEMSET  	   1	/* write char to a given memory area */
 #define USE_RUNCTL         1	/* control stop flags of a process */
+#define USE_IPCTRACE       1	/* system-wide IPC trace ring */
 
 /* This section contains defines for valuable system resources that are used
  * by device drivers. The number of elements of the vectors is determined by 
@@ -23,6 +23,7 @@ extern struct kinfo kinfo;		  /* kernel information for users */
 extern struct machine machine;		  /* machine information for users */
 extern struct kmessages kmessages;  	  /* diagnostic messages in kernel */
 extern struct loadinfo loadinfo;	  /* status of load average */
+extern struct kclockinfo kclockinfo;	  /* current time for users */
 extern struct minix_kerninfo minix_kerninfo;
 
 EXTERN struct k_randomness krandom; 	/* gather kernel random information */
@@ -57,6 +58,8 @@ EXTERN int verboseflags;
 EXTERN int config_no_apic; /* optionaly turn off apic */
 EXTERN int config_apic_timer_x; /* apic timer slowdown factor */
 #endif
+EXTERN int config_no_tickless; /* optionaly keep ticking when idle */
+EXTERN int config_no_ipctime; /* optionaly do not time IPC blocking */
 
 EXTERN u64_t cpu_hz[CONFIG_MAX_CPUS];
 
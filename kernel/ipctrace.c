@@ -0,0 +1,44 @@
+/* This file contains the system-wide IPC trace ring.
+ *
+ * The entry points into this file are:
+ *   ipctrace_record:	add an event to the ring of the current cpu
+ *
+ * The rings are started, stopped and read out through SYS_IPCTRACE. When the
+ * ring of a cpu is full, the oldest entry is overwritten and counted as lost.
+ */
+
+#include "kernel/kernel.h"
+#include <minix/minlib.h>
+
+#if USE_IPCTRACE
+
+struct ipctrace_ring ipctrace_ring[CONFIG_MAX_CPUS];
+
+/*===========================================================================*
+ *				ipctrace_record				     *
+ *===========================================================================*/
+void ipctrace_record(int event, int flags, endpoint_t src, endpoint_t dst,
+	int type)
+{
+  struct ipctrace_ring *ring;
+  ipctrace_entry *entry;
+
+  ring = &ipctrace_ring[cpuid];
+
+  if (ring->head - ring->tail >= IPCTRACE_RING) {
+	ring->tail++;
+	ring->lost++;
+  }
+
+  entry = &ring->entries[ring->head % IPCTRACE_RING];
+  read_tsc_64(&entry->tsc);
+  entry->src = src;
+  entry->dst = dst;
+  entry->type = type;
+  entry->event = event;
+  entry->flags = flags;
+
+  ring->head++;
+}
+
+#endif /* USE_IPCTRACE */
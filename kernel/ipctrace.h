@@ -0,0 +1,39 @@
+#ifndef IPCTRACE_H
+#define IPCTRACE_H
+
+#include <minix/ipctrace.h>
+
+#if USE_IPCTRACE
+
+/* Each cpu records into its own ring, so recording never waits for another
+ * cpu. Readers run in a kernel call, under the same big kernel lock as all
+ * writers.
+ */
+struct ipctrace_ring {
+  u32_t head;				/* number of entries ever written */
+  u32_t tail;				/* number of entries ever taken */
+  u32_t lost;				/* entries overwritten before taken */
+  ipctrace_entry entries[IPCTRACE_RING];
+};
+
+extern struct ipctrace_ring ipctrace_ring[];
+
+EXTERN int ipctracing;			/* whether IPC tracing is running */
+
+void ipctrace_record(int event, int flags, endpoint_t src, endpoint_t dst,
+	int type);
+
+/* While tracing is off, every trace point costs one test and branch. */
+#define IPCTRACE(event, flags, src, dst, type) 				\
+	do {								\
+		if (ipctracing)						\
+			ipctrace_record(event, flags, src, dst, type);	\
+	} while (0)
+
+#else /* !USE_IPCTRACE */
+
+#define IPCTRACE(event, flags, src, dst, type)
+
+#endif /* USE_IPCTRACE */
+
+#endif /* IPCTRACE_H */
@@ -42,6 +42,7 @@
 #include "kernel/glo.h"		/* global variables */
 #include "kernel/ipc.h"		/* IPC constants */
 #include "kernel/profile.h"		/* system profiling */
+#include "kernel/ipctrace.h"		/* IPC tracing */
 #include "kernel/proc.h"		/* process table */
 #include "kernel/cpulocals.h"		/* CPU-local variables */
 #include "kernel/debug.h"		/* debugging, MUST be last kernel header */
@@ -441,6 +441,18 @@ void cstart()
 	config_apic_timer_x = 1;
 #endif
 
+  value = env_get("no_tickless");
+  if(value)
+	config_no_tickless = atoi(value);
+  else
+	config_no_tickless = 0;
+
+  value = env_get("no_ipctime");
+  if(value)
+	config_no_ipctime = atoi(value);
+  else
+	config_no_ipctime = 0;
+
 #ifdef USE_WATCHDOG
   value = env_get("watchdog");
   if (value)
@@ -55,6 +55,8 @@ struct priv {
   int s_irq_tab[NR_IRQ];
   vir_bytes s_grant_table;	/* grant table address of process, or 0 */
   int s_grant_entries;		/* no. of entries, or 0 */
+
+  unsigned long s_kcalls[NR_SYS_CALLS];	/* kernel calls made, per call */
 };
 
 /* Guard word for task stacks. */
@@ -60,10 +60,17 @@ static int try_async(struct proc *caller_ptr);
 static int try_one(struct proc *src_ptr, struct proc *dst_ptr);
 static struct proc * pick_proc(void);
 static void enqueue_head(struct proc *rp);
+static void ipcstat_block(struct proc *rp);
+static void ipcstat_unblock(struct proc *rp, u64_t *total);
 
 /* all idles share the same idle_priv structure */
 static struct priv idle_priv;
 
+/* IPC trace flags for a message sent by 'sp' with IPC flags 'fl'. */
+#define IPCTRACE_FLAGS(sp, fl)						\
+	(((sp)->p_misc_flags & MF_REPLY_PEND ? ITF_SENDREC : 0) |	\
+	 ((fl) & NON_BLOCKING ? ITF_NONBLOCK : 0))
+
 static void set_idle_name(char * name, int n)
 {
         int i, c;
@@ -129,6 +136,7 @@ void proc_init(void)
 		rp->p_scheduler = NULL;		/* no user space scheduler */
 		rp->p_priority = 0;		/* no priority */
 		rp->p_quantum_size_ms = 0;	/* no quantum size */
+		rp->p_ipcstat.block_start = 0;	/* blocking not timed */
 
 		/* arch-specific initialization */
 		arch_proc_reset(rp);
@@ -193,10 +201,11 @@ static void idle(void)
 #endif
 	{
 		/*
-		 * If the timer has expired while in kernel we must
-		 * rearm it before we go to sleep
+		 * Arm the timer for the next kernel timer that is due, or
+		 * if it has expired while in kernel, rearm it for the next
+		 * tick before we go to sleep
 		 */
-		restart_local_timer();
+		tickless_enter();
 	}
 
 	/* start accounting for the idle time */
@@ -514,6 +523,7 @@ static int do_sync_ipc(struct proc * caller_ptr, /* who made the call */
 	break;
   case NOTIFY:
 	result = mini_notify(caller_ptr, src_dst_e);
+	if (result == OK) caller_ptr->p_ipcstat.notified++;
 	break;
   case SENDNB:
         result = mini_send(caller_ptr, src_dst_e, m_ptr, NON_BLOCKING);
@@ -844,12 +854,20 @@ int mini_send(
 	if (dst_ptr->p_misc_flags & MF_REPLY_PEND)
 		dst_ptr->p_misc_flags &= ~MF_REPLY_PEND;
 
+	ipcstat_unblock(dst_ptr, &dst_ptr->p_ipcstat.receive_cycles);
 	RTS_UNSET(dst_ptr, RTS_RECEIVING);
 
+	if (!(flags & FROM_KERNEL)) caller_ptr->p_ipcstat.sent++;
+	dst_ptr->p_ipcstat.received++;
+
 #if DEBUG_IPC_HOOK
 	hook_ipc_msgsend(&dst_ptr->p_delivermsg, caller_ptr, dst_ptr);
 	hook_ipc_msgrecv(&dst_ptr->p_delivermsg, caller_ptr, dst_ptr);
 #endif
+	IPCTRACE(ITE_SEND, IPCTRACE_FLAGS(caller_ptr, flags),
+		caller_ptr->p_endpoint, dst_e, dst_ptr->p_delivermsg.m_type);
+	IPCTRACE(ITE_RECEIVE, IPCTRACE_FLAGS(caller_ptr, flags),
+		caller_ptr->p_endpoint, dst_e, dst_ptr->p_delivermsg.m_type);
   } else {
 	if(flags & NON_BLOCKING) {
 		return(ENOTREADY);
@@ -874,8 +892,10 @@ int mini_send(
 		caller_ptr->p_misc_flags |= MF_SENDING_FROM_KERNEL;
 	}
 
+	ipcstat_block(caller_ptr);
 	RTS_SET(caller_ptr, RTS_SENDING);
 	caller_ptr->p_sendto_e = dst_e;
+	if (!(flags & FROM_KERNEL)) caller_ptr->p_ipcstat.sent++;
 
 	/* Process is now blocked.  Put in on the destination's queue. */
 	assert(caller_ptr->p_q_link == NULL);
@@ -886,6 +906,8 @@ int mini_send(
 #if DEBUG_IPC_HOOK
 	hook_ipc_msgsend(&caller_ptr->p_sendmsg, caller_ptr, dst_ptr);
 #endif
+	IPCTRACE(ITE_SEND, IPCTRACE_FLAGS(caller_ptr, flags),
+		caller_ptr->p_endpoint, dst_e, caller_ptr->p_sendmsg.m_type);
   }
   return(OK);
 }
@@ -954,6 +976,9 @@ static int mini_receive(struct proc * caller_ptr,
 	    caller_ptr->p_misc_flags |= MF_DELIVERMSG;
 
 	    IPC_STATUS_ADD_CALL(caller_ptr, NOTIFY);
+	    caller_ptr->p_ipcstat.received++;
+	    IPCTRACE(ITE_RECEIVE, 0, hisep, caller_ptr->p_endpoint,
+		NOTIFY_MESSAGE);
 
 	    goto receive_done;
         }
@@ -987,6 +1012,8 @@ static int mini_receive(struct proc * caller_ptr,
 	    caller_ptr->p_delivermsg = sender->p_sendmsg;
 	    caller_ptr->p_delivermsg.m_source = sender->p_endpoint;
 	    caller_ptr->p_misc_flags |= MF_DELIVERMSG;
+	    caller_ptr->p_ipcstat.received++;
+	    ipcstat_unblock(sender, &sender->p_ipcstat.send_cycles);
 	    RTS_UNSET(sender, RTS_SENDING);
 
 	    call = (sender->p_misc_flags & MF_REPLY_PEND ? SENDREC : SEND);
@@ -1007,6 +1034,9 @@ static int mini_receive(struct proc * caller_ptr,
 #if DEBUG_IPC_HOOK
             hook_ipc_msgrecv(&caller_ptr->p_delivermsg, *xpp, caller_ptr);
 #endif
+	    IPCTRACE(ITE_RECEIVE, IPCTRACE_FLAGS(sender, 0),
+		sender->p_endpoint, caller_ptr->p_endpoint,
+		caller_ptr->p_delivermsg.m_type);
 		
             *xpp = sender->p_q_link;		/* remove from queue */
 	    sender->p_q_link = NULL;
@@ -1026,6 +1056,9 @@ static int mini_receive(struct proc * caller_ptr,
       }
 
       caller_ptr->p_getfrom_e = src_e;		
+      /* In a SENDREC, the block began when the send blocked. */
+      if (!RTS_ISSET(caller_ptr, RTS_SENDING))
+	  ipcstat_block(caller_ptr);
       RTS_SET(caller_ptr, RTS_RECEIVING);
       return(OK);
   } else {
@@ -1058,6 +1091,8 @@ int mini_notify(
 
   dst_ptr = proc_addr(dst_p);
 
+  IPCTRACE(ITE_NOTIFY, 0, caller_ptr->p_endpoint, dst_e, NOTIFY_MESSAGE);
+
   /* Check to see if target is blocked waiting for this message. A process 
    * can be both sending and receiving during a SENDREC system call.
    */
@@ -1074,7 +1109,10 @@ int mini_notify(
       dst_ptr->p_misc_flags |= MF_DELIVERMSG;
 
       IPC_STATUS_ADD_CALL(dst_ptr, NOTIFY);
+      dst_ptr->p_ipcstat.received++;
+      ipcstat_unblock(dst_ptr, &dst_ptr->p_ipcstat.receive_cycles);
       RTS_UNSET(dst_ptr, RTS_RECEIVING);
+      IPCTRACE(ITE_RECEIVE, 0, caller_ptr->p_endpoint, dst_e, NOTIFY_MESSAGE);
 
       return(OK);
   } 
@@ -1088,6 +1126,52 @@ int mini_notify(
   return(OK);
 }
 
+/*===========================================================================*
+ *				ipcstat_block				     *
+ *===========================================================================*/
+static void ipcstat_block(struct proc *rp)
+{
+/* The process is about to block in SEND or RECEIVE. */
+  if (config_no_ipctime) return;
+
+  read_tsc_64(&rp->p_ipcstat.block_start);
+}
+
+/*===========================================================================*
+ *				ipcstat_unblock				     *
+ *===========================================================================*/
+static void ipcstat_unblock(struct proc *rp, u64_t *total)
+{
+/* The process is no longer blocked in SEND or RECEIVE. Add the time it was
+ * blocked to the given total. A SENDREC that is done sending blocks on in
+ * RECEIVE, so start counting that from now. A start time of 0 means that
+ * blocking was not timed.
+ */
+  u64_t now;
+
+  if (config_no_ipctime || rp->p_ipcstat.block_start == 0) return;
+
+  read_tsc_64(&now);
+  *total += now - rp->p_ipcstat.block_start;
+  rp->p_ipcstat.block_start = now;
+}
+
+/*===========================================================================*
+ *				ipcstat_clear				     *
+ *===========================================================================*/
+void ipcstat_clear(struct proc *rp)
+{
+/* The process is taken out of SEND or RECEIVE without a message, because it
+ * or its peer is gone or because it is being exec'd. Count the time it was
+ * blocked so far, and stop timing.
+ */
+  if (RTS_ISSET(rp, RTS_SENDING))
+	ipcstat_unblock(rp, &rp->p_ipcstat.send_cycles);
+  else if (RTS_ISSET(rp, RTS_RECEIVING))
+	ipcstat_unblock(rp, &rp->p_ipcstat.receive_cycles);
+  rp->p_ipcstat.block_start = 0;
+}
+
 #define ASCOMPLAIN(caller, entry, field)	\
 	printf("kernel:%s:%d: asyn failed for %s in %s "	\
 	"(%d/%d, tab 0x%lx)\n",__FILE__,__LINE__,	\
@@ -1222,7 +1306,14 @@ int try_deliver_senda(struct proc *caller_ptr,
 		dst_ptr->p_delivermsg.m_source = caller_ptr->p_endpoint;
 		dst_ptr->p_misc_flags |= MF_DELIVERMSG;
 		IPC_STATUS_ADD_CALL(dst_ptr, SENDA);
+		caller_ptr->p_ipcstat.sent++;
+		dst_ptr->p_ipcstat.received++;
+		ipcstat_unblock(dst_ptr, &dst_ptr->p_ipcstat.receive_cycles);
 		RTS_UNSET(dst_ptr, RTS_RECEIVING);
+		IPCTRACE(ITE_SEND, ITF_ASYNC, caller_ptr->p_endpoint,
+			dst_ptr->p_endpoint, tabent.msg.m_type);
+		IPCTRACE(ITE_RECEIVE, ITF_ASYNC, caller_ptr->p_endpoint,
+			dst_ptr->p_endpoint, tabent.msg.m_type);
 	} else if (r == OK) {
 		/* Inform receiver that something is pending */
 		set_sys_bit(priv(dst_ptr)->s_asyn_pending, 
@@ -1398,6 +1489,10 @@ static int try_one(struct proc *src_ptr, struct proc *dst_ptr)
 	dst_ptr->p_delivermsg = tabent.msg;
 	dst_ptr->p_delivermsg.m_source = src_ptr->p_endpoint;
 	dst_ptr->p_misc_flags |= MF_DELIVERMSG;
+	src_ptr->p_ipcstat.sent++;
+	dst_ptr->p_ipcstat.received++;
+	IPCTRACE(ITE_RECEIVE, ITF_ASYNC, src_ptr->p_endpoint,
+		dst_ptr->p_endpoint, tabent.msg.m_type);
 
 store_result:
 	/* Store results for sender */
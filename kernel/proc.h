@@ -64,6 +64,18 @@ struct proc {
   u64_t p_kcall_cycles;		/* kernel cycles caused by this proc (kcall) */
   u64_t p_kipc_cycles;		/* cycles caused by this proc (ipc) */
 
+  /* IPC statistics, kept up to date at all times for procfs */
+  struct {
+	u64_t block_start;	/* when blocking in SEND or RECEIVE began */
+	u64_t send_cycles;	/* time spent blocked in SEND */
+	u64_t receive_cycles;	/* time spent blocked in RECEIVE */
+	unsigned long sent;	/* messages sent */
+	unsigned long received;	/* messages and notifications received */
+	unsigned long notified;	/* notifications sent */
+	unsigned long kcalls;	/* kernel calls made */
+	unsigned long pagefaults; /* page faults passed on to VM */
+  } p_ipcstat;
+
   struct proc *p_nextready;	/* pointer to next ready process */
   struct proc *p_caller_q;	/* head of list of procs wishing to send */
   struct proc *p_q_link;	/* link to next proc wishing to send */
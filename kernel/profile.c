@@ -62,6 +62,9 @@ void stop_profile_clock()
   rm_irq_handler(&profile_clock_hook);
 }
 
+/* Return addresses collected while walking a stack, one set per CPU. */
+static reg_t sprof_frames[CONFIG_MAX_CPUS][SPROF_STACK_MAX];
+
 static void sprof_save_sample(struct proc * p, void * pc)
 {
 	struct sprof_sample *s;
@@ -86,9 +89,56 @@ static void sprof_save_proc(struct proc * p)
 	sprof_info.mem_used += sizeof(struct sprof_proc);
 }
 
+static void sprof_save_stack(reg_t *frames, int depth, int flags)
+{
+	struct sprof_stack *s;
+
+	s = (struct sprof_stack *) (sprof_sample_buffer + sprof_info.mem_used);
+
+	s->depth = depth;
+	s->flags = flags;
+	sprof_info.mem_used += sizeof(struct sprof_stack);
+
+	memcpy(sprof_sample_buffer + sprof_info.mem_used, frames,
+		depth * sizeof(void *));
+	sprof_info.mem_used += depth * sizeof(void *);
+}
+
+static int sprof_unwind(struct proc * p, reg_t *frames)
+{
+/* Follow the saved frame pointers on the stack of a process that was
+ * interrupted in user mode, and collect up to sprof_depth return addresses.
+ * Code built without frame pointers gives a short or bogus chain; since the
+ * stack grows down, a frame that does not lie above the previous one, or one
+ * that cannot be read, ends the walk.
+ */
+  int n = 0;
+#if defined(__i386__)
+  reg_t fp, frame[2];
+
+  if (iskernelp(p))
+	return 0;
+
+  fp = p->p_reg.fp;
+  while (n < sprof_depth && fp != 0) {
+	if (data_copy(p->p_endpoint, fp, KERNEL, (vir_bytes) frame,
+			sizeof(frame)) != OK)
+		break;
+	frames[n++] = frame[1];
+	if (frame[0] <= fp)
+		break;
+	fp = frame[0];
+  }
+#endif
+
+  return n;
+}
+
 static void profile_sample(struct proc * p, void * pc)
 {
 /* This executes on every tick of the CMOS timer. */
+  reg_t *frames;
+  int depth, flags;
 
   /* Are we profiling, and profiling memory not full? */
   if (!sprofiling || sprof_info.mem_used == -1)
@@ -96,31 +146,43 @@ static void profile_sample(struct proc * p, void * pc)
 
   /* Check if enough memory available before writing sample. */
   if (sprof_info.mem_used + sizeof(sprof_info) +
-		  2*sizeof(struct sprof_sample) +
-		  2*sizeof(struct sprof_sample) > sprof_mem_size) {
+		  sizeof(struct sprof_proc) + sizeof(struct sprof_sample) +
+		  sizeof(struct sprof_stack) + sprof_depth * sizeof(void *) >
+		  sprof_mem_size) {
 	sprof_info.mem_used = -1;
 	return;
   }
 
+  sprof_info.total_samples++;
+
   /* Runnable system process? */
-  if (p->p_endpoint == IDLE)
+  if (p->p_endpoint == IDLE) {
 	sprof_info.idle_samples++;
-  else if (p->p_endpoint == KERNEL ||
+	return;
+  } else if (p->p_endpoint == KERNEL ||
 		(priv(p)->s_flags & SYS_PROC && proc_is_runnable(p))) {
-
-	if (!(p->p_misc_flags & MF_SPROF_SEEN)) {
-		p->p_misc_flags |= MF_SPROF_SEEN;
-		sprof_save_proc(p);
-	}
-
-	sprof_save_sample(p, pc);
 	sprof_info.system_samples++;
+	flags = 0;
   } else {
-	/* User process. */
+	/* User process. Only recorded when taking call stacks. */
 	sprof_info.user_samples++;
+	if (sprof_depth == 0 || !proc_is_runnable(p))
+		return;
+	flags = SPROF_STACK_USER;
+  }
+
+  if (!(p->p_misc_flags & MF_SPROF_SEEN)) {
+	p->p_misc_flags |= MF_SPROF_SEEN;
+	sprof_save_proc(p);
+  }
+
+  sprof_save_sample(p, pc);
+
+  if (sprof_depth > 0) {
+	frames = sprof_frames[cpuid];
+	depth = sprof_unwind(p, frames);
+	sprof_save_stack(frames, depth, flags);
   }
-  
-  sprof_info.total_samples++;
 }
 
 /*===========================================================================*
@@ -12,6 +12,7 @@ extern char sprof_sample_buffer[SAMPLE_BUFFER_SIZE];
 
 EXTERN int sprofiling;			/* whether profiling is running */
 EXTERN int sprofiling_type;			/* whether profiling is running */
+EXTERN int sprof_depth;			/* call stack depth, 0 for none */
 EXTERN int sprof_mem_size;		/* available user memory for data */
 EXTERN struct sprof_info_s sprof_info;	/* profiling info for user program */
 EXTERN vir_bytes sprof_data_addr_vir;	/* user address to write data */
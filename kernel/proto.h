@@ -19,6 +19,9 @@ clock_t get_realtime(void);
 void set_realtime(clock_t);
 void set_adjtime_delta(clock_t);
 clock_t get_monotonic(void);
+void update_clockinfo(void);
+void tickless_enter(void);
+void tickless_leave(void);
 void set_timer(struct timer *tp, clock_t t, tmr_func_t f);
 void reset_timer(struct timer *tp);
 void ser_dump_proc(void);
@@ -60,6 +63,7 @@ void unset_notify_pending(struct proc * caller, int src_p);
 int mini_notify(const struct proc *src, endpoint_t dst);
 void enqueue(struct proc *rp);
 void dequeue(struct proc *rp);
+void ipcstat_clear(struct proc *rp);
 void switch_to_user(void);
 void arch_proc_reset(struct proc *rp);
 void arch_proc_setcontext(struct proc *rp, struct stackframe_s *state,
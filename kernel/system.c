@@ -36,6 +36,7 @@
 #include "kernel/vm.h"
 #include "kernel/clock.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <signal.h>
 #include <unistd.h>
@@ -57,6 +58,8 @@ static int (*call_vec[NR_SYS_CALLS])(struct proc * caller, message *m_ptr);
 
 static void kernel_call_finish(struct proc * caller, message *msg, int result)
 {
+  IPCTRACE(ITE_KDONE, 0, caller->p_endpoint, SYSTEM, result);
+
   if(result == VMSUSPEND) {
 	  /* Special case: message has to be saved for handling
 	   * until VM tells us it's allowed. VM has been notified
@@ -99,6 +102,7 @@ static int kernel_call_dispatch(struct proc * caller, message *msg)
 #if DEBUG_IPC_HOOK
 	hook_ipc_msgkcall(msg, caller);
 #endif
+  IPCTRACE(ITE_KCALL, 0, caller->p_endpoint, SYSTEM, msg->m_type);
   call_nr = msg->m_type - KERNEL_CALL;
 
   /* See if the caller made a valid request and try to handle it. */
@@ -112,6 +116,9 @@ static int kernel_call_dispatch(struct proc * caller, message *msg)
 			  call_nr,msg->m_source);
 	  result = ECALLDENIED;			/* illegal message type */
   } else {
+	  caller->p_ipcstat.kcalls++;
+	  priv(caller)->s_kcalls[call_nr]++;
+
 	  /* handle the system call */
 	  if (call_vec[call_nr])
 		  result = (*call_vec[call_nr])(caller, msg);
@@ -247,6 +254,7 @@ void system_init(void)
   map(SYS_SPROF, do_sprofile);         /* start/stop statistical profiling */
   map(SYS_CPROF, do_cprofile);         /* get/reset call profiling data */
   map(SYS_PROFBUF, do_profbuf);        /* announce locations to kernel */
+  map(SYS_IPCTRACE, do_ipctrace);      /* start/stop/get IPC tracing */
 
   /* i386-specific. */
 #if defined(__i386__)
@@ -292,6 +300,7 @@ int priv_id;				/* privilege id */
   }
   rc->p_priv = sp;			    /* assign new slot */
   rc->p_priv->s_proc_nr = proc_nr(rc);	    /* set association */
+  memset(sp->s_kcalls, 0, sizeof(sp->s_kcalls));
 
   return(OK);
 }
@@ -467,6 +476,8 @@ static void clear_ipc(
 /* Clear IPC data for a given process slot. */
   struct proc **xpp;			/* iterate over caller queue */
 
+  ipcstat_clear(rc);
+
   if (RTS_ISSET(rc, RTS_SENDING)) {
       int target_proc;
 
@@ -186,6 +186,11 @@ int do_sprofile(struct proc * caller, message *m_ptr);
 #define do_sprofile NULL
 #endif
 
+int do_ipctrace(struct proc * caller, message *m_ptr);
+#if ! USE_IPCTRACE
+#define do_ipctrace NULL
+#endif
+
 int do_cprofile(struct proc * caller, message *m_ptr);
 int do_profbuf(struct proc * caller, message *m_ptr);
 #if ! CPROFILE
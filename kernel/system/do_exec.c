@@ -44,6 +44,7 @@ int do_exec(struct proc * caller, message * m_ptr)
   arch_proc_init(rp, (u32_t) m_ptr->PR_IP_PTR, (u32_t) m_ptr->PR_STACK_PTR, name);
 
   /* No reply to EXEC call */
+  ipcstat_clear(rp);
   RTS_UNSET(rp, RTS_RECEIVING);
 
   /* Mark fpu_regs contents as not significant, so fpu
@@ -90,6 +90,7 @@ int do_fork(struct proc * caller, message * m_ptr)
   make_zero64(rpc->p_cycles);
   make_zero64(rpc->p_kcall_cycles);
   make_zero64(rpc->p_kipc_cycles);
+  memset(&rpc->p_ipcstat, 0, sizeof(rpc->p_ipcstat));
 
   /* If the parent is a privileged process, take away the privileges from the 
    * child process and inhibit it from running by setting the NO_PRIV flag.
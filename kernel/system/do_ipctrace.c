@@ -0,0 +1,121 @@
+/* The kernel call that is implemented in this file:
+ *   m_type:    SYS_IPCTRACE
+ *
+ * The parameters for this kernel call are:
+ *    m7_i1:    ITR_ACTION        (start/stop/get)
+ *    m7_i2:    ITR_CPU           (cpu whose ring to get)
+ *    m7_i3:    ITR_SIZE          (number of entries that fit in buffer)
+ *    m7_i4:    ITR_ENDPT         (endpoint of caller)
+ *    m7_p1:    ITR_INFO_PTR      (location of info struct)
+ *    m7_p2:    ITR_BUF_PTR       (location of entry buffer)
+ */
+
+#include "kernel/system.h"
+
+#if USE_IPCTRACE
+
+/*===========================================================================*
+ *				get_ring				     *
+ *===========================================================================*/
+static int get_ring(struct proc * caller, message * m_ptr)
+{
+/* Copy out the oldest entries of one cpu's ring, and take them off the ring.
+ * The ring wraps, so this may take two copies.
+ */
+  struct ipctrace_ring *ring;
+  ipctrace_info info;
+  endpoint_t ep;
+  vir_bytes buf;
+  u32_t avail, start, chunk, done;
+  int r, cpu;
+
+  cpu = m_ptr->ITR_CPU;
+  ep = m_ptr->ITR_ENDPT;
+  if (!isokendpt(ep, &r) || m_ptr->ITR_SIZE < 0)
+	return EINVAL;
+#ifdef CONFIG_SMP
+  if (cpu < 0 || cpu >= ncpus)
+#else
+  if (cpu != 0)
+#endif
+	return EINVAL;
+
+  ring = &ipctrace_ring[cpu];
+  avail = ring->head - ring->tail;
+  if (avail > (u32_t) m_ptr->ITR_SIZE)
+	avail = m_ptr->ITR_SIZE;
+
+  buf = (vir_bytes) m_ptr->ITR_BUF_PTR;
+  for (done = 0; done < avail; done += chunk) {
+	start = (ring->tail + done) % IPCTRACE_RING;
+	chunk = MIN(avail - done, IPCTRACE_RING - start);
+
+	if ((r = data_copy_vmcheck(caller, KERNEL,
+	    (vir_bytes) &ring->entries[start], ep,
+	    buf + done * sizeof(ipctrace_entry),
+	    chunk * sizeof(ipctrace_entry))) != OK)
+		return r;
+  }
+
+#ifdef CONFIG_SMP
+  info.cpus = ncpus;
+#else
+  info.cpus = 1;
+#endif
+  info.count = avail;
+  info.lost = ring->lost;
+  info.freq = cpu_get_freq(cpu);
+
+  if ((r = data_copy_vmcheck(caller, KERNEL, (vir_bytes) &info, ep,
+	(vir_bytes) m_ptr->ITR_INFO_PTR, sizeof(info))) != OK)
+	return r;
+
+  /* Only now that everything has been copied, take the entries. */
+  ring->tail += avail;
+  ring->lost = 0;
+
+  return OK;
+}
+
+/*===========================================================================*
+ *				do_ipctrace				     *
+ *===========================================================================*/
+int do_ipctrace(struct proc * caller, message * m_ptr)
+{
+  int cpu;
+
+  switch(m_ptr->ITR_ACTION) {
+
+  case ITR_START:
+	/* Empty all rings, and start recording. */
+	if (ipctracing)
+		return EBUSY;
+
+	for (cpu = 0; cpu < CONFIG_MAX_CPUS; cpu++) {
+		ipctrace_ring[cpu].head = 0;
+		ipctrace_ring[cpu].tail = 0;
+		ipctrace_ring[cpu].lost = 0;
+	}
+
+	ipctracing = 1;
+
+	return OK;
+
+  case ITR_STOP:
+	/* Stop recording. The rings are kept until the next start. */
+	if (!ipctracing)
+		return EBUSY;
+
+	ipctracing = 0;
+
+	return OK;
+
+  case ITR_GET:
+	return get_ring(caller, m_ptr);
+
+  default:
+	return EINVAL;
+  }
+}
+
+#endif /* USE_IPCTRACE */
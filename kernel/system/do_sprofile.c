@@ -6,6 +6,7 @@
  *    m7_i2:    PROF_MEM_SIZE     (available memory for data)
  *    m7_i3:    PROF_FREQ         (requested sample frequency)
  *    m7_i4:    PROF_ENDPT        (endpoint of caller)
+ *    m7_i5:    PROF_INTR_TYPE    (interrupt type and call stack depth)
  *    m7_p1:    PROF_CTL_PTR      (location of info struct)
  *    m7_p2:    PROF_MEM_PTR      (location of memory for data)
  *
@@ -66,14 +67,27 @@ int do_sprofile(struct proc * caller, message * m_ptr)
 	sprof_info.system_samples = 0;
 	sprof_info.user_samples = 0;
 
+	/* Call stacks are taken from the profiling clock interrupt only; the
+	 * NMI handler cannot safely read stacks that may not be mapped in.
+	 */
+	sprof_depth = PROF_DEPTH(m_ptr->PROF_INTR_TYPE);
+	if (sprof_depth > SPROF_STACK_MAX)
+		sprof_depth = SPROF_STACK_MAX;
+#if !defined(__i386__)
+	sprof_depth = 0;
+#endif
+	sprof_info.stack_depth = sprof_depth;
+
 	sprof_mem_size = m_ptr->PROF_MEM_SIZE < SAMPLE_BUFFER_SIZE ?
 				m_ptr->PROF_MEM_SIZE : SAMPLE_BUFFER_SIZE;
 
-	switch (sprofiling_type = m_ptr->PROF_INTR_TYPE) {
+	switch (sprofiling_type = m_ptr->PROF_INTR_TYPE & PROF_TYPE_MASK) {
 		case PROF_RTC:
 			init_profile_clock(m_ptr->PROF_FREQ);
 			break;
 		case PROF_NMI:
+			if (sprof_depth > 0)
+				return EINVAL;
 			err = nmi_watchdog_start_profiling(m_ptr->PROF_FREQ);
 			if (err)
 				return err;
@@ -15,5 +15,6 @@
 int do_stime(struct proc * caller, message * m_ptr)
 {
   boottime= m_ptr->T_BOOTTIME;
+  update_clockinfo();
   return(OK);
 }
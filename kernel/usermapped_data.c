@@ -8,4 +8,5 @@ struct kinfo kinfo;               /* kernel information for users */
 struct machine machine;           /* machine information for users */
 struct kmessages kmessages;       /* diagnostic messages in kernel */
 struct loadinfo loadinfo;        /* status of load average */
+struct kclockinfo kclockinfo;     /* current time for users */
 
@@ -99,6 +99,7 @@ static int _tcp_getsockopt(int sock, int level, int option_name,
 	void *__restrict option_value, socklen_t *__restrict option_len)
 {
 	int i, r, err;
+	size_t size;
 
 	if (level == SOL_SOCKET && option_name == SO_REUSEADDR)
 	{
@@ -123,15 +124,29 @@ static int _tcp_getsockopt(int sock, int level, int option_name,
 	}
 	if (level == SOL_SOCKET && option_name == SO_RCVBUF)
 	{
-		i = 32 * 1024;	/* Receive buffer in the current 
-		              	 * implementation 
-				 */
+		r = ioctl(sock, NWIOGTCPRCVBUF, &size);
+		if (r == 0)
+			i = size;
+		else if (errno == ENOTTY || errno == EBADIOCTL)
+			i = 32 * 1024;	/* fixed receive buffer of the
+					 * TCP service
+					 */
+		else
+			return r;
 		getsockopt_copy(&i, sizeof(i), option_value, option_len);
 		return 0;
 	}
 	if (level == SOL_SOCKET && option_name == SO_SNDBUF)
 	{
-		i = 32 * 1024;	/* Send buffer in the current implementation */
+		r = ioctl(sock, NWIOGTCPSNDBUF, &size);
+		if (r == 0)
+			i = size;
+		else if (errno == ENOTTY || errno == EBADIOCTL)
+			i = 32 * 1024;	/* fixed send buffer of the TCP
+					 * service
+					 */
+		else
+			return r;
 		getsockopt_copy(&i, sizeof(i), option_value, option_len);
 		return 0;
 	}
@@ -0,0 +1,27 @@
+#include <sys/cdefs.h>
+#include "namespace.h"
+
+#ifdef __weak_alias
+#define ipctrace _ipctrace
+__weak_alias(ipctrace, _ipctrace)
+#endif
+
+#include <lib.h>
+#include <minix/ipctrace.h>
+
+int ipctrace(int action,
+		int cpu,
+		ipctrace_info *info,
+		ipctrace_entry *buf,
+		size_t count)
+{
+  message m;
+
+  m.ITR_ACTION		= action;
+  m.ITR_CPU		= cpu;
+  m.ITR_SIZE		= count;
+  m.ITR_INFO_PTR	= (void *) info;
+  m.ITR_BUF_PTR		= (void *) buf;
+
+  return _syscall(PM_PROC_NR, IPCTRACE, &m);
+}
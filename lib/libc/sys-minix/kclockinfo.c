@@ -0,0 +1,99 @@
+/*
+kclockinfo.c
+*/
+
+#include <sys/cdefs.h>
+#include <lib.h>
+#include "namespace.h"
+
+#include <sys/param.h>
+#include <sys/time.h>
+
+extern struct minix_kerninfo *_minix_kerninfo;
+
+/* The time the cycle counter added to the last clock page update that we
+ * read. The kernel stamps the page with the counter of the cpu it runs on,
+ * and another cpu's counter may be behind it, so a later read on another cpu
+ * could otherwise return an earlier time. The counter never adds a whole
+ * tick, so later updates are safe.
+ */
+static u32_t last_seq;
+static u64_t last_delta;
+
+static u64_t read_cycles(void)
+{
+#if defined(__i386__)
+  u32_t lo, hi;
+
+  __asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((u64_t) hi << 32) | lo;
+#else
+  return 0;
+#endif
+}
+
+/* Read a clock from the clock page the kernel maps into every process.
+ * Returns -1 if there is no such page, so that the caller can ask PM.
+ */
+int _minix_clock_read(clockid_t clock_id, struct timespec *ts)
+{
+  volatile struct kclockinfo *ci;
+  u32_t seq, hz, ticks, mult, limit;
+  u64_t tsc, cycles, nsec, delta;
+  time_t boottime;
+
+  if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+	return -1;
+
+  if (_minix_kerninfo == NULL ||
+      !(_minix_kerninfo->ki_flags & MINIX_KIF_CLOCKINFO) ||
+      _minix_kerninfo->kclockinfo == NULL)
+	return -1;
+
+  ci = _minix_kerninfo->kclockinfo;
+  cycles = 0;
+
+  for (;;) {
+	seq = ci->seq;
+	__insn_barrier();
+
+	hz = ci->hz;
+	ticks = (clock_id == CLOCK_MONOTONIC) ? ci->uptime : ci->realtime;
+	boottime = ci->boottime;
+	tsc = ci->tsc;
+	mult = ci->tsc_mult;
+	limit = ci->tsc_limit;
+	if (mult != 0)
+		cycles = read_cycles();
+
+	__insn_barrier();
+	if (!(seq & 1) && ci->seq == seq)
+		break;
+  }
+
+  if (hz == 0)
+	return -1;	/* the kernel hasn't filled in the page yet */
+
+  nsec = (u64_t) (ticks % hz) * 1000000000 / hz;
+
+  /* Add the time since the last clock tick from the cycle counter. */
+  delta = 0;
+  if (mult != 0 && cycles > tsc) {
+	cycles -= tsc;
+	if (cycles >> 32)
+		delta = limit;
+	else
+		delta = MIN((cycles * mult) >> KCLOCK_TSC_SHIFT, limit);
+  }
+
+  if (seq == last_seq && delta < last_delta)
+	delta = last_delta;
+  last_seq = seq;
+  last_delta = delta;
+  nsec += delta;
+
+  ts->tv_sec = boottime + ticks / hz + (time_t) (nsec / 1000000000);
+  ts->tv_nsec = (long) (nsec % 1000000000);
+
+  return 0;
+}
@@ -0,0 +1,22 @@
+#include <sys/cdefs.h>
+#include <lib.h>
+#include "namespace.h"
+
+#include <sys/event.h>
+#include <sys/time.h>
+
+int kevent(int fd, const struct kevent *changelist, size_t nchanges,
+	struct kevent *eventlist, size_t nevents,
+	const struct timespec *timeout)
+{
+  message m;
+
+  m.KEV_FD = fd;
+  m.KEV_CHANGELIST = (char *) __UNCONST(changelist);
+  m.KEV_NCHANGES = nchanges;
+  m.KEV_EVENTLIST = (char *) eventlist;
+  m.KEV_NEVENTS = nevents;
+  m.KEV_TIMEOUT = (char *) __UNCONST(timeout);
+
+  return (_syscall(VFS_PROC_NR, KEVENT, &m));
+}
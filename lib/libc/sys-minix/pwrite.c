@@ -12,43 +12,27 @@ __weak_alias(pwrite, _pwrite)
 
 ssize_t pwrite64(int fd, const void *buffer, size_t nbytes, u64_t where)
 {
-	u64_t here;
-	ssize_t w;
+	message m;
 
-	if (lseek64(fd, make64(0,0), SEEK_CUR, &here) < 0) return(-1);
-	if (lseek64(fd, where, SEEK_SET, NULL) < 0) return(-1);
-	if ((w = write(fd, buffer, nbytes)) < 0) {
-		int e = errno;
-		lseek64(fd, here, SEEK_SET, NULL);
-		errno = e;
-		return(-1);
-	}
+	m.PRW_FD = fd;
+	m.PRW_NBYTES = nbytes;
+	m.PRW_BUFFER = (char *) __UNCONST(buffer);
+	m.PRW_POS_LO = ex64lo(where);
+	m.PRW_POS_HI = ex64hi(where);
 
-	if (lseek64(fd, here, SEEK_SET, NULL) < 0) return(-1);
-
-	return(w);
+	return(_syscall(VFS_PROC_NR, PWRITE, &m));
 }
 
 ssize_t pwrite(int fd, const void *buffer, size_t nbytes, off_t where)
 {
-	off_t here;
-	ssize_t w;
-
-	if((here = lseek(fd, 0, SEEK_CUR)) < 0)
-		return -1;
-
-	if(lseek(fd, where, SEEK_SET) < 0)
-		return -1;
-
-	if((w=write(fd, buffer, nbytes)) < 0) {
-		int e = errno;
-		lseek(fd, here, SEEK_SET);
-		errno = e;
-		return -1;
-	}
+	message m;
 
-	if(lseek(fd, here, SEEK_SET) < 0)
-		return -1;
+	/* The position is sign-extended, so that VFS rejects negative ones. */
+	m.PRW_FD = fd;
+	m.PRW_NBYTES = nbytes;
+	m.PRW_BUFFER = (char *) __UNCONST(buffer);
+	m.PRW_POS_LO = where;
+	m.PRW_POS_HI = (where < 0 ? -1 : 0);
 
-	return w;
+	return(_syscall(VFS_PROC_NR, PWRITE, &m));
 }
@@ -81,7 +81,8 @@ int setsockopt(int sock, int level, int option_name,
 static int _tcp_setsockopt(int sock, int level, int option_name,
 	const void *option_value, socklen_t option_len)
 {
-	int i;
+	int i, r;
+	size_t size;
 
 	if (level == SOL_SOCKET && option_name == SO_REUSEADDR)
 	{
@@ -127,16 +128,22 @@ static int _tcp_setsockopt(int sock, int level, int option_name,
 			return -1;
 		}
 		i= *(const int *)option_value;
+		if (i <= 0)
+		{
+			errno= EINVAL;
+			return -1;
+		}
+		size= i;
+		r= ioctl(sock, NWIOSTCPRCVBUF, &size);
+		if (r != -1 || (errno != ENOTTY && errno != EBADIOCTL))
+			return r;
+
+		/* The TCP service has a fixed receive buffer of 32K. */
 		if (i > 32*1024)
 		{
-			/* The receive buffer is limited to 32K at the moment.
-			 */
 			errno= ENOSYS;
 			return -1;
 		}
-		/* There is no way to reduce the receive buffer, do we have to
-		 * let this call fail for smaller buffers?
-		 */
 		return 0;
 	}
 	if (level == SOL_SOCKET && option_name == SO_SNDBUF)
@@ -147,16 +154,22 @@ static int _tcp_setsockopt(int sock, int level, int option_name,
 			return -1;
 		}
 		i= *(const int *)option_value;
+		if (i <= 0)
+		{
+			errno= EINVAL;
+			return -1;
+		}
+		size= i;
+		r= ioctl(sock, NWIOSTCPSNDBUF, &size);
+		if (r != -1 || (errno != ENOTTY && errno != EBADIOCTL))
+			return r;
+
+		/* The TCP service has a fixed send buffer of 32K. */
 		if (i > 32*1024)
 		{
-			/* The send buffer is limited to 32K at the moment.
-			 */
 			errno= ENOSYS;
 			return -1;
 		}
-		/* There is no way to reduce the send buffer, do we have to
-		 * let this call fail for smaller buffers?
-		 */
 		return 0;
 	}
 	if (level == IPPROTO_TCP && option_name == TCP_NODELAY)
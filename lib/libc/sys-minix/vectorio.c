@@ -20,8 +20,19 @@ __weak_alias(writev, _writev)
 __weak_alias(readv, _readv)
 #endif
 
+static ssize_t vectorio_single(int fildes, void *buf, size_t len,
+	int readwrite, int at_pos, off_t offset)
+{
+	if (readwrite == VECTORIO_READ)
+		return at_pos ? pread(fildes, buf, len, offset) :
+			read(fildes, buf, len);
+	else
+		return at_pos ? pwrite(fildes, buf, len, offset) :
+			write(fildes, buf, len);
+}
+
 static ssize_t vectorio_buffer(int fildes, const struct iovec *iov, 
-	int iovcnt, int readwrite, ssize_t totallen)
+	int iovcnt, int readwrite, int at_pos, off_t offset, ssize_t totallen)
 {
 	char *buffer;
 	int iovidx, errno_saved;
@@ -37,7 +48,8 @@ static ssize_t vectorio_buffer(int fildes, const struct iovec *iov,
 	{
 		case VECTORIO_READ:
 			/* first read, then copy buffers (only part read) */
-			r = read(fildes, buffer, totallen);
+			r = vectorio_single(fildes, buffer, totallen, readwrite,
+				at_pos, offset);
 
 			copied = 0;
 			iovidx = 0;
@@ -62,7 +74,8 @@ static ssize_t vectorio_buffer(int fildes, const struct iovec *iov,
 			}
 			assert(copied == totallen);
 
-			r = write(fildes, buffer, totallen);
+			r = vectorio_single(fildes, buffer, totallen, readwrite,
+				at_pos, offset);
 			break;
 
 		default:        
@@ -80,13 +93,14 @@ static ssize_t vectorio_buffer(int fildes, const struct iovec *iov,
 }
 
 static ssize_t vectorio(int fildes, const struct iovec *iov, 
-	int iovcnt, int readwrite)
+	int iovcnt, int readwrite, int at_pos, off_t offset)
 {
-	int i;
-	ssize_t totallen;
+	message m;
+	int i, errno_saved;
+	ssize_t totallen, r;
 
 	/* parameter sanity checks */
-	if (iovcnt > IOV_MAX)
+	if (iovcnt < 0 || iovcnt > IOV_MAX || (at_pos && offset < 0))
 	{
 		errno = EINVAL;
 		return -1;
@@ -115,21 +129,51 @@ static ssize_t vectorio(int fildes, const struct iovec *iov,
 	if (totallen == 0)
 		return 0;
 
+	/* a single buffer needs no vector */
+	if (iovcnt == 1)
+		return vectorio_single(fildes, iov[0].iov_base,
+			iov[0].iov_len, readwrite, at_pos, offset);
+
+	m.PRW_FD = fildes;
+	m.PRW_BUFFER = (char *) __UNCONST(iov);
+	m.PRW_IOVCNT = iovcnt;
+	m.PRW_FLAGS = at_pos ? PRW_AT_POS : 0;
+	m.PRW_POS_LO = offset;
+	m.PRW_POS_HI = 0;
+
+	errno_saved = errno;
+	r = _syscall(VFS_PROC_NR,
+		(readwrite == VECTORIO_READ) ? READV : WRITEV, &m);
+	if (r >= 0 || errno != ENOSYS)
+		return r;
+	errno = errno_saved;
+
 	/* 
-	 * there aught to be a system call here; instead we use an intermediate 
-	 * buffer; this is preferred over multiple read/write calls because 
-	 * this function has to be atomic
+	 * VFS only does vectors on files and block devices; for anything
+	 * else, we use an intermediate buffer; this is preferred over
+	 * multiple read/write calls because this function has to be atomic
 	 */
-	return vectorio_buffer(fildes, iov, iovcnt, readwrite, totallen);
+	return vectorio_buffer(fildes, iov, iovcnt, readwrite, at_pos, offset,
+		totallen);
 }
 
 ssize_t readv(int fildes, const struct iovec *iov, int iovcnt)
 {
-	return vectorio(fildes, iov, iovcnt, VECTORIO_READ);	
+	return vectorio(fildes, iov, iovcnt, VECTORIO_READ, 0, 0);	
 }
 
 ssize_t writev(int fildes, const struct iovec *iov, int iovcnt)
 {
-	return vectorio(fildes, iov, iovcnt, VECTORIO_WRITE);	
+	return vectorio(fildes, iov, iovcnt, VECTORIO_WRITE, 0, 0);	
+}
+
+ssize_t preadv(int fildes, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	return vectorio(fildes, iov, iovcnt, VECTORIO_READ, 1, offset);
+}
+
+ssize_t pwritev(int fildes, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	return vectorio(fildes, iov, iovcnt, VECTORIO_WRITE, 1, offset);
 }
 
@@ -166,7 +166,7 @@ int libexec_load_elf(struct exec_info *execi)
 
 	for (i = 0; i < hdr->e_phnum; i++) {
 		vir_bytes seg_membytes, page_offset, p_vaddr, vaddr;
-		vir_bytes chunk, vfileend, vmemend;
+		vir_bytes chunk, vfileend, vprealloc, vmemend;
 		Elf_Phdr *ph = &phdr[i];
 		if (ph->p_type != PT_LOAD || ph->p_memsz == 0) continue;
 		vaddr = p_vaddr = ph->p_vaddr + execi->load_offset;
@@ -178,8 +178,25 @@ int libexec_load_elf(struct exec_info *execi)
 		if(first || startv > vaddr) startv = vaddr;
 		first = 0;
 
+		vfileend  = p_vaddr + ph->p_filesz;
+		vmemend = vaddr + seg_membytes;
+
+		/* If the caller can get zero-filled memory on demand, only the
+		 * pages holding file contents are allocated up front; the bss
+		 * pages past them cost nothing until they are touched.
+		 */
+		vprealloc = vmemend;
+		if(execi->allocmem_zeroed)
+			vprealloc = roundup(vfileend, PAGE_SIZE);
+
 		/* make us some memory */
-		if(execi->allocmem_prealloc(execi, vaddr, seg_membytes) != OK) {
+		if(vprealloc > vaddr && execi->allocmem_prealloc(execi, vaddr,
+			vprealloc - vaddr) != OK) {
+			if(execi->clearproc) execi->clearproc(execi);
+			return ENOMEM;
+		}
+		if(vmemend > vprealloc && execi->allocmem_zeroed(execi,
+			vprealloc, vmemend - vprealloc) != OK) {
 			if(execi->clearproc) execi->clearproc(execi);
 			return ENOMEM;
 		}
@@ -198,16 +215,14 @@ int libexec_load_elf(struct exec_info *execi)
 		printf("copied 0x%lx-0x%lx\n", p_vaddr, p_vaddr+ph->p_filesz);
 #endif
 
-		/* Clear remaining bits */
-		vfileend  = p_vaddr + ph->p_filesz;
-		vmemend = vaddr + seg_membytes;
+		/* Clear remaining bits of the preallocated pages */
 		if((chunk = p_vaddr - vaddr) > 0) {
 #if ELF_DEBUG
 			printf("start clearing 0x%lx-0x%lx\n", vaddr, vaddr+chunk);
 #endif
 			execi->clearmem(execi, vaddr, chunk);
 		}
-		if((chunk = vmemend - vfileend) > 0) {
+		if((chunk = vprealloc - vfileend) > 0) {
 #if ELF_DEBUG
 			printf("end clearing 0x%lx-0x%lx\n", vfileend, vaddr+chunk);
 #endif
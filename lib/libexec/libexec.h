@@ -35,6 +35,7 @@ struct exec_info {
     libexec_clearfunc_t clearmem;	/* Clear callback */
     libexec_allocfunc_t allocmem_prealloc; /* Alloc callback */
     libexec_allocfunc_t allocmem_ondemand; /* Alloc callback */
+    libexec_allocfunc_t allocmem_zeroed; /* Optional zero-fill alloc */
     libexec_procclearfunc_t clearproc;	/* Clear process callback */
     void *opaque;			/* Callback data */
 
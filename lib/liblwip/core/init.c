@@ -115,8 +115,14 @@
   #error "MEMP_NUM_REASSDATA > IP_REASS_MAX_PBUFS doesn't make sense since each struct ip_reassdata must hold 2 pbufs at least!"
 #endif
 #endif /* !MEMP_MEM_MALLOC */
-#if (LWIP_TCP && (TCP_WND > 0xffff))
-  #error "If you want to use TCP, TCP_WND must fit in an u16_t, so, you have to reduce it in your lwipopts.h"
+#if (LWIP_TCP && LWIP_WND_SCALE && (TCP_RCV_SCALE > 14))
+  #error "TCP_RCV_SCALE must be at most 14 (RFC 7323), so, you have to reduce it in your lwipopts.h"
+#endif
+#if (LWIP_TCP && (TCP_WND > (0xffffUL << TCP_RCV_SCALE)))
+  #error "If you want to use TCP, TCP_WND must fit in an u16_t shifted by TCP_RCV_SCALE, so, you have to reduce it in your lwipopts.h"
+#endif
+#if (LWIP_TCP && TCP_PCB_HASH && ((TCP_PCB_HASH_SIZE & (TCP_PCB_HASH_SIZE - 1)) || (TCP_LISTEN_HASH_SIZE & (TCP_LISTEN_HASH_SIZE - 1))))
+  #error "TCP_PCB_HASH_SIZE and TCP_LISTEN_HASH_SIZE must be powers of two, so, you have to fix them in your lwipopts.h"
 #endif
 #if (LWIP_TCP && (TCP_SND_QUEUELEN > 0xffff))
   #error "If you want to use TCP, TCP_SND_QUEUELEN must fit in an u16_t, so, you have to reduce it in your lwipopts.h"
@@ -781,8 +781,13 @@ err_t ip_output_if_opt(struct pbuf *p, ip_addr_t *src, ip_addr_t *dest,
 #endif /* LWIP_IGMP */
 #endif /* ENABLE_LOOPBACK */
 #if IP_FRAG
-  /* don't fragment if interface has mtu set to 0 [loopif] */
-  if (netif->mtu && (p->tot_len > netif->mtu)) {
+  /* don't fragment if interface has mtu set to 0 [loopif], or if the
+     interface segments the packet itself */
+  if (netif->mtu && (p->tot_len > netif->mtu)
+#if LWIP_NETIF_OFFLOAD
+      && p->tso_mss == 0
+#endif /* LWIP_NETIF_OFFLOAD */
+     ) {
     return ip_frag(p, netif, dest);
   }
 #endif /* IP_FRAG */
@@ -711,6 +711,10 @@ netif_loop_output(struct netif *netif, struct pbuf *p,
     snmp_inc_ifoutdiscards(stats_if);
     return err;
   }
+#if LWIP_NETIF_OFFLOAD
+  /* A checksum left for the hardware is never completed on the way back */
+  r->flags |= p->flags & PBUF_FLAG_CSUM_PARTIAL;
+#endif /* LWIP_NETIF_OFFLOAD */
 
   /* Put the packet on a linked list which gets emptied through calling
      netif_poll(). */
@@ -344,6 +344,9 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
   p->ref = 1;
   /* set flags */
   p->flags = 0;
+#if LWIP_NETIF_OFFLOAD
+  p->tso_mss = 0;
+#endif /* LWIP_NETIF_OFFLOAD */
   LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"U16_F") == %p\n", length, (void *)p));
   return p;
 }
@@ -407,6 +410,9 @@ pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf_cust
   p->pbuf.len = p->pbuf.tot_len = length;
   p->pbuf.type = type;
   p->pbuf.ref = 1;
+#if LWIP_NETIF_OFFLOAD
+  p->pbuf.tso_mss = 0;
+#endif /* LWIP_NETIF_OFFLOAD */
   return &p->pbuf;
 }
 #endif /* LWIP_SUPPORT_CUSTOM_PBUF */
@@ -121,6 +121,13 @@ struct tcp_pcb *tcp_tmp_pcb;
 
 u8_t tcp_active_pcbs_changed;
 
+#if TCP_PCB_HASH
+/** Active and TIME-WAIT PCBs, hashed on their address and port 4-tuple */
+struct tcp_pcb *tcp_pcb_hash[TCP_PCB_HASH_SIZE];
+/** LISTEN PCBs, hashed on their local port */
+struct tcp_pcb *tcp_listen_hash[TCP_LISTEN_HASH_SIZE];
+#endif /* TCP_PCB_HASH */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */ 
 static u8_t tcp_timer;
 static u8_t tcp_timer_ctr;
@@ -175,7 +182,7 @@ tcp_close_shutdown(struct tcp_pcb *pcb, u8_t rst_on_unacked_data)
   err_t err;
 
   if (rst_on_unacked_data && ((pcb->state == ESTABLISHED) || (pcb->state == CLOSE_WAIT))) {
-    if ((pcb->refused_data != NULL) || (pcb->rcv_wnd != TCP_WND)) {
+    if ((pcb->refused_data != NULL) || (pcb->rcv_wnd != TCP_WND_MAX(pcb))) {
       /* Not all data received by application, send RST to tell the remote
          side about this. */
       LWIP_ASSERT("pcb->flags & TF_RXCLOSED", pcb->flags & TF_RXCLOSED);
@@ -557,6 +564,8 @@ tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog)
   lpcb->local_port = pcb->local_port;
   lpcb->state = LISTEN;
   lpcb->prio = pcb->prio;
+  lpcb->rcv_wnd_max = pcb->rcv_wnd_max;
+  lpcb->snd_buf_max = pcb->snd_buf_max;
   lpcb->so_options = pcb->so_options;
   ip_set_option(lpcb, SOF_ACCEPTCONN);
   lpcb->ttl = pcb->ttl;
@@ -613,7 +622,7 @@ u32_t tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb)
 {
   u32_t new_right_edge = pcb->rcv_nxt + pcb->rcv_wnd;
 
-  if (TCP_SEQ_GEQ(new_right_edge, pcb->rcv_ann_right_edge + LWIP_MIN((TCP_WND / 2), pcb->mss))) {
+  if (TCP_SEQ_GEQ(new_right_edge, pcb->rcv_ann_right_edge + LWIP_MIN((TCP_WND_MAX(pcb) / 2), pcb->mss))) {
     /* we can advertise more window */
     pcb->rcv_ann_wnd = pcb->rcv_wnd;
     return new_right_edge - pcb->rcv_ann_right_edge;
@@ -625,8 +634,9 @@ u32_t tcp_update_rcv_ann_wnd(struct tcp_pcb *pcb)
     } else {
       /* keep the right edge of window constant */
       u32_t new_rcv_ann_wnd = pcb->rcv_ann_right_edge - pcb->rcv_nxt;
-      LWIP_ASSERT("new_rcv_ann_wnd <= 0xffff", new_rcv_ann_wnd <= 0xffff);
-      pcb->rcv_ann_wnd = (u16_t)new_rcv_ann_wnd;
+      LWIP_ASSERT("new_rcv_ann_wnd <= TCP_RCVBUF_MAX",
+        new_rcv_ann_wnd <= TCP_RCVBUF_MAX);
+      pcb->rcv_ann_wnd = (tcpwnd_size_t)new_rcv_ann_wnd;
     }
     return 0;
   }
@@ -649,11 +659,11 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
   LWIP_ASSERT("don't call tcp_recved for listen-pcbs",
     pcb->state != LISTEN);
   LWIP_ASSERT("tcp_recved: len would wrap rcv_wnd\n",
-              len <= 0xffff - pcb->rcv_wnd );
+              (tcpwnd_size_t)(pcb->rcv_wnd + len) >= pcb->rcv_wnd);
 
   pcb->rcv_wnd += len;
-  if (pcb->rcv_wnd > TCP_WND) {
-    pcb->rcv_wnd = TCP_WND;
+  if (pcb->rcv_wnd > TCP_WND_MAX(pcb)) {
+    pcb->rcv_wnd = TCP_WND_MAX(pcb);
   }
 
   wnd_inflation = tcp_update_rcv_ann_wnd(pcb);
@@ -667,8 +677,8 @@ tcp_recved(struct tcp_pcb *pcb, u16_t len)
     tcp_output(pcb);
   }
 
-  LWIP_DEBUGF(TCP_DEBUG, ("tcp_recved: recveived %"U16_F" bytes, wnd %"U16_F" (%"U16_F").\n",
-         len, pcb->rcv_wnd, TCP_WND - pcb->rcv_wnd));
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_recved: recveived %"U16_F" bytes, wnd %"TCPWNDSIZE_F" (%"TCPWNDSIZE_F").\n",
+         len, pcb->rcv_wnd, TCP_WND_MAX(pcb) - pcb->rcv_wnd));
 }
 
 /**
@@ -779,8 +789,10 @@ tcp_connect(struct tcp_pcb *pcb, ip_addr_t *ipaddr, u16_t port,
   pcb->snd_nxt = iss;
   pcb->lastack = iss - 1;
   pcb->snd_lbb = iss - 1;
-  pcb->rcv_wnd = TCP_WND;
-  pcb->rcv_ann_wnd = TCP_WND;
+  /* the window grows beyond 64K only once the SYN|ACK turns out to carry
+     the window scale option */
+  pcb->rcv_wnd = TCPWND16(pcb->rcv_wnd_max);
+  pcb->rcv_ann_wnd = TCPWND16(pcb->rcv_wnd_max);
   pcb->rcv_ann_right_edge = pcb->rcv_nxt;
   pcb->snd_wnd = TCP_WND;
   /* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -824,7 +836,7 @@ void
 tcp_slowtmr(void)
 {
   struct tcp_pcb *pcb, *prev;
-  u16_t eff_wnd;
+  tcpwnd_size_t eff_wnd;
   u8_t pcb_remove;      /* flag if a PCB should be removed */
   u8_t pcb_reset;       /* flag if a RST should be sent when removing */
   err_t err;
@@ -903,8 +915,8 @@ tcp_slowtmr_start:
             pcb->ssthresh = (pcb->mss << 1);
           }
           pcb->cwnd = pcb->mss;
-          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"U16_F
-                                       " ssthresh %"U16_F"\n",
+          LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"TCPWNDSIZE_F
+                                       " ssthresh %"TCPWNDSIZE_F"\n",
                                        pcb->cwnd, pcb->ssthresh));
  
           /* The following needs to be called AFTER cwnd is set to one
@@ -994,6 +1006,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", tcp_active_pcbs == pcb);
         tcp_active_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_active_pcbs, pcb);
 
       if (pcb_reset) {
         tcp_rst(pcb->snd_nxt, pcb->rcv_nxt, &pcb->local_ip, &pcb->remote_ip,
@@ -1062,6 +1075,7 @@ tcp_slowtmr_start:
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", tcp_tw_pcbs == pcb);
         tcp_tw_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_tw_pcbs, pcb);
       pcb2 = pcb;
       pcb = pcb->next;
       memp_free(MEMP_TCP_PCB, pcb2);
@@ -1134,7 +1148,7 @@ tcp_process_refused_data(struct tcp_pcb *pcb)
     if (refused_flags & PBUF_FLAG_TCP_FIN) {
       /* correct rcv_wnd as the application won't call tcp_recved()
          for the FIN's seqno */
-      if (pcb->rcv_wnd != TCP_WND) {
+      if (pcb->rcv_wnd != TCP_WND_MAX(pcb)) {
         pcb->rcv_wnd++;
       }
       TCP_EVENT_CLOSED(pcb, err);
@@ -1201,6 +1215,70 @@ tcp_setprio(struct tcp_pcb *pcb, u8_t prio)
   pcb->prio = prio;
 }
 
+/**
+ * Sets the send buffer size of a connection: the amount of data that may be
+ * enqueued but not yet acknowledged. The buffer cannot shrink below the data
+ * already enqueued. May also be called for listen pcbs, whose connections
+ * inherit the size.
+ *
+ * @param pcb the tcp_pcb to manipulate
+ * @param size new send buffer size in bytes
+ */
+void
+tcp_set_sndbufsize(struct tcp_pcb *pcb, tcpwnd_size_t size)
+{
+  tcpwnd_size_t queued;
+
+  size = LWIP_MAX(LWIP_MIN(size, TCP_SNDBUF_MAX), 2 * TCP_MSS);
+  if (pcb->state == LISTEN) {
+    pcb->snd_buf_max = size;
+    return;
+  }
+
+  queued = pcb->snd_buf_max - pcb->snd_buf;
+  if (size < queued) {
+    size = queued;
+  }
+  pcb->snd_buf_max = size;
+  pcb->snd_buf = size - queued;
+}
+
+/**
+ * Sets the receive buffer size of a connection: the largest window offered
+ * to the remote host. The window only exceeds 64K if window scaling is in
+ * use. The announced right edge of the window never moves back, so a smaller
+ * buffer takes effect as the application reads data. May also be called for
+ * listen pcbs, whose connections inherit the size.
+ *
+ * @param pcb the tcp_pcb to manipulate
+ * @param size new receive buffer size in bytes
+ */
+void
+tcp_set_rcvbufsize(struct tcp_pcb *pcb, tcpwnd_size_t size)
+{
+  tcpwnd_size_t in_use;
+
+  size = LWIP_MAX(LWIP_MIN(size, TCP_RCVBUF_MAX), 2 * TCP_MSS);
+  if (pcb->state == LISTEN) {
+    pcb->rcv_wnd_max = size;
+    return;
+  }
+
+  /* data received but not yet taken by the application */
+  in_use = TCP_WND_MAX(pcb) - pcb->rcv_wnd;
+  pcb->rcv_wnd_max = size;
+  pcb->rcv_wnd = (TCP_WND_MAX(pcb) > in_use) ? TCP_WND_MAX(pcb) - in_use : 0;
+
+  if (pcb->state == CLOSED) {
+    pcb->rcv_ann_wnd = pcb->rcv_wnd;
+  } else if (pcb->state != SYN_SENT && pcb->state != SYN_RCVD &&
+             tcp_update_rcv_ann_wnd(pcb) >= TCP_WND_UPDATE_THRESHOLD) {
+    /* let the remote host know about a much larger window now */
+    tcp_ack_now(pcb);
+    tcp_output(pcb);
+  }
+}
+
 #if TCP_QUEUE_OOSEQ
 /**
  * Returns a copy of the given TCP segment.
@@ -1342,10 +1420,12 @@ tcp_alloc(u8_t prio)
   if (pcb != NULL) {
     memset(pcb, 0, sizeof(struct tcp_pcb));
     pcb->prio = prio;
-    pcb->snd_buf = TCP_SND_BUF;
+    pcb->snd_buf = pcb->snd_buf_max = TCP_SND_BUF;
     pcb->snd_queuelen = 0;
-    pcb->rcv_wnd = TCP_WND;
-    pcb->rcv_ann_wnd = TCP_WND;
+    /* the window grows beyond 64K only once both sides agree to scaling */
+    pcb->rcv_wnd_max = TCP_WND;
+    pcb->rcv_wnd = TCPWND16(TCP_WND);
+    pcb->rcv_ann_wnd = TCPWND16(TCP_WND);
     pcb->tos = 0;
     pcb->ttl = TCP_TTL;
     /* As initial send MSS, we use TCP_MSS but limit it to 536.
@@ -1617,6 +1697,81 @@ tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_pcb_remove: tcp_pcbs_sane()", tcp_pcbs_sane());
 }
 
+#if TCP_PCB_HASH
+/**
+ * Computes the bucket of a connection in the 4-tuple hash table.
+ * Addresses are taken in network byte order, ports in host byte order.
+ *
+ * @return index into tcp_pcb_hash
+ */
+u32_t
+tcp_pcb_hash_index(u32_t local_ip, u16_t local_port,
+                   u32_t remote_ip, u16_t remote_port)
+{
+  u32_t h;
+
+  h = local_ip ^ (remote_ip * 0x9e3779b1UL) ^
+      (((u32_t)local_port << 16) | remote_port);
+  h ^= h >> 16;
+  h *= 0x85ebca6bUL;
+  h ^= h >> 13;
+  return h & (TCP_PCB_HASH_SIZE - 1);
+}
+
+/**
+ * Returns the hash chain a PCB on the given list belongs in, or NULL if
+ * PCBs on that list are not hashed.
+ */
+static struct tcp_pcb **
+tcp_pcb_hash_chain(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  if (pcbs == &tcp_active_pcbs || pcbs == &tcp_tw_pcbs) {
+    return &tcp_pcb_hash[tcp_pcb_hash_index(ipX_2_ip(&pcb->local_ip)->addr,
+      pcb->local_port, ipX_2_ip(&pcb->remote_ip)->addr, pcb->remote_port)];
+  }
+  if (pcbs == &tcp_listen_pcbs.pcbs) {
+    return &tcp_listen_hash[TCP_LISTEN_HASH(pcb->local_port)];
+  }
+  return NULL;
+}
+
+/**
+ * Adds a PCB that was just put on one of the PCB lists to the matching
+ * hash table. Called through TCP_REG.
+ */
+void
+tcp_pcb_hash_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **chain;
+
+  if ((chain = tcp_pcb_hash_chain(pcbs, pcb)) != NULL) {
+    pcb->hash_next = *chain;
+    *chain = pcb;
+  }
+}
+
+/**
+ * Removes a PCB that was just taken off one of the PCB lists from the
+ * matching hash table. Called through TCP_RMV.
+ */
+void
+tcp_pcb_hash_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **chain;
+
+  if ((chain = tcp_pcb_hash_chain(pcbs, pcb)) == NULL) {
+    return;
+  }
+  for (; *chain != NULL; chain = &(*chain)->hash_next) {
+    if (*chain == pcb) {
+      *chain = pcb->hash_next;
+      break;
+    }
+  }
+  pcb->hash_next = NULL;
+}
+#endif /* TCP_PCB_HASH */
+
 /**
  * Calculates a new initial sequence number for new connections.
  *
@@ -83,6 +83,37 @@
 /* Forward declarations.*/
 static void tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb);
 
+/**
+ * Compute the checksum of an outgoing TCP packet. If the netif the packet
+ * leaves through completes TCP checksums itself, only the pseudo header is
+ * summed and the packet is marked, so that the driver asks for the rest.
+ *
+ * @param isipv6 whether the packet is IPv6
+ * @param p the packet, starting at the TCP header (with chksum set to 0)
+ * @param src source address of the packet
+ * @param dest destination address of the packet
+ * @return the value to store in the checksum field
+ */
+static u16_t
+tcp_output_chksum(u8_t isipv6, struct pbuf *p, ipX_addr_t *src, ipX_addr_t *dest)
+{
+#if LWIP_NETIF_OFFLOAD
+  struct netif *netif;
+
+  if (!isipv6) {
+    netif = ip_route(ipX_2_ip(dest));
+    if (netif != NULL && (netif->offload & NETIF_OFFLOAD_CSUM_TCP)) {
+      p->flags |= PBUF_FLAG_CSUM_PARTIAL;
+      return (u16_t)~ipX_chksum_pseudo_partial(isipv6, p, IP_PROTO_TCP,
+        p->tot_len, 0, src, dest);
+    }
+  }
+  /* the route may have changed since the segment was last sent */
+  p->flags &= ~PBUF_FLAG_CSUM_PARTIAL;
+#endif /* LWIP_NETIF_OFFLOAD */
+  return ipX_chksum_pseudo(isipv6, p, IP_PROTO_TCP, p->tot_len, src, dest);
+}
+
 /** Allocate a pbuf and create a tcphdr at p->payload, used for output
  * functions other than the default tcp_output -> tcp_output_segment
  * (e.g. tcp_send_empty_ack, etc.)
@@ -108,7 +139,7 @@ tcp_output_alloc_header(struct tcp_pcb *pcb, u16_t optlen, u16_t datalen,
     tcphdr->seqno = seqno_be;
     tcphdr->ackno = htonl(pcb->rcv_nxt);
     TCPH_HDRLEN_FLAGS_SET(tcphdr, (5 + optlen / 4), TCP_ACK);
-    tcphdr->wnd = htons(pcb->rcv_ann_wnd);
+    tcphdr->wnd = htons(TCPWND16(RCV_WND_SCALE(pcb, pcb->rcv_ann_wnd)));
     tcphdr->chksum = 0;
     tcphdr->urgp = 0;
 
@@ -309,7 +340,7 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
 
   /* fail on too much data */
   if (len > pcb->snd_buf) {
-    LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 3, ("tcp_write: too much data (len=%"U16_F" > snd_buf=%"U16_F")\n",
+    LWIP_DEBUGF(TCP_OUTPUT_DEBUG | 3, ("tcp_write: too much data (len=%"U16_F" > snd_buf=%"TCPWNDSIZE_F")\n",
       len, pcb->snd_buf));
     pcb->flags |= TF_NAGLEMEMERR;
     return ERR_MEM;
@@ -745,6 +776,17 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
 
   if (flags & TCP_SYN) {
     optflags = TF_SEG_OPTS_MSS;
+    /* A SYN|ACK may only carry the options that the SYN carried */
+#if LWIP_WND_SCALE
+    if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_WND_SCALE)) {
+      optflags |= TF_SEG_OPTS_WND_SCALE;
+    }
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+    if ((pcb->state != SYN_RCVD) || (pcb->flags & TF_SACK)) {
+      optflags |= TF_SEG_OPTS_SACK_PERM;
+    }
+#endif /* LWIP_TCP_SACK */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
@@ -837,6 +879,52 @@ tcp_build_timestamp_option(struct tcp_pcb *pcb, u32_t *opts)
 }
 #endif
 
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+/* Build a SACK option reporting the out-of-sequence data held on
+ * pcb->ooseq at the specified options pointer, or count the blocks it
+ * would hold if opts is NULL.
+ *
+ * @param pcb tcp_pcb
+ * @param opts option pointer where to store the SACK option, or NULL
+ * @return the number of SACK blocks (the option is 4 + 8 * n bytes long)
+ */
+static u8_t
+tcp_build_sack_option(struct tcp_pcb *pcb, u32_t *opts)
+{
+  struct tcp_seg *seg;
+  u32_t left, right;
+  u8_t n;
+
+  if (!(pcb->flags & TF_SACK) || pcb->ooseq == NULL) {
+    return 0;
+  }
+
+  n = 0;
+  seg = pcb->ooseq;
+  while (seg != NULL && n < TCP_SACK_MAX_BLOCKS) {
+    /* merge the segments that are contiguous into one block */
+    left = seg->tcphdr->seqno;
+    right = ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+    for (seg = seg->next; seg != NULL &&
+         ntohl(seg->tcphdr->seqno) == right; seg = seg->next) {
+      right += TCP_TCPLEN(seg);
+    }
+    if (opts != NULL) {
+      /* left is still in network byte order */
+      opts[1 + 2 * n] = left;
+      opts[2 + 2 * n] = htonl(right);
+    }
+    n++;
+  }
+
+  if (opts != NULL) {
+    /* Pad with two NOP options to make everything nicely aligned */
+    opts[0] = htonl(0x01010500 | (2 + 8 * n));
+  }
+  return n;
+}
+#endif /* LWIP_TCP_SACK && TCP_QUEUE_OOSEQ */
+
 /** Send an ACK without data.
  *
  * @param pcb Protocol control block for the TCP connection to send the ACK
@@ -847,12 +935,23 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   struct pbuf *p;
   struct tcp_hdr *tcphdr;
   u8_t optlen = 0;
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  u8_t sack_blocks;
+#endif
 
 #if LWIP_TCP_TIMESTAMPS
   if (pcb->flags & TF_TIMESTAMP) {
     optlen = LWIP_TCP_OPT_LENGTH(TF_SEG_OPTS_TS);
   }
 #endif
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  /* Only pure ACKs carry SACK blocks: they are the ones sent when
+     out-of-sequence data arrives. */
+  sack_blocks = tcp_build_sack_option(pcb, NULL);
+  if (sack_blocks > 0) {
+    optlen += 4 + 8 * sack_blocks;
+  }
+#endif
 
   p = tcp_output_alloc_header(pcb, optlen, 0, htonl(pcb->snd_nxt));
   if (p == NULL) {
@@ -873,10 +972,16 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
     tcp_build_timestamp_option(pcb, (u32_t *)(tcphdr + 1));
   }
 #endif 
+#if LWIP_TCP_SACK && TCP_QUEUE_OOSEQ
+  if (sack_blocks > 0) {
+    tcp_build_sack_option(pcb, (u32_t *)(tcphdr + 1) +
+      ((pcb->flags & TF_TIMESTAMP) ? 3 : 0));
+  }
+#endif
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = ipX_chksum_pseudo(PCB_ISIPV6(pcb), p, IP_PROTO_TCP, p->tot_len,
-    &pcb->local_ip, &pcb->remote_ip);
+  tcphdr->chksum = tcp_output_chksum(PCB_ISIPV6(pcb), p, &pcb->local_ip,
+    &pcb->remote_ip);
 #endif
 #if LWIP_NETIF_HWADDRHINT
   ipX_output_hinted(PCB_ISIPV6(pcb), p, &pcb->local_ip, &pcb->remote_ip, pcb->ttl, pcb->tos,
@@ -890,6 +995,117 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   return ERR_OK;
 }
 
+#if LWIP_NETIF_OFFLOAD
+/**
+ * Called by tcp_output() to send a TCP segment over IP, together with the
+ * data of as many following unsent segments as the window allows, if the
+ * netif can split the result into segments itself (TSO). The data of those
+ * segments is appended to seg->p only for as long as it takes to send it:
+ * all segments stay on the queues as they are, so they can be acknowledged
+ * and retransmitted one by one.
+ *
+ * @param seg the tcp_seg to send
+ * @param pcb the tcp_pcb for the TCP connection used to send the segment
+ * @param wnd the window available for sending
+ * @return the number of segments following seg whose data has been sent
+ */
+static u16_t
+tcp_output_tso(struct tcp_seg *seg, struct tcp_pcb *pcb, u32_t wnd)
+{
+  struct netif *netif;
+  struct tcp_seg *next;
+  struct pbuf *chain, *data, *last, *q, *r;
+  u32_t total;
+  u16_t count, off;
+
+  netif = PCB_ISIPV6(pcb) ? NULL : ip_route(ipX_2_ip(&pcb->remote_ip));
+  if (netif == NULL || (netif->offload & (NETIF_OFFLOAD_CSUM_TCP |
+      NETIF_OFFLOAD_TSO4)) != (NETIF_OFFLOAD_CSUM_TCP | NETIF_OFFLOAD_TSO4) ||
+      seg->len != pcb->mss || (TCPH_FLAGS(seg->tcphdr) & (TCP_SYN | TCP_FIN))) {
+    tcp_output_segment(seg, pcb);
+    return 0;
+  }
+
+  /* Collect the data of the following full-sized segments. Only full-sized
+   * segments are taken, so that the netif recreates them exactly, and so
+   * that the nagle check in tcp_output() would have let them go anyway. */
+  chain = NULL;
+  count = 0;
+  total = TCPH_HDRLEN(seg->tcphdr) * 4 + seg->len;
+  for (next = seg->next; next != NULL; next = next->next) {
+    if (next->len != pcb->mss ||
+        (TCPH_FLAGS(next->tcphdr) & (TCP_SYN | TCP_FIN)) ||
+        (next->flags & TF_SEG_OPTS_TS) != (seg->flags & TF_SEG_OPTS_TS) ||
+        ntohl(next->tcphdr->seqno) != ntohl(seg->tcphdr->seqno) +
+          (total - TCPH_HDRLEN(seg->tcphdr) * 4) ||
+        ntohl(next->tcphdr->seqno) - pcb->lastack + next->len > wnd ||
+        total + next->len > NETIF_TSO_MAX_LEN) {
+      break;
+    }
+
+    /* The data follows the TCP header, which is preceded by whatever
+     * headers were added when the segment was sent before, if ever. */
+    off = (u16_t)((u8_t *)next->tcphdr - (u8_t *)next->p->payload) +
+      TCPH_HDRLEN(next->tcphdr) * 4;
+    data = NULL;
+    for (q = next->p; q != NULL; q = q->next) {
+      if (off >= q->len) {
+        off -= q->len;
+        continue;
+      }
+      r = pbuf_alloc(PBUF_RAW, q->len - off, PBUF_REF);
+      if (r == NULL) {
+        break;
+      }
+      r->payload = (u8_t *)q->payload + off;
+      off = 0;
+      if (data == NULL) {
+        data = r;
+      } else {
+        pbuf_cat(data, r);
+      }
+    }
+    if (q != NULL || data == NULL) {
+      /* out of pbufs: send only the segments collected completely */
+      if (data != NULL) {
+        pbuf_free(data);
+      }
+      break;
+    }
+    if (chain == NULL) {
+      chain = data;
+    } else {
+      pbuf_cat(chain, data);
+    }
+    total += next->len;
+    count++;
+  }
+
+  if (count == 0) {
+    tcp_output_segment(seg, pcb);
+    return 0;
+  }
+
+  for (last = seg->p; last->next != NULL; last = last->next);
+  pbuf_cat(seg->p, chain);
+  seg->p->tso_mss = pcb->mss;
+
+  tcp_output_segment(seg, pcb);
+
+  /* Detach the data of the other segments again. */
+  seg->p->tso_mss = 0;
+  last->next = NULL;
+  for (q = seg->p; q != NULL; q = q->next) {
+    q->tot_len -= chain->tot_len;
+  }
+  pbuf_free(chain);
+
+  LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_output_tso: sent %"U16_F" segments in one packet\n",
+    (u16_t)(count + 1)));
+  return count;
+}
+#endif /* LWIP_NETIF_OFFLOAD */
+
 /**
  * Find out what we can send and send it
  *
@@ -902,6 +1118,9 @@ tcp_output(struct tcp_pcb *pcb)
 {
   struct tcp_seg *seg, *useg;
   u32_t wnd, snd_nxt;
+#if LWIP_NETIF_OFFLOAD
+  u16_t tso_left = 0;
+#endif /* LWIP_NETIF_OFFLOAD */
 #if TCP_CWND_DEBUG
   s16_t i = 0;
 #endif /* TCP_CWND_DEBUG */
@@ -948,13 +1167,13 @@ tcp_output(struct tcp_pcb *pcb)
 #endif /* TCP_OUTPUT_DEBUG */
 #if TCP_CWND_DEBUG
   if (seg == NULL) {
-    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %"U16_F
-                                 ", cwnd %"U16_F", wnd %"U32_F
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %"TCPWNDSIZE_F
+                                 ", cwnd %"TCPWNDSIZE_F", wnd %"U32_F
                                  ", seg == NULL, ack %"U32_F"\n",
                                  pcb->snd_wnd, pcb->cwnd, wnd, pcb->lastack));
   } else {
     LWIP_DEBUGF(TCP_CWND_DEBUG, 
-                ("tcp_output: snd_wnd %"U16_F", cwnd %"U16_F", wnd %"U32_F
+                ("tcp_output: snd_wnd %"TCPWNDSIZE_F", cwnd %"TCPWNDSIZE_F", wnd %"U32_F
                  ", effwnd %"U32_F", seq %"U32_F", ack %"U32_F"\n",
                  pcb->snd_wnd, pcb->cwnd, wnd,
                  ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len,
@@ -978,7 +1197,7 @@ tcp_output(struct tcp_pcb *pcb)
       break;
     }
 #if TCP_CWND_DEBUG
-    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %"U16_F", cwnd %"U16_F", wnd %"U32_F", effwnd %"U32_F", seq %"U32_F", ack %"U32_F", i %"S16_F"\n",
+    LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_output: snd_wnd %"TCPWNDSIZE_F", cwnd %"TCPWNDSIZE_F", wnd %"U32_F", effwnd %"U32_F", seq %"U32_F", ack %"U32_F", i %"S16_F"\n",
                             pcb->snd_wnd, pcb->cwnd, wnd,
                             ntohl(seg->tcphdr->seqno) + seg->len -
                             pcb->lastack,
@@ -996,7 +1215,16 @@ tcp_output(struct tcp_pcb *pcb)
 #if TCP_OVERSIZE_DBGCHECK
     seg->oversize_left = 0;
 #endif /* TCP_OVERSIZE_DBGCHECK */
+#if LWIP_NETIF_OFFLOAD
+    if (tso_left > 0) {
+      /* the data of this segment has left with the previous one */
+      tso_left--;
+    } else {
+      tso_left = tcp_output_tso(seg, pcb, wnd);
+    }
+#else /* LWIP_NETIF_OFFLOAD */
     tcp_output_segment(seg, pcb);
+#endif /* LWIP_NETIF_OFFLOAD */
     snd_nxt = ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
     if (TCP_SEQ_LT(pcb->snd_nxt, snd_nxt)) {
       pcb->snd_nxt = snd_nxt;
@@ -1065,7 +1293,12 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   seg->tcphdr->ackno = htonl(pcb->rcv_nxt);
 
   /* advertise our receive window size in this TCP segment */
-  seg->tcphdr->wnd = htons(pcb->rcv_ann_wnd);
+  if (TCPH_FLAGS(seg->tcphdr) & TCP_SYN) {
+    /* the window in a SYN segment is never scaled */
+    seg->tcphdr->wnd = htons(TCPWND16(pcb->rcv_ann_wnd));
+  } else {
+    seg->tcphdr->wnd = htons(TCPWND16(RCV_WND_SCALE(pcb, pcb->rcv_ann_wnd)));
+  }
 
   pcb->rcv_ann_right_edge = pcb->rcv_nxt + pcb->rcv_ann_wnd;
 
@@ -1082,6 +1315,20 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
     *opts = TCP_BUILD_MSS_OPTION(mss);
     opts += 1;
   }
+#if LWIP_WND_SCALE
+  if (seg->flags & TF_SEG_OPTS_WND_SCALE) {
+    /* Pad with one NOP option to make everything nicely aligned */
+    *opts = PP_HTONL(0x01030300 | TCP_RCV_SCALE);
+    opts += 1;
+  }
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK
+  if (seg->flags & TF_SEG_OPTS_SACK_PERM) {
+    /* Pad with two NOP options to make everything nicely aligned */
+    *opts = PP_HTONL(0x01010402);
+    opts += 1;
+  }
+#endif /* LWIP_TCP_SACK */
 #if LWIP_TCP_TIMESTAMPS
   pcb->ts_lastacksent = pcb->rcv_nxt;
 
@@ -1160,8 +1407,8 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
   }
 #else /* TCP_CHECKSUM_ON_COPY */
 #if CHECKSUM_GEN_TCP
-  seg->tcphdr->chksum = ipX_chksum_pseudo(PCB_ISIPV6(pcb), seg->p, IP_PROTO_TCP,
-    seg->p->tot_len, &pcb->local_ip, &pcb->remote_ip);
+  seg->tcphdr->chksum = tcp_output_chksum(PCB_ISIPV6(pcb), seg->p,
+    &pcb->local_ip, &pcb->remote_ip);
 #endif /* CHECKSUM_GEN_TCP */
 #endif /* TCP_CHECKSUM_ON_COPY */
   TCP_STATS_INC(tcp.xmit);
@@ -1220,7 +1467,7 @@ tcp_rst_impl(u32_t seqno, u32_t ackno,
   tcphdr->seqno = htonl(seqno);
   tcphdr->ackno = htonl(ackno);
   TCPH_HDRLEN_FLAGS_SET(tcphdr, TCP_HLEN/4, TCP_RST | TCP_ACK);
-  tcphdr->wnd = PP_HTONS(TCP_WND);
+  tcphdr->wnd = PP_HTONS(TCPWND16(TCP_WND));
   tcphdr->chksum = 0;
   tcphdr->urgp = 0;
 
@@ -1253,6 +1500,14 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
     return;
   }
 
+#if LWIP_TCP_SACK
+  /* The remote host may discard SACKed data, so forget about it (RFC 2018) */
+  tcp_sack_clear(pcb);
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg->flags &= ~TF_SEG_SACKED;
+  }
+#endif /* LWIP_TCP_SACK */
+
   /* Move all unacked segments to the head of the unsent queue */
   for (seg = pcb->unacked; seg->next != NULL; seg = seg->next);
   /* concatenate unsent queue after unacked queue */
@@ -1274,27 +1529,17 @@ tcp_rexmit_rto(struct tcp_pcb *pcb)
 }
 
 /**
- * Requeue the first unacked segment for retransmission
+ * Requeue a segment taken off the unacked queue for retransmission
  *
- * Called by tcp_receive() for fast retramsmit.
- *
- * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ * @param pcb the tcp_pcb for which to retransmit the segment
+ * @param seg the segment to retransmit
  */
-void
-tcp_rexmit(struct tcp_pcb *pcb)
+static void
+tcp_requeue_seg(struct tcp_pcb *pcb, struct tcp_seg *seg)
 {
-  struct tcp_seg *seg;
   struct tcp_seg **cur_seg;
 
-  if (pcb->unacked == NULL) {
-    return;
-  }
-
-  /* Move the first unacked segment to the unsent queue */
   /* Keep the unsent queue sorted. */
-  seg = pcb->unacked;
-  pcb->unacked = seg->next;
-
   cur_seg = &(pcb->unsent);
   while (*cur_seg &&
     TCP_SEQ_LT(ntohl((*cur_seg)->tcphdr->seqno), ntohl(seg->tcphdr->seqno))) {
@@ -1320,6 +1565,87 @@ tcp_rexmit(struct tcp_pcb *pcb)
      and thus tcp_output directly returns. */
 }
 
+/**
+ * Requeue the first unacked segment for retransmission
+ *
+ * Called by tcp_receive() for fast retramsmit.
+ *
+ * @param pcb the tcp_pcb for which to retransmit the first unacked segment
+ */
+void
+tcp_rexmit(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+
+  if (pcb->unacked == NULL) {
+    return;
+  }
+
+  /* Move the first unacked segment to the unsent queue */
+  seg = pcb->unacked;
+  pcb->unacked = seg->next;
+#if LWIP_TCP_SACK
+  seg->flags |= TF_SEG_SACK_RTX;
+#endif /* LWIP_TCP_SACK */
+  tcp_requeue_seg(pcb, seg);
+}
+
+#if LWIP_TCP_SACK
+/**
+ * Requeue the first segment in a hole reported by the remote host for
+ * retransmission: the first unacked segment below the highest SACKed
+ * sequence number that was neither SACKed nor retransmitted yet during
+ * this fast recovery.
+ *
+ * Called by tcp_receive() for duplicate and partial ACKs in fast recovery.
+ *
+ * @param pcb the tcp_pcb for which to retransmit a segment
+ */
+void
+tcp_rexmit_sack(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg, **prev;
+
+  for (prev = &pcb->unacked; (seg = *prev) != NULL; prev = &seg->next) {
+    if (!TCP_SEQ_LT(ntohl(seg->tcphdr->seqno), pcb->sack_high)) {
+      return;
+    }
+    if (!(seg->flags & (TF_SEG_SACKED | TF_SEG_SACK_RTX))) {
+      break;
+    }
+  }
+  if (seg == NULL) {
+    return;
+  }
+
+  LWIP_DEBUGF(TCP_FR_DEBUG, ("tcp_rexmit_sack: retransmit %"U32_F"\n",
+                             ntohl(seg->tcphdr->seqno)));
+  *prev = seg->next;
+  seg->flags |= TF_SEG_SACK_RTX;
+  tcp_requeue_seg(pcb, seg);
+}
+
+/**
+ * Forget which segments were retransmitted during fast recovery, and the
+ * highest sequence number SACKed so far.
+ *
+ * @param pcb the tcp_pcb that leaves fast recovery
+ */
+void
+tcp_sack_clear(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg;
+
+  for (seg = pcb->unacked; seg != NULL; seg = seg->next) {
+    seg->flags &= ~TF_SEG_SACK_RTX;
+  }
+  for (seg = pcb->unsent; seg != NULL; seg = seg->next) {
+    seg->flags &= ~TF_SEG_SACK_RTX;
+  }
+  pcb->sack_high = pcb->lastack;
+}
+#endif /* LWIP_TCP_SACK */
+
 
 /**
  * Handle retransmission after three dupacks received
@@ -1349,7 +1675,7 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
     /* The minimum value for ssthresh should be 2 MSS */
     if (pcb->ssthresh < 2*pcb->mss) {
       LWIP_DEBUGF(TCP_FR_DEBUG, 
-                  ("tcp_receive: The minimum value for ssthresh %"U16_F
+                  ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
                    " should be min 2 mss %"U16_F"...\n",
                    pcb->ssthresh, 2*pcb->mss));
       pcb->ssthresh = 2*pcb->mss;
@@ -1357,6 +1683,10 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
     
     pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
     pcb->flags |= TF_INFR;
+#if LWIP_TCP_SACK
+    /* Recovery ends once everything sent so far is acknowledged */
+    pcb->recover = pcb->snd_nxt;
+#endif /* LWIP_TCP_SACK */
   } 
 }
 
@@ -1390,8 +1720,8 @@ tcp_keepalive(struct tcp_pcb *pcb)
   }
   tcphdr = (struct tcp_hdr *)p->payload;
 
-  tcphdr->chksum = ipX_chksum_pseudo(PCB_ISIPV6(pcb), p, IP_PROTO_TCP, p->tot_len,
-      &pcb->local_ip, &pcb->remote_ip);
+  tcphdr->chksum = tcp_output_chksum(PCB_ISIPV6(pcb), p, &pcb->local_ip,
+      &pcb->remote_ip);
   TCP_STATS_INC(tcp.xmit);
 
   /* Send output to IP */
@@ -1469,8 +1799,8 @@ tcp_zero_window_probe(struct tcp_pcb *pcb)
   }
 
 #if CHECKSUM_GEN_TCP
-  tcphdr->chksum = ipX_chksum_pseudo(PCB_ISIPV6(pcb), p, IP_PROTO_TCP, p->tot_len,
-      &pcb->local_ip, &pcb->remote_ip);
+  tcphdr->chksum = tcp_output_chksum(PCB_ISIPV6(pcb), p, &pcb->local_ip,
+      &pcb->remote_ip);
 #endif
   TCP_STATS_INC(tcp.xmit);
 
@@ -340,6 +340,10 @@ udp_input(struct pbuf *p, struct netif *inp)
     } else
 #endif /* LWIP_UDPLITE */
     {
+#if LWIP_NETIF_OFFLOAD
+      /* Verified by the netif already, or never completed on loopback? */
+      if ((p->flags & (PBUF_FLAG_CSUM_OK | PBUF_FLAG_CSUM_PARTIAL)) == 0)
+#endif /* LWIP_NETIF_OFFLOAD */
       if (udphdr->chksum != 0) {
         if (ipX_chksum_pseudo(ip_current_is_v6(), p, IP_PROTO_UDP, p->tot_len,
                               ipX_current_src_addr(),
@@ -812,6 +816,16 @@ udp_sendto_if_chksum(struct udp_pcb *pcb, struct pbuf *p, ip_addr_t *dst_ip,
     /* Checksum is mandatory over IPv6. */
     if (PCB_ISIPV6(pcb) || (pcb->flags & UDP_FLAGS_NOCHKSUM) == 0) {
       u16_t udpchksum;
+#if LWIP_NETIF_OFFLOAD
+      q->flags &= ~PBUF_FLAG_CSUM_PARTIAL;
+      /* a datagram that gets fragmented cannot be completed by the netif */
+      if (!PCB_ISIPV6(pcb) && (netif->offload & NETIF_OFFLOAD_CSUM_UDP) &&
+          (netif->mtu == 0 || q->tot_len + IP_HLEN <= netif->mtu)) {
+        q->flags |= PBUF_FLAG_CSUM_PARTIAL;
+        udpchksum = (u16_t)~ipX_chksum_pseudo_partial(0, q, IP_PROTO_UDP,
+          q->tot_len, 0, ip_2_ipX(src_ip), ip_2_ipX(dst_ip));
+      } else
+#endif /* LWIP_NETIF_OFFLOAD */
 #if LWIP_CHECKSUM_ON_COPY
       if (have_chksum) {
         u32_t acc;
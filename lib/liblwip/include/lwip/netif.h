@@ -98,6 +98,24 @@ extern "C" {
  * Set by the netif driver in its init function. */
 #define NETIF_FLAG_IGMP         0x80U
 
+#if LWIP_NETIF_OFFLOAD
+/** If set, the netif completes the TCP checksum of outgoing packets. TCP then
+ * only stores the pseudo header sum in the checksum field, and marks the packet
+ * with PBUF_FLAG_CSUM_PARTIAL. Received packets whose checksums the netif
+ * verified are marked with PBUF_FLAG_CSUM_OK by the netif driver. */
+#define NETIF_OFFLOAD_CSUM_TCP  0x01U
+/** If set, the netif cuts TCP/IPv4 packets with up to NETIF_TSO_MAX_LEN bytes
+ * of data into segments of pbuf->tso_mss bytes. TCP then sends consecutive
+ * segments as one packet. Requires NETIF_OFFLOAD_CSUM_TCP. */
+#define NETIF_OFFLOAD_TSO4      0x02U
+/** Most TCP data in one packet for NETIF_OFFLOAD_TSO4, leaving room for the
+ * headers in the 16 bit length of the pbuf. */
+#define NETIF_TSO_MAX_LEN       0xf000U
+/** If set, the netif completes the UDP checksum of outgoing IPv4 datagrams
+ * that need no fragmentation, like NETIF_OFFLOAD_CSUM_TCP does for TCP. */
+#define NETIF_OFFLOAD_CSUM_UDP  0x04U
+#endif /* LWIP_NETIF_OFFLOAD */
+
 /** Function prototype for netif init functions. Set up flags and output/linkoutput
  * callback functions in this function.
  *
@@ -236,6 +254,10 @@ struct netif {
   u8_t hwaddr[NETIF_MAX_HWADDR_LEN];
   /** flags (see NETIF_FLAG_ above) */
   u8_t flags;
+#if LWIP_NETIF_OFFLOAD
+  /** work done by the hardware (see NETIF_OFFLOAD_ above) */
+  u8_t offload;
+#endif /* LWIP_NETIF_OFFLOAD */
   /** descriptive abbreviation */
   char name[2];
   /** number of this interface */
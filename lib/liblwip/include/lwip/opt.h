@@ -1060,12 +1060,62 @@
 #define LWIP_TCP_TIMESTAMPS             0
 #endif
 
+/**
+ * LWIP_WND_SCALE and TCP_RCV_SCALE:
+ * Set LWIP_WND_SCALE to 1 to enable the window scale option (RFC 7323).
+ * Set TCP_RCV_SCALE to the shift count to announce for the receive window
+ * (in the range of [0..14]). TCP_WND and the per-pcb receive buffer may then
+ * be as large as (0xffff << TCP_RCV_SCALE).
+ */
+#ifndef LWIP_WND_SCALE
+#define LWIP_WND_SCALE                  0
+#define TCP_RCV_SCALE                   0
+#endif
+
+/**
+ * LWIP_TCP_SACK==1: support selective acknowledgements (RFC 2018): report
+ * out-of-sequence data to the remote side in SACK blocks, and retransmit
+ * only the holes reported by the remote side during fast recovery.
+ */
+#ifndef LWIP_TCP_SACK
+#define LWIP_TCP_SACK                   0
+#endif
+
+/**
+ * TCP_PCB_HASH==1: find the pcb of an incoming segment through hash tables
+ * instead of walking the pcb lists: active and TIME-WAIT pcbs are hashed on
+ * their address and port 4-tuple, listening pcbs on their local port. The
+ * lists are still kept, for the timers. The tables take
+ * (TCP_PCB_HASH_SIZE + TCP_LISTEN_HASH_SIZE) pointers of memory, whatever the
+ * number of connections.
+ */
+#ifndef TCP_PCB_HASH
+#define TCP_PCB_HASH                    0
+#endif
+
+/**
+ * TCP_PCB_HASH_SIZE: the number of buckets for active and TIME-WAIT pcbs.
+ * Must be a power of two.
+ */
+#ifndef TCP_PCB_HASH_SIZE
+#define TCP_PCB_HASH_SIZE               256
+#endif
+
+/**
+ * TCP_LISTEN_HASH_SIZE: the number of buckets for listening pcbs. Must be a
+ * power of two.
+ */
+#ifndef TCP_LISTEN_HASH_SIZE
+#define TCP_LISTEN_HASH_SIZE            16
+#endif
+
 /**
  * TCP_WND_UPDATE_THRESHOLD: difference in window to trigger an
- * explicit window update
+ * explicit window update. Kept small, as connections that do not use
+ * window scaling have windows much smaller than a scaled TCP_WND.
  */
 #ifndef TCP_WND_UPDATE_THRESHOLD
-#define TCP_WND_UPDATE_THRESHOLD   (TCP_WND / 4)
+#define TCP_WND_UPDATE_THRESHOLD   LWIP_MIN((TCP_WND / 4), (TCP_MSS * 4))
 #endif
 
 /**
@@ -1159,6 +1209,15 @@
 #define LWIP_NETIF_HWADDRHINT           0
 #endif
 
+/**
+ * LWIP_NETIF_OFFLOAD==1: Support network interfaces that complete TCP and UDP
+ * checksums, verify the checksums of received packets or segment large TCP
+ * packets in hardware (see NETIF_OFFLOAD_* in netif.h).
+ */
+#ifndef LWIP_NETIF_OFFLOAD
+#define LWIP_NETIF_OFFLOAD              0
+#endif
+
 /**
  * LWIP_NETIF_LOOPBACK==1: Support sending packets with a destination IP
  * address equal to the netif IP address, looping them back up the stack.
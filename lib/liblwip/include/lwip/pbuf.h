@@ -82,6 +82,10 @@ typedef enum {
 #define PBUF_FLAG_LLMCAST   0x10U
 /** indicates this pbuf includes a TCP FIN flag */
 #define PBUF_FLAG_TCP_FIN   0x20U
+/** indicates the netif verified the checksums of this received packet */
+#define PBUF_FLAG_CSUM_OK   0x40U
+/** indicates the netif must complete the TCP or UDP checksum of this packet */
+#define PBUF_FLAG_CSUM_PARTIAL 0x80U
 
 struct pbuf {
   /** next pbuf in singly linked pbuf chain */
@@ -114,6 +118,12 @@ struct pbuf {
    * the stack itself, or pbuf->next pointers from a chain.
    */
   u16_t ref;
+
+#if LWIP_NETIF_OFFLOAD
+  /** if not zero, the segment size for a TCP packet that the netif
+   * segments (NETIF_OFFLOAD_TSO4) */
+  u16_t tso_mss;
+#endif /* LWIP_NETIF_OFFLOAD */
 };
 
 #if LWIP_SUPPORT_CUSTOM_PBUF
@@ -125,6 +125,32 @@ typedef void  (*tcp_err_fn)(void *arg, err_t err);
  */
 typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *tpcb, err_t err);
 
+#if LWIP_WND_SCALE
+#define RCV_WND_SCALE(pcb, wnd) (((wnd) >> (pcb)->rcv_scale))
+#define SND_WND_SCALE(pcb, wnd) (((wnd) << (pcb)->snd_scale))
+#define TCPWND16(x)             ((u16_t)LWIP_MIN((x), 0xFFFF))
+typedef u32_t tcpwnd_size_t;
+typedef u16_t tcpflags_t;
+#define TCPWNDSIZE_F            U32_F
+#else /* LWIP_WND_SCALE */
+#define RCV_WND_SCALE(pcb, wnd) (wnd)
+#define SND_WND_SCALE(pcb, wnd) (wnd)
+#define TCPWND16(x)             (x)
+typedef u16_t tcpwnd_size_t;
+#if LWIP_TCP_SACK
+typedef u16_t tcpflags_t;
+#else /* LWIP_TCP_SACK */
+typedef u8_t tcpflags_t;
+#endif /* LWIP_TCP_SACK */
+#define TCPWNDSIZE_F            U16_F
+#endif /* LWIP_WND_SCALE */
+
+/** The largest receive and send buffers that can be set per pcb */
+#define TCP_RCVBUF_MAX          ((tcpwnd_size_t)(0xffffUL << TCP_RCV_SCALE))
+#define TCP_SNDBUF_MAX          ((tcpwnd_size_t)LWIP_MIN( \
+                                   (u32_t)(TCP_SND_QUEUELEN / 2) * TCP_MSS, \
+                                   (tcpwnd_size_t)~0))
+
 enum tcp_state {
   CLOSED      = 0,
   LISTEN      = 1,
@@ -155,13 +181,23 @@ enum tcp_state {
 /**
  * members common to struct tcp_pcb and struct tcp_listen_pcb
  */
+#if TCP_PCB_HASH
+#define TCP_PCB_HASH_NEXT(type) type *hash_next; /* for the hash table chain */
+#else /* TCP_PCB_HASH */
+#define TCP_PCB_HASH_NEXT(type)
+#endif /* TCP_PCB_HASH */
+
 #define TCP_PCB_COMMON(type) \
   type *next; /* for the linked list */ \
+  TCP_PCB_HASH_NEXT(type) \
   void *callback_arg; \
   /* the accept callback for listen- and normal pcbs, if LWIP_CALLBACK_API */ \
   DEF_ACCEPT_CALLBACK \
   enum tcp_state state; /* TCP state */ \
   u8_t prio; \
+  /* receive and send buffer sizes, inherited from listen pcbs */ \
+  tcpwnd_size_t rcv_wnd_max; \
+  tcpwnd_size_t snd_buf_max; \
   /* ports are in host byte order */ \
   u16_t local_port
 
@@ -176,15 +212,21 @@ struct tcp_pcb {
   /* ports are in host byte order */
   u16_t remote_port;
   
-  u8_t flags;
-#define TF_ACK_DELAY   ((u8_t)0x01U)   /* Delayed ACK. */
-#define TF_ACK_NOW     ((u8_t)0x02U)   /* Immediate ACK. */
-#define TF_INFR        ((u8_t)0x04U)   /* In fast recovery. */
-#define TF_TIMESTAMP   ((u8_t)0x08U)   /* Timestamp option enabled */
-#define TF_RXCLOSED    ((u8_t)0x10U)   /* rx closed by tcp_shutdown */
-#define TF_FIN         ((u8_t)0x20U)   /* Connection was closed locally (FIN segment enqueued). */
-#define TF_NODELAY     ((u8_t)0x40U)   /* Disable Nagle algorithm */
-#define TF_NAGLEMEMERR ((u8_t)0x80U)   /* nagle enabled, memerr, try to output to prevent delayed ACK to happen */
+  tcpflags_t flags;
+#define TF_ACK_DELAY   ((tcpflags_t)0x01U)   /* Delayed ACK. */
+#define TF_ACK_NOW     ((tcpflags_t)0x02U)   /* Immediate ACK. */
+#define TF_INFR        ((tcpflags_t)0x04U)   /* In fast recovery. */
+#define TF_TIMESTAMP   ((tcpflags_t)0x08U)   /* Timestamp option enabled */
+#define TF_RXCLOSED    ((tcpflags_t)0x10U)   /* rx closed by tcp_shutdown */
+#define TF_FIN         ((tcpflags_t)0x20U)   /* Connection was closed locally (FIN segment enqueued). */
+#define TF_NODELAY     ((tcpflags_t)0x40U)   /* Disable Nagle algorithm */
+#define TF_NAGLEMEMERR ((tcpflags_t)0x80U)   /* nagle enabled, memerr, try to output to prevent delayed ACK to happen */
+#if LWIP_WND_SCALE
+#define TF_WND_SCALE   ((tcpflags_t)0x0100U) /* Window scale option enabled */
+#endif
+#if LWIP_TCP_SACK
+#define TF_SACK        ((tcpflags_t)0x0200U) /* SACK option enabled */
+#endif
 
   /* the rest of the fields are in host byte order
      as we have to do some math with them */
@@ -196,8 +238,8 @@ struct tcp_pcb {
 
   /* receiver variables */
   u32_t rcv_nxt;   /* next seqno expected */
-  u16_t rcv_wnd;   /* receiver window available */
-  u16_t rcv_ann_wnd; /* receiver window to announce */
+  tcpwnd_size_t rcv_wnd;   /* receiver window available */
+  tcpwnd_size_t rcv_ann_wnd; /* receiver window to announce */
   u32_t rcv_ann_right_edge; /* announced right edge of window */
 
   /* Retransmission timer. */
@@ -218,20 +260,24 @@ struct tcp_pcb {
   u32_t lastack; /* Highest acknowledged seqno. */
 
   /* congestion avoidance/control variables */
-  u16_t cwnd;
-  u16_t ssthresh;
+  tcpwnd_size_t cwnd;
+  tcpwnd_size_t ssthresh;
+#if LWIP_TCP_SACK
+  u32_t sack_high; /* Highest seqno SACKed by the remote host. */
+  u32_t recover;   /* snd_nxt when fast recovery was entered. */
+#endif /* LWIP_TCP_SACK */
 
   /* sender variables */
   u32_t snd_nxt;   /* next new seqno to be sent */
   u32_t snd_wl1, snd_wl2; /* Sequence and acknowledgement numbers of last
                              window update. */
   u32_t snd_lbb;       /* Sequence number of next byte to be buffered. */
-  u16_t snd_wnd;   /* sender window */
-  u16_t snd_wnd_max; /* the maximum sender window announced by the remote host */
+  tcpwnd_size_t snd_wnd;   /* sender window */
+  tcpwnd_size_t snd_wnd_max; /* the maximum sender window announced by the remote host */
 
-  u16_t acked;
+  tcpwnd_size_t acked;
 
-  u16_t snd_buf;   /* Available buffer space for sending (in bytes). */
+  tcpwnd_size_t snd_buf;   /* Available buffer space for sending (in bytes). */
 #define TCP_SNDQUEUELEN_OVERFLOW (0xffffU-3)
   u16_t snd_queuelen; /* Available buffer space for sending (in tcp_segs). */
 
@@ -281,6 +327,11 @@ struct tcp_pcb {
 
   /* KEEPALIVE counter */
   u8_t keep_cnt_sent;
+
+#if LWIP_WND_SCALE
+  u8_t snd_scale;
+  u8_t rcv_scale;
+#endif /* LWIP_WND_SCALE */
 };
 
 struct tcp_pcb_listen {
@@ -333,6 +384,16 @@ void             tcp_err     (struct tcp_pcb *pcb, tcp_err_fn err);
 #define          tcp_nagle_disable(pcb)   ((pcb)->flags |= TF_NODELAY)
 #define          tcp_nagle_enable(pcb)    ((pcb)->flags &= ~TF_NODELAY)
 #define          tcp_nagle_disabled(pcb)  (((pcb)->flags & TF_NODELAY) != 0)
+#define          tcp_sndbufsize(pcb)      ((pcb)->snd_buf_max)
+#define          tcp_rcvbufsize(pcb)      ((pcb)->rcv_wnd_max)
+
+#if LWIP_WND_SCALE
+/** The receive window may only grow beyond 0xffff once scaling is agreed on */
+#define          TCP_WND_MAX(pcb) ((tcpwnd_size_t)(((pcb)->flags & TF_WND_SCALE) ? \
+                                   (pcb)->rcv_wnd_max : TCPWND16((pcb)->rcv_wnd_max)))
+#else /* LWIP_WND_SCALE */
+#define          TCP_WND_MAX(pcb) ((pcb)->rcv_wnd_max)
+#endif /* LWIP_WND_SCALE */
 
 #if TCP_LISTEN_BACKLOG
 #define          tcp_accepted(pcb) do { \
@@ -364,6 +425,8 @@ err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t le
                               u8_t apiflags);
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
+void             tcp_set_sndbufsize(struct tcp_pcb *pcb, tcpwnd_size_t size);
+void             tcp_set_rcvbufsize(struct tcp_pcb *pcb, tcpwnd_size_t size);
 
 #define TCP_PRIO_MIN    1
 #define TCP_PRIO_NORMAL 64
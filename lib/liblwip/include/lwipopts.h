@@ -59,6 +59,7 @@
 
 #define LWIP_NETIF_LOOPBACK			1
 #define LWIP_NETIF_API				0
+#define LWIP_NETIF_OFFLOAD			1
 
 #define CHECKSUM_GEN_IP                 	1
 #define CHECKSUM_GEN_UDP                	1
@@ -68,10 +69,16 @@
 #define CHECKSUM_CHECK_TCP              	1
 
 #define TCP_MSS				(1460)
-#define TCP_SND_BUF			(44 * TCP_MSS)
+#define TCP_SND_BUF			(128 << 10)
 #define TCP_SNDLOWAT			(256)
 #define TCP_SND_QUEUELEN		(512)
-#define TCP_WND				((1 << 16) - 1)	
+#define TCP_WND				(128 << 10)
+#define LWIP_WND_SCALE			1
+#define TCP_RCV_SCALE			4
+#define LWIP_TCP_SACK			1
+#define TCP_PCB_HASH			1
+#define TCP_PCB_HASH_SIZE		1024
+#define TCP_LISTEN_HASH_SIZE		64
 #define PBUF_POOL_BUFSIZE		(2048)
 
 /*
@@ -150,7 +157,7 @@
  * MEMP_NUM_TCP_PCB: the number of simulatenously active TCP connections.
  * (requires the LWIP_TCP option)
  */
-#define MEMP_NUM_TCP_PCB                64
+#define MEMP_NUM_TCP_PCB                512
 
 /**
  * MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP connections.
@@ -162,7 +169,7 @@
  * MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP segments.
  * (requires the LWIP_TCP option)
  */
-#define MEMP_NUM_TCP_SEG                512
+#define MEMP_NUM_TCP_SEG                2048
 
 /**
  * MEMP_NUM_REASSDATA: the number of simultaneously IP packets queued for
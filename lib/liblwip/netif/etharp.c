@@ -1099,6 +1099,13 @@ etharp_query(struct netif *netif, ip_addr_t *ipaddr, struct pbuf *q)
           pbuf_free(p);
           p = NULL;
         }
+#if LWIP_NETIF_OFFLOAD
+        else {
+          /* the copy still leaves for hardware that completes it */
+          p->flags |= q->flags & PBUF_FLAG_CSUM_PARTIAL;
+          p->tso_mss = q->tso_mss;
+        }
+#endif /* LWIP_NETIF_OFFLOAD */
       }
     } else {
       /* referencing the old pbuf is enough */
@@ -43,6 +43,8 @@ static int fs_block_size = 1024;	/* raw i/o block size */
 
 static int rdwt_err;
 
+static unsigned int wb_round;	/* number of lmfs_writeback() calls so far */
+
 u32_t fs_bufs_heuristic(int minbufs, u32_t btotal, u32_t bfree, 
          int blocksize, dev_t majordev)
 {
@@ -96,6 +98,8 @@ u32_t fs_bufs_heuristic(int minbufs, u32_t btotal, u32_t bfree,
 void
 lmfs_markdirty(struct buf *bp)
 {
+	if (bp->lmfs_dirt == BP_CLEAN)
+		bp->lmfs_dirtied = wb_round;
 	bp->lmfs_dirt = BP_DIRTY;
 }
 
@@ -103,6 +107,7 @@ void
 lmfs_markclean(struct buf *bp)
 {
 	bp->lmfs_dirt = BP_CLEAN;
+	bp->lmfs_wbfail = 0;
 }
 
 int 
@@ -391,6 +396,21 @@ void lmfs_invalidate(
   vm_forgetblocks();
 }
 
+/*===========================================================================*
+ *				lmfs_discard				     *
+ *===========================================================================*/
+void lmfs_discard(struct buf *bp)
+{
+/* The contents of a block in use can no longer be trusted, for instance
+ * because a copy into it failed. Forget about it, dirty or not: once it is
+ * released, it is not found again, and the block is read from disk the next
+ * time it is needed.
+ */
+  lmfs_markclean(bp);
+  bp->lmfs_dev = NO_DEV;
+  vm_forgetblocks();
+}
+
 /*===========================================================================*
  *				flushall				     *
  *===========================================================================*/
@@ -670,6 +690,81 @@ void lmfs_flushall(void)
 			flushall(bp->lmfs_dev);
 }
 
+static int cmp_blocknr(const void *a, const void *b)
+{
+	const struct buf *bpa = *(struct buf * const *) a;
+	const struct buf *bpb = *(struct buf * const *) b;
+
+	if (bpa->lmfs_dev != bpb->lmfs_dev)
+		return (bpa->lmfs_dev < bpb->lmfs_dev) ? -1 : 1;
+	return (bpa->lmfs_blocknr < bpb->lmfs_blocknr) ? -1 :
+		(bpa->lmfs_blocknr > bpb->lmfs_blocknr);
+}
+
+/*===========================================================================*
+ *				lmfs_writeback				     *
+ *===========================================================================*/
+void lmfs_writeback(unsigned int age)
+{
+/* Timed writeback. Called periodically by the file system, this writes out
+ * the blocks that have stayed dirty for 'age' or more calls, rather than
+ * leaving them for a sync or an eviction that has to flush the whole cache.
+ * Metadata blocks that are updated over and over again, such as bitmaps and
+ * inode table blocks, are written at most once per 'age' calls. Younger
+ * dirty blocks that are adjacent on disk to an old block go along, so each
+ * write is as long as the dirty run allows.
+ */
+  struct buf *bp;
+  static struct buf **dirty;	/* static so it isn't on stack */
+  static unsigned int dirtylistsize = 0;
+  int i, j, k, ndirty, old;
+
+  if(dirtylistsize != nr_bufs) {
+	if(dirtylistsize > 0) {
+		assert(dirty != NULL);
+		free(dirty);
+	}
+	if(!(dirty = malloc(sizeof(dirty[0])*nr_bufs)))
+		panic("couldn't allocate writeback buf list");
+	dirtylistsize = nr_bufs;
+  }
+
+  /* Collect the dirty blocks of all devices at once, sorted by position. */
+  for (bp = &buf[0], ndirty = 0; bp < &buf[nr_bufs]; bp++) {
+	if (bp->lmfs_dev != NO_DEV && bp->lmfs_dirt == BP_DIRTY &&
+	    !bp->lmfs_wbfail)
+		dirty[ndirty++] = bp;
+  }
+
+  qsort(dirty, ndirty, sizeof(dirty[0]), cmp_blocknr);
+
+  /* Write each run of consecutive blocks holding at least one old block.
+   * Runs are written separately, so that a failing one does not hold up the
+   * others. The blocks of a run that could not be written stay dirty for a
+   * sync or an eviction to write or report, but are not tried here again
+   * until one has, so that a bad spot does not fail every round.
+   */
+  for (i = 0; i < ndirty; i = j) {
+	old = 0;
+	for (j = i; j < ndirty; j++) {
+		if (j > i && (dirty[j]->lmfs_dev != dirty[i]->lmfs_dev ||
+		    dirty[j]->lmfs_blocknr != dirty[j - 1]->lmfs_blocknr + 1))
+			break;
+		if (wb_round - dirty[j]->lmfs_dirtied >= age)
+			old = 1;
+	}
+	if (!old) continue;
+
+	lmfs_rw_scattered(dirty[i]->lmfs_dev, &dirty[i], j - i, WRITING);
+
+	for (k = i; k < j; k++)
+		if (dirty[k]->lmfs_dirt == BP_DIRTY)
+			dirty[k]->lmfs_wbfail = 1;
+  }
+
+  wb_round++;
+}
+
 int lmfs_fs_block_size(void)
 {
 	return fs_block_size;
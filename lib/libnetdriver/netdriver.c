@@ -7,12 +7,20 @@
  *
  *   netdriver_announce: called by a network driver to announce it is up
  *   netdriver_receive:	 receive() interface for network drivers
+ *   netdriver_batch_init:   start serving a DL_READV_M request
+ *   netdriver_batch_next:   get the next free buffer of a DL_READV_M request
+ *   netdriver_batch_fill:   mark that buffer as holding a packet
+ *   netdriver_batch_set:    mark a given buffer as holding a packet
+ *   netdriver_batch_hold:   keep a buffer for direct reception by the device
+ *   netdriver_batch_csum:   mark the checksums of a packet as verified
+ *   netdriver_batch_finish: report the packet sizes back to the client
  */
 
 #include <minix/drivers.h>
 #include <minix/endpoint.h>
 #include <minix/netdriver.h>
 #include <minix/ds.h>
+#include <assert.h>
 
 static int conf_expected = TRUE;
 
@@ -75,3 +83,141 @@ int *status_ptr;
   return OK;
 }
 
+
+/*===========================================================================*
+ *			     netdriver_batch_init			     *
+ *===========================================================================*/
+int netdriver_batch_init(nb, m_ptr)
+struct netdriver_batch *nb;
+const message *m_ptr;
+{
+/* Copy in the buffer vector of a DL_READV_M request. */
+  int r;
+
+  if (m_ptr->DL_COUNT <= 0 || m_ptr->DL_COUNT > DL_READV_M_MAX)
+	return EINVAL;
+
+  nb->nb_client = m_ptr->m_source;
+  nb->nb_grant = m_ptr->DL_GRANT;
+  nb->nb_count = m_ptr->DL_COUNT;
+  nb->nb_filled = 0;
+  nb->nb_cur = -1;
+  nb->nb_done = 0;
+  nb->nb_held = 0;
+  nb->nb_csum = 0;
+
+  r = sys_safecopyfrom(nb->nb_client, nb->nb_grant, 0,
+	(vir_bytes) nb->nb_iovec, nb->nb_count * sizeof(nb->nb_iovec[0]));
+
+  return r;
+}
+
+/*===========================================================================*
+ *			     netdriver_batch_next			     *
+ *===========================================================================*/
+iovec_s_t *netdriver_batch_next(nb)
+struct netdriver_batch *nb;
+{
+/* Return the buffer the next packet goes into, or NULL if none is left. */
+  int i;
+
+  for (i = 0; i < nb->nb_count; i++) {
+	if (!((nb->nb_done | nb->nb_held) & (1UL << i))) {
+		nb->nb_cur = i;
+		return &nb->nb_iovec[i];
+	}
+  }
+
+  return NULL;
+}
+
+/*===========================================================================*
+ *			     netdriver_batch_fill			     *
+ *===========================================================================*/
+void netdriver_batch_fill(nb, size)
+struct netdriver_batch *nb;
+size_t size;
+{
+/* The buffer returned by netdriver_batch_next() now holds a packet. */
+
+  netdriver_batch_set(nb, nb->nb_cur, size);
+}
+
+/*===========================================================================*
+ *			     netdriver_batch_set			     *
+ *===========================================================================*/
+void netdriver_batch_set(nb, slot, size)
+struct netdriver_batch *nb;
+int slot;
+size_t size;
+{
+/* The buffer in the given slot now holds a packet of the given size. */
+
+  assert(slot >= 0 && slot < nb->nb_count);
+  assert(!(nb->nb_done & (1UL << slot)));
+
+  nb->nb_iovec[slot].iov_size = size;
+  nb->nb_done |= 1UL << slot;
+  nb->nb_held &= ~(1UL << slot);
+  nb->nb_filled++;
+}
+
+/*===========================================================================*
+ *			     netdriver_batch_hold			     *
+ *===========================================================================*/
+void netdriver_batch_hold(nb, slot)
+struct netdriver_batch *nb;
+int slot;
+{
+/* The buffer in the given slot has been handed to the device, or still is from
+ * an earlier request. It is not returned by netdriver_batch_next().
+ */
+
+  assert(slot >= 0 && slot < nb->nb_count);
+
+  nb->nb_held |= 1UL << slot;
+}
+
+/*===========================================================================*
+ *			     netdriver_batch_csum			     *
+ *===========================================================================*/
+void netdriver_batch_csum(nb, slot)
+struct netdriver_batch *nb;
+int slot;
+{
+/* The checksums of the packet in the given slot are known to be good. The
+ * driver passes nb_csum to the client in the DL_RXCSUM field of its reply.
+ */
+
+  assert(slot >= 0 && slot < nb->nb_count);
+  assert(nb->nb_done & (1UL << slot));
+
+  nb->nb_csum |= 1UL << slot;
+}
+
+/*===========================================================================*
+ *			    netdriver_batch_finish			     *
+ *===========================================================================*/
+int netdriver_batch_finish(nb)
+struct netdriver_batch *nb;
+{
+/* Store the packet sizes in the client's buffer vector, zero for the buffers
+ * without a packet, and return the number of packets for the DL_COUNT field of
+ * the reply.
+ */
+  int i, r;
+
+  if (nb->nb_filled == 0)
+	return 0;
+
+  for (i = 0; i < nb->nb_count; i++)
+	if (!(nb->nb_done & (1UL << i)))
+		nb->nb_iovec[i].iov_size = 0;
+
+  r = sys_safecopyto(nb->nb_client, nb->nb_grant, 0,
+	(vir_bytes) nb->nb_iovec, nb->nb_count * sizeof(nb->nb_iovec[0]));
+  if (r != OK)
+	panic("netdriver: unable to copy packet sizes: %d", r);
+
+  return nb->nb_filled;
+}
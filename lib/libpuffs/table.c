@@ -43,4 +43,7 @@ int (*fs_call_vec[])(void) = {
     fs_rdlink,          /* 30  */
     fs_getdents,        /* 31  */
     fs_statvfs,		/* 32  */
+    no_sys,             /* 33  */
+    no_sys,             /* 34  */
+    no_sys,             /* 35  */
 };
@@ -42,6 +42,8 @@ int (*call_vec[])(void) = {
 	do_getdents,	/* 31 getdents		*/
 	do_statvfs,	/* 32 statvfs		*/
 	no_sys,		/* 33 peek		*/
+	no_sys,		/* 34 readv		*/
+	no_sys,		/* 35 writev		*/
 };
 
 /* This should not fail with "array size is negative": */
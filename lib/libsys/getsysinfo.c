@@ -17,3 +17,27 @@ int getsysinfo(
   if (_syscall(who, COMMON_GETSYSINFO, &m) < 0) return(-1);
   return(0);
 }
+
+int getsysinfo_delta(
+  endpoint_t who,		/* from whom to request info */
+  int what,			/* what information is requested */
+  void *where,			/* copy of the table to update */
+  size_t size,			/* how big the table is */
+  int *gen			/* generation of the copy (0 at first) */
+)
+{
+/* Update a copy of a table, getting only the entries that changed since
+ * the copy was last updated. On return, '*gen' is the generation to pass
+ * next time.
+ */
+  message m;
+  int r;
+
+  m.SI_WHAT = what;
+  m.SI_WHERE = where;
+  m.SI_SIZE = size;
+  m.SI_GEN = *gen;
+  if ((r = _syscall(who, COMMON_GETSYSINFO, &m)) < 0) return(-1);
+  *gen = r;
+  return(0);
+}
@@ -0,0 +1,24 @@
+#include "syslib.h"
+
+/*===========================================================================*
+ *                                sys_ipctrace				     *
+ *===========================================================================*/
+int sys_ipctrace(action, cpu, endpt, info_ptr, buf_ptr, size)
+int action;				/* start/stop/get */
+int cpu;				/* cpu whose ring to get */
+endpoint_t endpt;			/* caller endpoint */
+void *info_ptr;				/* location of info struct */
+void *buf_ptr;				/* location of entry buffer */
+int size;				/* number of entries in buffer */
+{
+  message m;
+
+  m.ITR_ACTION		= action;
+  m.ITR_CPU		= cpu;
+  m.ITR_ENDPT		= endpt;
+  m.ITR_INFO_PTR	= info_ptr;
+  m.ITR_BUF_PTR		= buf_ptr;
+  m.ITR_SIZE		= size;
+
+  return(_kernel_call(SYS_IPCTRACE, &m));
+}
@@ -0,0 +1,75 @@
+#include "sysutil.h"
+#include <minix/sysinfo.h>
+#include <limits.h>
+
+#define SD_GEN(sd, i) \
+	((int *) ((char *) (sd)->sd_table + (i) * (sd)->sd_size + \
+	(sd)->sd_genoff))
+
+/*===========================================================================*
+ *				sysinfo_delta_touch			     *
+ *===========================================================================*/
+void sysinfo_delta_touch(sd, slot)
+struct sysinfo_delta *sd;		/* table that changed */
+int slot;				/* entry that changed */
+{
+/* Give an entry that changed the next generation. */
+  int i;
+
+  if (sd->sd_seq == INT_MAX) {
+	/* Start over. Callers will find their generation to be newer than
+	 * ours, which makes them get the whole table again.
+	 */
+	for (i = 0; i < sd->sd_count; i++)
+		*SD_GEN(sd, i) = 0;
+	sd->sd_seq = 0;
+  }
+
+  *SD_GEN(sd, slot) = ++sd->sd_seq;
+}
+
+/*===========================================================================*
+ *				sysinfo_delta_copy			     *
+ *===========================================================================*/
+int sysinfo_delta_copy(sd, who, where, size, gen)
+struct sysinfo_delta *sd;		/* table to copy from */
+endpoint_t who;				/* process to copy to */
+vir_bytes where;			/* caller's copy of the table */
+size_t size;				/* size of caller's copy */
+int gen;				/* generation of caller's copy */
+{
+/* Copy the entries that changed after generation 'gen' into the caller's
+ * copy of the table, and return the generation that the copy now has.
+ * Consecutive changed entries are copied at once. A generation of 0, or
+ * one we never handed out, gets the whole table.
+ */
+  vir_bytes offset;
+  int i, first, r;
+
+  if (size != sd->sd_size * sd->sd_count)
+	return(EINVAL);
+
+  if (gen <= 0 || gen > sd->sd_seq) {
+	r = sys_datacopy(SELF, (vir_bytes) sd->sd_table, who, where, size);
+	return(r == OK ? sd->sd_seq : r);
+  }
+
+  for (i = 0; i < sd->sd_count; ) {
+	if (*SD_GEN(sd, i) <= gen) {
+		i++;
+		continue;
+	}
+
+	first = i;
+	while (i < sd->sd_count && *SD_GEN(sd, i) > gen)
+		i++;
+
+	offset = first * sd->sd_size;
+	r = sys_datacopy(SELF, (vir_bytes) sd->sd_table + offset, who,
+		where + offset, (i - first) * sd->sd_size);
+	if (r != OK)
+		return(r);
+  }
+
+  return(sd->sd_seq);
+}
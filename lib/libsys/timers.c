@@ -15,7 +15,7 @@
 #include <timers.h>
 #include <minix/sysutil.h>
 
-static timer_t *timers = NULL;
+static timers_t timers;
 static int expiring = 0;
 
 /*===========================================================================*
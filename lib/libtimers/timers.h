@@ -4,3 +4,18 @@
 
 #include <timers.h>		/* definitions and function prototypes */
 #include <sys/null.h>
+
+#define TMRS_MASK	(TMRS_SLOTS - 1)
+#define TMRS_SPAN	(1UL << (TMRS_BITS * TMRS_LEVELS))	/* ticks covered */
+
+/* A timer is in a queue if the link it was put on still points to it. This
+ * way a stale copy of an active timer structure is not mistaken for it.
+ */
+#define tmrs_active(tp)	((tp)->tmr_prev != NULL && *(tp)->tmr_prev == (tp))
+
+/* Timing wheel internals, in tmrs_wheel.c. */
+void tmrs_link(timers_t *tmrs, timer_t *tp);
+void tmrs_unlink(timers_t *tmrs, timer_t *tp);
+void tmrs_advance(timers_t *tmrs, clock_t when);
+clock_t tmrs_next(timers_t *tmrs);
+clock_t tmrs_earliest(timers_t *tmrs);
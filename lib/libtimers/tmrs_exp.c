@@ -4,28 +4,72 @@
  *				tmrs_exptimers				     *
  *===========================================================================*/
 void tmrs_exptimers(tmrs, now, new_head)
-timer_t **tmrs;				/* pointer to timers queue */
+timers_t *tmrs;				/* pointer to timers queue */
 clock_t now;				/* current time */
 clock_t *new_head;
 {
 /* Use the current time to check the timers queue list for expired timers. 
  * Run the watchdog functions for all expired timers and deactivate them.
  * The caller is responsible for scheduling a new alarm if needed.
+ * The wheel is turned from one tick with work to the next, up to 'now'.
  */
-  timer_t *tp;
+  timer_t *tp, **atp, *parked;
+  clock_t next;
+  int done;
 
-  while ((tp = *tmrs) != NULL && tp->tmr_exp_time <= now) {
-	*tmrs = tp->tmr_next;
-	tp->tmr_exp_time = TMR_NEVER;
-	(*tp->tmr_func)(tp);
-  }
+  /* Watchdog functions may look at the queue while it is being run. */
+  tmrs->tmrs_stale = 1;
+
+  for (;;) {
+	/* Run the timers due on the current tick. */
+	parked = NULL;
+	atp = &tmrs->tmrs_slot[0][tmrs->tmrs_now & TMRS_MASK];
+	while ((tp = *atp) != NULL) {
+		tmrs_unlink(tmrs, tp);
+
+		/* A timer parked at the end of the wheel is not due yet. It
+		 * goes back in once the wheel has moved on.
+		 */
+		if ((long) (tp->tmr_exp_time - tmrs->tmrs_now) > 0) {
+			tp->tmr_next = parked;
+			parked = tp;
+			continue;
+		}
+
+		tp->tmr_exp_time = TMR_NEVER;
+		(*tp->tmr_func)(tp);
+	}
+
+	if (tmrs->tmrs_count == 0 && parked == NULL)
+		break;
 
-  if(new_head) {
-  	if(*tmrs)
-  		*new_head = (*tmrs)->tmr_exp_time;
-  	else
-  		*new_head = 0;
+	/* Move on to the next tick with work, but not beyond 'now'. */
+	done = ((long) (now - tmrs->tmrs_now) <= 0);
+	if (!done) {
+		if (parked != NULL) {
+			next = tmrs->tmrs_now + 1;
+		} else {
+			next = tmrs_next(tmrs);
+			if ((long) (next - now) > 0)
+				next = now;
+		}
+		tmrs_advance(tmrs, next);
+	}
+
+	while ((tp = parked) != NULL) {
+		parked = tp->tmr_next;
+		tmrs_link(tmrs, tp);
+	}
+
+	if (done)
+		break;
   }
-}
 
+  if (tmrs->tmrs_count == 0 && (long) (now - tmrs->tmrs_now) > 0)
+	tmrs->tmrs_now = now;
+  tmrs->tmrs_stale = 1;
+
+  if(new_head)
+  	*new_head = tmrs_earliest(tmrs);
+}
 
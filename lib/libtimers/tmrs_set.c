@@ -4,7 +4,7 @@
  *				tmrs_settimer				     *
  *===========================================================================*/
 clock_t tmrs_settimer(tmrs, tp, exp_time, watchdog, new_head)
-timer_t **tmrs;				/* pointer to timers queue */
+timers_t *tmrs;				/* pointer to timers queue */
 timer_t *tp;				/* the timer to be added */
 clock_t exp_time;			/* its expiration time */
 tmr_func_t watchdog;			/* watchdog function to be run */
@@ -12,28 +12,35 @@ clock_t *new_head;			/* new earliest timer, if non NULL */
 {
 /* Activate a timer to run function 'fp' at time 'exp_time'. If the timer is
  * already in use it is first removed from the timers queue. Then, it is put
- * in the list of active timers with the first to expire in front.
+ * in the slot of the timing wheel that matches its expiration time.
  * The caller responsible for scheduling a new alarm for the timer if needed. 
  */
-  timer_t **atp;
-  clock_t old_head = 0;
+  clock_t old_head;
 
-  if(*tmrs)
-  	old_head = (*tmrs)->tmr_exp_time;
+  old_head = tmrs_earliest(tmrs);
 
-  /* Set the timer's variables. */
-  (void) tmrs_clrtimer(tmrs, tp, NULL);
+  /* Set the timer's variables. The caller may already have changed the
+   * expiration time of an active timer, so its old one is not known.
+   */
+  if (tmrs_active(tp)) {
+	tmrs_unlink(tmrs, tp);
+	tmrs->tmrs_stale = 1;
+  }
   tp->tmr_exp_time = exp_time;
   tp->tmr_func = watchdog;
 
-  /* Add the timer to the active timers. The next timer due is in front. */
-  for (atp = tmrs; *atp != NULL; atp = &(*atp)->tmr_next) {
-	if (exp_time < (*atp)->tmr_exp_time) break;
+  /* Keep track of the next timer due. */
+  if (tmrs->tmrs_count == 0) {
+	tmrs->tmrs_head = exp_time;
+	tmrs->tmrs_stale = 0;
+  } else if (!tmrs->tmrs_stale && exp_time < tmrs->tmrs_head) {
+	tmrs->tmrs_head = exp_time;
   }
-  tp->tmr_next = *atp;
-  *atp = tp;
+
+  tmrs_link(tmrs, tp);
+
   if(new_head)
-  	(*new_head) = (*tmrs)->tmr_exp_time;
+  	(*new_head) = tmrs_earliest(tmrs);
   return old_head;
 }
 
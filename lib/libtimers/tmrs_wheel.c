@@ -0,0 +1,192 @@
+#include "timers.h"
+
+static int first_bit(u32_t bits);
+static u32_t rotate(u32_t bits, int n);
+
+/*===========================================================================*
+ *				first_bit				     *
+ *===========================================================================*/
+static int first_bit(u32_t bits)
+{
+/* Return the number of the lowest bit set in 'bits', which is not zero. */
+  int n = 0;
+
+  if (!(bits & 0xffff)) { n += 16; bits >>= 16; }
+  if (!(bits & 0xff)) { n += 8; bits >>= 8; }
+  if (!(bits & 0xf)) { n += 4; bits >>= 4; }
+  if (!(bits & 0x3)) { n += 2; bits >>= 2; }
+  if (!(bits & 0x1)) n++;
+
+  return(n);
+}
+
+/*===========================================================================*
+ *				rotate					     *
+ *===========================================================================*/
+static u32_t rotate(u32_t bits, int n)
+{
+/* Rotate a slot bitmap so that slot 'n' ends up in bit 0. */
+  if (n == 0) return(bits);
+
+  return((bits >> n) | (bits << (TMRS_SLOTS - n)));
+}
+
+/*===========================================================================*
+ *				tmrs_link				     *
+ *===========================================================================*/
+void tmrs_link(timers_t *tmrs, timer_t *tp)
+{
+/* Put a timer in the slot for its expiration time. A timer goes on the
+ * lowest level whose current turn includes that time, so that every slot
+ * on a level but the first lies ahead of the current one. Timers that have
+ * already expired are due on the current tick. Timers beyond the reach of
+ * the wheel are parked at the end of it, and put back when they get there.
+ */
+  unsigned long now, when, diff;
+  int level, idx;
+  timer_t **atp;
+
+  now = (unsigned long) tmrs->tmrs_now;
+  when = (unsigned long) tp->tmr_exp_time;
+  if ((long) (when - now) < 0)
+	when = now;
+
+  diff = when ^ now;
+  if (diff >= TMRS_SPAN) {
+	when = now | (TMRS_SPAN - 1);
+	diff = when ^ now;
+  }
+
+  for (level = 0; diff >> (TMRS_BITS * (level + 1)); level++)
+	;
+  idx = (when >> (TMRS_BITS * level)) & TMRS_MASK;
+
+  atp = &tmrs->tmrs_slot[level][idx];
+  if ((tp->tmr_next = *atp) != NULL)
+	tp->tmr_next->tmr_prev = &tp->tmr_next;
+  *atp = tp;
+  tp->tmr_prev = atp;
+
+  tmrs->tmrs_busy[level] |= 1UL << idx;
+  tmrs->tmrs_count++;
+}
+
+/*===========================================================================*
+ *				tmrs_unlink				     *
+ *===========================================================================*/
+void tmrs_unlink(timers_t *tmrs, timer_t *tp)
+{
+/* Take an active timer out of its slot. */
+  timer_t **first;
+  int n;
+
+  if ((*tp->tmr_prev = tp->tmr_next) != NULL)
+	tp->tmr_next->tmr_prev = tp->tmr_prev;
+
+  /* If this emptied a slot, clear its bit in the level's bitmap. */
+  first = &tmrs->tmrs_slot[0][0];
+  if (tp->tmr_prev >= first && tp->tmr_prev < first +
+      TMRS_LEVELS * TMRS_SLOTS && *tp->tmr_prev == NULL) {
+	n = tp->tmr_prev - first;
+	tmrs->tmrs_busy[n / TMRS_SLOTS] &= ~(1UL << (n % TMRS_SLOTS));
+  }
+
+  tp->tmr_next = NULL;
+  tp->tmr_prev = NULL;
+  tmrs->tmrs_count--;
+}
+
+/*===========================================================================*
+ *				tmrs_advance				     *
+ *===========================================================================*/
+void tmrs_advance(timers_t *tmrs, clock_t when)
+{
+/* Move the wheel on to tick 'when'. All ticks in between must be free of
+ * work, which tmrs_next() makes sure of. Where a level completes a turn,
+ * the timers in the next slot of the level above are spread out below.
+ */
+  unsigned long now;
+  timer_t *tp;
+  int level, idx;
+
+  tmrs->tmrs_now = when;
+  now = (unsigned long) when;
+
+  for (level = TMRS_LEVELS - 1; level > 0; level--) {
+	if (now & ((1UL << (TMRS_BITS * level)) - 1))
+		continue;
+
+	idx = (now >> (TMRS_BITS * level)) & TMRS_MASK;
+	while ((tp = tmrs->tmrs_slot[level][idx]) != NULL) {
+		tmrs_unlink(tmrs, tp);
+		tmrs_link(tmrs, tp);
+	}
+  }
+}
+
+/*===========================================================================*
+ *				tmrs_next				     *
+ *===========================================================================*/
+clock_t tmrs_next(timers_t *tmrs)
+{
+/* Find the first tick from now on at which there is work: either timers on
+ * level 0 are due, or a slot higher up must be spread out. The wheel must
+ * not be empty.
+ */
+  unsigned long now, when, best;
+  int level, shift, d;
+  u32_t busy;
+
+  now = (unsigned long) tmrs->tmrs_now;
+  best = now - 1;	/* farthest away */
+
+  for (level = 0; level < TMRS_LEVELS; level++) {
+	if ((busy = tmrs->tmrs_busy[level]) == 0)
+		continue;
+
+	shift = TMRS_BITS * level;
+	d = first_bit(rotate(busy, (now >> shift) & TMRS_MASK));
+	when = ((now >> shift) + d) << shift;
+	if ((long) (when - now) < 0)
+		when = now;
+	if (when - now < best - now)
+		best = when;
+  }
+
+  return((clock_t) best);
+}
+
+/*===========================================================================*
+ *				tmrs_earliest				     *
+ *===========================================================================*/
+clock_t tmrs_earliest(timers_t *tmrs)
+{
+/* Return the earliest expiration time in the queue, or 0 if it is empty. The
+ * timers due first are all in the first busy slot of the lowest busy level.
+ */
+  timer_t *tp;
+  clock_t head;
+  int level, idx;
+
+  if (tmrs->tmrs_count == 0)
+	return(0);
+
+  if (tmrs->tmrs_stale) {
+	for (level = 0; tmrs->tmrs_busy[level] == 0; level++)
+		;
+	idx = ((unsigned long) tmrs->tmrs_now >> (TMRS_BITS * level)) &
+		TMRS_MASK;
+	idx = (idx + first_bit(rotate(tmrs->tmrs_busy[level], idx))) &
+		TMRS_MASK;
+
+	tp = tmrs->tmrs_slot[level][idx];
+	for (head = tp->tmr_exp_time; tp != NULL; tp = tp->tmr_next)
+		if (tp->tmr_exp_time < head)
+			head = tp->tmr_exp_time;
+
+	tmrs->tmrs_head = head;
+	tmrs->tmrs_stale = 0;
+  }
+
+  return(tmrs->tmrs_head);
+}
@@ -237,8 +237,8 @@ exchange_features(struct virtio_device *dev)
 		f->host_support =  ((host_features >> f->bit) & 1);
 	}
 
-	/* let the device know about our features */
-	virtio_write32(dev, VIRTIO_GUEST_F_OFF, guest_features);
+	/* let the device know about our features, as far as it offers them */
+	virtio_write32(dev, VIRTIO_GUEST_F_OFF, guest_features & host_features);
 
 	return OK;
 }
@@ -348,6 +348,33 @@ virtio_device_ready(struct virtio_device *dev)
 	virtio_write8(dev, VIRTIO_DEV_STATUS_OFF, VIRTIO_STATUS_DRV_OK);
 }
 
+void
+virtio_restart_device(struct virtio_device *dev)
+{
+	int i;
+	struct virtio_queue *q;
+
+	assert(dev != NULL);
+
+	/* After the reset, the host no longer uses any buffer it was given */
+	virtio_reset_device(dev);
+
+	virtio_write8(dev, VIRTIO_DEV_STATUS_OFF, VIRTIO_STATUS_ACK);
+	exchange_features(dev);
+
+	for (i = 0; i < dev->num_indirect; i++)
+		dev->indirect[i].in_use = 0;
+
+	for (i = 0; i < dev->num_queues; i++) {
+		q = &dev->queues[i];
+		virtio_write16(dev, VIRTIO_QSEL_OFF, i);
+		init_phys_queue(q);
+		virtio_write32(dev, VIRTIO_QADDR_OFF, q->page);
+	}
+
+	virtio_write8(dev, VIRTIO_DEV_STATUS_OFF, VIRTIO_STATUS_DRV);
+}
+
 void
 virtio_free_queues(struct virtio_device *dev)
 {
@@ -38,6 +38,8 @@ int (*fs_call_vec[])(void) = {
 	fs_getdents,	/* 31	getdents	*/
 	fs_statvfs,	/* 32	statvfs		*/
 	no_sys,		/* 33   peek            */
+	no_sys,		/* 34	readv		*/
+	no_sys,		/* 35	writev		*/
 };
 
 /* This should not fail with "array size is negative": */
@@ -182,12 +182,14 @@ struct inode *rip;		/* used for preallocation */
   for (i = 0; i <= sp->s_groups_count; i++, group++) {
 	struct buf *bp;
 	struct group_desc *gd;
+	struct group_hint *gh;
 
 	if (group >= sp->s_groups_count)
 		group = 0;
 
 	gd = get_group_desc(group);
-	if (gd == NULL)
+	gh = get_group_hint(group);
+	if (gd == NULL || gh == NULL)
 		panic("can't get group_desc to alloc block");
 
 	if (gd->free_blocks_count == 0) {
@@ -195,6 +197,10 @@ struct inode *rip;		/* used for preallocation */
 		continue;
 	}
 
+	/* There are no free blocks below the hint, skip that part. */
+	if (word < gh->gh_bword)
+		word = gh->gh_bword;
+
 	bp = get_block(sp->s_dev, gd->block_bitmap, NORMAL);
 
 	if (rip->i_preallocation &&
@@ -239,7 +245,8 @@ struct inode *rip;		/* used for preallocation */
 
         bit = setbit(b_bitmap(bp), sp->s_blocks_per_group, word);
 	if (bit == -1) {
-		if (word == 0) {
+		put_block(bp, MAP_BLOCK);
+		if (word <= gh->gh_bword) {
 			panic("ext2: allocator failed to allocate a bit in bitmap\
 				with free bits.");
 		} else {
@@ -248,6 +255,10 @@ struct inode *rip;		/* used for preallocation */
 		}
 	}
 
+	/* Searched from the hint, so everything below 'bit' is in use now. */
+	if (word == gh->gh_bword)
+		gh->gh_bword = bit / FS_BITCHUNK_BITS;
+
 	block = sp->s_first_data_block + group * sp->s_blocks_per_group + bit;
 	check_block_number(block, sp, gd);
 
@@ -280,6 +291,7 @@ void free_block(struct super_block *sp, bit_t bit_returned)
   int bit;		/* bit_returned number within its group */
   struct buf *bp;
   struct group_desc *gd;
+  struct group_hint *gh;
 
   if (sp->s_rd_only)
 	panic("can't free bit on read-only filesys.");
@@ -319,6 +331,10 @@ void free_block(struct super_block *sp, bit_t bit_returned)
   lmfs_markdirty(bp);
   put_block(bp, MAP_BLOCK);
 
+  gh = get_group_hint(group);
+  if (gh != NULL && bit / FS_BITCHUNK_BITS < gh->gh_bword)
+	gh->gh_bword = bit / FS_BITCHUNK_BITS;
+
   gd->free_blocks_count++;
   sp->s_free_blocks_count++;
 
@@ -178,5 +178,25 @@
 
 #define EXT2_PREALLOC_BLOCKS		8
 
+/* Superblock s_flags, tell how chars were treated by the HTree hash. */
+#define EXT2_FLAGS_SIGNED_HASH		0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+/* HTree (directory index) hash versions. */
+#define DX_HASH_LEGACY			0
+#define DX_HASH_HALF_MD4		1
+#define DX_HASH_TEA			2
+#define DX_HASH_LEGACY_UNSIGNED		3
+#define DX_HASH_HALF_MD4_UNSIGNED	4
+#define DX_HASH_TEA_UNSIGNED		5
+
+/* HTree layout: the root lives in the first directory block after the fake
+ * "." and ".." entries, interior nodes after one fake empty entry.
+ */
+#define DX_ROOT_INFO_OFFSET		24
+#define DX_NODE_OFFSET			8
+#define DX_MAX_DEPTH			3	/* root plus two index levels */
+#define DX_BLOCK_MASK			0x0fffffff
+
 
 #endif /* EXT2_CONST_H */
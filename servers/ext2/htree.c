@@ -0,0 +1,416 @@
+/* This file contains the HTree (dir_index) support. Directories indexed by
+ * Linux carry a B-tree of name hashes in blocks that look like empty entries
+ * to a linear scan, so the index can be used for lookups and simply dropped
+ * when it cannot be kept up to date.
+ *
+ * The entry points into this file are
+ *   htree_lookup:	find the leaf block a name belongs in
+ *   htree_next:	find the next leaf holding names with the same hash
+ *
+ * The hash functions were taken from linux/fs/ext2/hash.c.
+ */
+
+#include "fs.h"
+#include <string.h>
+#include "buf.h"
+#include "inode.h"
+#include "super.h"
+#include "const.h"
+
+static u32_t dx_hack_hash(const char *name, int len, int unsigned_char);
+static void str2hashbuf(const char *msg, int len, u32_t *buf, int num, int
+	unsigned_char);
+static void tea_transform(u32_t buf[4], u32_t const in[4]);
+static void half_md4_transform(u32_t buf[4], u32_t const in[8]);
+static u32_t htree_hash(struct super_block *sp, const char *name, int
+	version);
+static struct dx_entry *dx_node(struct inode *dirp, struct buf *bp, int
+	level, int root_off, unsigned int *countp);
+
+
+/*===========================================================================*
+ *				dx_hack_hash				     *
+ *===========================================================================*/
+static u32_t dx_hack_hash(const char *name, int len, int unsigned_char)
+{
+/* The legacy hash. */
+  u32_t hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+  int c;
+
+  while (len--) {
+	c = unsigned_char ? (int) *(const unsigned char *) name :
+		(int) *(const signed char *) name;
+	name++;
+	hash = hash1 + (hash0 ^ (c * 7152373));
+
+	if (hash & 0x80000000)
+		hash -= 0x7fffffff;
+	hash1 = hash0;
+	hash0 = hash;
+  }
+  return hash0 << 1;
+}
+
+
+/*===========================================================================*
+ *				str2hashbuf				     *
+ *===========================================================================*/
+static void str2hashbuf(const char *msg, int len, u32_t *buf, int num,
+	int unsigned_char)
+{
+/* Pack up to 'num' words of the name into 'buf', padded with the length. */
+  u32_t pad, val;
+  int i, c;
+
+  pad = (u32_t) len | ((u32_t) len << 8);
+  pad |= pad << 16;
+
+  val = pad;
+  if (len > num * 4)
+	len = num * 4;
+  for (i = 0; i < len; i++) {
+	c = unsigned_char ? (int) ((const unsigned char *) msg)[i] :
+		(int) ((const signed char *) msg)[i];
+	val = c + (val << 8);
+	if ((i % 4) == 3) {
+		*buf++ = val;
+		val = pad;
+		num--;
+	}
+  }
+  if (--num >= 0)
+	*buf++ = val;
+  while (--num >= 0)
+	*buf++ = pad;
+}
+
+
+/*===========================================================================*
+ *				tea_transform				     *
+ *===========================================================================*/
+static void tea_transform(u32_t buf[4], u32_t const in[4])
+{
+  u32_t sum = 0;
+  u32_t b0 = buf[0], b1 = buf[1];
+  u32_t a = in[0], b = in[1], c = in[2], d = in[3];
+  int n = 16;
+
+  do {
+	sum += 0x9E3779B9;
+	b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+	b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+  } while (--n);
+
+  buf[0] += b0;
+  buf[1] += b1;
+}
+
+
+/* F, G and H are basic MD4 functions: selection, majority, parity */
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+
+#define ROL32(x, s) (((x) << (s)) | ((x) >> (32 - (s))))
+#define ROUND(f, a, b, c, d, x, s) \
+	(a += f(b, c, d) + (x), a = ROL32(a, s))
+#define K1 0
+#define K2 013240474631UL
+#define K3 015666365641UL
+
+/*===========================================================================*
+ *				half_md4_transform			     *
+ *===========================================================================*/
+static void half_md4_transform(u32_t buf[4], u32_t const in[8])
+{
+  u32_t a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+  /* Round 1 */
+  ROUND(F, a, b, c, d, in[0] + K1,  3);
+  ROUND(F, d, a, b, c, in[1] + K1,  7);
+  ROUND(F, c, d, a, b, in[2] + K1, 11);
+  ROUND(F, b, c, d, a, in[3] + K1, 19);
+  ROUND(F, a, b, c, d, in[4] + K1,  3);
+  ROUND(F, d, a, b, c, in[5] + K1,  7);
+  ROUND(F, c, d, a, b, in[6] + K1, 11);
+  ROUND(F, b, c, d, a, in[7] + K1, 19);
+
+  /* Round 2 */
+  ROUND(G, a, b, c, d, in[1] + K2,  3);
+  ROUND(G, d, a, b, c, in[3] + K2,  5);
+  ROUND(G, c, d, a, b, in[5] + K2,  9);
+  ROUND(G, b, c, d, a, in[7] + K2, 13);
+  ROUND(G, a, b, c, d, in[0] + K2,  3);
+  ROUND(G, d, a, b, c, in[2] + K2,  5);
+  ROUND(G, c, d, a, b, in[4] + K2,  9);
+  ROUND(G, b, c, d, a, in[6] + K2, 13);
+
+  /* Round 3 */
+  ROUND(H, a, b, c, d, in[3] + K3,  3);
+  ROUND(H, d, a, b, c, in[7] + K3,  9);
+  ROUND(H, c, d, a, b, in[2] + K3, 11);
+  ROUND(H, b, c, d, a, in[6] + K3, 15);
+  ROUND(H, a, b, c, d, in[1] + K3,  3);
+  ROUND(H, d, a, b, c, in[5] + K3,  9);
+  ROUND(H, c, d, a, b, in[0] + K3, 11);
+  ROUND(H, b, c, d, a, in[4] + K3, 15);
+
+  buf[0] += a;
+  buf[1] += b;
+  buf[2] += c;
+  buf[3] += d;
+}
+
+
+/*===========================================================================*
+ *				htree_hash				     *
+ *===========================================================================*/
+static u32_t htree_hash(struct super_block *sp, const char *name, int version)
+{
+/* Hash a name the way Linux does for the given hash version. The low bit is
+ * reserved in index entries to mark hash collisions across leaves.
+ */
+  u32_t hash, in[8], buf[4];
+  int i, len, unsigned_char;
+
+  len = strlen(name);
+
+  /* Default seed, used when the superblock has none. */
+  buf[0] = 0x67452301;
+  buf[1] = 0xefcdab89;
+  buf[2] = 0x98badcfe;
+  buf[3] = 0x10325476;
+  for (i = 0; i < 4; i++) {
+	if (sp->s_hash_seed[i] != 0) {
+		memcpy(buf, sp->s_hash_seed, sizeof(buf));
+		break;
+	}
+  }
+
+  unsigned_char = (version >= DX_HASH_LEGACY_UNSIGNED);
+
+  switch (version) {
+	case DX_HASH_LEGACY:
+	case DX_HASH_LEGACY_UNSIGNED:
+		hash = dx_hack_hash(name, len, unsigned_char);
+		break;
+	case DX_HASH_HALF_MD4:
+	case DX_HASH_HALF_MD4_UNSIGNED:
+		for (; len > 0; len -= 32, name += 32) {
+			str2hashbuf(name, len, in, 8, unsigned_char);
+			half_md4_transform(buf, in);
+		}
+		hash = buf[1];
+		break;
+	case DX_HASH_TEA:
+	case DX_HASH_TEA_UNSIGNED:
+		for (; len > 0; len -= 16, name += 16) {
+			str2hashbuf(name, len, in, 4, unsigned_char);
+			tea_transform(buf, in);
+		}
+		hash = buf[0];
+		break;
+	default:
+		return 0;
+  }
+
+  hash &= ~1;
+  if (hash == 0xfffffffeUL)	/* reserved as end of directory marker */
+	hash = 0xfffffffcUL;
+  return hash;
+}
+
+
+/*===========================================================================*
+ *				dx_node					     *
+ *===========================================================================*/
+static struct dx_entry *dx_node(struct inode *dirp, struct buf *bp,
+	int level, int root_off, unsigned int *countp)
+{
+/* Return the entries of the index node in 'bp', or NULL if the node does
+ * not look sane. The root node is at level 0.
+ */
+  struct dx_entry *entries;
+  struct dx_countlimit *cl;
+  unsigned int count, limit, off;
+
+  off = (level == 0 ? root_off : DX_NODE_OFFSET);
+  entries = (struct dx_entry *) &b_data(bp)[off];
+  cl = (struct dx_countlimit *) entries;
+  count = conv2(le_CPU, cl->count);
+  limit = conv2(le_CPU, cl->limit);
+
+  if (count == 0 || count > limit ||
+      off + limit * sizeof(struct dx_entry) > dirp->i_sp->s_block_size)
+	return(NULL);
+
+  *countp = count;
+  return(entries);
+}
+
+
+/*===========================================================================*
+ *				htree_lookup				     *
+ *===========================================================================*/
+int htree_lookup(
+  struct inode *dirp,		/* directory to search */
+  const char *name,		/* name to look for or enter */
+  struct htree_cursor *hc	/* on success, leaf to search */
+)
+{
+/* Walk the index of 'dirp' down to the leaf block 'name' belongs in. Return
+ * OK with the position of the leaf in hc->hc_pos, or an error if the
+ * directory is not indexed, or the index cannot be used and the caller must
+ * fall back to a linear search.
+ */
+  struct super_block *sp = dirp->i_sp;
+  struct dx_root_info *info;
+  struct dx_entry *entries;
+  struct buf *bp;
+  unsigned int count, lo, hi, mid, idx;
+  int level, version;
+  block_t b;
+  off_t pos;
+
+  if (!HAS_COMPAT_FEATURE(sp, COMPAT_DIR_INDEX) ||
+      !(dirp->i_flags & EXT2_INDEX_FL))
+	return(EINVAL);
+
+  /* "." and ".." live in the root block and are not in the index. */
+  if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	return(EINVAL);
+
+  if ((b = read_map(dirp, 0)) == NO_BLOCK)
+	return(EINVAL);
+  bp = get_block(dirp->i_dev, b, NORMAL);
+
+  info = (struct dx_root_info *) &b_data(bp)[DX_ROOT_INFO_OFFSET];
+  version = info->hash_version;
+  if (info->reserved_zero != 0 || version > DX_HASH_TEA ||
+      info->indirect_levels >= DX_MAX_DEPTH) {
+	put_block(bp, DIRECTORY_BLOCK);
+	return(EINVAL);
+  }
+  if (sp->s_flags & EXT2_FLAGS_UNSIGNED_HASH)
+	version += DX_HASH_LEGACY_UNSIGNED;
+
+  hc->hc_hash = htree_hash(sp, name, version);
+  hc->hc_levels = info->indirect_levels;
+  hc->hc_root_off = DX_ROOT_INFO_OFFSET + info->info_length;
+
+  pos = 0;
+  for (level = 0; ; level++) {
+	entries = dx_node(dirp, bp, level, hc->hc_root_off, &count);
+	if (entries == NULL) {
+		put_block(bp, DIRECTORY_BLOCK);
+		return(EINVAL);
+	}
+
+	/* Find the last entry whose hash is not above the name's hash. The
+	 * first entry has no hash, it covers everything below the second.
+	 */
+	idx = 0;
+	lo = 1;
+	hi = count - 1;
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+		if ((u32_t) conv4(le_CPU, entries[mid].hash) > hc->hc_hash) {
+			hi = mid - 1;
+		} else {
+			idx = mid;
+			lo = mid + 1;
+		}
+	}
+
+	hc->hc_frame[level].hf_pos = pos;
+	hc->hc_frame[level].hf_index = idx;
+
+	pos = (off_t) (conv4(le_CPU, entries[idx].block) & DX_BLOCK_MASK) *
+		sp->s_block_size;
+	put_block(bp, DIRECTORY_BLOCK);
+
+	if (pos >= (off_t) dirp->i_size)
+		return(EINVAL);
+	if (level == hc->hc_levels)
+		break;
+
+	if ((b = read_map(dirp, pos)) == NO_BLOCK)
+		return(EINVAL);
+	bp = get_block(dirp->i_dev, b, NORMAL);
+  }
+
+  hc->hc_pos = pos;
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				htree_next				     *
+ *===========================================================================*/
+int htree_next(struct inode *dirp, struct htree_cursor *hc)
+{
+/* The leaf at hc->hc_pos did not have the name. If the hash continues in the
+ * next leaf (a leaf was split in the middle of a run of equal hashes), move
+ * the cursor there and return OK. Return ENOENT if the name cannot be in the
+ * directory, or another error if the caller must fall back to a linear search.
+ */
+  struct dx_entry *entries;
+  struct buf *bp;
+  unsigned int count;
+  int level;
+  block_t b;
+  off_t pos;
+
+  /* Go up until some index node has entries after the one we followed. */
+  for (level = hc->hc_levels; ; level--) {
+	if (level < 0)
+		return(ENOENT);
+	if ((b = read_map(dirp, hc->hc_frame[level].hf_pos)) == NO_BLOCK)
+		return(EINVAL);
+	bp = get_block(dirp->i_dev, b, NORMAL);
+	if ((entries = dx_node(dirp, bp, level, hc->hc_root_off,
+	    &count)) == NULL) {
+		put_block(bp, DIRECTORY_BLOCK);
+		return(EINVAL);
+	}
+	if (hc->hc_frame[level].hf_index + 1 < count)
+		break;
+	put_block(bp, DIRECTORY_BLOCK);
+  }
+
+  /* A set low bit in the next hash says it equals the one before it. */
+  hc->hc_frame[level].hf_index++;
+  if (((u32_t) conv4(le_CPU, entries[hc->hc_frame[level].hf_index].hash)
+      & ~1) != hc->hc_hash) {
+	put_block(bp, DIRECTORY_BLOCK);
+	return(ENOENT);
+  }
+
+  /* Go down the leftmost entries to the next leaf. */
+  for (;;) {
+	pos = (off_t) (conv4(le_CPU,
+		entries[hc->hc_frame[level].hf_index].block) & DX_BLOCK_MASK) *
+		dirp->i_sp->s_block_size;
+	put_block(bp, DIRECTORY_BLOCK);
+
+	if (pos >= (off_t) dirp->i_size)
+		return(EINVAL);
+	if (level == hc->hc_levels)
+		break;
+
+	level++;
+	hc->hc_frame[level].hf_pos = pos;
+	hc->hc_frame[level].hf_index = 0;
+	if ((b = read_map(dirp, pos)) == NO_BLOCK)
+		return(EINVAL);
+	bp = get_block(dirp->i_dev, b, NORMAL);
+	if ((entries = dx_node(dirp, bp, level, hc->hc_root_off,
+	    &count)) == NULL) {
+		put_block(bp, DIRECTORY_BLOCK);
+		return(EINVAL);
+	}
+  }
+
+  hc->hc_pos = pos;
+  return(OK);
+}
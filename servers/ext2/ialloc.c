@@ -129,6 +129,7 @@ int is_dir;			/* inode will be a directory if it is TRUE */
   bit_t bit;
   struct buf *bp;
   struct group_desc *gd;
+  struct group_hint *gh;
 
   if (sp->s_rd_only)
 	panic("can't alloc inode on read-only filesys.");
@@ -151,7 +152,8 @@ int is_dir;			/* inode will be a directory if it is TRUE */
 	return(NO_BIT);	/* no bit could be allocated */
 
   gd = get_group_desc(group);
-  if (gd == NULL)
+  gh = get_group_hint(group);
+  if (gd == NULL || gh == NULL)
 	  panic("can't get group_desc to alloc block");
 
   /* find_group_* should always return either a group with
@@ -160,8 +162,9 @@ int is_dir;			/* inode will be a directory if it is TRUE */
   ASSERT(gd->free_inodes_count);
 
   bp = get_block(sp->s_dev, gd->inode_bitmap, NORMAL);
-  bit = setbit(b_bitmap(bp), sp->s_inodes_per_group, 0);
+  bit = setbit(b_bitmap(bp), sp->s_inodes_per_group, gh->gh_iword);
   ASSERT(bit != -1); /* group definitly contains free inode */
+  gh->gh_iword = bit / FS_BITCHUNK_BITS;
 
   inumber = group * sp->s_inodes_per_group + bit + 1;
 
@@ -208,6 +211,7 @@ static void free_inode_bit(struct super_block *sp, bit_t bit_returned,
   int bit;		/* bit_returned number within its group */
   struct buf *bp;
   struct group_desc *gd;
+  struct group_hint *gh;
 
   if (sp->s_rd_only)
 	panic("can't free bit on read-only filesys.");
@@ -234,6 +238,10 @@ static void free_inode_bit(struct super_block *sp, bit_t bit_returned,
   lmfs_markdirty(bp);
   put_block(bp, MAP_BLOCK);
 
+  gh = get_group_hint(group);
+  if (gh != NULL && bit / FS_BITCHUNK_BITS < gh->gh_iword)
+	gh->gh_iword = bit / FS_BITCHUNK_BITS;
+
   gd->free_inodes_count++;
   sp->s_free_inodes_count++;
 
@@ -511,6 +511,8 @@ int ftype;			 /* used when ENTER and
   int extended = 0;
   int required_space = 0;
   int string_len = 0;
+  int hashed = FALSE;
+  struct htree_cursor hc;
 
   /* If 'ldir_ptr' is not a pointer to a dir inode, error. */
   if ( (ldir_ptr->i_mode & I_TYPE) != I_DIRECTORY)  {
@@ -547,6 +549,19 @@ int ftype;			 /* used when ENTER and
 		pos = ldir_ptr->i_last_dpos;
   }
 
+  /* In an indexed directory, only the leaf the name hashes to has to be
+   * searched. A new name must go into that leaf too, or the index is lost.
+   */
+  if (flag != IS_EMPTY) {
+	if (htree_lookup(ldir_ptr, string, &hc) == OK) {
+		hashed = TRUE;
+		pos = hc.hc_pos;
+	} else if (flag == ENTER && (ldir_ptr->i_flags & EXT2_INDEX_FL) &&
+		   string != dot1 && string != dot2) {
+		ldir_ptr->i_flags &= ~EXT2_INDEX_FL;
+	}
+  }
+
   for (; pos < ldir_ptr->i_size; pos += ldir_ptr->i_sp->s_block_size) {
 	b = read_map(ldir_ptr, pos);	/* get block number */
 
@@ -590,15 +605,11 @@ int ftype;			 /* used when ENTER and
 				dp->d_ino = NO_ENTRY;	/* erase entry */
 				lmfs_markdirty(bp);
 
-				/* If we don't support HTree (directory index),
-				 * which is fully compatible ext2 feature,
-				 * we should reset EXT2_INDEX_FL, when modify
-				 * linked directory structure.
-				 *
-				 * @TODO: actually we could just reset it for
-				 * each directory, but I added if() to not
-				 * forget about it later, when add HTree
-				 * support.
+				/* Deleting an entry keeps the HTree (directory
+				 * index) valid, but without the dir_index
+				 * feature nobody maintains it, so reset
+				 * EXT2_INDEX_FL when we modify the linked
+				 * directory structure.
 				 */
 				if (!HAS_COMPAT_FEATURE(ldir_ptr->i_sp,
 							COMPAT_DIR_INDEX))
@@ -663,6 +674,27 @@ int ftype;			 /* used when ENTER and
 	/* The whole block has been searched or ENTER has a free slot. */
 	if (e_hit) break;	/* e_hit set if ENTER can be performed now */
 	put_block(bp, DIRECTORY_BLOCK); /* otherwise, continue searching dir */
+
+	if (hashed) {
+		if (flag == ENTER) {
+			/* The leaf is full. We do not split leaves, so drop
+			 * the index and make this a linear directory.
+			 */
+			ldir_ptr->i_flags &= ~EXT2_INDEX_FL;
+			r = EINVAL;
+		} else {
+			r = htree_next(ldir_ptr, &hc);
+		}
+
+		if (r == ENOENT) break;		/* name is not there */
+		if (r == OK) {
+			pos = hc.hc_pos - ldir_ptr->i_sp->s_block_size;
+		} else {
+			/* The index can't tell, search the whole directory. */
+			hashed = FALSE;
+			pos = -ldir_ptr->i_sp->s_block_size;
+		}
+	}
   }
 
   /* The whole directory has now been searched. */
@@ -673,8 +705,10 @@ int ftype;			 /* used when ENTER and
   /* When ENTER next time, start searching for free slot from
    * i_last_dpos. It gives solid performance improvement.
    */
-  ldir_ptr->i_last_dpos = pos;
-  ldir_ptr->i_last_dentry_size = required_space;
+  if (!hashed) {
+	ldir_ptr->i_last_dpos = pos;
+	ldir_ptr->i_last_dentry_size = required_space;
+  }
 
   /* This call is for ENTER.  If no free slot has been found so far, try to
    * extend directory.
@@ -9,6 +9,7 @@
 /* Structs used in prototypes must be declared as such first. */
 struct buf;
 struct filp;
+struct htree_cursor;
 struct inode;
 struct super_block;
 
@@ -18,6 +19,11 @@ void discard_preallocated_blocks(struct inode *rip);
 block_t alloc_block(struct inode *rip, block_t goal);
 void free_block(struct super_block *sp, bit_t bit);
 
+/* htree.c */
+int htree_lookup(struct inode *dirp, const char *name, struct htree_cursor
+	*hc);
+int htree_next(struct inode *dirp, struct htree_cursor *hc);
+
 /* ialloc.c */
 struct inode *alloc_inode(struct inode *parent, mode_t bits);
 void free_inode(struct inode *rip);
@@ -89,6 +95,7 @@ struct super_block *get_super(dev_t dev);
 int read_super(struct super_block *sp);
 void write_super(struct super_block *sp);
 struct group_desc* get_group_desc(unsigned int bnum);
+struct group_hint* get_group_hint(unsigned int bnum);
 
 /* time.c */
 int fs_utime(void);
@@ -3,6 +3,8 @@
  * The entry points into this file are
  *   get_super:       search the 'superblock' table for a device
  *   read_super:      read a superblock
+ *   get_group_desc:  return the descriptor of a block group
+ *   get_group_hint:  return the bitmap search hints of a block group
  *
  * Created (MFS based):
  *   February 2010 (Evgeniy Ivanov)
@@ -71,6 +73,8 @@ register struct super_block *sp; /* pointer to a superblock */
   int r;
   /* group descriptors, sp->s_group_desc points to this. */
   static struct group_desc *group_descs;
+  /* per group search hints, sp->s_group_hint points to this. */
+  static struct group_hint *group_hints;
   char *buf;
   block_t gd_size; /* group descriptors table size in blocks */
   int gdt_position;
@@ -189,6 +193,15 @@ register struct super_block *sp; /* pointer to a superblock */
   copy_group_descriptors(group_descs, ondisk_group_descs, sp->s_groups_count);
   sp->s_group_desc = group_descs;
 
+  /* Nothing is known about the bitmaps yet, so start all searches at the
+   * beginning of each group's bitmaps.
+   */
+  free(group_hints);
+  group_hints = calloc(sp->s_groups_count, sizeof(*group_hints));
+  if (group_hints == NULL)
+	panic("can't allocate memory for group hints");
+  sp->s_group_hint = group_hints;
+
   /* Make a few basic checks to see if super block looks reasonable. */
   if (sp->s_inodes_count < 1 || sp->s_blocks_count < 1) {
 	printf("not enough inodes or data blocks, \n");
@@ -271,6 +284,19 @@ struct group_desc* get_group_desc(unsigned int bnum)
 }
 
 
+/*===========================================================================*
+ *                              get_group_hint                               *
+ *===========================================================================*/
+struct group_hint* get_group_hint(unsigned int bnum)
+{
+  if (bnum >= superblock->s_groups_count) {
+	printf("ext2, get_group_hint: wrong bnum (%d) requested\n", bnum);
+	return NULL;
+  }
+  return &superblock->s_group_hint[bnum];
+}
+
+
 static u32_t ext2_count_dirs(struct super_block *sp)
 {
   u32_t count = 0;
@@ -359,6 +385,8 @@ static void super_copy(
 /* Note: we don't convert stuff, used in ext3. */
 {
 /* Copy super_block to the in-core table, swapping bytes if need be. */
+  int i;
+
   if (le_CPU) {
 	/* Just use memcpy */
 	memcpy(dest, source, SUPER_SIZE_D);
@@ -405,6 +433,10 @@ static void super_copy(
   dest->s_prealloc_blocks = source->s_prealloc_blocks;
   dest->s_prealloc_dir_blocks = source->s_prealloc_dir_blocks;
   dest->s_padding1 = conv2(le_CPU, source->s_padding1);
+  for (i = 0; i < 4; i++)
+	dest->s_hash_seed[i] = conv4(le_CPU, source->s_hash_seed[i]);
+  dest->s_def_hash_version = source->s_def_hash_version;
+  dest->s_flags = conv4(le_CPU, source->s_flags);
 }
 
 
@@ -79,7 +79,15 @@ EXTERN struct super_block {
     u16_t   s_reserved_word_pad;
     u32_t   s_default_mount_opts;
     u32_t   s_first_meta_bg;        /* First metablock block group */
-    u32_t   s_reserved[190];        /* Padding to the end of the block */
+    u32_t   s_mkfs_time;            /* When the filesystem was created */
+    u32_t   s_jnl_blocks[17];       /* Backup of the journal inode */
+    u32_t   s_blocks_count_hi;      /* Blocks count (high 32 bits) */
+    u32_t   s_r_blocks_count_hi;    /* Reserved blocks count (high) */
+    u32_t   s_free_blocks_hi;       /* Free blocks count (high) */
+    u16_t   s_min_extra_isize;      /* All inodes have at least # bytes */
+    u16_t   s_want_extra_isize;     /* New inodes should reserve # bytes */
+    u32_t   s_flags;                /* Miscellaneous flags */
+    u32_t   s_reserved[167];        /* Padding to the end of the block */
 
     /* The following items are only used when the super_block is in memory. */
     u32_t   s_inodes_per_block;     /* Number of inodes per block */
@@ -92,6 +100,7 @@ EXTERN struct super_block {
                                      * always s_log_block_size+10.
                                      */
     struct group_desc *s_group_desc; /* Group descriptors read into RAM */
+    struct group_hint *s_group_hint; /* Per group bitmap search hints */
 
     u16_t   s_block_size;       /* block size in bytes. */
     u16_t   s_sectors_in_block; /* s_block_size / 512 */
@@ -121,6 +130,15 @@ struct group_desc
     u32_t  reserved[3];
 };
 
+/* In-memory only, one per group. All bitmap words below these are known to
+ * be fully in use, so bitmap searches in the group can start here.
+ */
+struct group_hint
+{
+    u32_t  gh_bword;            /* first block bitmap word with a free bit */
+    u32_t  gh_iword;            /* first inode bitmap word with a free bit */
+};
+
 #define IMAP	0           /* operating on the inode bit map */
 #define BMAP	1           /* operating on the block bit map */
 #define IMAPD	2           /* operating on the inode bit map, inode is dir */
@@ -47,4 +47,6 @@ int (*fs_call_vec[])(void) = {
     fs_getdents,        /* 31  */
     fs_statvfs,		/* 32  */
     fs_readwrite,       /* 33  */
+    no_sys,             /* 34  */
+    no_sys,             /* 35  */
 };
@@ -75,6 +75,43 @@ struct ext2_disk_dir_desc {
   char      d_name[1];
 };
 
+/* HTree (directory index) on-disk structures. The root info follows the
+ * fake "." and ".." entries in the first block of an indexed directory. Each
+ * index node is an array of dx_entry, where the hash of the first entry is
+ * replaced by dx_countlimit.
+ */
+struct dx_root_info {
+  u32_t     reserved_zero;
+  u8_t      hash_version;
+  u8_t      info_length;	/* 8 */
+  u8_t      indirect_levels;
+  u8_t      unused_flags;
+};
+
+struct dx_countlimit {
+  u16_t     limit;
+  u16_t     count;
+};
+
+struct dx_entry {
+  u32_t     hash;
+  u32_t     block;		/* logical block in the directory */
+};
+
+/* Path taken through an HTree by htree_lookup(), so htree_next() can move on
+ * to the following leaf.
+ */
+struct htree_cursor {
+  u32_t     hc_hash;		/* hash of the name looked up */
+  int       hc_levels;		/* number of index levels below the root */
+  int       hc_root_off;	/* offset of the entries in the root block */
+  off_t     hc_pos;		/* position of the current leaf block */
+  struct {
+	off_t hf_pos;		/* position of the index block */
+	unsigned int hf_index;	/* entry followed in that block */
+  } hc_frame[DX_MAX_DEPTH];
+};
+
 /* Current position in block */
 #define CUR_DISC_DIR_POS(cur_desc, base)  ((char*)cur_desc - (char*)base)
 /* Return pointer to the next dentry */
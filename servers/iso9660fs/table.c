@@ -41,5 +41,7 @@ int (*fs_call_vec[])(void) = {
   no_sys,			/* 30: not used */
   fs_getdents,			/* 31 */
   fs_statvfs,			/* 32 */
-  fs_read			/* 33 */
+  fs_read,			/* 33 */
+  no_sys,			/* 34: not used */
+  no_sys,			/* 35: not used */
 };
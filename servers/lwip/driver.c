@@ -114,8 +114,11 @@ void nic_init_all(void)
 
 		if (cpf_getgrants(&devices[i].rx_iogrant, 1) != 1)
 			panic("Cannot initialize grants");
-		if (cpf_getgrants(&devices[i].rx_iovec[0].iov_grant, 1) != 1)
-			panic("Cannot initialize grants");
+		for (g = 0; g < RX_IOVEC_NUM; g++) {
+			cp_grant_id_t * gid = &devices[i].rx_iovec[g].iov_grant;
+			if (cpf_getgrants(gid, 1) != 1)
+				panic("Cannot initialize grants");
+		}
 		if (cpf_getgrants(&devices[i].tx_iogrant, 1) != 1)
 			panic("Cannot initialize grants");
 		for (g = 0; g < TX_IOVEC_NUM; g++) {
@@ -130,24 +133,35 @@ void nic_init_all(void)
 static void driver_setup_read(struct nic * nic)
 {
 	message m;
+	int i, count;
 
 	debug_print("device /dev/%s", nic->name);
-	//assert(nic->rx_pbuf == NULL);
-	if (!(nic->rx_pbuf == NULL)) {
-		panic("device /dev/%s rx_pbuf %p", nic->name, nic->rx_pbuf);
-	}
 
-	if (!(nic->rx_pbuf = pbuf_alloc(PBUF_RAW, ETH_MAX_PACK_SIZE + ETH_CRC_SIZE, PBUF_RAM)))
-		panic("Cannot allocate rx pbuf");
+	/*
+	 * A driver that supports batched reads gets a buffer for each slot of
+	 * the rx iovec and may fill any number of them in a single reply.
+	 * Buffers the driver did not fill last time must be posted again in
+	 * the same slots, as the device may still be receiving into them.
+	 */
+	count = nic->rx_multi ? RX_IOVEC_NUM : 1;
 
-	if (cpf_setgrant_direct(nic->rx_iovec[0].iov_grant,
-				nic->drv_ep, (vir_bytes) nic->rx_pbuf->payload,
-				nic->rx_pbuf->len, CPF_WRITE) != OK)
-		panic("Failed to set grant");
-	nic->rx_iovec[0].iov_size = nic->rx_pbuf->len;
+	for (i = 0; i < count; i++) {
+		if (nic->rx_pbuf[i] == NULL && !(nic->rx_pbuf[i] =
+				pbuf_alloc(PBUF_RAW,
+					ETH_MAX_PACK_SIZE + ETH_CRC_SIZE,
+					PBUF_RAM)))
+			panic("Cannot allocate rx pbuf");
 
-	m.m_type = DL_READV_S;
-	m.DL_COUNT = 1;
+		if (cpf_setgrant_direct(nic->rx_iovec[i].iov_grant,
+					nic->drv_ep,
+					(vir_bytes) nic->rx_pbuf[i]->payload,
+					nic->rx_pbuf[i]->len, CPF_WRITE) != OK)
+			panic("Failed to set grant");
+		nic->rx_iovec[i].iov_size = nic->rx_pbuf[i]->len;
+	}
+
+	m.m_type = nic->rx_multi ? DL_READV_M : DL_READV_S;
+	m.DL_COUNT = count;
 	m.DL_GRANT = nic->rx_iogrant;
 
 	if (asynsend(nic->drv_ep, &m) != OK)
@@ -157,6 +171,23 @@ static void driver_setup_read(struct nic * nic)
 static void nic_up(struct nic * nic, message * m)
 {
 	memcpy(nic->netif.hwaddr, m->DL_HWADDR, NETIF_MAX_HWADDR_LEN);
+	nic->caps = m->DL_CAPS;
+	nic->rx_multi = !!(m->DL_CAPS & DL_CAP_READV_M);
+
+	/*
+	 * Let tcp and udp leave checksums, and tcp segmentation, to the
+	 * device, if the driver can ask it to. Segmentation needs both.
+	 */
+	nic->netif.offload = 0;
+	if (m->DL_CAPS & DL_CAP_TXCSUM) {
+		nic->netif.offload |= NETIF_OFFLOAD_CSUM_TCP |
+			NETIF_OFFLOAD_CSUM_UDP;
+		if (m->DL_CAPS & DL_CAP_TSO4) {
+			nic->netif.offload |= NETIF_OFFLOAD_TSO4;
+			nic->max_pkt_sz = ETH_HDR_SIZE + IP_MAX_HDR_SIZE +
+				NETIF_TSO_MAX_LEN;
+		}
+	}
 
 	debug_print("device %s is up MAC : %02x:%02x:%02x:%02x:%02x:%02x",
 			nic->name,
@@ -211,6 +242,14 @@ int driver_tx(struct nic * nic)
 	m.DL_COUNT = 1;
 	m.DL_GRANT = nic->tx_iogrant;
 
+	m.DL_OFFLOAD = pkt->offload;
+	m.DL_MSS = pkt->mss;
+	m.DL_L4OFF = 0;
+	/* the tcp or udp header follows the ethernet and ip headers */
+	if (pkt->offload != DL_OFL_NONE)
+		m.DL_L4OFF = ETH_HDR_SIZE +
+			(((unsigned char *) pkt->buf)[ETH_HDR_SIZE] & 0xf) * 4;
+
 	if (asynsend(nic->drv_ep, &m) != OK)
 		panic("asynsend to the driver failed!");
 	nic->state = DRV_SENDING;
@@ -220,13 +259,30 @@ int driver_tx(struct nic * nic)
 	return 1;
 }
 
-static void nic_pkt_sent(struct nic * nic)
+static void nic_pkt_sent(struct nic * nic, int flags)
 {
 	debug_print("device /dev/%s", nic->name);
 	assert(nic->state != DRV_IDLE);
 
-	/* packet has been sent, we are not intereted anymore */
-	driver_tx_dequeue(nic);
+	/*
+	 * the driver could not send a segmentation packet; stop making them,
+	 * tcp retransmits the lost data segment by segment
+	 */
+	if ((flags & DL_PACK_ERROR) && nic->tx_head->mss != 0 &&
+			(nic->netif.offload & NETIF_OFFLOAD_TSO4)) {
+		printf("LWIP : /dev/%s failed to send a TSO packet, "
+				"disabling TSO\n", nic->name);
+		nic->netif.offload &= ~NETIF_OFFLOAD_TSO4;
+	}
+
+	/*
+	 * packet has been sent, we are not intereted anymore, unless the
+	 * device is still reading it from our buffer
+	 */
+	if (flags & DL_PACK_HELD)
+		driver_tx_hold(nic);
+	else
+		driver_tx_dequeue(nic);
 	/*
 	 * Try to transmit the next packet. Failure means that no packet is
 	 * enqueued and thus the device is entering idle state
@@ -235,6 +291,13 @@ static void nic_pkt_sent(struct nic * nic)
 		nic->state = DRV_IDLE;
 }
 
+static void nic_pkt_done(struct nic * nic, unsigned count)
+{
+	/* the driver is done with the oldest held packets */
+	while (count-- > 0 && nic->tx_held_head)
+		driver_tx_release(nic);
+}
+
 __unused static void print_pkt(unsigned char * pkt, int len)
 {
 	int i = 0;
@@ -343,19 +406,57 @@ int raw_socket_input(struct pbuf * pbuf, struct nic * nic)
 	return 0;
 }
 
-static void nic_pkt_received(struct nic * nic, unsigned size)
+static void nic_pkt_deliver(struct nic * nic, int slot, unsigned size,
+				int csum_ok)
 {
-	assert(nic->netif.input);
+	struct pbuf * p = nic->rx_pbuf[slot];
 
 #if 0
-	print_pkt((unsigned char *) nic->rx_pbuf->payload, 64 /*nic->rx_pbuf->len */);
+	print_pkt((unsigned char *) p->payload, 64 /*p->len */);
 #endif
 	
-	assert(nic->rx_pbuf->tot_len == nic->rx_pbuf->len);
-	nic->rx_pbuf->tot_len = nic->rx_pbuf->len = size - ETH_CRC_SIZE;
+	assert(p->tot_len == p->len);
+	p->tot_len = p->len = size - ETH_CRC_SIZE;
+
+	/* the driver may have checked the checksums already */
+	if (csum_ok)
+		p->flags |= PBUF_FLAG_CSUM_OK;
+	else
+		p->flags &= ~PBUF_FLAG_CSUM_OK;
+
+	nic->rx_pbuf[slot] = NULL;
+	nic->netif.input(p, &nic->netif);
+}
+
+static void nic_pkt_received(struct nic * nic, unsigned count,
+				unsigned csum)
+{
+	unsigned i;
+
+	assert(nic->netif.input);
+
+	/*
+	 * For a batched read, count is the number of packets. The driver
+	 * stored their sizes in the rx iovec, and zero for the slots it did
+	 * not fill. Otherwise count is the size of the single packet. Bit i
+	 * of csum tells whether the driver found the checksums of the packet
+	 * in slot i good; only drivers with DL_CAP_RXCSUM set it.
+	 */
+	if (!(nic->caps & DL_CAP_RXCSUM))
+		csum = 0;
+
+	if (nic->rx_multi) {
+		assert(count <= RX_IOVEC_NUM);
+		for (i = 0; i < RX_IOVEC_NUM && count > 0; i++) {
+			if (nic->rx_iovec[i].iov_size == 0)
+				continue;
+			nic_pkt_deliver(nic, i, nic->rx_iovec[i].iov_size,
+							csum & (1U << i));
+			count--;
+		}
+	} else
+		nic_pkt_deliver(nic, 0, count, csum & 1);
 
-	nic->netif.input(nic->rx_pbuf, &nic->netif);
-	nic->rx_pbuf = NULL;
 	driver_setup_read(nic);
 }
 
@@ -380,10 +481,12 @@ void driver_request(message * m)
 			break;
 		}
 		*/
+		if (m->DL_FLAGS & DL_PACK_DONE)
+			nic_pkt_done(nic, m->DL_TXDONE);
 		if (m->DL_FLAGS & DL_PACK_SEND)
-			nic_pkt_sent(nic);
+			nic_pkt_sent(nic, m->DL_FLAGS);
 		if (m->DL_FLAGS & DL_PACK_RECV)
-			nic_pkt_received(nic, m->DL_COUNT);
+			nic_pkt_received(nic, m->DL_COUNT, m->DL_RXCSUM);
 		break;
 	case DL_STAT_REPLY:
 		break;
@@ -396,6 +499,7 @@ void driver_request(message * m)
 void driver_up(const char * label, endpoint_t ep)
 {
 	struct nic * nic;
+	int i;
 
 	nic = lookup_nic_by_drv_name(label);
 	
@@ -426,6 +530,13 @@ void driver_up(const char * label, endpoint_t ep)
 	if (nic->is_default)
 		netif_set_default(&nic->netif);
 
+	/*
+	 * The previous instance of the driver may have been sending some
+	 * packets from our buffers. The new one resets the device first.
+	 */
+	while (nic->tx_held_head)
+		driver_tx_release(nic);
+
 	/* FIXME we support ethernet only, 2048 is safe */
 	nic->tx_buffer = debug_malloc(2048);
 	if (nic->tx_buffer == NULL)
@@ -435,16 +546,29 @@ void driver_up(const char * label, endpoint_t ep)
 	 * on it. A new one is allocated when we send a new read request to the
 	 * driver.
 	 */
-	if (nic->rx_pbuf) {
-		pbuf_free(nic->rx_pbuf);
-		nic->rx_pbuf = NULL;
+	for (i = 0; i < RX_IOVEC_NUM; i++) {
+		if (nic->rx_pbuf[i]) {
+			pbuf_free(nic->rx_pbuf[i]);
+			nic->rx_pbuf[i] = NULL;
+		}
 	}
+	/*
+	 * The new instance tells us in its DL_CONF_REPLY if it can batch, and
+	 * which offloads it supports.
+	 */
+	nic->rx_multi = 0;
+	nic->caps = DL_NOCAPS;
+	nic->netif.offload = 0;
 
-	/* prepare the RX grant once and forever */
+	/*
+	 * prepare the RX grant once and forever, a batched read writes the
+	 * sizes of the received packets back to the iovec
+	 */
 	if (cpf_setgrant_direct(nic->rx_iogrant,
 				nic->drv_ep,
 				(vir_bytes) &nic->rx_iovec,
-				1 * sizeof(iovec_s_t), CPF_READ) != OK)
+				RX_IOVEC_NUM * sizeof(iovec_s_t),
+				CPF_READ | CPF_WRITE) != OK)
 		panic("Failed to set grant");
 }
 
@@ -778,12 +902,23 @@ static int driver_pkt_enqueue(struct packet_q ** head,
 
 	pkt->next = NULL;
 	pkt->buf_len = pbuf->tot_len;
+	pkt->offload = DL_OFL_NONE;
+	pkt->mss = pbuf->tso_mss;
+	if (pbuf->flags & PBUF_FLAG_CSUM_PARTIAL)
+		pkt->offload |= DL_OFL_TCPCSUM;
+	if (pbuf->tso_mss != 0)
+		pkt->offload |= DL_OFL_TSO4;
 	
 	for (b = pkt->buf; pbuf; pbuf = pbuf->next) {
 		memcpy(b, pbuf->payload, pbuf->len);
 		b += pbuf->len;
 	}
 
+	/* the ip protocol field tells a partial udp checksum from a tcp one */
+	if ((pkt->offload & DL_OFL_TCPCSUM) &&
+			pkt->buf[ETH_HDR_SIZE + 9] == IP_PROTO_UDP)
+		pkt->offload = DL_OFL_UDPCSUM;
+
 	if (*head == NULL)
 		*head = *tail = pkt;
 	else {
@@ -822,6 +957,33 @@ void driver_tx_dequeue(struct nic * nic)
 	driver_pkt_dequeue(&nic->tx_head, &nic->tx_tail);
 }
 
+void driver_tx_hold(struct nic * nic)
+{
+	struct packet_q * pkt;
+
+	debug_print("device /dev/%s", nic->name);
+
+	/* move the head of the tx queue to the end of the held list */
+	assert(nic->tx_head);
+	pkt = nic->tx_head;
+	if ((nic->tx_head = pkt->next) == NULL)
+		nic->tx_tail = NULL;
+
+	pkt->next = NULL;
+	if (nic->tx_held_head == NULL)
+		nic->tx_held_head = nic->tx_held_tail = pkt;
+	else {
+		nic->tx_held_tail->next = pkt;
+		nic->tx_held_tail = pkt;
+	}
+}
+
+void driver_tx_release(struct nic * nic)
+{
+	debug_print("device /dev/%s", nic->name);
+	driver_pkt_dequeue(&nic->tx_held_head, &nic->tx_held_tail);
+}
+
 struct packet_q * driver_tx_head(struct nic * nic)
 {
 	debug_print("device /dev/%s", nic->name);
@@ -3,6 +3,7 @@
 
 #include <minix/endpoint.h>
 #include <minix/ds.h>
+#include <minix/com.h>
 
 #include <lwip/pbuf.h>
 
@@ -10,10 +11,13 @@
 #define DRV_NAME_LEN	DS_MAX_KEYLEN
 
 #define TX_IOVEC_NUM	16 /* something the drivers assume */
+#define RX_IOVEC_NUM	DL_READV_M_MAX /* packets per batched read */
 
 struct packet_q {
 	struct packet_q *	next;
 	unsigned		buf_len;
+	unsigned		offload;	/* DL_OFL_* to ask the driver */
+	unsigned		mss;		/* segment size for TSO */
 	char			buf[];
 };
 
@@ -29,12 +33,16 @@ struct nic {
 	int			is_default;
 	int			state;
 	cp_grant_id_t		rx_iogrant;
-	iovec_s_t		rx_iovec[1];
-	struct pbuf *		rx_pbuf;
+	iovec_s_t		rx_iovec[RX_IOVEC_NUM];
+	struct pbuf *		rx_pbuf[RX_IOVEC_NUM];
+	int			rx_multi; /* driver can do DL_READV_M */
+	int			caps;	  /* DL_CAP_* of the driver */
 	cp_grant_id_t		tx_iogrant;
 	iovec_s_t		tx_iovec[TX_IOVEC_NUM];
 	struct packet_q	*	tx_head;
 	struct packet_q	*	tx_tail;
+	struct packet_q	*	tx_held_head; /* sent, but still in use by */
+	struct packet_q	*	tx_held_tail; /* the driver, oldest first */
 	void *			tx_buffer;
 	struct netif		netif;
 	unsigned		max_pkt_sz;
@@ -44,6 +52,8 @@ struct nic {
 
 int driver_tx_enqueue(struct nic * nic, struct pbuf * pbuf);
 void driver_tx_dequeue(struct nic * nic);
+void driver_tx_hold(struct nic * nic);
+void driver_tx_release(struct nic * nic);
 struct packet_q * driver_tx_head(struct nic * nic);
 
 /*
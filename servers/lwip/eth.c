@@ -102,7 +102,7 @@ static void low_level_init(struct netif *netif)
 	/* device capabilities */
 	netif->flags = NETIF_FLAG_ETHARP;
 
-        m.DL_MODE = DL_NOMODE;
+        m.DL_MODE = DL_OFFLOAD_REQ | DL_TXHOLD_REQ;
         if (nic->flags & NWEO_EN_BROAD)
                 m.DL_MODE |= DL_BROAD_REQ;
         if (nic->flags & NWEO_EN_MULTI)
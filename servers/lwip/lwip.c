@@ -20,6 +20,7 @@
 #include <lwip/pbuf.h>
 #include <lwip/stats.h>
 #include <lwip/netif.h>
+#include <lwip/ip.h>
 #include <netif/etharp.h>
 #include <lwip/tcp_impl.h>
 
@@ -30,6 +31,24 @@ static int arp_ticks, tcp_fticks, tcp_sticks;
 
 static struct netif * netif_lo;
 
+/*
+ * Optional delay stage on the loopback interface, in the spirit of netem:
+ * when started with "lodelay=<ms>", every packet looped back through lo0 is
+ * held for that long before it is received, so local connections see a round
+ * trip time of twice the delay. At most LO_DELAY_QLEN packets are held, any
+ * more are dropped, like netem's queue limit.
+ */
+#define LO_DELAY_QLEN	1024
+
+static struct {
+	struct pbuf *	p;
+	clock_t		due;
+} lo_delay_q[LO_DELAY_QLEN];
+static unsigned lo_delay_head, lo_delay_count;
+static long lo_delay_ms;
+static clock_t lo_delay_ticks;
+static timer_t lo_delay_tmr;
+
 extern struct sock_ops sock_udp_ops;
 extern struct sock_ops sock_tcp_ops;
 extern struct sock_ops sock_raw_ip_ops;
@@ -80,6 +99,9 @@ static int sef_cb_init_fresh(__unused int type, __unused sef_init_info_t *info)
 
 	hz = sys_hz();
 
+	env_parse("lodelay", "d", 0, &lo_delay_ms, 0, 10000);
+	lo_delay_ticks = (lo_delay_ms * hz + 999) / 1000;
+
 	arp_ticks = ARP_TMR_INTERVAL / (1000 / hz);
 	tcp_fticks = TCP_FAST_INTERVAL / (1000 / hz);
 	tcp_sticks = TCP_SLOW_INTERVAL / (1000 / hz);
@@ -193,11 +215,80 @@ static void ds_event(void)
 		printf("LWIP : ds_event: ds_check failed: %d\n", r);
 }
 
+static void lo_delay_watchdog(__unused timer_t *tp)
+{
+	struct pbuf * p;
+	clock_t now;
+
+	if (getticks(&now) != OK)
+		panic("LWIP : cannot get uptime");
+
+	while (lo_delay_count > 0 &&
+			(long) (now - lo_delay_q[lo_delay_head].due) >= 0) {
+		p = lo_delay_q[lo_delay_head].p;
+		lo_delay_head = (lo_delay_head + 1) % LO_DELAY_QLEN;
+		lo_delay_count--;
+
+		/* loopback packets are always IP packets */
+		if (ip_input(p, netif_lo) != ERR_OK)
+			pbuf_free(p);
+	}
+
+	if (lo_delay_count > 0)
+		set_timer(&lo_delay_tmr, lo_delay_q[lo_delay_head].due - now,
+				lo_delay_watchdog, 0);
+}
+
+/*
+ * Move the packets looped back since the last poll to the delay queue. The
+ * list is taken apart the same way netif_poll() does it.
+ */
+static void lo_delay_enqueue(void)
+{
+	struct pbuf * p, * p_end;
+	clock_t now;
+	unsigned tail;
+
+	if (getticks(&now) != OK)
+		panic("LWIP : cannot get uptime");
+
+	while ((p = netif_lo->loop_first) != NULL) {
+#if LWIP_LOOPBACK_MAX_PBUFS
+		netif_lo->loop_cnt_current -= pbuf_clen(p);
+#endif
+		for (p_end = p; p_end->len != p_end->tot_len; p_end = p_end->next)
+			;
+
+		if (p_end == netif_lo->loop_last)
+			netif_lo->loop_first = netif_lo->loop_last = NULL;
+		else
+			netif_lo->loop_first = p_end->next;
+		p_end->next = NULL;
+
+		if (lo_delay_count == LO_DELAY_QLEN) {
+			pbuf_free(p);
+			continue;
+		}
+
+		tail = (lo_delay_head + lo_delay_count) % LO_DELAY_QLEN;
+		lo_delay_q[tail].p = p;
+		lo_delay_q[tail].due = now + lo_delay_ticks;
+		if (lo_delay_count++ == 0)
+			set_timer(&lo_delay_tmr, lo_delay_ticks,
+					lo_delay_watchdog, 0);
+	}
+}
+
 static void netif_poll_lo(void)
 {
 	if (netif_lo == NULL)
 		return;
 
+	if (lo_delay_ticks > 0) {
+		lo_delay_enqueue();
+		return;
+	}
+
 	while (netif_lo->loop_first)
 		netif_poll(netif_lo);
 }
@@ -252,8 +343,9 @@ void socket_open(message * m)
         }
 }
 
-int main(__unused int argc, __unused char ** argv)
+int main(int argc, char ** argv)
 {
+	env_setargs(argc, argv);
 	sef_local_startup();
 
 	for(;;) {
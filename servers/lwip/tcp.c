@@ -14,8 +14,12 @@
 #include <minix/netsock.h>
 #include "proto.h"
 
+/* the largest buffer a single write is copied into */
 #define TCP_BUF_SIZE	(32 << 10)
 
+/* how much written data a socket may hold, sent or not, set by SO_SNDBUF */
+#define sock_snd_limit(s)	tcp_sndbufsize((struct tcp_pcb *) (s)->pcb)
+
 #define sock_alloc_buf(s)	debug_malloc(s)
 #define sock_free_buf(x)	debug_free(x)
 
@@ -407,18 +411,19 @@ static void tcp_op_write(struct socket * sock, message * m, __unused int blk)
 			get_sock_num(sock), usr_buf_len);
 
 	/*
-	 * Let at most one buffer grow beyond TCP_BUF_SIZE. This is to minimize
-	 * small writes from userspace if only a few bytes were sent before
+	 * Let at most one buffer grow beyond the send buffer size. This is to
+	 * minimize small writes from userspace if only a few bytes were sent
+	 * before
 	 */
-	if (sock->buf_size >= TCP_BUF_SIZE) {
+	if (sock->buf_size >= sock_snd_limit(sock)) {
 		/* FIXME do not block for now */
 		debug_tcp_print("WARNING : tcp buffers too large, cannot allocate more");
 		sock_reply(sock, ENOMEM);
 		return;
 	}
 	/*
-	 * Never let the allocated buffers grow more than to 2xTCP_BUF_SIZE and
-	 * never copy more than space available
+	 * Never let the allocated buffers grow more than TCP_BUF_SIZE beyond
+	 * the send buffer size and never copy more than space available
 	 */
 	usr_buf_len = (usr_buf_len > TCP_BUF_SIZE ? TCP_BUF_SIZE : usr_buf_len);
 	wbuf = wbuf_add(sock, usr_buf_len);
@@ -458,7 +463,7 @@ static void tcp_op_write(struct socket * sock, message * m, __unused int blk)
 		 * We cannot accept new operations (write). We set the flag
 		 * after sending reply not to revive only. We could deadlock.
 		 */
-		if (sock->buf_size >= TCP_BUF_SIZE)
+		if (sock->buf_size >= sock_snd_limit(sock))
 			sock->flags |= SOCK_FLG_OP_PENDING;
 
 		return;
@@ -498,7 +503,7 @@ static void tcp_op_write(struct socket * sock, message * m, __unused int blk)
 		debug_tcp_print("returns %d\n", usr_buf_len);
 		sock_reply(sock, usr_buf_len);
 		sock->flags |= SOCK_FLG_OP_WRITING;
-		if (sock->buf_size >= TCP_BUF_SIZE)
+		if (sock->buf_size >= sock_snd_limit(sock))
 			sock->flags |= SOCK_FLG_OP_PENDING;
 	} else
 		sock_reply(sock, EIO);
@@ -709,7 +714,7 @@ static err_t tcp_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len)
 	}
 
 	/* we have just freed some space, write will be accepted */
-	if (sock->buf_size < TCP_BUF_SIZE && sock_select_rw_set(sock)) {
+	if (sock->buf_size < sock_snd_limit(sock) && sock_select_rw_set(sock)) {
 		if (!(sock->flags & SOCK_FLG_OP_READING)) {
 			sock->flags &= ~SOCK_FLG_OP_PENDING;
 			sock_select_notify(sock);
@@ -1043,6 +1048,54 @@ static void tcp_set_opt(struct socket * sock, message * m)
 	sock_reply(sock, OK);
 }
 
+static void tcp_get_bufsize(struct socket * sock, message * m, int rcv)
+{
+	size_t size;
+	struct tcp_pcb * pcb = (struct tcp_pcb *) sock->pcb;
+
+	debug_tcp_print("socket num %ld", get_sock_num(sock));
+
+	size = rcv ? tcp_rcvbufsize(pcb) : tcp_sndbufsize(pcb);
+
+	sock_reply(sock, copy_to_user(m->m_source, &size, sizeof(size),
+				(cp_grant_id_t) m->IO_GRANT, 0));
+}
+
+static void tcp_set_bufsize(struct socket * sock, message * m, int rcv)
+{
+	int err;
+	size_t size;
+	struct tcp_pcb * pcb = (struct tcp_pcb *) sock->pcb;
+
+	debug_tcp_print("socket num %ld", get_sock_num(sock));
+
+	err = copy_from_user(m->m_source, &size, sizeof(size),
+				(cp_grant_id_t) m->IO_GRANT, 0);
+	if (err != OK) {
+		sock_reply(sock, err);
+		return;
+	}
+
+	if (size == 0) {
+		sock_reply(sock, EINVAL);
+		return;
+	}
+
+	/*
+	 * lwip rounds the size into the range it supports. The receive buffer
+	 * is the largest window we offer, which can only exceed 64K if the
+	 * other side agrees to window scaling when the connection is set up.
+	 */
+	if (rcv)
+		tcp_set_rcvbufsize(pcb, size > TCP_RCVBUF_MAX ?
+						TCP_RCVBUF_MAX : size);
+	else
+		tcp_set_sndbufsize(pcb, size > TCP_SNDBUF_MAX ?
+						TCP_SNDBUF_MAX : size);
+
+	sock_reply(sock, OK);
+}
+
 static void tcp_op_ioctl(struct socket * sock, message * m, __unused int blk)
 {
 	if (!sock->pcb) {
@@ -1084,6 +1137,18 @@ static void tcp_op_ioctl(struct socket * sock, message * m, __unused int blk)
 	case NWIOSTCPOPT:
 		tcp_set_opt(sock, m);
 		break;
+	case NWIOGTCPSNDBUF:
+		tcp_get_bufsize(sock, m, 0);
+		break;
+	case NWIOSTCPSNDBUF:
+		tcp_set_bufsize(sock, m, 0);
+		break;
+	case NWIOGTCPRCVBUF:
+		tcp_get_bufsize(sock, m, 1);
+		break;
+	case NWIOSTCPRCVBUF:
+		tcp_set_bufsize(sock, m, 1);
+		break;
 	default:
 		sock_reply(sock, EBADIOCTL);
 		return;
@@ -8,6 +8,7 @@
  *   put_block:	  return a block previously requested with get_block
  *   alloc_zone:  allocate a new zone (to increase the length of a file)
  *   free_zone:	  release a zone (when a file is removed)
+ *   prealloc_zones: allocate zones following a zone for a growing file
  *   invalidate:  remove all the cache blocks on some device
  *
  * Private functions:
@@ -69,6 +70,33 @@ zone_t alloc_zone(
   return( (zone_t) (sp->s_firstdatazone - 1) + (zone_t) b);
 }
 
+/*===========================================================================*
+ *				prealloc_zones				     *
+ *===========================================================================*/
+unsigned int prealloc_zones(
+  dev_t dev,			/* device where zones wanted */
+  zone_t z,			/* zone after which to allocate */
+  unsigned int count		/* maximum number of zones to allocate */
+)
+{
+/* Allocate up to 'count' zones directly following zone 'z', stopping at the
+ * first zone that is already in use. Return the number of zones allocated.
+ * The caller (new_block) keeps these zones as a preallocation window for a
+ * file that is being written, so that the file's zones stay contiguous even
+ * while other files are being extended at the same time.
+ */
+  struct super_block *sp;
+  unsigned int n;
+
+  sp = get_super(dev);
+  if (z < sp->s_firstdatazone || z >= sp->s_zones - 1) return(0);
+
+  n = alloc_bit_run(sp, ZMAP, (bit_t) (z - (sp->s_firstdatazone - 1)),
+	count);
+  sp->s_prealloc += n;		/* still free, as far as statvfs knows */
+  return(n);
+}
+
 /*===========================================================================*
  *				free_zone				     *
  *===========================================================================*/
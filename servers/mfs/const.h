@@ -42,6 +42,14 @@
 
 #define NO_BIT   ((bit_t) 0)	/* returned by alloc_bit() to signal failure */
 
+#define PREALLOC_ZONES	   8	/* most zones reserved for a growing file */
+
+#define DIRHASH_MIN_BLOCKS 2	/* index directories of at least this size */
+#define DIRHASH_MAX_MEM	(2*1024*1024)	/* memory for all directory indexes */
+
+#define WRITEBACK_INTERVAL 5	/* seconds between timed writebacks */
+#define WRITEBACK_AGE	   2	/* write blocks dirty for this many intervals */
+
 #define LOOK_UP            0 /* tells search_dir to lookup string */
 #define ENTER              1 /* tells search_dir to make dir entry */
 #define DELETE             2 /* tells search_dir to delete entry */
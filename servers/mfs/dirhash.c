@@ -0,0 +1,330 @@
+/* This file maintains in-memory indexes of large directories, so that looking
+ * up or deleting a name does not require a linear scan of the directory.
+ * The on-disk directory format is not changed in any way.
+ *
+ * An index is built the first time a large enough directory is searched, and
+ * is kept in sync by search_dir() when entries are added or deleted. Each
+ * index is an open-addressing hash table that maps the hash of a name to the
+ * slot number of the directory entry holding that name. Names themselves are
+ * not stored; a candidate entry is verified by reading its directory block
+ * through the block cache. The total memory used by indexes is bounded; when
+ * the bound is reached, the least recently used indexes are thrown away.
+ *
+ * The entry points into this file are
+ *   dirhash_get:	return the index of a directory, building it if needed
+ *   dirhash_lookup:	look up a name in a directory through its index
+ *   dirhash_add:	add an entry to the index of a directory, if any
+ *   dirhash_remove:	remove a looked-up entry from the index of a directory
+ *   dirhash_free:	throw away the index of a directory, if any
+ */
+
+#include "fs.h"
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/queue.h>
+#include "buf.h"
+#include "inode.h"
+#include "super.h"
+
+#define DH_EMPTY	0		/* bucket has never been used */
+#define DH_DELETED	((u32_t) ~0)	/* bucket held an entry that was removed */
+
+struct dirhash {
+  struct inode *dh_inode;	/* directory to which this index belongs */
+  unsigned int dh_size;		/* number of buckets (a power of two) */
+  unsigned int dh_used;		/* number of buckets holding an entry */
+  unsigned int dh_deleted;	/* number of buckets marked as deleted */
+  u32_t *dh_hash;		/* name hash, per bucket */
+  u32_t *dh_slot;		/* entry slot number plus one, per bucket */
+  TAILQ_ENTRY(dirhash) dh_lru;	/* least recently used list */
+};
+
+static TAILQ_HEAD(dirhash_lru_t, dirhash) dirhash_lru =
+	TAILQ_HEAD_INITIALIZER(dirhash_lru);
+static size_t dirhash_mem;	/* total memory used by all indexes */
+
+static u32_t dirhash_name(char *name);
+static int dirhash_resize(struct dirhash *dh, unsigned int size);
+static void dirhash_insert(struct dirhash *dh, u32_t hash, u32_t slot);
+
+/*===========================================================================*
+ *				dirhash_name				     *
+ *===========================================================================*/
+static u32_t dirhash_name(char *name)
+{
+/* Compute the hash of a directory entry name (FNV-1a). Names are compared as
+ * with strncmp() on MFS_NAME_MAX bytes, so hash no more than that.
+ */
+  u32_t hash;
+  int i;
+
+  hash = 2166136261UL;
+  for (i = 0; i < MFS_NAME_MAX && name[i] != '\0'; i++)
+	hash = (hash ^ (unsigned char) name[i]) * 16777619UL;
+
+  return(hash);
+}
+
+/*===========================================================================*
+ *				dirhash_insert				     *
+ *===========================================================================*/
+static void dirhash_insert(struct dirhash *dh, u32_t hash, u32_t slot)
+{
+/* Insert an entry into a hash table known to have room for it. */
+  unsigned int i, mask;
+
+  mask = dh->dh_size - 1;
+  for (i = hash & mask; dh->dh_slot[i] != DH_EMPTY; i = (i + 1) & mask)
+	if (dh->dh_slot[i] == DH_DELETED) {
+		dh->dh_deleted--;
+		break;
+	}
+
+  dh->dh_hash[i] = hash;
+  dh->dh_slot[i] = slot + 1;
+  dh->dh_used++;
+}
+
+/*===========================================================================*
+ *				dirhash_resize				     *
+ *===========================================================================*/
+static int dirhash_resize(struct dirhash *dh, unsigned int size)
+{
+/* Reallocate the hash table of an index with the given number of buckets, and
+ * rehash all entries into it, dropping any deleted marks. Make room first by
+ * throwing away other indexes if the memory bound would be exceeded.
+ */
+  struct dirhash *victim;
+  u32_t *old_hash, *old_slot;
+  unsigned int i, old_size;
+  size_t bytes;
+
+  bytes = size * 2 * sizeof(u32_t);
+
+  while (dirhash_mem + bytes > DIRHASH_MAX_MEM) {
+	if ((victim = TAILQ_FIRST(&dirhash_lru)) == dh)
+		victim = TAILQ_NEXT(victim, dh_lru);
+	if (victim == NULL) return(ENOMEM);
+
+	dirhash_free(victim->dh_inode);
+  }
+
+  old_hash = dh->dh_hash;
+  old_slot = dh->dh_slot;
+  old_size = dh->dh_size;
+
+  dh->dh_hash = malloc(size * sizeof(u32_t));
+  dh->dh_slot = calloc(size, sizeof(u32_t));
+  if (dh->dh_hash == NULL || dh->dh_slot == NULL) {
+	free(dh->dh_hash);
+	free(dh->dh_slot);
+	dh->dh_hash = old_hash;
+	dh->dh_slot = old_slot;
+	return(ENOMEM);
+  }
+
+  dh->dh_size = size;
+  dh->dh_used = 0;
+  dh->dh_deleted = 0;
+  dirhash_mem += bytes;
+
+  for (i = 0; i < old_size; i++)
+	if (old_slot[i] != DH_EMPTY && old_slot[i] != DH_DELETED)
+		dirhash_insert(dh, old_hash[i], old_slot[i] - 1);
+
+  if (old_size > 0) {
+	free(old_hash);
+	free(old_slot);
+	dirhash_mem -= old_size * 2 * sizeof(u32_t);
+  }
+
+  return(OK);
+}
+
+/*===========================================================================*
+ *				dirhash_get				     *
+ *===========================================================================*/
+struct dirhash *dirhash_get(struct inode *dirp)
+{
+/* Return the index of the given directory. If it has none yet and is large
+ * enough to benefit from one, build it now by scanning the directory once.
+ * Return NULL if the directory is not (or cannot be) indexed.
+ */
+  struct dirhash *dh;
+  struct direct *dp;
+  struct buf *bp;
+  unsigned int slot, nr_slots, size, per_block;
+  off_t pos;
+  block_t b;
+
+  if ((dh = dirp->i_dirhash) != NULL) {
+	TAILQ_REMOVE(&dirhash_lru, dh, dh_lru);
+	TAILQ_INSERT_TAIL(&dirhash_lru, dh, dh_lru);
+	return(dh);
+  }
+
+  if (dirp->i_size < DIRHASH_MIN_BLOCKS * dirp->i_sp->s_block_size)
+	return(NULL);
+
+  if ((dh = malloc(sizeof(*dh))) == NULL)
+	return(NULL);
+
+  dh->dh_inode = dirp;
+  dh->dh_size = 0;
+  dh->dh_hash = dh->dh_slot = NULL;
+  TAILQ_INSERT_TAIL(&dirhash_lru, dh, dh_lru);
+  dirp->i_dirhash = dh;
+
+  /* Keep the load factor at one half at most, assuming all slots in use. */
+  nr_slots = (unsigned int) (dirp->i_size / DIR_ENTRY_SIZE);
+  for (size = 64; size < nr_slots * 2; size <<= 1) ;
+
+  if (dirhash_resize(dh, size) != OK) {
+	dirhash_free(dirp);
+	return(NULL);
+  }
+
+  /* Add all entries in use. Directories do not have holes. */
+  per_block = NR_DIR_ENTRIES(dirp->i_sp->s_block_size);
+  for (pos = 0, slot = 0; slot < nr_slots;
+	pos += dirp->i_sp->s_block_size) {
+	b = read_map(dirp, pos);
+	bp = get_block(dirp->i_dev, b, NORMAL);
+	assert(bp != NULL);
+
+	for (dp = &b_dir(bp)[0]; dp < &b_dir(bp)[per_block] &&
+		slot < nr_slots; dp++, slot++) {
+		if (dp->mfs_d_ino != NO_ENTRY)
+			dirhash_insert(dh, dirhash_name(dp->mfs_d_name), slot);
+	}
+
+	put_block(bp, DIRECTORY_BLOCK);
+  }
+
+  return(dh);
+}
+
+/*===========================================================================*
+ *				dirhash_lookup				     *
+ *===========================================================================*/
+int dirhash_lookup(dirp, string, bpp, dpp, posp, bucketp)
+struct inode *dirp;		/* indexed directory to search */
+char string[MFS_NAME_MAX];	/* name to search for */
+struct buf **bpp;		/* on success, block holding the entry */
+struct direct **dpp;		/* on success, pointer to the entry */
+off_t *posp;			/* on success, position of the block */
+unsigned int *bucketp;		/* on success, bucket for dirhash_remove */
+{
+/* Search an indexed directory for a name. On success, return OK with the
+ * directory block that contains the entry still held; the caller must release
+ * it with put_block(). If the name is not in the directory, return ENOENT.
+ */
+  struct dirhash *dh;
+  struct direct *dp;
+  struct buf *bp;
+  unsigned int i, mask, n, per_block;
+  u32_t hash;
+  off_t pos;
+
+  dh = dirp->i_dirhash;
+  assert(dh != NULL);
+
+  hash = dirhash_name(string);
+  mask = dh->dh_size - 1;
+  per_block = NR_DIR_ENTRIES(dirp->i_sp->s_block_size);
+
+  for (i = hash & mask, n = 0; dh->dh_slot[i] != DH_EMPTY && n < dh->dh_size;
+	i = (i + 1) & mask, n++) {
+	if (dh->dh_slot[i] == DH_DELETED || dh->dh_hash[i] != hash)
+		continue;
+
+	/* The hash matches; check the name in the actual entry. */
+	pos = (off_t) ((dh->dh_slot[i] - 1) / per_block) *
+		dirp->i_sp->s_block_size;
+	bp = get_block(dirp->i_dev, read_map(dirp, pos), NORMAL);
+	assert(bp != NULL);
+
+	dp = &b_dir(bp)[(dh->dh_slot[i] - 1) % per_block];
+
+	if (dp->mfs_d_ino != NO_ENTRY &&
+		strncmp(dp->mfs_d_name, string, sizeof(dp->mfs_d_name)) == 0) {
+		*bpp = bp;
+		*dpp = dp;
+		*posp = pos;
+		*bucketp = i;
+		return(OK);
+	}
+
+	put_block(bp, DIRECTORY_BLOCK);
+  }
+
+  return(ENOENT);
+}
+
+/*===========================================================================*
+ *				dirhash_add				     *
+ *===========================================================================*/
+void dirhash_add(struct inode *dirp, char string[MFS_NAME_MAX], unsigned slot)
+{
+/* A new entry has been stored in the given directory slot. If the directory
+ * is indexed, add the entry to the index. If the index cannot be grown to
+ * accommodate the entry, throw the index away, so that it is never stale.
+ */
+  struct dirhash *dh;
+  unsigned int size;
+
+  if ((dh = dirp->i_dirhash) == NULL) return;
+
+  if ((dh->dh_used + dh->dh_deleted + 1) * 2 > dh->dh_size) {
+	for (size = dh->dh_size; (dh->dh_used + 1) * 2 > size; size <<= 1) ;
+
+	if (dirhash_resize(dh, size) != OK) {
+		dirhash_free(dirp);
+		return;
+	}
+  }
+
+  dirhash_insert(dh, dirhash_name(string), slot);
+}
+
+/*===========================================================================*
+ *				dirhash_remove				     *
+ *===========================================================================*/
+void dirhash_remove(struct inode *dirp, unsigned int bucket)
+{
+/* The entry found in the given bucket by dirhash_lookup() has been deleted
+ * from the directory. Mark the bucket as deleted.
+ */
+  struct dirhash *dh;
+
+  dh = dirp->i_dirhash;
+  assert(dh != NULL);
+  assert(bucket < dh->dh_size);
+
+  dh->dh_slot[bucket] = DH_DELETED;
+  dh->dh_used--;
+  dh->dh_deleted++;
+}
+
+/*===========================================================================*
+ *				dirhash_free				     *
+ *===========================================================================*/
+void dirhash_free(struct inode *dirp)
+{
+/* Throw away the index of the given directory, if it has one. */
+  struct dirhash *dh;
+
+  if ((dh = dirp->i_dirhash) == NULL) return;
+
+  TAILQ_REMOVE(&dirhash_lru, dh, dh_lru);
+
+  if (dh->dh_size > 0) {
+	free(dh->dh_hash);
+	free(dh->dh_slot);
+	dirhash_mem -= dh->dh_size * 2 * sizeof(u32_t);
+  }
+
+  free(dh);
+  dirp->i_dirhash = NULL;
+}
@@ -13,6 +13,7 @@
  *   rw_inode:	   read a disk block and extract an inode, or corresp. write
  *   dup_inode:	   indicate that someone else is using an inode table entry
  *   find_inode:   retrieve pointer to inode in inode cache
+ *   drop_prealloc: return the zones preallocated for an inode
  *
  */
 
@@ -157,9 +158,11 @@ struct inode *get_inode(
   }
   rip = TAILQ_FIRST(&unused_inodes);
 
-  /* If not free unhash it */
-  if (rip->i_num != NO_ENTRY)
+  /* If not free unhash it, and drop what is cached for the old inode */
+  if (rip->i_num != NO_ENTRY) {
       unhash_inode(rip);
+      dirhash_free(rip);
+  }
   
   /* Inode is not unused any more */
   TAILQ_REMOVE(&unused_inodes, rip, i_unused);
@@ -171,6 +174,7 @@ struct inode *get_inode(
   if (dev != NO_DEV) rw_inode(rip, READING);	/* get inode from disk */
   rip->i_update = 0;		/* all the times are initially up-to-date */
   rip->i_zsearch = NO_ZONE;	/* no zones searched for yet */
+  rip->i_prealloc_count = 0;	/* no zones preallocated yet */
   rip->i_mountpoint= FALSE;
   rip->i_last_dpos = 0;		/* no dentries searched for yet */
 
@@ -207,6 +211,22 @@ struct inode *find_inode(
 }
 
 
+/*===========================================================================*
+ *				drop_prealloc				     *
+ *===========================================================================*/
+void drop_prealloc(rip)
+register struct inode *rip;	/* inode whose window is to be released */
+{
+/* Free the zones of the inode's preallocation window that were not used. */
+
+  while (rip->i_prealloc_count > 0) {
+	free_zone(rip->i_dev, rip->i_prealloc++);
+	rip->i_prealloc_count--;
+	rip->i_sp->s_prealloc--;
+  }
+}
+
+
 /*===========================================================================*
  *				put_inode				     *
  *===========================================================================*/
@@ -224,6 +244,9 @@ register struct inode *rip;	/* pointer to inode to be released */
 	panic("put_inode: i_count already below 1: %d", rip->i_count);
 
   if (--rip->i_count == 0) {	/* i_count == 0 means no one is using it now */
+	/* Return any zones that were preallocated but not used. */
+	drop_prealloc(rip);
+
 	if (rip->i_nlinks == NO_LINK) {
 		/* i_nlinks == NO_LINK means free the inode. */
 		/* return all the disk blocks */
@@ -242,6 +265,7 @@ register struct inode *rip;	/* pointer to inode to be released */
 
 	if (rip->i_nlinks == NO_LINK) {
 		/* free, put at the front of the LRU list */
+		dirhash_free(rip);
 		unhash_inode(rip);
 		rip->i_num = NO_ENTRY;
 		TAILQ_INSERT_HEAD(&unused_inodes, rip, i_unused);
@@ -38,7 +38,10 @@ EXTERN struct inode {
   struct super_block *i_sp;	/* pointer to super block for inode's device */
   char i_dirt;			/* CLEAN or DIRTY */
   zone_t i_zsearch;		/* where to start search for new zones */
+  zone_t i_prealloc;		/* next zone in preallocation window */
+  unsigned int i_prealloc_count;/* # zones left in preallocation window */
   off_t i_last_dpos;		/* where to start dentry search */
+  struct dirhash *i_dirhash;	/* in-memory directory index, or NULL */
   
   char i_mountpoint;		/* true if mounted on */
 
@@ -146,15 +146,18 @@ static void sef_cb_signal_handler(int signo)
 static void get_work(m_in)
 message *m_in;				/* pointer to message */
 {
-  int r, srcok = 0;
+  int r, srcok = 0, ipc_status;
   endpoint_t src;
 
   do {
-	if ((r = sef_receive(ANY, m_in)) != OK) 	/* wait for message */
+	/* wait for message */
+	if ((r = sef_receive_status(ANY, m_in, &ipc_status)) != OK)
 		panic("sef_receive failed: %d", r);
 	src = m_in->m_source;
 
-	if(src == VFS_PROC_NR) {
+	if (is_ipc_notify(ipc_status) && src == CLOCK) {
+		writeback();		/* timed writeback, no reply */
+	} else if(src == VFS_PROC_NR) {
 		if(unmountdone) 
 			printf("MFS: unmounted: unexpected message from FS\n");
 		else 
@@ -3,6 +3,7 @@
 #include <minix/vfsif.h>
 #include <minix/bdev.h>
 #include "inode.h"
+#include "super.h"
 #include "clean.h"
 
 /*===========================================================================*
@@ -30,6 +31,42 @@ int fs_sync()
 }
 
 
+/*===========================================================================*
+ *				writeback				     *
+ *===========================================================================*/
+void writeback()
+{
+/* The writeback timer went off. Copy the dirty inodes into their inode table
+ * blocks, which is cheap and lets the updates of neighbouring inodes share a
+ * block write. Then write out the blocks that have been dirty for a while,
+ * in as few and as long runs as possible, and wait for the next round.
+ */
+  struct inode *rip;
+
+  if (superblock.s_dev == NO_DEV || superblock.s_rd_only) return;
+
+  for(rip = &inode[0]; rip < &inode[NR_INODES]; rip++)
+	  if(rip->i_count > 0 && IN_ISDIRTY(rip)) rw_inode(rip, WRITING);
+
+  lmfs_writeback(WRITEBACK_AGE);
+
+  set_writeback_timer(TRUE);
+}
+
+
+/*===========================================================================*
+ *				set_writeback_timer			     *
+ *===========================================================================*/
+void set_writeback_timer(int on)
+{
+/* Start or stop the writeback timer. */
+  int r;
+
+  if ((r = sys_setalarm(on ? WRITEBACK_INTERVAL * sys_hz() : 0, 0)) != OK)
+	printf("MFS: unable to set writeback timer: %d\n", r);
+}
+
+
 /*===========================================================================*
  *				fs_flush				     *
  *===========================================================================*/
@@ -3,6 +3,7 @@
 #include "super.h"
 #include <minix/vfsif.h>
 #include <minix/bdev.h>
+#include <stdlib.h>
 
 static int cleanmount = 1;
 
@@ -98,6 +99,10 @@ int fs_readsuper()
 
   superblock.s_rd_only = readonly;
   superblock.s_is_root = isroot;
+
+  /* Summarize the free space in the zone map, for faster allocation. */
+  if (!readonly && init_zmap_summary(&superblock) != OK)
+	printf("MFS: no memory for free space summary\n");
   
   /* Root inode properties */
   fs_m_out.RES_INODE_NR = root_ip->i_num;
@@ -113,6 +118,9 @@ int fs_readsuper()
 	  superblock.s_flags &= ~MFSFLAG_CLEAN;
 	  if(write_super(&superblock) != OK)
 		panic("mounting: couldn't write dirty superblock");
+
+	  /* Age dirty blocks out to disk from now on. */
+	  set_writeback_timer(TRUE);
   }
 
   return(r);
@@ -176,6 +184,7 @@ int fs_unmount()
   put_inode(root_ip);
 
   /* force any cached blocks out of memory */
+  if (!superblock.s_rd_only) set_writeback_timer(FALSE);
   (void) fs_sync();
 
   /* Mark it clean if we're allowed to write _and_ it was clean originally. */
@@ -188,6 +197,8 @@ int fs_unmount()
   bdev_close(fs_dev);
 
   /* Finish off the unmount. */
+  free(superblock.s_zmap_free);
+  superblock.s_zmap_free = NULL;
   superblock.s_dev = NO_DEV;
   unmountdone = TRUE;
 
@@ -479,9 +479,10 @@ int check_permissions;		 /* check permissions when flag is !IS_EMPTY */
  *    if 'string' is dot1 or dot2, no access permissions are checked.
  */
 
-  register struct direct *dp = NULL;
-  register struct buf *bp = NULL;
+  struct direct *dp = NULL;
+  struct buf *bp = NULL;
   int i, r, e_hit, t, match;
+  unsigned int bucket;
   mode_t bits;
   off_t pos;
   unsigned new_slots, old_slots;
@@ -510,6 +511,31 @@ int check_permissions;		 /* check permissions when flag is !IS_EMPTY */
 	}
   }
   if (r != OK) return(r);
+
+  /* Large directories are looked up through their in-memory index. */
+  if ((flag == LOOK_UP || flag == DELETE) && dirhash_get(ldir_ptr) != NULL) {
+	if ((r = dirhash_lookup(ldir_ptr, string, &bp, &dp, &pos,
+		&bucket)) != OK)
+		return(r);
+
+	if (flag == DELETE) {
+		/* Save d_ino for recovery. */
+		t = MFS_NAME_MAX - sizeof(ino_t);
+		*((ino_t *) &dp->mfs_d_name[t]) = dp->mfs_d_ino;
+		dp->mfs_d_ino = NO_ENTRY;	/* erase entry */
+		MARKDIRTY(bp);
+		ldir_ptr->i_update |= CTIME | MTIME;
+		IN_MARKDIRTY(ldir_ptr);
+		if (pos < ldir_ptr->i_last_dpos)
+			ldir_ptr->i_last_dpos = pos;
+		dirhash_remove(ldir_ptr, bucket);
+	} else {
+		sp = ldir_ptr->i_sp;
+		*numb = (ino_t) conv4(sp->s_native, (int) dp->mfs_d_ino);
+	}
+	put_block(bp, DIRECTORY_BLOCK);
+	return(OK);
+  }
   
   /* Step through the directory one block at a time. */
   old_slots = (unsigned) (ldir_ptr->i_size/DIR_ENTRY_SIZE);
@@ -618,6 +644,7 @@ int check_permissions;		 /* check permissions when flag is !IS_EMPTY */
   dp->mfs_d_ino = conv4(sp->s_native, (int) *numb);
   MARKDIRTY(bp);
   put_block(bp, DIRECTORY_BLOCK);
+  dirhash_add(ldir_ptr, string, new_slots - 1);
   ldir_ptr->i_update |= CTIME | MTIME;	/* mark mtime for update later */
   IN_MARKDIRTY(ldir_ptr);
   if (new_slots > old_slots) {
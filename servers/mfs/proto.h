@@ -9,6 +9,8 @@
 
 /* Structs used in prototypes must be declared as such first. */
 struct buf;
+struct direct;
+struct dirhash;
 struct filp;		
 struct inode;
 struct super_block;
@@ -17,6 +19,17 @@ struct super_block;
 /* cache.c */
 zone_t alloc_zone(dev_t dev, zone_t z);
 void free_zone(dev_t dev, zone_t numb);
+unsigned int prealloc_zones(dev_t dev, zone_t z, unsigned int count);
+
+/* dirhash.c */
+struct dirhash *dirhash_get(struct inode *dirp);
+int dirhash_lookup(struct inode *dirp, char string[MFS_NAME_MAX],
+	struct buf **bpp, struct direct **dpp, off_t *posp,
+	unsigned int *bucketp);
+void dirhash_add(struct inode *dirp, char string[MFS_NAME_MAX],
+	unsigned slot);
+void dirhash_remove(struct inode *dirp, unsigned int bucket);
+void dirhash_free(struct inode *dirp);
 
 /* inode.c */
 struct inode *alloc_inode(dev_t dev, mode_t bits);
@@ -26,6 +39,7 @@ int fs_putnode(void);
 void init_inode_cache(void);
 struct inode *get_inode(dev_t dev, ino_t numb);
 void put_inode(struct inode *rip);
+void drop_prealloc(struct inode *rip);
 void update_times(struct inode *rip);
 void rw_inode(struct inode *rip, int rw_flag);
 
@@ -41,6 +55,8 @@ int truncate_inode(struct inode *rip, off_t len);
 int fs_flush(void);
 int fs_sync(void);
 int fs_new_driver(void);
+void set_writeback_timer(int on);
+void writeback(void);
 
 /* mount.c */
 int fs_mountpoint(void);
@@ -83,7 +99,10 @@ int fs_statvfs(void);
 
 /* super.c */
 bit_t alloc_bit(struct super_block *sp, int map, bit_t origin);
+unsigned int alloc_bit_run(struct super_block *sp, int map, bit_t bit,
+	unsigned int count);
 void free_bit(struct super_block *sp, int map, bit_t bit_returned);
+int init_zmap_summary(struct super_block *sp);
 unsigned int get_block_size(dev_t dev);
 struct super_block *get_super(dev_t dev);
 int read_super(struct super_block *sp);
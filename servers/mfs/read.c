@@ -16,6 +16,20 @@ static struct buf *rahead(struct inode *rip, block_t baseblock, u64_t
 static int rw_chunk(struct inode *rip, u64_t position, unsigned off,
 	size_t chunk, unsigned left, int rw_flag, cp_grant_id_t gid, unsigned
 	buf_off, unsigned int block_size, int *completed);
+static void copy_queue(struct buf *bp, int rw_flag, cp_grant_id_t gid,
+	unsigned buf_off, unsigned off, size_t chunk, int block_type);
+static int copy_full(void);
+static int copy_flush(unsigned int *undonep);
+
+/* Copies between the block cache and user buffers are queued up by rw_chunk,
+ * and done with a single vectored safecopy. The blocks involved stay in use
+ * until then.
+ */
+static struct vscp_vec copy_vec[SCPVEC_NR];
+static struct buf *copy_buf[SCPVEC_NR];
+static int copy_type[SCPVEC_NR];
+static int copy_dirty[SCPVEC_NR];	/* block was dirty before the copy */
+static int copy_count = 0;
 
 
 /*===========================================================================*
@@ -32,6 +46,9 @@ int fs_readwrite(void)
   int completed;
   struct inode *rip;
   size_t nrbytes;
+  iovec_s_t iov[NR_IOREQS];
+  int i, iovcnt, vector, r2;
+  unsigned int iov_off, undone;
   
   r = OK;
   
@@ -53,15 +70,38 @@ int fs_readwrite(void)
   }
 
   /* Get the values from the request message */ 
+  vector = 0;
   switch(fs_m_in.m_type) {
   	case REQ_READ: rw_flag = READING; break;
   	case REQ_WRITE: rw_flag = WRITING; break;
   	case REQ_PEEK: rw_flag = PEEKING; break;
+	case REQ_READV: rw_flag = READING; vector = 1; break;
+	case REQ_WRITEV: rw_flag = WRITING; vector = 1; break;
 	default: panic("odd request");
   }
   gid = (cp_grant_id_t) fs_m_in.REQ_GRANT;
   position = (off_t) fs_m_in.REQ_SEEK_POS_LO;
   nrbytes = (size_t) fs_m_in.REQ_NBYTES;
+
+  /* A vectored request grants us an array of grants, one per user buffer.
+   * A plain request is treated as a vector with a single buffer.
+   */
+  if (vector) {
+	iovcnt = fs_m_in.REQ_IOVCNT;
+	if (iovcnt <= 0 || iovcnt > NR_IOREQS)
+		return(EINVAL);
+	r = sys_safecopyfrom(VFS_PROC_NR, gid, (vir_bytes) 0,
+		(vir_bytes) iov, iovcnt * sizeof(iov[0]));
+	if (r != OK) return(r);
+
+	nrbytes = 0;
+	for (i = 0; i < iovcnt; i++)
+		nrbytes += iov[i].iov_size;
+  } else {
+	iov[0].iov_grant = gid;
+	iov[0].iov_size = nrbytes;
+	iovcnt = 1;
+  }
   
   lmfs_reset_rdwt_err();
 
@@ -87,10 +127,20 @@ int fs_readwrite(void)
 		return EROFS;
 	      
   cum_io = 0;
-  /* Split the transfer into chunks that don't span two blocks. */
+  i = 0;
+  iov_off = 0;
+  /* Split the transfer into chunks that don't span two blocks or two user
+   * buffers.
+   */
   while (nrbytes > 0) {
+	  while (iov_off == iov[i].iov_size) {
+		  i++;		/* this buffer is done; move to the next */
+		  iov_off = 0;
+	  }
+
 	  off = ((unsigned int) position) % block_size; /* offset in blk*/
 	  chunk = min(nrbytes, block_size - off);
+	  chunk = min(chunk, iov[i].iov_size - iov_off);
 
 	  if (rw_flag == READING) {
 		  bytes_left = f_size - position;
@@ -100,7 +150,8 @@ int fs_readwrite(void)
 	  
 	  /* Read or write 'chunk' bytes. */
 	  r = rw_chunk(rip, cvul64((unsigned long) position), off, chunk,
-	  	       nrbytes, rw_flag, gid, cum_io, block_size, &completed);
+	  	       nrbytes, rw_flag, iov[i].iov_grant, iov_off, block_size,
+		       &completed);
 
 	  if (r != OK) break;	/* EOF reached */
 	  if (lmfs_rdwt_err() < 0) break;
@@ -108,9 +159,23 @@ int fs_readwrite(void)
 	  /* Update counters and pointers. */
 	  nrbytes -= chunk;	/* bytes yet to be read */
 	  cum_io += chunk;	/* bytes read so far */
+	  iov_off += chunk;	/* offset within the current buffer */
 	  position += (off_t) chunk;	/* position within the file */
+
+	  if (copy_full()) {
+		  r = copy_flush(&undone);
+		  cum_io -= undone;
+		  position -= (off_t) undone;
+		  if (r != OK) break;
+	  }
   }
 
+  /* Do the copies still queued; take back what could not be copied. */
+  r2 = copy_flush(&undone);
+  cum_io -= undone;
+  position -= (off_t) undone;
+  if (r == OK) r = r2;
+
   fs_m_out.RES_SEEK_POS_LO = position; /* It might change later and the VFS
 					   has to know this value */
   
@@ -146,10 +211,10 @@ int fs_readwrite(void)
  *===========================================================================*/
 int fs_breadwrite(void)
 {
-  int r, rw_flag, completed;
+  int r, r2, rw_flag, completed;
   cp_grant_id_t gid;
   u64_t position;
-  unsigned int off, cum_io, chunk, block_size;
+  unsigned int off, cum_io, chunk, block_size, undone;
   size_t nrbytes;
   dev_t target_dev;
 
@@ -196,7 +261,20 @@ int fs_breadwrite(void)
 	  nrbytes -= chunk;	        /* bytes yet to be read */
 	  cum_io += chunk;	        /* bytes read so far */
 	  position = add64ul(position, chunk);	/* position within the file */
+
+	  if (copy_full()) {
+		  r = copy_flush(&undone);
+		  cum_io -= undone;
+		  position = sub64ul(position, undone);
+		  if (r != OK) break;
+	  }
   }
+
+  /* Do the copies still queued; take back what could not be copied. */
+  r2 = copy_flush(&undone);
+  cum_io -= undone;
+  position = sub64ul(position, undone);
+  if (r == OK) r = r2;
   
   fs_m_out.RES_SEEK_POS_LO = ex64lo(position); 
   fs_m_out.RES_SEEK_POS_HI = ex64hi(position); 
@@ -269,6 +347,11 @@ int *completed;			/* number of bytes copied */
 		 */
 		if ((bp = new_block(rip, (off_t) ex64lo(position))) == NULL)
 			return(err_code);
+
+		/* The zone is in the file now, so its zeroes must reach the
+		 * disk even if the copy into it fails.
+		 */
+		if (rw_flag == WRITING) MARKDIRTY(bp);
 	}
   } else if (rw_flag == READING || rw_flag == PEEKING) {
 	/* Read and read ahead if convenient. */
@@ -292,19 +375,121 @@ int *completed;			/* number of bytes copied */
 	zero_block(bp);
   }
 
+  n = (off + chunk == block_size ? FULL_DATA_BLOCK : PARTIAL_DATA_BLOCK);
+
+  if (rw_flag == READING || rw_flag == WRITING) {
+	/* Queue the copy; the block is released once it has been done. */
+	copy_queue(bp, rw_flag, gid, buf_off, off, chunk, n);
+  } else {
+	put_block(bp, n);
+  }
+
+  return(r);
+}
+
+
+/*===========================================================================*
+ *				copy_queue				     *
+ *===========================================================================*/
+static void copy_queue(bp, rw_flag, gid, buf_off, off, chunk, block_type)
+struct buf *bp;			/* block to copy to or from, in use */
+int rw_flag;			/* READING or WRITING */
+cp_grant_id_t gid;		/* grant */
+unsigned buf_off;		/* offset in grant */
+unsigned off;			/* offset within the block */
+size_t chunk;			/* number of bytes to copy */
+int block_type;			/* how to put_block() afterwards */
+{
+/* Add a copy between a block and a user buffer to the queue. The caller must
+ * flush the queue as soon as copy_full() says so.
+ */
+  struct vscp_vec *vp;
+
+  assert(copy_count < SCPVEC_NR);
+
+  vp = &copy_vec[copy_count];
   if (rw_flag == READING) {
-	/* Copy a chunk from the block buffer to user space. */
-	r = sys_safecopyto(VFS_PROC_NR, gid, (vir_bytes) buf_off,
-			   (vir_bytes) (b_data(bp)+off), (size_t) chunk);
-  } else if(rw_flag == WRITING) {
-	/* Copy a chunk from user space to the block buffer. */
-	r = sys_safecopyfrom(VFS_PROC_NR, gid, (vir_bytes) buf_off,
-			     (vir_bytes) (b_data(bp)+off), (size_t) chunk);
-	MARKDIRTY(bp);
+	vp->v_from = SELF;
+	vp->v_to = VFS_PROC_NR;
+  } else {
+	vp->v_from = VFS_PROC_NR;
+	vp->v_to = SELF;
   }
-  
-  n = (off + chunk == block_size ? FULL_DATA_BLOCK : PARTIAL_DATA_BLOCK);
-  put_block(bp, n);
+  vp->v_gid = gid;
+  vp->v_offset = (size_t) buf_off;
+  vp->v_addr = (vir_bytes) (b_data(bp) + off);
+  vp->v_bytes = chunk;
+
+  copy_buf[copy_count] = bp;
+  copy_type[copy_count] = block_type;
+  copy_dirty[copy_count] = !lmfs_isclean(bp);
+  copy_count++;
+}
+
+
+/*===========================================================================*
+ *				copy_full				     *
+ *===========================================================================*/
+static int copy_full(void)
+{
+/* The queue is full if the next copy does not fit in it, or if the blocks it
+ * holds take up half of the cache; read ahead needs the rest.
+ */
+  return(copy_count == SCPVEC_NR ||
+	(copy_count > 0 && lmfs_bufs_in_use() >= lmfs_nr_bufs() / 2));
+}
+
+
+/*===========================================================================*
+ *				copy_flush				     *
+ *===========================================================================*/
+static int copy_flush(undonep)
+unsigned int *undonep;		/* number of bytes not copied */
+{
+/* Do all queued copies and release the blocks involved. If the vectored copy
+ * fails, redo the copies one by one to find out how far we get, so that the
+ * caller can report a partial transfer and the error.
+ *
+ * A block is only marked dirty if the copy into it was done. A block that
+ * was not dirty before is dropped from the cache if the copy into it failed
+ * or was not done, as it may hold a part of the copy, or nothing valid at
+ * all if it was to be overwritten entirely and was not read in. Otherwise it
+ * would be taken for a valid block, or written back later on.
+ */
+  struct vscp_vec *vp;
+  int i, r, done;
+
+  *undonep = 0;
+  if (copy_count == 0) return(OK);
+
+  done = copy_count;
+  if ((r = sys_vsafecopy(copy_vec, copy_count)) != OK) {
+	for (i = 0; i < copy_count; i++) {
+		vp = &copy_vec[i];
+		if (vp->v_to == SELF)
+			r = sys_safecopyfrom(vp->v_from, vp->v_gid,
+				(vir_bytes) vp->v_offset, vp->v_addr,
+				vp->v_bytes);
+		else
+			r = sys_safecopyto(vp->v_to, vp->v_gid,
+				(vir_bytes) vp->v_offset, vp->v_addr,
+				vp->v_bytes);
+		if (r != OK) break;
+	}
+	for (done = i; i < copy_count; i++)
+		*undonep += copy_vec[i].v_bytes;
+  }
+
+  for (i = 0; i < copy_count; i++) {
+	if (copy_vec[i].v_to == SELF) {
+		if (i < done)
+			MARKDIRTY(copy_buf[i]);
+		else if (!copy_dirty[i])
+			lmfs_discard(copy_buf[i]);
+	}
+	put_block(copy_buf[i], copy_type[i]);
+  }
+  copy_count = 0;
 
   return(r);
 }
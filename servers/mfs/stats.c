@@ -29,6 +29,14 @@ int map;			/* IMAP (inode map) or ZMAP (zone map) */
 
   assert(sp != NULL);
 
+  /* The free space summary of the zone map has the answer already. */
+  if (map == ZMAP && sp->s_zmap_free != NULL) {
+    free_bits = 0;
+    for (block = 0; block < (block_t) sp->s_zmap_blocks; block++)
+      free_bits += sp->s_zmap_free[block];
+    return free_bits;
+  }
+
   if (map == IMAP) {
     start_block = START_BLOCK;
     map_bits = (bit_t) (sp->s_ninodes + 1);
@@ -104,7 +112,8 @@ void fs_blockstats(u32_t *blocks, u32_t *free, u32_t *used)
   scale = sp->s_log_zone_size;
 
   *blocks = sp->s_zones << scale;
-  *free = count_free_bits(sp, ZMAP) << scale;
+  /* Zones preallocated to files but not used yet are still free. */
+  *free = (count_free_bits(sp, ZMAP) + sp->s_prealloc) << scale;
   *used = *blocks - *free;
 
   return;
@@ -5,7 +5,9 @@
  *
  * The entry points into this file are
  *   alloc_bit:       somebody wants to allocate a zone or inode; find one
+ *   alloc_bit_run:   allocate a run of bits following a given bit
  *   free_bit:        indicate that a zone or inode is available for allocation
+ *   init_zmap_summary: build the free space summary of the zone map
  *   get_super:       search the 'superblock' table for a device
  *   mounted:         tells if file inode is on mounted (or ROOT) file system
  *   read_super:      read a superblock
@@ -13,6 +15,7 @@
 
 #include "fs.h"
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <minix/com.h>
 #include <minix/u64.h>
@@ -65,6 +68,16 @@ bit_t origin;			/* number of bit to start searching at */
   /* Iterate over all blocks plus one, because we start in the middle. */
   bcount = bit_blocks + 1;
   do {
+	/* Skip zone map blocks that the free space summary reports as full,
+	 * without reading them in.
+	 */
+	if (map == ZMAP && sp->s_zmap_free != NULL &&
+	    sp->s_zmap_free[block] == 0) {
+		if (++block >= (unsigned int) bit_blocks) block = 0;
+		word = 0;
+		continue;
+	}
+
 	bp = get_block(sp->s_dev, start_block + block, NORMAL);
 	wlim = &b_bitmap(bp)[FS_BITMAP_CHUNKS(sp->s_block_size)];
 
@@ -91,6 +104,8 @@ bit_t origin;			/* number of bit to start searching at */
 		*wptr = (bitchunk_t) conv4(sp->s_native, (int) k);
 		MARKDIRTY(bp);
 		put_block(bp, MAP_BLOCK);
+		if (map == ZMAP && sp->s_zmap_free != NULL)
+			sp->s_zmap_free[block]--;
 		return(b);
 	}
 	put_block(bp, MAP_BLOCK);
@@ -144,6 +159,126 @@ bit_t bit_returned;		/* number of bit to insert into the map */
   MARKDIRTY(bp);
 
   put_block(bp, MAP_BLOCK);
+
+  if (map == ZMAP && sp->s_zmap_free != NULL)
+	sp->s_zmap_free[block]++;
+}
+
+
+/*===========================================================================*
+ *				alloc_bit_run				     *
+ *===========================================================================*/
+unsigned int alloc_bit_run(sp, map, bit, count)
+struct super_block *sp;		/* the filesystem to allocate from */
+int map;			/* IMAP (inode map) or ZMAP (zone map) */
+bit_t bit;			/* allocate bits following this one */
+unsigned int count;		/* maximum number of bits to allocate */
+{
+/* Allocate up to 'count' bits directly following bit 'bit', stopping at the
+ * first bit that is already in use, at the end of the map, or at the end of
+ * the bit map block. Return the number of bits allocated.
+ */
+  block_t start_block, block;
+  bit_t map_bits, b;
+  unsigned int word, n;
+  struct buf *bp;
+  bitchunk_t k, mask;
+
+  if (sp->s_rd_only)
+	panic("can't allocate bit on read-only filesys");
+
+  if (map == IMAP) {
+	start_block = START_BLOCK;
+	map_bits = (bit_t) (sp->s_ninodes + 1);
+  } else {
+	start_block = START_BLOCK + sp->s_imap_blocks;
+	map_bits = (bit_t) (sp->s_zones - (sp->s_firstdatazone - 1));
+  }
+
+  b = bit + 1;
+  if (count == 0 || b >= map_bits) return(0);
+
+  block = (block_t) (b / FS_BITS_PER_BLOCK(sp->s_block_size));
+
+  if (map == ZMAP && sp->s_zmap_free != NULL && sp->s_zmap_free[block] == 0)
+	return(0);
+
+  bp = get_block(sp->s_dev, start_block + block, NORMAL);
+
+  for (n = 0; n < count && b < map_bits; n++, b++) {
+	if (b / FS_BITS_PER_BLOCK(sp->s_block_size) != block) break;
+
+	word = (b % FS_BITS_PER_BLOCK(sp->s_block_size)) / FS_BITCHUNK_BITS;
+	mask = 1 << (b % FS_BITCHUNK_BITS);
+
+	k = (bitchunk_t) conv4(sp->s_native, (int) b_bitmap(bp)[word]);
+	if (k & mask) break;
+
+	k |= mask;
+	b_bitmap(bp)[word] = (bitchunk_t) conv4(sp->s_native, (int) k);
+  }
+
+  if (n > 0) MARKDIRTY(bp);
+  put_block(bp, MAP_BLOCK);
+
+  if (map == ZMAP && sp->s_zmap_free != NULL)
+	sp->s_zmap_free[block] -= n;
+
+  return(n);
+}
+
+
+/*===========================================================================*
+ *				init_zmap_summary			     *
+ *===========================================================================*/
+int init_zmap_summary(sp)
+struct super_block *sp;		/* the filesystem to summarize */
+{
+/* Build the in-memory free space summary of the zone bit map: the number of
+ * free zones described by each zone map block. It is kept up to date by
+ * alloc_bit(), alloc_bit_run() and free_bit(), and lets allocation skip over
+ * full parts of the map without reading them. On a nearly full file system,
+ * this avoids scanning most of the zone map for every new zone.
+ */
+  block_t start_block, block;
+  bit_t map_bits, b;
+  unsigned int word, i, nfree;
+  struct buf *bp;
+  bitchunk_t k;
+
+  if (sp->s_zmap_free != NULL) free(sp->s_zmap_free);
+
+  sp->s_zmap_free = malloc(sp->s_zmap_blocks * sizeof(sp->s_zmap_free[0]));
+  if (sp->s_zmap_free == NULL) return(ENOMEM);
+
+  start_block = START_BLOCK + sp->s_imap_blocks;
+  map_bits = (bit_t) (sp->s_zones - (sp->s_firstdatazone - 1));
+
+  for (block = 0; block < (block_t) sp->s_zmap_blocks; block++) {
+	bp = get_block(sp->s_dev, start_block + block, NORMAL);
+	nfree = 0;
+
+	for (word = 0; word < FS_BITMAP_CHUNKS(sp->s_block_size); word++) {
+		if (b_bitmap(bp)[word] == (bitchunk_t) ~0) continue;
+
+		k = (bitchunk_t) conv4(sp->s_native, (int) b_bitmap(bp)[word]);
+
+		for (i = 0; i < FS_BITCHUNK_BITS; i++) {
+			b = ((bit_t) block * FS_BITS_PER_BLOCK(sp->s_block_size))
+			    + word * FS_BITCHUNK_BITS + i;
+
+			/* Don't count bits beyond the end of the map. */
+			if (b >= map_bits) break;
+
+			if (!(k & (1 << i))) nfree++;
+		}
+	}
+
+	put_block(bp, MAP_BLOCK);
+	sp->s_zmap_free[block] = nfree;
+  }
+
+  return(OK);
 }
 
 
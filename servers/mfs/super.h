@@ -61,6 +61,8 @@ EXTERN struct super_block {
   int s_nindirs;		/* # indirect zones per indirect block */
   bit_t s_isearch;		/* inodes below this bit number are in use */
   bit_t s_zsearch;		/* all zones below this bit number are in use*/
+  unsigned int *s_zmap_free;	/* # free zones per zone map block, or NULL */
+  zone_t s_prealloc;		/* # zones in preallocation windows */
   char s_is_root;
 } superblock;
 
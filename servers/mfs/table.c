@@ -45,5 +45,7 @@ int (*fs_call_vec[])(void) = {
         fs_getdents,	    /* 31  */
         fs_statvfs,         /* 32  */
         fs_readwrite,       /* 33  */
+        fs_readwrite,       /* 34  */
+        fs_readwrite,       /* 35  */
 };
 
@@ -280,9 +280,11 @@ off_t position;			/* file pointer */
  */
 
   register struct buf *bp;
+  register struct inode *ip;
   block_t b, base_block;
-  zone_t z;
+  zone_t z, start;
   zone_t zone_size;
+  unsigned int count;
   int scale, r;
 
   /* Is another block available in the current zone? */
@@ -300,7 +302,41 @@ off_t position;			/* file pointer */
 		/* searched before, start from last find */
 		z = rip->i_zsearch;
 	}
-	if ( (z = alloc_zone(rip->i_dev, z)) == NO_ZONE) return(NULL);
+	scale = rip->i_sp->s_log_zone_size;
+	zone_size = (zone_t) rip->i_sp->s_block_size << scale;
+	if (rip->i_prealloc_count > 0) {
+		/* Take the next zone from the preallocation window. */
+		z = rip->i_prealloc++;
+		rip->i_prealloc_count--;
+		rip->i_sp->s_prealloc--;
+	} else {
+		start = z;
+		if ( (z = alloc_zone(rip->i_dev, start)) == NO_ZONE &&
+		    rip->i_sp->s_prealloc > 0) {
+			/* The disk is only full because of the windows of
+			 * other files. Take their zones back and try again.
+			 */
+			for (ip = &inode[0]; ip < &inode[NR_INODES]; ip++)
+				if (ip->i_count > 0 && ip->i_dev == rip->i_dev)
+					drop_prealloc(ip);
+			z = alloc_zone(rip->i_dev, start);
+		}
+		if (z == NO_ZONE) return(NULL);
+
+		/* Reserve the zones following this one for the file, so that
+		 * it stays contiguous while other files are written at the
+		 * same time. The window is as large as the file so far, up to
+		 * PREALLOC_ZONES, so a file that fits in one zone reserves
+		 * nothing. put_inode() releases what is left of the window.
+		 */
+		count = (unsigned int) (position / zone_size);
+		if (count > PREALLOC_ZONES - 1) count = PREALLOC_ZONES - 1;
+		if ((rip->i_mode & I_TYPE) == I_REGULAR && count > 0) {
+			rip->i_prealloc = z + 1;
+			rip->i_prealloc_count = prealloc_zones(rip->i_dev, z,
+				count);
+		}
+	}
 	rip->i_zsearch = z;	/* store for next lookup */
 	if ( (r = write_map(rip, position, z, 0)) != OK) {
 		free_zone(rip->i_dev, z);
@@ -310,9 +346,7 @@ off_t position;			/* file pointer */
 
 	/* If we are not writing at EOF, clear the zone, just to be safe. */
 	if ( position != rip->i_size) clear_zone(rip, position, 1);
-	scale = rip->i_sp->s_log_zone_size;
 	base_block = (block_t) z << scale;
-	zone_size = (zone_t) rip->i_sp->s_block_size << scale;
 	b = base_block + (block_t)((position % zone_size)/rip->i_sp->s_block_size);
   }
 
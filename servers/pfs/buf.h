@@ -1,26 +1,27 @@
 #ifndef __PFS_BUF_H__
 #define __PFS_BUF_H__
 
-/* Buffer (block) cache.
+/* Pipe buffers. Each pipe inode in use has one buffer, found through a hash
+ * table on the inode number. The data of the pipe is kept in a ring of pages
+ * that are allocated as the pipe fills up, and given back as it drains.
+ * The ring has one page more than the largest capacity, so that the tail of
+ * the data never wraps into the page that holds the head.
  */
 
+#include <machine/vmparam.h>
+
+#define PIPE_PAGES	(PIPE_MAX_SIZE / PAGE_SIZE + 1)	/* pages in a ring */
+#define PIPE_RING_SIZE	(PIPE_PAGES * PAGE_SIZE)	/* bytes in a ring */
+
 struct buf {
-  /* Data portion of the buffer. */
-  char b_data[PIPE_BUF];     /* ordinary user data */
+  char *b_page[PIPE_PAGES];	/* data pages, NULL if not allocated */
+  size_t b_head;		/* ring offset of the first byte of data */
 
   /* Header portion of the buffer. */
-  struct buf *b_next;           /* used to link all free bufs in a chain */
-  struct buf *b_prev;           /* used to link all free bufs the other way */
+  struct buf *b_hash;		/* next buffer in the hash chain */
   ino_t b_num;			/* inode number on minor device */
   dev_t b_dev;                  /* major | minor device where block resides */
-  int b_bytes;                  /* Number of bytes allocated in bp */
   int b_count;			/* Number of users of this buffer */
 };
 
-/* A block is free if b_dev == NO_DEV. */
-
-
-EXTERN struct buf *front;	/* points to least recently used free block */
-EXTERN struct buf *rear;	/* points to most recently used free block */
-
 #endif
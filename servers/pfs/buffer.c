@@ -2,10 +2,30 @@
 #include "buf.h"
 #include "inode.h"
 #include <sys/types.h>
+#include <sys/param.h>
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define BUF_HASH_SIZE	64	/* # chains in the buffer hash table */
+#define BUF_HASH(inum)	((unsigned long) (inum) % BUF_HASH_SIZE)
+
+/* Pages given back by drained pipes are kept for reuse, up to a limit, so
+ * that a page can travel from one pipe to the next without going through
+ * the allocator.
+ */
+#define FREE_PAGES_MAX	64
+
+static struct buf *buf_hash[BUF_HASH_SIZE];
+static char *free_pages[FREE_PAGES_MAX];
+static int nr_free_pages;
+
+static struct buf *find_block(dev_t dev, ino_t inum);
 static struct buf *new_block(dev_t dev, ino_t inum);
+static char *get_page(void);
+static void put_page(char *page);
+static int copy_ring(struct buf *bp, size_t offset, int rw_flag,
+	cp_grant_id_t gid, size_t nbytes);
 
 /*===========================================================================*
  *                              buf_pool                                     *
@@ -14,25 +34,36 @@ void buf_pool(void)
 {
 /* Initialize the buffer pool. */
 
-  front = NULL;
-  rear = NULL;
+  memset(buf_hash, 0, sizeof(buf_hash));
+  nr_free_pages = 0;
 }
 
 
+/*===========================================================================*
+ *				find_block				     *
+ *===========================================================================*/
+static struct buf *find_block(dev_t dev, ino_t inum)
+{
+  struct buf *bp;
+
+  for (bp = buf_hash[BUF_HASH(inum)]; bp != NULL; bp = bp->b_hash)
+	if (bp->b_dev == dev && bp->b_num == inum)
+		return(bp);
+
+  return(NULL);
+}
+
 
 /*===========================================================================*
  *				get_block				     *
  *===========================================================================*/
 struct buf *get_block(dev_t dev, ino_t inum)
 {
-  struct buf *bp = front;
+  struct buf *bp;
 
-  while(bp != NULL) {
-	if (bp->b_dev == dev && bp->b_num == inum) {
-		bp->b_count++;
-		return(bp);
-	}
-	bp = bp->b_next;
+  if ((bp = find_block(dev, inum)) != NULL) {
+	bp->b_count++;
+	return(bp);
   }
 
   /* Buffer was not found. Try to allocate a new one */
@@ -45,8 +76,11 @@ struct buf *get_block(dev_t dev, ino_t inum)
  *===========================================================================*/
 static struct buf *new_block(dev_t dev, ino_t inum)
 {
-/* Allocate a new buffer and add it to the double linked buffer list */
+/* Allocate a new buffer and add it to the buffer hash table. No data pages
+ * are allocated until something is written.
+ */
   struct buf *bp;
+  unsigned long h;
 
   bp = malloc(sizeof(struct buf));
   if (bp == NULL) {
@@ -55,20 +89,13 @@ static struct buf *new_block(dev_t dev, ino_t inum)
   }
   bp->b_num = inum;
   bp->b_dev = dev;
-  bp->b_bytes = 0;
   bp->b_count = 1;
-  memset(bp->b_data, 0 , PIPE_BUF);
-
-  /* Add at the end of the buffer */
-  if (front == NULL) {	/* Empty list? */
-	front = bp;
-	bp->b_prev = NULL;
-  } else {
-	rear->b_next = bp;
-	bp->b_prev = rear;
-  }
-  bp->b_next = NULL;
-  rear = bp;
+  bp->b_head = 0;
+  memset(bp->b_page, 0, sizeof(bp->b_page));
+
+  h = BUF_HASH(inum);
+  bp->b_hash = buf_hash[h];
+  buf_hash[h] = bp;
 
   return(bp);
 }
@@ -79,25 +106,223 @@ static struct buf *new_block(dev_t dev, ino_t inum)
  *===========================================================================*/
 void put_block(dev_t dev, ino_t inum)
 {
-  struct buf *bp;
+  struct buf *bp, **bpp;
 
-  bp = get_block(dev, inum);
+  bp = find_block(dev, inum);
   if (bp == NULL) return; /* We didn't find the block. Nothing to put. */
 
-  bp->b_count--;	/* Compensate for above 'get_block'. */
   if (--bp->b_count > 0) return;
 
-  /* Cut bp out of the loop */
-  if (bp->b_prev == NULL)
-	front = bp->b_next;
-  else
-	bp->b_prev->b_next = bp->b_next;
+  /* Cut bp out of its hash chain */
+  for (bpp = &buf_hash[BUF_HASH(inum)]; *bpp != bp; bpp = &(*bpp)->b_hash)
+	;
+  *bpp = bp->b_hash;
+
+  /* Buffer administration is done. Now it's safe to free up bp. */
+  clear_block(bp);
+  free(bp);
+}
+
+
+/*===========================================================================*
+ *				clear_block				     *
+ *===========================================================================*/
+void clear_block(struct buf *bp)
+{
+/* Throw away all data in the buffer, and give back its pages. */
+  int i;
+
+  for (i = 0; i < PIPE_PAGES; i++) {
+	if (bp->b_page[i] != NULL) {
+		put_page(bp->b_page[i]);
+		bp->b_page[i] = NULL;
+	}
+  }
+  bp->b_head = 0;
+}
+
+
+/*===========================================================================*
+ *				get_page				     *
+ *===========================================================================*/
+static char *get_page(void)
+{
+  if (nr_free_pages > 0)
+	return(free_pages[--nr_free_pages]);
 
-  if (bp->b_next == NULL)
-	rear = bp->b_prev;
+  return(malloc(PAGE_SIZE));
+}
+
+
+/*===========================================================================*
+ *				put_page				     *
+ *===========================================================================*/
+static void put_page(char *page)
+{
+  if (nr_free_pages < FREE_PAGES_MAX)
+	free_pages[nr_free_pages++] = page;
   else
-	bp->b_next->b_prev = bp->b_prev;
+	free(page);
+}
 
-  /* Buffer administration is done. Now it's safe to free up bp. */
+
+/*===========================================================================*
+ *				copy_ring				     *
+ *===========================================================================*/
+static int copy_ring(struct buf *bp, size_t offset, int rw_flag,
+	cp_grant_id_t gid, size_t nbytes)
+{
+/* Copy 'nbytes' between the grant and the ring, starting at ring offset
+ * 'offset'. Every page touched is one element of a vectored safecopy. The
+ * pages must have been allocated.
+ */
+  struct vscp_vec vec[SCPVEC_NR];
+  size_t done, chunk, page_off;
+  int i, n, r;
+
+  done = 0;
+  while (done < nbytes) {
+	for (n = 0; n < SCPVEC_NR && done < nbytes; n++) {
+		i = (offset / PAGE_SIZE) % PIPE_PAGES;
+		page_off = offset % PAGE_SIZE;
+		chunk = MIN(PAGE_SIZE - page_off, nbytes - done);
+
+		assert(bp->b_page[i] != NULL);
+		if (rw_flag == READING) {
+			vec[n].v_from = SELF;
+			vec[n].v_to = VFS_PROC_NR;
+		} else {
+			vec[n].v_from = VFS_PROC_NR;
+			vec[n].v_to = SELF;
+		}
+		vec[n].v_gid = gid;
+		vec[n].v_offset = done;
+		vec[n].v_addr = (vir_bytes) (bp->b_page[i] + page_off);
+		vec[n].v_bytes = chunk;
+
+		done += chunk;
+		offset = (offset + chunk) % PIPE_RING_SIZE;
+	}
+
+	if ((r = sys_vsafecopy(vec, n)) != OK)
+		return(r);
+  }
+
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				write_block				     *
+ *===========================================================================*/
+int write_block(struct buf *bp, size_t size, cp_grant_id_t gid,
+	size_t nbytes)
+{
+/* Append 'nbytes' from the grant to the 'size' bytes already in the buffer,
+ * allocating pages as needed.
+ */
+  size_t start, offset, end;
+  int i;
+
+  assert(size + nbytes <= PIPE_RING_SIZE - PAGE_SIZE);
+  if (nbytes == 0) return(OK);
+
+  start = (bp->b_head + size) % PIPE_RING_SIZE;
+
+  /* Make sure all pages to be written exist. */
+  for (offset = start - start % PAGE_SIZE, end = start + nbytes;
+       offset < end; offset += PAGE_SIZE) {
+	i = (offset / PAGE_SIZE) % PIPE_PAGES;
+	if (bp->b_page[i] == NULL &&
+	    (bp->b_page[i] = get_page()) == NULL)
+		return(ENOSPC);
+  }
+
+  return copy_ring(bp, start, WRITING, gid, nbytes);
+}
+
+
+/*===========================================================================*
+ *				read_block				     *
+ *===========================================================================*/
+int read_block(struct buf *bp, size_t size, cp_grant_id_t gid,
+	size_t nbytes)
+{
+/* Take the first 'nbytes' of the 'size' bytes in the buffer and copy them to
+ * the grant.
+ */
+  int r;
+
+  assert(nbytes <= size);
+  if (nbytes == 0) return(OK);
+
+  if ((r = copy_ring(bp, bp->b_head, READING, gid, nbytes)) != OK)
+	return(r);
+
+  drop_block(bp, size, nbytes);
+
+  return(OK);
+}
+
+
+/*===========================================================================*
+ *				drop_block				     *
+ *===========================================================================*/
+void drop_block(struct buf *bp, size_t size, size_t nbytes)
+{
+/* Throw away the first 'nbytes' of the 'size' bytes in the buffer. Pages
+ * that have been consumed completely are given back.
+ */
+  size_t head;
+  int i;
+
+  assert(nbytes <= size);
+  if (nbytes == 0) return;
+
+  if (nbytes == size) {
+	/* Empty now; start over at the beginning of the ring. */
+	clear_block(bp);
+	return;
+  }
+
+  head = bp->b_head;
+  bp->b_head = (head + nbytes) % PIPE_RING_SIZE;
+
+  /* Give back the pages before the one holding the new head. */
+  for (i = head / PAGE_SIZE; i != bp->b_head / PAGE_SIZE;
+       i = (i + 1) % PIPE_PAGES) {
+	put_page(bp->b_page[i]);
+	bp->b_page[i] = NULL;
+  }
+}
+
+
+/*===========================================================================*
+ *				new_ring				     *
+ *===========================================================================*/
+struct buf *new_ring(void)
+{
+/* Allocate a buffer that does not belong to a pipe inode, and so is not in
+ * the hash table. Unix domain sockets keep their data in these.
+ */
+  struct buf *bp;
+
+  if ((bp = malloc(sizeof(struct buf))) == NULL)
+	return(NULL);
+
+  memset(bp, 0, sizeof(struct buf));
+  bp->b_dev = NO_DEV;
+  bp->b_count = 1;
+
+  return(bp);
+}
+
+
+/*===========================================================================*
+ *				free_ring				     *
+ *===========================================================================*/
+void free_ring(struct buf *bp)
+{
+  clear_block(bp);
   free(bp);
 }
@@ -36,12 +36,15 @@ static int uds_perform_read(int minor, endpoint_t m_source, size_t
 	size, int pretend);
 static int uds_perform_write(int minor, endpoint_t m_source, size_t
 	size, int pretend);
+static int uds_handoff(int minor, int peer, endpoint_t m_source, size_t
+	count);
+
+/* staging buffer for handing data to a reader that is blocked */
+static char uds_stage[PIPE_BUF];
 
 int uds_open(message *dev_m_in, message *dev_m_out)
 {
-	message fs_m_in, fs_m_out;
-	struct ucred ucred;
-	int rc, i;
+	int i;
 	int minor;
 
 #if DEBUG == 1
@@ -101,12 +104,18 @@ int uds_open(message *dev_m_in, message *dev_m_out)
 	uds_fd_table[minor].sel_ops_out = 0;
 	uds_fd_table[minor].status_updated = 0;
 
-	/* initialize the data pointer (pos) to the start of the PIPE */
-	uds_fd_table[minor].pos = 0;
-
-	/* the PIPE is initially empty */
+	/* the ring is initially empty */
 	uds_fd_table[minor].size = 0;
 
+	/* buffer sizes can be changed with setsockopt(2) */
+	uds_fd_table[minor].rcvbuf = UDS_BUF_DEFAULT;
+	uds_fd_table[minor].sndbuf = UDS_BUF_DEFAULT;
+
+	/* no message boundaries to keep track of yet */
+	uds_fd_table[minor].msgs = NULL;
+	uds_fd_table[minor].msg_head = 0;
+	uds_fd_table[minor].msg_count = 0;
+
 	/* the default for a new socket is to allow reading and writing.
 	 * shutdown(2) will remove one or both flags.
 	 */
@@ -160,44 +169,19 @@ int uds_open(message *dev_m_in, message *dev_m_out)
 	/* The process isn't suspended so we don't flag it as revivable */
 	uds_fd_table[minor].ready_to_revive = 0;
 
-	/* get the effective user id and effective group id from the endpoint */
-	/* this is needed in the REQ_NEWNODE request to PFS. */
-	rc = getnucred(uds_fd_table[minor].endpoint, &ucred);
-	if (rc == -1) {
-		/* roll back the changes we made to the descriptor */
-		memset(&(uds_fd_table[minor]), '\0', sizeof(uds_fd_t));
-
-		/* likely error: invalid endpoint / proc doesn't exist */
-		uds_set_reply(dev_m_out, DEV_OPEN_REPL, dev_m_in->USER_ENDPT,
-			      (cp_grant_id_t) dev_m_in->IO_GRANT, errno);
-		return errno;
-	}
-
-	/* Prepare Request to the FS side of PFS */
-
-	fs_m_in.m_type = REQ_NEWNODE;
-	fs_m_in.REQ_MODE = I_NAMED_PIPE;
-	fs_m_in.REQ_DEV = NO_DEV;
-	fs_m_in.REQ_UID = ucred.uid;
-	fs_m_in.REQ_GID = ucred.gid;
-
-	/* Request a new inode on the pipe file system */
-
-	rc = fs_newnode(&fs_m_in, &fs_m_out);
-	if (rc != OK) {
+	/* Allocate the receive ring. It holds no pages until data
+	 * arrives.
+	 */
+	uds_fd_table[minor].buf = new_ring();
+	if (uds_fd_table[minor].buf == NULL) {
 		/* roll back the changes we made to the descriptor */
 		memset(&(uds_fd_table[minor]), '\0', sizeof(uds_fd_t));
 
-		/* likely error: get_block() failed */
 		uds_set_reply(dev_m_out, DEV_OPEN_REPL, dev_m_in->USER_ENDPT,
-				(cp_grant_id_t) dev_m_in->IO_GRANT, rc);
-		return rc;
+				(cp_grant_id_t) dev_m_in->IO_GRANT, ENOMEM);
+		return ENOMEM;
 	}
 
-	/* Process the response */
-
-	uds_fd_table[minor].inode_nr = fs_m_out.RES_INODE_NR;
-
 	/* prepare the reply */
 
 	uds_fd_table[minor].syscall_done = 1;
@@ -209,8 +193,6 @@ int uds_open(message *dev_m_in, message *dev_m_out)
 int uds_close(message *dev_m_in, message *dev_m_out)
 {
 	int minor;
-	message fs_m_in, fs_m_out;
-	int rc;
 
 #if DEBUG == 1
 	static int call_count = 0;
@@ -256,24 +238,13 @@ int uds_close(message *dev_m_in, message *dev_m_out)
 		clear_fds(minor, &(uds_fd_table[minor].ancillary_data));
 	}
 
-	/* Prepare Request to the FS side of PFS */
-
-	fs_m_in.m_type = REQ_PUTNODE;
-	fs_m_in.REQ_INODE_NR = uds_fd_table[minor].inode_nr;
-	fs_m_in.REQ_COUNT = 1;
+	/* throw away any unread data */
+	free_ring(uds_fd_table[minor].buf);
+	free(uds_fd_table[minor].msgs);
 
 	/* set the socket back to its original UDS_FREE state */
 	memset(&(uds_fd_table[minor]), '\0', sizeof(uds_fd_t));
 
-	/* Request the removal of the inode from the pipe file system */
-
-	rc = fs_putnode(&fs_m_in, &fs_m_out);
-	if (rc != OK) {
-		perror("fs_putnode");
-		/* likely error: get_block() failed */
-		return rc;
-	}
-
 	uds_set_reply(dev_m_out, DEV_CLOSE_REPL, dev_m_in->USER_ENDPT,
 		      (cp_grant_id_t) dev_m_in->IO_GRANT, OK);
 	return OK;
@@ -338,7 +309,7 @@ int uds_select(message *dev_m_in, message *dev_m_out)
 	}
 
 	/* check if we can write without blocking */
-	bytes = uds_perform_write(minor, dev_m_in->m_source, PIPE_BUF, 1);
+	bytes = uds_perform_write(minor, dev_m_in->m_source, 1, 1);
 	if (bytes != 0 && bytes != SUSPEND) {
 		/* There is room to write or there is an error condition */
 		uds_fd_table[minor].sel_ops_out |= SEL_WR;
@@ -355,8 +326,8 @@ static int uds_perform_read(int minor, endpoint_t m_source,
 	size_t size, int pretend)
 {
 	int rc, peer;
-	message fs_m_in;
-	message fs_m_out;
+	size_t len, count;
+	struct uds_msg *msg;
 
 #if DEBUG == 1
 	static int call_count = 0;
@@ -423,49 +394,56 @@ static int uds_perform_read(int minor, endpoint_t m_source,
 		return SUSPEND;
 	}
 
-	if (pretend) {
-
-		return (size > uds_fd_table[minor].size) ?
-				uds_fd_table[minor].size : size;
+	/* a stream is read up to the data available. datagrams are read
+	 * whole; whatever doesn't fit in the caller's buffer is discarded.
+	 */
+	msg = NULL;
+	if (uds_fd_table[minor].type == SOCK_STREAM) {
+		len = uds_fd_table[minor].size;
+	} else {
+		msg = &uds_fd_table[minor].msgs[uds_fd_table[minor].msg_head];
+		len = msg->len;
 	}
+	count = (size > len) ? len : size;
 
-
-	/* Prepare Request to the FS side of PFS */
-	fs_m_in.m_type = REQ_READ;
-	fs_m_in.REQ_INODE_NR = uds_fd_table[minor].inode_nr;
-	fs_m_in.REQ_GRANT = uds_fd_table[minor].io_gr;
-	fs_m_in.REQ_SEEK_POS_HI = 0;
-	fs_m_in.REQ_SEEK_POS_LO = uds_fd_table[minor].pos;
-	fs_m_in.REQ_NBYTES = (size > uds_fd_table[minor].size) ?
-				uds_fd_table[minor].size : size;
+	if (pretend) {
+		return count;
+	}
 
 	/* perform the read */
-	rc = fs_readwrite(&fs_m_in, &fs_m_out);
+	rc = read_block(uds_fd_table[minor].buf, uds_fd_table[minor].size,
+		uds_fd_table[minor].io_gr, count);
 	if (rc != OK) {
-		perror("fs_readwrite");
+		perror("read_block");
 		return rc;
 	}
 
-	/* Process the response */
-#if DEBUG == 1
-	printf("(uds) [%d] read complete\n", minor);
-#endif
+	/* decrease the number of unread bytes */
+	uds_fd_table[minor].size -= count;
 
-	/* move the position of the data pointer up to data we haven't
-	 * read yet
-	 */
-	uds_fd_table[minor].pos += fs_m_out.RES_NBYTES;
+	if (msg != NULL) {
+		/* drop the rest of the datagram */
+		drop_block(uds_fd_table[minor].buf, uds_fd_table[minor].size,
+			len - count);
+		uds_fd_table[minor].size -= len - count;
 
-	/* decrease the number of unread bytes */
-	uds_fd_table[minor].size -= fs_m_out.RES_NBYTES;
+		/* fill in the source address to be returned by recvfrom &
+		 * recvmsg
+		 */
+		if (uds_fd_table[minor].type == SOCK_DGRAM) {
+			memcpy(&uds_fd_table[minor].source, &msg->source,
+						sizeof(struct sockaddr_un));
+		}
 
-	/* if we have 0 unread bytes, move the data pointer back to the
-	 * start of the buffer
-	 */
-	if (uds_fd_table[minor].size == 0) {
-		uds_fd_table[minor].pos = 0;
+		uds_fd_table[minor].msg_head =
+			(uds_fd_table[minor].msg_head + 1) % UDS_MSG_MAX;
+		uds_fd_table[minor].msg_count--;
 	}
 
+#if DEBUG == 1
+	printf("(uds) [%d] read complete\n", minor);
+#endif
+
 	/* maybe a big write was waiting for us to read some data, if
 	 * needed revive the writer
 	 */
@@ -478,7 +456,7 @@ static int uds_perform_read(int minor, endpoint_t m_source,
 	 * (from peer to minor)
 	 */
 	if (peer != -1 && uds_fd_table[peer].selecting == 1 &&
-	    (uds_fd_table[minor].size+uds_fd_table[minor].pos + 1 < PIPE_BUF)){
+	    uds_fd_table[minor].size < uds_fd_table[minor].rcvbuf) {
 
 		/* if the peer wants to know about write being possible
 		 * and it doesn't know about it already, then let the peer know.
@@ -493,15 +471,15 @@ static int uds_perform_read(int minor, endpoint_t m_source,
 		}
 	}
 
-	return fs_m_out.RES_NBYTES; /* return number of bytes read */
+	return count; /* return number of bytes read */
 }
 
 static int uds_perform_write(int minor, endpoint_t m_source,
 						size_t size, int pretend)
 {
-	int rc, peer, i;
-	message fs_m_in;
-	message fs_m_out;
+	int rc, peer, i, blocked;
+	size_t avail, atomic, count;
+	struct uds_msg *msg;
 
 #if DEBUG == 1
 	static int call_count = 0;
@@ -521,12 +499,6 @@ static int uds_perform_write(int minor, endpoint_t m_source,
 		return EPIPE;
 	}
 
-	if (size > PIPE_BUF) {
-
-		/* message is too big to ever write to the PIPE */
-		return EMSGSIZE;
-	}
-
 	if (uds_fd_table[minor].type == SOCK_STREAM ||
 			uds_fd_table[minor].type == SOCK_SEQPACKET) {
 
@@ -579,15 +551,32 @@ static int uds_perform_write(int minor, endpoint_t m_source,
 		return EPIPE;
 	}
 
-	/* check if write would overrun buffer. check if message
-	 * boundry preserving types (SEQPACKET and DGRAM) wouldn't write
-	 * to an empty buffer. check if connectionless sockets have a
-	 * target to write to.
+	/* check if write would overrun the peer's receive buffer. stream
+	 * writes of up to SO_SNDBUF bytes are atomic, larger ones take
+	 * whatever room there is. message boundary preserving types
+	 * (SEQPACKET and DGRAM) need room for the whole message.
 	 */
-	if ((uds_fd_table[peer].pos+uds_fd_table[peer].size+size > PIPE_BUF) ||
-		((uds_fd_table[minor].type == SOCK_SEQPACKET ||
-		uds_fd_table[minor].type == SOCK_DGRAM) &&
-		uds_fd_table[peer].size > 0)) {
+	avail = (uds_fd_table[peer].size < uds_fd_table[peer].rcvbuf) ?
+		uds_fd_table[peer].rcvbuf - uds_fd_table[peer].size : 0;
+
+	if (uds_fd_table[minor].type == SOCK_STREAM) {
+		atomic = MIN(uds_fd_table[minor].sndbuf,
+			uds_fd_table[peer].rcvbuf);
+		count = (size > avail && size > atomic) ? avail : size;
+		blocked = (count == 0 || count > avail);
+	} else {
+		if (size > uds_fd_table[minor].sndbuf ||
+			size > uds_fd_table[peer].rcvbuf) {
+
+			/* message is too big to ever fit in the buffer */
+			return EMSGSIZE;
+		}
+		count = size;
+		blocked = (count > avail ||
+			uds_fd_table[peer].msg_count == UDS_MSG_MAX);
+	}
+
+	if (blocked) {
 
 		if (pretend) {
 			return SUSPEND;
@@ -603,45 +592,60 @@ static int uds_perform_write(int minor, endpoint_t m_source,
 	printf("(uds) [%d] suspending write request\n", minor);
 #endif
 
-		/* Process is reading from an empty pipe,
-		 * suspend it so some bytes can be written
+		/* Process is writing to a full buffer,
+		 * suspend it so some bytes can be read
 		 */
 		uds_fd_table[minor].suspended = UDS_SUSPENDED_WRITE;
 		return SUSPEND;
 	}
 
 	if (pretend) {
-		return size;
+		return count;
+	}
+
+	/* a reader that is blocked on an empty buffer gets the data
+	 * directly, without queueing it first
+	 */
+	if (uds_fd_table[peer].suspended == UDS_SUSPENDED_READ &&
+		uds_fd_table[peer].size == 0 &&
+		uds_handoff(minor, peer, m_source, count) == OK) {
+
+		return count;
 	}
 
-	/* Prepare Request to the FS side of PFS */
-	fs_m_in.m_type = REQ_WRITE;
-	fs_m_in.REQ_INODE_NR = uds_fd_table[peer].inode_nr;
-	fs_m_in.REQ_GRANT = uds_fd_table[minor].io_gr;
-	fs_m_in.REQ_SEEK_POS_HI = 0;
-	fs_m_in.REQ_SEEK_POS_LO = uds_fd_table[peer].pos +
-					uds_fd_table[peer].size;
-	fs_m_in.REQ_NBYTES = size;
-
-	/* Request the write */
-	rc = fs_readwrite(&fs_m_in, &fs_m_out);
+	if (uds_fd_table[minor].type != SOCK_STREAM &&
+		uds_fd_table[peer].msgs == NULL) {
+
+		/* first datagram for peer, set up its message queue */
+		uds_fd_table[peer].msgs =
+			malloc(UDS_MSG_MAX * sizeof(struct uds_msg));
+		if (uds_fd_table[peer].msgs == NULL) {
+			return ENOMEM;
+		}
+	}
+
+	/* perform the write */
+	rc = write_block(uds_fd_table[peer].buf, uds_fd_table[peer].size,
+		uds_fd_table[minor].io_gr, count);
 	if (rc != OK) {
-		perror("fs_readwrite");
+		perror("write_block");
 		return rc;
 	}
 
-	/* Process the response */
 #if DEBUG == 1
 	printf("(uds) [%d] write complete\n", minor);
 #endif
 	/* increase the count of unread bytes */
-	uds_fd_table[peer].size += fs_m_out.RES_NBYTES;
-
-
-	/* fill in the source address to be returned by recvfrom & recvmsg */
-	if (uds_fd_table[minor].type == SOCK_DGRAM) {
-		memcpy(&uds_fd_table[peer].source, &uds_fd_table[minor].addr,
+	uds_fd_table[peer].size += count;
+
+	/* remember the message boundary and where it came from */
+	if (uds_fd_table[minor].type != SOCK_STREAM) {
+		msg = &uds_fd_table[peer].msgs[(uds_fd_table[peer].msg_head +
+			uds_fd_table[peer].msg_count) % UDS_MSG_MAX];
+		msg->len = count;
+		memcpy(&msg->source, &uds_fd_table[minor].addr,
 						sizeof(struct sockaddr_un));
+		uds_fd_table[peer].msg_count++;
 	}
 
 	/* revive peer that was waiting for us to write */
@@ -651,7 +655,7 @@ static int uds_perform_write(int minor, endpoint_t m_source,
 	}
 
 	/* see if peer is blocked on select()*/
-	if (uds_fd_table[peer].selecting == 1 && fs_m_out.RES_NBYTES > 0) {
+	if (uds_fd_table[peer].selecting == 1) {
 
 		/* if the peer wants to know about data ready to read
 		 * and it doesn't know about it already, then let the peer
@@ -667,7 +671,51 @@ static int uds_perform_write(int minor, endpoint_t m_source,
 		}
 	}
 
-	return fs_m_out.RES_NBYTES; /* return number of bytes written */
+	return count; /* return number of bytes written */
+}
+
+static int uds_handoff(int minor, int peer, endpoint_t m_source,
+	size_t count)
+{
+	message m_out;
+	int rc;
+
+	/* The kernel copies between a grant and our own memory only, so
+	 * the data goes through a staging buffer on its way from the
+	 * writer to the reader. Anything that doesn't fit is queued.
+	 */
+	if (count > sizeof(uds_stage) ||
+		count > uds_fd_table[peer].io_gr_size) {
+		return EAGAIN;
+	}
+
+	rc = sys_safecopyfrom(VFS_PROC_NR, uds_fd_table[minor].io_gr,
+			(vir_bytes) 0, (vir_bytes) uds_stage, count);
+	if (rc != OK) {
+		return rc;
+	}
+
+	rc = sys_safecopyto(VFS_PROC_NR, uds_fd_table[peer].io_gr,
+			(vir_bytes) 0, (vir_bytes) uds_stage, count);
+	if (rc != OK) {
+		return rc;
+	}
+
+	/* fill in the source address to be returned by recvfrom & recvmsg */
+	if (uds_fd_table[minor].type == SOCK_DGRAM) {
+		memcpy(&uds_fd_table[peer].source, &uds_fd_table[minor].addr,
+						sizeof(struct sockaddr_un));
+	}
+
+	/* the read is done, revive the reader */
+	uds_fd_table[peer].suspended = UDS_NOT_SUSPENDED;
+	uds_fd_table[peer].ready_to_revive = 0;
+
+	uds_set_reply(&m_out, DEV_REVIVE, uds_fd_table[peer].endpoint,
+		      uds_fd_table[peer].io_gr, count);
+	reply(m_source, &m_out);
+
+	return OK;
 }
 
 int uds_read(message *dev_m_in, message *dev_m_out)
@@ -38,10 +38,18 @@ off_t newsize;			/* inode must become this size */
  * writing is done.
  */
 
+  struct buf *bp;
+
   /* Pipes can shrink, so adjust size to make sure all zones are removed. */
   if(newsize != 0) return(EINVAL);	/* Only truncate pipes to 0. */
   rip->i_size = newsize;
 
+  /* Throw away the data in the pipe. */
+  if ((bp = get_block(rip->i_dev, rip->i_num)) != NULL) {
+	clear_block(bp);
+	put_block(rip->i_dev, rip->i_num);
+  }
+
   /* Next correct the inode size. */
   wipe_inode(rip);	/* Pipes can only be truncated to 0. */
 
@@ -32,6 +32,9 @@ int fs_newnode(message *fs_m_in, message *fs_m_out)
 		if ((get_block(dev, rip->i_num)) == NULL)
 			r = EIO;
 		break;
+	case 0:
+		/* A node of no file type, such as a kqueue, holds no data */
+		break;
 	default:
 		r = EIO; /* Unsupported file type */
   }
@@ -12,6 +12,14 @@ struct ancillary;
 /* buffer.c */
 struct buf *get_block(dev_t dev, ino_t inum);
 void put_block(dev_t dev, ino_t inum);
+void clear_block(struct buf *bp);
+int read_block(struct buf *bp, size_t size, cp_grant_id_t gid, size_t
+	nbytes);
+int write_block(struct buf *bp, size_t size, cp_grant_id_t gid, size_t
+	nbytes);
+void drop_block(struct buf *bp, size_t size, size_t nbytes);
+struct buf *new_ring(void);
+void free_ring(struct buf *bp);
 
 /* cache.c */
 void buf_pool(void);
@@ -13,7 +13,7 @@ int fs_readwrite(message *fs_m_in, message *fs_m_out)
   int r, rw_flag;
   struct buf *bp;
   cp_grant_id_t gid;
-  off_t position, f_size;
+  off_t f_size;
   unsigned int nrbytes, cum_io;
   mode_t mode_word;
   struct inode *rip;
@@ -36,7 +36,7 @@ int fs_readwrite(message *fs_m_in, message *fs_m_out)
   nrbytes = (unsigned) fs_m_in->REQ_NBYTES;
 
   /* We can't read beyond the max file position */
-  if (nrbytes > PIPE_BUF) return(EFBIG);
+  if (nrbytes > PIPE_MAX_SIZE) return(EFBIG);
 
   /* Mark inode in use */
   if ((get_inode(rip->i_dev, rip->i_num)) == NULL) return(err_code);
@@ -44,44 +44,30 @@ int fs_readwrite(message *fs_m_in, message *fs_m_out)
 
   if (rw_flag == WRITING) {
 	/* Check in advance to see if file will grow too big. */
-	/* Casting nrbytes to signed is safe, because it's guaranteed not to
-	 * be beyond max signed value (i.e., MAX_FILE_POS).
-	 */
-	position = rip->i_size;
-	if ((unsigned) position + nrbytes > PIPE_BUF) {
+	if ((unsigned) f_size + nrbytes > PIPE_MAX_SIZE) {
 		put_inode(rip);
 		put_block(rip->i_dev, rip->i_num);
 		return(EFBIG);
 	}
+
+	/* Append the data to the ring. */
+	r = write_block(bp, (size_t) f_size, gid, (size_t) nrbytes);
+	if (r == OK) {
+		rip->i_size += (off_t) nrbytes;
+		cum_io += nrbytes;
+	}
   } else {
-	position = 0;
-	if (nrbytes > rip->i_size) {
+	if (nrbytes > f_size) {
 		/* There aren't that many bytes to read */
-		nrbytes = rip->i_size;
+		nrbytes = f_size;
 	}
-  }
-
-  if (rw_flag == READING) {
-	/* Copy a chunk from the block buffer to user space. */
-	r = sys_safecopyto(VFS_PROC_NR, gid, (vir_bytes) 0,
-		(vir_bytes) (bp->b_data+position), (size_t) nrbytes);
-  } else {
-	/* Copy a chunk from user space to the block buffer. */
-	r = sys_safecopyfrom(VFS_PROC_NR, gid, (vir_bytes) 0,
-		(vir_bytes) (bp->b_data+position), (size_t) nrbytes);
-  }
 
-  if (r == OK) {
-	position += (signed) nrbytes; /* Update position */
-	cum_io += nrbytes;
-  }
-
-  /* On write, update file size and access time. */
-  if (rw_flag == WRITING) {
-	rip->i_size = position;
-  } else {
-	memmove(bp->b_data, bp->b_data+nrbytes, rip->i_size - nrbytes);
-	rip->i_size -= nrbytes;
+	/* Take the data from the front of the ring. */
+	r = read_block(bp, (size_t) f_size, gid, (size_t) nrbytes);
+	if (r == OK) {
+		rip->i_size -= (off_t) nrbytes;
+		cum_io += nrbytes;
+	}
   }
 
   if (rw_flag == READING) rip->i_update |= ATIME;
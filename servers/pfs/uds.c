@@ -996,8 +996,8 @@ int do_getsockopt_peercred(message *dev_m_in, message *dev_m_out)
 
 int do_getsockopt_sndbuf(message *dev_m_in, message *dev_m_out)
 {
+	int minor;
 	int rc;
-	size_t sndbuf = PIPE_BUF;
 
 #if DEBUG == 1
 	static int call_count = 0;
@@ -1005,23 +1005,29 @@ int do_getsockopt_sndbuf(message *dev_m_in, message *dev_m_out)
 				uds_minor(dev_m_in), ++call_count);
 #endif
 
+	minor = uds_minor(dev_m_in);
+
 	rc = sys_safecopyto(VFS_PROC_NR, (cp_grant_id_t) dev_m_in->IO_GRANT,
-		(vir_bytes) 0, (vir_bytes) &(sndbuf), sizeof(size_t));
+		(vir_bytes) 0, (vir_bytes) &(uds_fd_table[minor].sndbuf),
+		sizeof(size_t));
 
 	return rc ? EIO : OK;
 }
 
 int do_setsockopt_sndbuf(message *dev_m_in, message *dev_m_out)
 {
+	int minor;
 	int rc;
 	size_t sndbuf;
 
 #if DEBUG == 1
 	static int call_count = 0;
-	printf("(uds) [%d] do_setsockopt_rcvbuf() call_count=%d\n",
+	printf("(uds) [%d] do_setsockopt_sndbuf() call_count=%d\n",
 				uds_minor(dev_m_in), ++call_count);
 #endif
 
+	minor = uds_minor(dev_m_in);
+
 	rc = sys_safecopyfrom(VFS_PROC_NR, (cp_grant_id_t) dev_m_in->IO_GRANT,
 				(vir_bytes) 0, (vir_bytes) &sndbuf,
 				sizeof(size_t));
@@ -1030,21 +1036,27 @@ int do_setsockopt_sndbuf(message *dev_m_in, message *dev_m_out)
 		return EIO;
 	}
 
-	if (sndbuf > PIPE_BUF) {
-		/* The send buffer is limited to 32K at the moment. */
-		return ENOSYS;
+	if (sndbuf == 0) {
+		return EINVAL;
 	}
 
-	/* There is no way to reduce the send buffer, do we have to
-	 * let this call fail for smaller buffers?
+	if (sndbuf > UDS_BUF_MAX) {
+		/* The buffers are limited to the size of a ring. */
+		return ENOBUFS;
+	}
+
+	/* The send buffer bounds atomic stream writes and the size of
+	 * datagrams.
 	 */
+	uds_fd_table[minor].sndbuf = sndbuf;
+
 	return OK;
 }
 
 int do_getsockopt_rcvbuf(message *dev_m_in, message *dev_m_out)
 {
+	int minor;
 	int rc;
-	size_t rcvbuf = PIPE_BUF;
 
 #if DEBUG == 1
 	static int call_count = 0;
@@ -1052,14 +1064,18 @@ int do_getsockopt_rcvbuf(message *dev_m_in, message *dev_m_out)
 				uds_minor(dev_m_in), ++call_count);
 #endif
 
+	minor = uds_minor(dev_m_in);
+
 	rc = sys_safecopyto(VFS_PROC_NR, (cp_grant_id_t) dev_m_in->IO_GRANT,
-		(vir_bytes) 0, (vir_bytes) &(rcvbuf), sizeof(size_t));
+		(vir_bytes) 0, (vir_bytes) &(uds_fd_table[minor].rcvbuf),
+		sizeof(size_t));
 
 	return rc ? EIO : OK;
 }
 
 int do_setsockopt_rcvbuf(message *dev_m_in, message *dev_m_out)
 {
+	int minor, peer;
 	int rc;
 	size_t rcvbuf;
 
@@ -1069,6 +1085,8 @@ int do_setsockopt_rcvbuf(message *dev_m_in, message *dev_m_out)
 				uds_minor(dev_m_in), ++call_count);
 #endif
 
+	minor = uds_minor(dev_m_in);
+
 	rc = sys_safecopyfrom(VFS_PROC_NR, (cp_grant_id_t) dev_m_in->IO_GRANT,
 				(vir_bytes) 0, (vir_bytes) &rcvbuf,
 				sizeof(size_t));
@@ -1077,14 +1095,27 @@ int do_setsockopt_rcvbuf(message *dev_m_in, message *dev_m_out)
 		return EIO;
 	}
 
-	if (rcvbuf > PIPE_BUF) {
-		/* The send buffer is limited to 32K at the moment. */
-		return ENOSYS;
+	if (rcvbuf == 0) {
+		return EINVAL;
 	}
 
-	/* There is no way to reduce the send buffer, do we have to
-	 * let this call fail for smaller buffers?
+	if (rcvbuf > UDS_BUF_MAX) {
+		/* The buffers are limited to the size of a ring. */
+		return ENOBUFS;
+	}
+
+	/* Data already queued is kept if the buffer shrinks below it;
+	 * writers block until it has been read.
 	 */
+	uds_fd_table[minor].rcvbuf = rcvbuf;
+
+	/* a writer blocked on a full buffer may fit now */
+	peer = uds_fd_table[minor].peer;
+	if (peer != -1 && uds_fd_table[peer].suspended == UDS_SUSPENDED_WRITE) {
+		uds_fd_table[peer].ready_to_revive = 1;
+		uds_unsuspend(dev_m_in->m_source, peer);
+	}
+
 	return OK;
 }
 
@@ -19,6 +19,15 @@
 /* max connection backlog for incoming connections */
 #define UDS_SOMAXCONN 64
 
+/* default and maximum size of the send and receive buffers. the maximum
+ * must fit in a ring of pages (see buf.h) with its spare page left free.
+ */
+#define UDS_BUF_DEFAULT PIPE_BUF
+#define UDS_BUF_MAX PIPE_MAX_SIZE
+
+/* max number of datagrams queued on a SOCK_DGRAM or SOCK_SEQPACKET socket */
+#define UDS_MSG_MAX 32
+
 typedef void* filp_id_t;
 
 /* ancillary data to be sent */
@@ -29,6 +38,12 @@ struct ancillary {
 	struct ucred cred;
 };
 
+/* boundary and sender of a queued datagram */
+struct uds_msg {
+	size_t len;
+	struct sockaddr_un source;
+};
+
 /*
  * Internal State Information for a socket descriptor.
  */
@@ -57,21 +72,31 @@ struct uds_fd {
 	/* endpoint for suspend/resume */
 	endpoint_t endpoint;
 
-/* Pipe Housekeeping */
+/* Buffer Housekeeping */
 
-	/* inode number on PFS -- each descriptor is backed by 1
-	 * PIPE which is allocated in uds_open() and freed in
-	 * uds_close(). Data is sent/written to a peer's PIPE.
-	 * Data is recv/read from this PIPE.
+	/* receive ring -- each descriptor has a ring of pages which
+	 * is allocated in uds_open() and freed in uds_close(). Data
+	 * is sent/written to a peer's ring. Data is recv/read from
+	 * this ring. Pages are only allocated while data is queued.
 	 */
-	ino_t inode_nr;
+	struct buf *buf;
 
+	/* size of data in the ring */
+	size_t size;
 
-	/* position in the PIPE where the data starts */
-	off_t pos;
+	/* SO_RCVBUF -- limit on the size of data in the ring */
+	size_t rcvbuf;
 
-	/* size of data in the PIPE */
-	size_t size;
+	/* SO_SNDBUF -- limit on the size of an atomic write */
+	size_t sndbuf;
+
+	/* message boundaries for SOCK_DGRAM and SOCK_SEQPACKET. The
+	 * queue of UDS_MSG_MAX entries is allocated on the first
+	 * write to the socket, and freed in uds_close().
+	 */
+	struct uds_msg *msgs;
+	int msg_head;
+	int msg_count;
 
 	/* control read/write, set by uds_open() and shutdown(2).
 	 * Can be set to S_IRUSR|S_IWUSR, S_IRUSR, S_IWUSR, or 0
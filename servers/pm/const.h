@@ -5,6 +5,8 @@
 				 * a 'short' instead of pid_t.)
 				 */
 
+#define PID_HASH_SIZE	 256	/* # chains in the pid and group hashes */
+
 #define NO_PID	           0	/* pid value indicating no process */
 #define INIT_PID	   1	/* INIT's process id number */
 
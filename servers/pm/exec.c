@@ -116,6 +116,7 @@ int do_newexec()
 
 	/* Kill process if something goes wrong after this point. */
 	rmp->mp_flags |= PARTIAL_EXEC;
+	proc_changed(rmp);
 
 	mp->mp_reply.reply_res2= (vir_bytes) rmp->mp_frame_addr;
 	mp->mp_reply.reply_res3= flags;
@@ -37,6 +37,7 @@ static void tell_parent(struct mproc *child);
 static void tell_tracer(struct mproc *child);
 static void tracer_died(struct mproc *child);
 static void cleanup(register struct mproc *rmp);
+static int wait_child(struct mproc *rp, int pidarg, int *children, int *r);
 
 /*===========================================================================*
  *				do_fork					     *
@@ -47,8 +48,7 @@ int do_fork()
   register struct mproc *rmp;	/* pointer to parent */
   register struct mproc *rmc;	/* pointer to child */
   pid_t new_pid;
-  static unsigned int next_child = 0;
-  int i, n = 0, s;
+  int i, s;
   endpoint_t child_ep;
   message m;
 
@@ -64,27 +64,22 @@ int do_fork()
   }
 
   /* Find a slot in 'mproc' for the child process.  A slot must exist. */
-  do {
-        next_child = (next_child+1) % NR_PROCS;
-	n++;
-  } while((mproc[next_child].mp_flags & IN_USE) && n <= NR_PROCS);
-  if(n > NR_PROCS)
+  if ((rmc = get_free_slot()) == NULL)
 	panic("do_fork can't find child slot");
-  if(next_child >= NR_PROCS || (mproc[next_child].mp_flags & IN_USE))
-	panic("do_fork finds wrong child slot: %d", next_child);
 
   /* Memory part of the forking. */
-  if((s=vm_fork(rmp->mp_endpoint, next_child, &child_ep)) != OK) {
+  if((s=vm_fork(rmp->mp_endpoint, rmc - mproc, &child_ep)) != OK) {
+	put_free_slot(rmc);
 	return s;
   }
 
   /* PM may not fail fork after call to vm_fork(), as VM calls sys_fork(). */
 
-  rmc = &mproc[next_child];
   /* Set up the child and its memory map; copy its 'mproc' slot from parent. */
   procs_in_use++;
   *rmc = *rmp;			/* copy parent's process slot to child's */
   rmc->mp_parent = who_p;			/* record child's parent */
+  rmc->mp_child = NULL;				/* no children yet */
   if (!(rmc->mp_trace_flags & TO_TRACEFORK)) {
 	rmc->mp_tracer = NO_TRACER;		/* no tracer attached */
 	rmc->mp_trace_flags = 0;
@@ -112,6 +107,8 @@ int do_fork()
   /* Find a free pid for the child and put it in the table. */
   new_pid = get_free_pid();
   rmc->mp_pid = new_pid;	/* assign pid to child */
+  link_proc(rmc);
+  proc_changed(rmc);
 
   m.m_type = PM_FORK;
   m.PM_PROC = rmc->mp_endpoint;
@@ -144,8 +141,7 @@ int do_srv_fork()
   register struct mproc *rmc;	/* pointer to child */
   int s;
   pid_t new_pid;
-  static unsigned int next_child = 0;
-  int i, n = 0;
+  int i;
   endpoint_t child_ep;
   message m;
 
@@ -165,24 +161,19 @@ int do_srv_fork()
   }
 
   /* Find a slot in 'mproc' for the child process.  A slot must exist. */
-  do {
-        next_child = (next_child+1) % NR_PROCS;
-	n++;
-  } while((mproc[next_child].mp_flags & IN_USE) && n <= NR_PROCS);
-  if(n > NR_PROCS)
-	panic("do_fork can't find child slot");
-  if(next_child >= NR_PROCS || (mproc[next_child].mp_flags & IN_USE))
-	panic("do_fork finds wrong child slot: %d", next_child);
+  if ((rmc = get_free_slot()) == NULL)
+	panic("do_srv_fork can't find child slot");
 
-  if((s=vm_fork(rmp->mp_endpoint, next_child, &child_ep)) != OK) {
+  if((s=vm_fork(rmp->mp_endpoint, rmc - mproc, &child_ep)) != OK) {
+	put_free_slot(rmc);
 	return s;
   }
 
-  rmc = &mproc[next_child];
   /* Set up the child and its memory map; copy its 'mproc' slot from parent. */
   procs_in_use++;
   *rmc = *rmp;			/* copy parent's process slot to child's */
   rmc->mp_parent = who_p;			/* record child's parent */
+  rmc->mp_child = NULL;				/* no children yet */
   if (!(rmc->mp_trace_flags & TO_TRACEFORK)) {
 	rmc->mp_tracer = NO_TRACER;		/* no tracer attached */
 	rmc->mp_trace_flags = 0;
@@ -205,6 +196,8 @@ int do_srv_fork()
   /* Find a free pid for the child and put it in the table. */
   new_pid = get_free_pid();
   rmc->mp_pid = new_pid;	/* assign pid to child */
+  link_proc(rmc);
+  proc_changed(rmc);
 
   m.m_type = PM_SRV_FORK;
   m.PM_PROC = rmc->mp_endpoint;
@@ -263,7 +256,7 @@ int dump_core;			/* flag indicating whether to dump core */
   register int proc_nr, proc_nr_e;
   int r;
   pid_t procgrp;
-  struct mproc *p_mp;
+  struct mproc *p_mp, *rmc;
   clock_t user_time, sys_time;
   message m;
 
@@ -342,8 +335,9 @@ int dump_core;			/* flag indicating whether to dump core */
   /* Clean up most of the flags describing the process's state before the exit,
    * and mark it as exiting.
    */
-  rmp->mp_flags &= (IN_USE|VFS_CALL|PRIV_PROC|TRACE_EXIT);
+  rmp->mp_flags &= (IN_USE|VFS_CALL|PRIV_PROC|TRACE_EXIT|TRACER);
   rmp->mp_flags |= EXITING;
+  proc_changed(rmp);
 
   /* Keep the process around until VFS is finished with it. */
   
@@ -355,23 +349,26 @@ int dump_core;			/* flag indicating whether to dump core */
   if (!dump_core)
 	zombify(rmp);
 
-  /* If the process has children, disinherit them.  INIT is the new parent. */
-  for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++) {
-	if (!(rmp->mp_flags & IN_USE)) continue;
 #if USE_TRACE
-	if (rmp->mp_tracer == proc_nr) {
-		/* This child's tracer died. Do something sensible. */
-		tracer_died(rmp);
+  /* If the process traced others, they may be anywhere in the table. */
+  if (rmp->mp_flags & TRACER) {
+	for (rmc = &mproc[0]; rmc < &mproc[NR_PROCS]; rmc++) {
+		if (!(rmc->mp_flags & IN_USE)) continue;
+		if (rmc->mp_tracer == proc_nr) {
+			/* This child's tracer died. Do something sensible. */
+			tracer_died(rmc);
+		}
 	}
+  }
 #endif /* USE_TRACE */
-	if (rmp->mp_parent == proc_nr) {
-		/* 'rmp' now points to a child to be disinherited. */
-		rmp->mp_parent = INIT_PROC_NR;
 
-		/* Notify new parent. */
-		if (rmp->mp_flags & ZOMBIE)
-			check_parent(rmp, TRUE /*try_cleanup*/);
-	}
+  /* If the process has children, disinherit them.  INIT is the new parent. */
+  while ((rmc = rmp->mp_child) != NULL) {
+	set_parent(rmc, INIT_PROC_NR);
+
+	/* Notify new parent. */
+	if (rmc->mp_flags & ZOMBIE)
+		check_parent(rmc, TRUE /*try_cleanup*/);
   }
 
   /* Send a hangup to the process' process group if it was a session leader. */
@@ -453,7 +450,7 @@ int do_waitpid()
  * Both WAIT and WAITPID are handled by this code.
  */
   register struct mproc *rp;
-  int i, pidarg, options, children;
+  int r, pidarg, options, children;
 
   /* Set internal variables, depending on whether this is WAIT or WAITPID. */
   pidarg  = (call_nr == WAIT ? -1 : m_in.pid);	   /* 1st param of waitpid */
@@ -464,54 +461,21 @@ int do_waitpid()
    *	pidarg  >  0 means pidarg is pid of a specific process to wait for
    *	pidarg == -1 means wait for any child
    *	pidarg  < -1 means wait for any child whose process group = -pidarg
+   * A tracer may be waiting for processes that are not its children, so it
+   * has to look at the whole table; any other process only has to look at
+   * its own children.
    */
   children = 0;
-  for (rp = &mproc[0]; rp < &mproc[NR_PROCS]; rp++) {
-	if ((rp->mp_flags & (IN_USE | TOLD_PARENT)) != IN_USE) continue;
-	if (rp->mp_parent != who_p && rp->mp_tracer != who_p) continue;
-	if (rp->mp_parent != who_p && (rp->mp_flags & ZOMBIE)) continue;
-
-	/* The value of pidarg determines which children qualify. */
-	if (pidarg  > 0 && pidarg != rp->mp_pid) continue;
-	if (pidarg < -1 && -pidarg != rp->mp_procgrp) continue;
-
-	children++;			/* this child is acceptable */
-
 #if USE_TRACE
-	if (rp->mp_tracer == who_p) {
-		if (rp->mp_flags & TRACE_ZOMBIE) {
-			/* Traced child meets the pid test and has exited. */
-			tell_tracer(rp);
-			check_parent(rp, TRUE /*try_cleanup*/);
-			return(SUSPEND);
-		}
-		if (rp->mp_flags & STOPPED) {
-			/* This child meets the pid test and is being traced.
-			 * Deliver a signal to the tracer, if any.
-			 */
-			for (i = 1; i < _NSIG; i++) {
-				if (sigismember(&rp->mp_sigtrace, i)) {
-					sigdelset(&rp->mp_sigtrace, i);
-
-					mp->mp_reply.reply_res2 =
-						0177 | (i << 8);
-					return(rp->mp_pid);
-				}
-			}
-		}
-	}
+  if (mp->mp_flags & TRACER) {
+	for (rp = &mproc[0]; rp < &mproc[NR_PROCS]; rp++)
+		if (wait_child(rp, pidarg, &children, &r))
+			return(r);
+  } else
 #endif /* USE_TRACE */
-
-	if (rp->mp_parent == who_p) {
-		if (rp->mp_flags & ZOMBIE) {
-			/* This child meets the pid test and has exited. */
-			tell_parent(rp); /* this child has already exited */
-			if (!(rp->mp_flags & VFS_CALL))
-				cleanup(rp);
-			return(SUSPEND);
-		}
-	}
-  }
+  for (rp = mp->mp_child; rp != NULL; rp = rp->mp_sibling)
+	if (wait_child(rp, pidarg, &children, &r))
+		return(r);
 
   /* No qualifying child has exited.  Wait for one, unless none exists. */
   if (children > 0) {
@@ -521,6 +485,7 @@ int do_waitpid()
 	}
 	mp->mp_flags |= WAITING;	     /* parent wants to wait */
 	mp->mp_wpid = (pid_t) pidarg;	     /* save pid for later */
+	proc_changed(mp);
 	return(SUSPEND);		     /* do not reply, let it wait */
   } else {
 	/* No child even meets the pid test.  Return error immediately. */
@@ -528,6 +493,70 @@ int do_waitpid()
   }
 }
 
+/*===========================================================================*
+ *				wait_child				     *
+ *===========================================================================*/
+static int wait_child(rp, pidarg, children, r)
+struct mproc *rp;			/* process that may be waited for */
+int pidarg;				/* pid argument of the wait call */
+int *children;				/* number of acceptable children */
+int *r;					/* result of the call, if done */
+{
+/* Check whether the caller of WAIT or WAITPID may collect process 'rp'.
+ * Return TRUE if the call is done, with its result in 'r'.
+ */
+  int i;
+
+  if ((rp->mp_flags & (IN_USE | TOLD_PARENT)) != IN_USE) return(FALSE);
+  if (rp->mp_parent != who_p && rp->mp_tracer != who_p) return(FALSE);
+  if (rp->mp_parent != who_p && (rp->mp_flags & ZOMBIE)) return(FALSE);
+
+  /* The value of pidarg determines which children qualify. */
+  if (pidarg  > 0 && pidarg != rp->mp_pid) return(FALSE);
+  if (pidarg < -1 && -pidarg != rp->mp_procgrp) return(FALSE);
+
+  (*children)++;			/* this child is acceptable */
+
+#if USE_TRACE
+  if (rp->mp_tracer == who_p) {
+	if (rp->mp_flags & TRACE_ZOMBIE) {
+		/* Traced child meets the pid test and has exited. */
+		tell_tracer(rp);
+		check_parent(rp, TRUE /*try_cleanup*/);
+		*r = SUSPEND;
+		return(TRUE);
+	}
+	if (rp->mp_flags & STOPPED) {
+		/* This child meets the pid test and is being traced.
+		 * Deliver a signal to the tracer, if any.
+		 */
+		for (i = 1; i < _NSIG; i++) {
+			if (sigismember(&rp->mp_sigtrace, i)) {
+				sigdelset(&rp->mp_sigtrace, i);
+
+				mp->mp_reply.reply_res2 = 0177 | (i << 8);
+				*r = rp->mp_pid;
+				return(TRUE);
+			}
+		}
+	}
+  }
+#endif /* USE_TRACE */
+
+  if (rp->mp_parent == who_p) {
+	if (rp->mp_flags & ZOMBIE) {
+		/* This child meets the pid test and has exited. */
+		tell_parent(rp); /* this child has already exited */
+		if (!(rp->mp_flags & VFS_CALL))
+			cleanup(rp);
+		*r = SUSPEND;
+		return(TRUE);
+	}
+  }
+
+  return(FALSE);
+}
+
 /*===========================================================================*
  *				wait_test				     *
  *===========================================================================*/
@@ -566,6 +595,8 @@ struct mproc *rmp;
   if (rmp->mp_flags & (TRACE_ZOMBIE | ZOMBIE))
 	panic("zombify: process was already a zombie");
 
+  proc_changed(rmp);
+
   /* See if we have to notify a tracer process first. */
   if (rmp->mp_tracer != NO_TRACER && rmp->mp_tracer != rmp->mp_parent) {
 #if USE_TRACE
@@ -651,6 +682,8 @@ register struct mproc *child;	/* tells which process is exiting */
   parent->mp_flags &= ~WAITING;		/* parent no longer waiting */
   child->mp_flags &= ~ZOMBIE;		/* child no longer a zombie */
   child->mp_flags |= TOLD_PARENT;	/* avoid informing parent twice */
+  proc_changed(parent);
+  proc_changed(child);
 }
 
 #if USE_TRACE
@@ -676,6 +709,8 @@ struct mproc *child;			/* tells which process is exiting */
   tracer->mp_flags &= ~WAITING;		/* tracer no longer waiting */
   child->mp_flags &= ~TRACE_ZOMBIE;	/* child no longer zombie to tracer */
   child->mp_flags |= ZOMBIE;		/* child is now zombie to parent */
+  proc_changed(tracer);
+  proc_changed(child);
 }
 
 /*===========================================================================*
@@ -707,6 +742,7 @@ struct mproc *child;			/* process being traced */
   if (child->mp_flags & TRACE_ZOMBIE) {
 	child->mp_flags &= ~TRACE_ZOMBIE;
 	child->mp_flags |= ZOMBIE;
+	proc_changed(child);
 
 	check_parent(child, TRUE /*try_cleanup*/);
   }
@@ -720,10 +756,13 @@ static void cleanup(rmp)
 register struct mproc *rmp;	/* tells which process is exiting */
 {
   /* Release the process table entry and reinitialize some field. */
+  unlink_proc(rmp);
   rmp->mp_pid = 0;
   rmp->mp_flags = 0;
+  proc_changed(rmp);
   rmp->mp_child_utime = 0;
   rmp->mp_child_stime = 0;
   procs_in_use--;
+  put_free_slot(rmp);
 }
 
@@ -167,7 +167,7 @@ int do_set()
 		break;
 	case SETSID:
 		if (rmp->mp_procgrp == rmp->mp_pid) return(EPERM);
-		rmp->mp_procgrp = rmp->mp_pid;
+		set_procgrp(rmp, rmp->mp_pid);
 
 		m.m_type = PM_SETSID;
 		m.PM_PROC = rmp->mp_endpoint;
@@ -178,6 +178,8 @@ int do_set()
 		return(EINVAL);
   }
 
+  proc_changed(rmp);
+
   /* Send the request to VFS */
   tell_vfs(rmp, &m);
 
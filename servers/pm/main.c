@@ -43,6 +43,13 @@ static void sendreply(void);
 static int get_nice_value(int queue);
 static void handle_vfs_reply(void);
 
+/* Slots that may have a reply pending, so that sendreply() need not look at
+ * every slot. Each slot is entered at most once.
+ */
+static int reply_slots[NR_PROCS];
+static char reply_queued[NR_PROCS];
+static int nr_reply_slots;
+
 #define click_to_round_k(n) \
 	((unsigned) ((((unsigned long) (n) << CLICK_SHIFT) + 512) / 1024))
 
@@ -270,6 +277,8 @@ static int sef_cb_init_fresh(int UNUSED(type), sef_init_info_t *UNUSED(info))
 		/* Get kernel endpoint identifier. */
 		rmp->mp_endpoint = ip->endpoint;
 
+		link_proc(rmp);
+
 		/* Tell VFS about this system process. */
 		mess.m_type = PM_INIT;
 		mess.PM_SLOT = ip->proc_nr;
@@ -280,6 +289,8 @@ static int sef_cb_init_fresh(int UNUSED(type), sef_init_info_t *UNUSED(info))
   	}
   }
 
+  init_free_slots();
+
   /* Tell VFS that no more system processes follow and synchronize. */
   mess.PR_ENDPT = NONE;
   if (sendrec(VFS_PROC_NR, &mess) != OK || mess.m_type != OK)
@@ -331,6 +342,10 @@ int result;			/* result of call (usually OK or error #) */
       panic("setreply arg out of range: %d", proc_nr);
 
   rmp->mp_reply.reply_res = result;
+  if (!reply_queued[proc_nr]) {
+      reply_queued[proc_nr] = TRUE;
+      reply_slots[nr_reply_slots++] = proc_nr;
+  }
   rmp->mp_flags |= REPLY;	/* reply pending */
 }
 
@@ -339,14 +354,16 @@ int result;			/* result of call (usually OK or error #) */
  *===========================================================================*/
 static void sendreply()
 {
-  int proc_nr;
+  int i;
   int s;
   struct mproc *rmp;
 
   /* Send out all pending reply messages, including the answer to
    * the call just made above.
    */
-  for (proc_nr=0, rmp=mproc; proc_nr < NR_PROCS; proc_nr++, rmp++) {
+  for (i = 0; i < nr_reply_slots; i++) {
+      reply_queued[reply_slots[i]] = FALSE;
+      rmp = &mproc[reply_slots[i]];
       /* In the meantime, the process may have been killed by a
        * signal (e.g. if a lethal pending signal was unblocked)
        * without the PM realizing it. If the slot is no longer in
@@ -359,9 +376,10 @@ static void sendreply()
               printf("PM can't reply to %d (%s): %d\n",
                   rmp->mp_endpoint, rmp->mp_name, s);
           }
-          rmp->mp_flags &= ~REPLY;
       }
+      rmp->mp_flags &= ~REPLY;
   }
+  nr_reply_slots = 0;
 }
 
 /*===========================================================================*
@@ -3,6 +3,7 @@
  * The entry points into this file are:
  *   do_reboot: kill all processes, then reboot system
  *   do_getsysinfo: request copy of PM data structure  (Jorrit N. Herder)
+ *   proc_changed: note a change to a process slot for SI_PROC_DELTA
  *   do_getprocnr: lookup process slot number  (Jorrit N. Herder)
  *   do_getepinfo: get the pid/uid/gid of a process given its endpoint
  *   do_getsetpriority: get/set process priority
@@ -21,6 +22,7 @@
 #include <minix/config.h>
 #include <minix/reboot.h>
 #include <minix/sysinfo.h>
+#include <stddef.h>
 #include <minix/type.h>
 #include <minix/vm.h>
 #include <string.h>
@@ -62,6 +64,11 @@ static char *uts_tbl[] = {
 unsigned long calls_stats[NCALLS];
 #endif
 
+/* The process table, handed out in deltas by SI_PROC_DELTA. */
+static struct sysinfo_delta mproc_delta = {
+  mproc, sizeof(struct mproc), NR_PROCS, offsetof(struct mproc, mp_gen), 0
+};
+
 /*===========================================================================*
  *				do_sysuname				     *
  *===========================================================================*/
@@ -150,6 +157,9 @@ int do_getsysinfo()
         src_addr = (vir_bytes) mproc;
         len = sizeof(struct mproc) * NR_PROCS;
         break;
+  case SI_PROC_DELTA:			/* copy changed process slots */
+	return sysinfo_delta_copy(&mproc_delta, who_e,
+		(vir_bytes) m_in.SI_WHERE, m_in.SI_SIZE, m_in.SI_GEN);
 #if ENABLE_SYSCALL_STATS
   case SI_CALL_STATS:
   	src_addr = (vir_bytes) calls_stats;
@@ -167,6 +177,18 @@ int do_getsysinfo()
   return sys_datacopy(SELF, src_addr, who_e, dst_addr, len);
 }
 
+/*===========================================================================*
+ *				proc_changed			       	     *
+ *===========================================================================*/
+void proc_changed(rmp)
+struct mproc *rmp;
+{
+/* A process slot changed in a way that procfs can see. Give it a new
+ * generation, so that it is part of the next SI_PROC_DELTA copy.
+ */
+  sysinfo_delta_touch(&mproc_delta, (int) (rmp - mproc));
+}
+
 /*===========================================================================*
  *				do_getprocnr			             *
  *===========================================================================*/
@@ -242,12 +264,10 @@ int do_getepinfo()
 
   ep = m_in.PM_ENDPT;
 
-  for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++) {
-	if ((rmp->mp_flags & IN_USE) && (rmp->mp_endpoint == ep)) {
-		mp->mp_reply.reply_res2 = rmp->mp_effuid;
-		mp->mp_reply.reply_res3 = rmp->mp_effgid;
-		return(rmp->mp_pid);
-	}
+  if ((rmp = find_proc_ep(ep)) != NULL) {
+	mp->mp_reply.reply_res2 = rmp->mp_effuid;
+	mp->mp_reply.reply_res3 = rmp->mp_effgid;
+	return(rmp->mp_pid);
   }
 
   /* Process not found */
@@ -272,12 +292,10 @@ int do_getepinfo_o()
 
   ep = m_in.PM_ENDPT;
 
-  for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++) {
-	if ((rmp->mp_flags & IN_USE) && (rmp->mp_endpoint == ep)) {
-		mp->mp_reply.reply_res2 = (short) rmp->mp_effuid;
-		mp->mp_reply.reply_res3 = (char) rmp->mp_effgid;
-		return(rmp->mp_pid);
-	}
+  if ((rmp = find_proc_ep(ep)) != NULL) {
+	mp->mp_reply.reply_res2 = (short) rmp->mp_effuid;
+	mp->mp_reply.reply_res3 = (char) rmp->mp_effgid;
+	return(rmp->mp_pid);
   }
 
   /* Process not found */
@@ -363,6 +381,7 @@ int do_getsetpriority()
 	}
 
 	rmp->mp_nice = arg_pri;
+	proc_changed(rmp);
 	return(OK);
 }
 
@@ -23,6 +23,14 @@ EXTERN struct mproc {
   int mp_parent;		/* index of parent process */
   int mp_tracer;		/* index of tracer process, or NO_TRACER */
 
+  /* Lookup structures, kept up to date by the routines in utility.c. */
+  struct mproc *mp_pidnext;	/* next in pid hash chain */
+  struct mproc *mp_grpnext;	/* next in process group hash chain */
+  struct mproc *mp_child;	/* first child of this process */
+  struct mproc *mp_sibling;	/* next child of the same parent */
+  struct mproc *mp_sibprev;	/* previous child of the same parent */
+  struct mproc *mp_freenext;	/* next free slot */
+
   /* Child user and system times. Accounting done on child exit. */
   clock_t mp_child_utime;	/* cumulative user time of children */
   clock_t mp_child_stime;	/* cumulative sys time of children */
@@ -69,6 +77,8 @@ EXTERN struct mproc {
 
   char mp_name[PROC_NAME_LEN];	/* process name */
 
+  int mp_gen;			/* generation of last change, for procfs */
+
   int mp_magic;			/* sanity check, MP_MAGIC */
 } mproc[NR_PROCS];
 
@@ -92,5 +102,6 @@ EXTERN struct mproc {
 #define TRACE_ZOMBIE	0x10000	/* waiting for tracer to issue WAIT call */
 #define DELAY_CALL	0x20000	/* waiting for call before sending signal */
 #define TAINTED		0x40000 /* process is 'tainted' */
+#define TRACER		0x80000	/* process has traced another process */
 
 #define MP_MAGIC	0xC0FFEE0
@@ -3,6 +3,7 @@
  * The entry points in this file are:
  *   do_sprofile:   start/stop statistical profiling
  *   do_cprofile:   get/reset call profiling tables
+ *   do_ipctrace:   start/stop/get system-wide IPC tracing
  *
  * Changes:
  *   14 Aug, 2006  Created (Rogier Meurs)
@@ -10,6 +11,7 @@
 
 #include <minix/config.h>
 #include <minix/profile.h>
+#include <minix/ipctrace.h>
 #include "pm.h"
 #include <sys/wait.h>
 #include <minix/callnr.h>
@@ -74,3 +76,28 @@ int do_cprofile(void)
 #endif
 }
 
+
+
+/*===========================================================================*
+ *				do_ipctrace				     *
+ *===========================================================================*/
+int do_ipctrace(void)
+{
+/* The trace shows all IPC in the system, so only the superuser may use it. */
+  if (mp->mp_effuid != SUPER_USER)
+	return EPERM;
+
+  switch(m_in.ITR_ACTION) {
+
+  case ITR_START:
+  case ITR_STOP:
+	return sys_ipctrace(m_in.ITR_ACTION, 0, NONE, NULL, NULL, 0);
+
+  case ITR_GET:
+	return sys_ipctrace(ITR_GET, m_in.ITR_CPU, who_e,
+		m_in.ITR_INFO_PTR, m_in.ITR_BUF_PTR, m_in.ITR_SIZE);
+
+  default:
+	return EINVAL;
+  }
+}
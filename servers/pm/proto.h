@@ -51,6 +51,7 @@ int do_setmcontext(void);
 int do_reboot(void);
 int do_sysuname(void);
 int do_getsysinfo(void);
+void proc_changed(struct mproc *rmp);
 int do_getprocnr(void);
 int do_getepinfo(void);
 int do_getepinfo_o(void);
@@ -64,6 +65,7 @@ int sched_nice(struct mproc *rmp, int nice);
 
 /* profile.c */
 int do_sprofile(void);
+int do_ipctrace(void);
 int do_cprofile(void);
 
 /* signal.c */
@@ -103,6 +105,16 @@ pid_t get_free_pid(void);
 int no_sys(void);
 char *find_param(const char *key);
 struct mproc *find_proc(pid_t lpid);
+struct mproc *find_proc_ep(endpoint_t ep);
+struct mproc *find_procgrp(pid_t procgrp);
+struct mproc *next_procgrp(struct mproc *rmp);
+void link_proc(struct mproc *rmp);
+void unlink_proc(struct mproc *rmp);
+void set_parent(struct mproc *rmp, int parent);
+void set_procgrp(struct mproc *rmp, pid_t procgrp);
+void init_free_slots(void);
+struct mproc *get_free_slot(void);
+void put_free_slot(struct mproc *rmp);
 int nice_to_priority(int nice, unsigned *new_q);
 int pm_isokendpt(int ep, int *proc);
 void tell_vfs(struct mproc *rmp, message *m_ptr);
@@ -158,6 +158,7 @@ int do_sigsuspend()
   sigdelset(&mp->mp_sigmask, SIGKILL);
   sigdelset(&mp->mp_sigmask, SIGSTOP);
   mp->mp_flags |= SIGSUSPENDED;
+  proc_changed(mp);
   check_pending(mp);
   return(SUSPEND);
 }
@@ -232,7 +233,7 @@ int process_ksig(endpoint_t proc_nr_e, int signo)
   }
   proc_id = rmp->mp_pid;
   mp = &mproc[0];			/* pretend signals are from PM */
-  mp->mp_procgrp = rmp->mp_procgrp;	/* get process group right */
+  set_procgrp(mp, rmp->mp_procgrp);	/* get process group right */
 
   /* For SIGVTALRM and SIGPROF, see if we need to restart a
    * virtual timer. For SIGINT, SIGWINCH and SIGQUIT, use proc_id 0
@@ -298,6 +299,7 @@ int do_pause()
 /* Perform the pause() system call. */
 
   mp->mp_flags |= PAUSED;
+  proc_changed(mp);
   return(SUSPEND);
 }
 
@@ -499,6 +501,8 @@ int ksig;			/* non-zero means signal comes from kernel  */
  */
 
   register struct mproc *rmp;
+  struct mproc *targets[NR_PROCS];
+  int i, n;
   int count;			/* count # of signals sent */
   int error_code;
 
@@ -511,21 +515,32 @@ int ksig;			/* non-zero means signal comes from kernel  */
   if (proc_id == -1 && signo == SIGTERM)
       sys_kill(RS_PROC_NR, signo);
 
-  /* Search the proc table for processes to signal. Start from the end of the
-   * table to analyze core system processes at the end when broadcasting.
+  /* Collect the processes to signal first, as signaling one may release the
+   * slots of others. A single process or a process group is looked up in
+   * the hashes. When broadcasting, search the proc table, starting from the
+   * end of the table to analyze core system processes at the end.
    * (See forkexit.c about pid magic.)
    */
+  n = 0;
+  if (proc_id > 0) {
+	if ((rmp = find_proc(proc_id)) != NULL)
+		targets[n++] = rmp;
+  } else if (proc_id == -1) {
+	for (rmp = &mproc[NR_PROCS-1]; rmp >= &mproc[0]; rmp--)
+		if ((rmp->mp_flags & IN_USE) && rmp->mp_pid > INIT_PID)
+			targets[n++] = rmp;
+  } else {
+	rmp = find_procgrp(proc_id == 0 ? mp->mp_procgrp : -proc_id);
+	for (; rmp != NULL; rmp = next_procgrp(rmp))
+		targets[n++] = rmp;
+  }
+
   count = 0;
   error_code = ESRCH;
-  for (rmp = &mproc[NR_PROCS-1]; rmp >= &mproc[0]; rmp--) {
+  for (i = 0; i < n; i++) {
+	rmp = targets[i];
 	if (!(rmp->mp_flags & IN_USE)) continue;
 
-	/* Check for selection. */
-	if (proc_id > 0 && proc_id != rmp->mp_pid) continue;
-	if (proc_id == 0 && mp->mp_procgrp != rmp->mp_procgrp) continue;
-	if (proc_id == -1 && rmp->mp_pid <= INIT_PID) continue;
-	if (proc_id < -1 && rmp->mp_procgrp != -proc_id) continue;
-
 	/* Do not kill servers and drivers when broadcasting SIGKILL. */
 	if (proc_id == -1 && signo == SIGKILL &&
 		(rmp->mp_flags & PRIV_PROC)) continue;
@@ -752,6 +767,7 @@ int signo;			/* signal to send to process (1 to _NSIG-1) */
   /* Was the process suspended in PM? Then interrupt the blocking call. */
   if (rmp->mp_flags & (PAUSED | WAITING | SIGSUSPENDED)) {
 	rmp->mp_flags &= ~(PAUSED | WAITING | SIGSUSPENDED);
+	proc_changed(rmp);
 
 	setreply(slot, EINTR);
   }
@@ -777,13 +793,23 @@ void vm_notify_sig_wrapper(endpoint_t ep)
  * instead of from DS server is that otherwise
  * it will cause deadlock between PM, VM and DS.
  */
+  static struct mproc *ipc_mp = NULL;
   struct mproc *rmp;
   endpoint_t ipc_ep = 0;
 
+  /* This runs on every exit, so remember where IPC was found. */
+  rmp = ipc_mp;
+  if (rmp != NULL && (rmp->mp_flags & IN_USE) &&
+	!strcmp(rmp->mp_name, "ipc")) {
+	vm_notify_sig(ep, rmp->mp_endpoint);
+	return;
+  }
+
   for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++) {
 	if (!(rmp->mp_flags & IN_USE))
 		continue;
 	if (!strcmp(rmp->mp_name, "ipc")) {
+		ipc_mp = rmp;
 		ipc_ep = rmp->mp_endpoint;
 		vm_notify_sig(ep, ipc_ep);
 
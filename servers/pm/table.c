@@ -80,8 +80,8 @@ int (*call_vec[])(void) = {
 	do_set, 	/* 66 = setgroups */
 	do_getmcontext,	/* 67 = getmcontext */
 	do_setmcontext,	/* 68 = setmcontext */
-	no_sys,		/* 69 = unused	*/
-	no_sys,		/* 70 = unused	*/
+	no_sys,		/* 69 = (kqueue) */
+	no_sys,		/* 70 = (kevent) */
 	do_sigaction,	/* 71 = sigaction   */
 	do_sigsuspend,	/* 72 = sigsuspend  */
 	do_sigpending,	/* 73 = sigpending  */
@@ -90,7 +90,7 @@ int (*call_vec[])(void) = {
 	do_reboot,	/* 76 = reboot	*/
 	do_svrctl,	/* 77 = svrctl	*/
 	do_sysuname,	/* 78 = sysuname */
-	no_sys,		/* 79 = unused */
+	no_sys,		/* 79 = (pread) */
 	no_sys,		/* 80 = (getdents) */
 	no_sys, 	/* 81 = unused */
 	no_sys, 	/* 82 = (fstatfs) */
@@ -108,19 +108,19 @@ int (*call_vec[])(void) = {
 	no_sys,		/* 94 = (ftruncate) */
 	no_sys,		/* 95 = (fchmod) */
 	no_sys,		/* 96 = (fchown) */
-	no_sys,		/* 97 = unused */
+	no_sys,		/* 97 = (pwrite) */
 	do_sprofile,	/* 98 = sprofile */
 	do_cprofile,	/* 99 = cprofile */
 	do_newexec,	/* 100 = newexec */
 	do_srv_fork,	/* 101 = srv_fork */
 	do_execrestart,	/* 102 = exec_restart */
-	no_sys,		/* 103 = unused */
+	do_ipctrace,	/* 103 = ipctrace */
 	do_getprocnr,	/* 104 = getprocnr */
 	no_sys,		/* 105 = unused */
 	do_get,		/* 106 = issetugid */
 	do_getepinfo_o,	/* 107 = getepinfo XXX: old implementation*/
-	no_sys,		/* 108 = unused */
-	no_sys,		/* 109 = unused */
+	no_sys,		/* 108 = (readv) */
+	no_sys,		/* 109 = (writev) */
 	no_sys,		/* 110 = unused */
 	do_srv_kill,	/* 111 = srv_kill */
  	no_sys, 	/* 112 = gcov_flush */
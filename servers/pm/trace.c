@@ -55,6 +55,7 @@ int do_trace()
 	if (mp->mp_tracer != NO_TRACER) return(EBUSY);
 
 	mp->mp_tracer = mp->mp_parent;
+	mproc[mp->mp_parent].mp_flags |= TRACER;
 	mp->mp_reply.reply_trace = 0;
 	return(OK);
 
@@ -85,6 +86,7 @@ int do_trace()
 
 	child->mp_tracer = who_p;
 	child->mp_trace_flags = TO_NOEXEC;
+	mp->mp_flags |= TRACER;
 
 	sig_proc(child, SIGSTOP, TRUE /*trace*/, FALSE /* ksig */);
 
@@ -225,6 +227,7 @@ int do_trace()
 	/* Resume the child as if nothing ever happened. */ 
 	child->mp_flags &= ~STOPPED;
 	child->mp_trace_flags = 0;
+	proc_changed(child);
 
 	check_pending(child);
 
@@ -251,6 +254,7 @@ int do_trace()
 	}
 
 	child->mp_flags &= ~STOPPED;
+	proc_changed(child);
 
 	check_pending(child);
 
@@ -279,10 +283,12 @@ int signo;
   if (r != OK) panic("sys_trace failed: %d", r);
  
   rmp->mp_flags |= STOPPED;
+  proc_changed(rmp);
   if (wait_test(rpmp, rmp)) {
 	sigdelset(&rmp->mp_sigtrace, signo);
 
 	rpmp->mp_flags &= ~WAITING;	/* parent is no longer waiting */
+	proc_changed(rpmp);
 	rpmp->mp_reply.reply_res2 = 0177 | (signo << 8);
 	setreply(rmp->mp_tracer, rmp->mp_pid);
   }
@@ -5,6 +5,16 @@
  *   no_sys:		called for invalid system call numbers
  *   find_param:	look up a boot monitor parameter
  *   find_proc:		return process pointer from pid number
+ *   find_proc_ep:	return process pointer from endpoint
+ *   find_procgrp:	return the first member of a process group
+ *   next_procgrp:	return the next member of a process group
+ *   link_proc:		enter a new process in the lookup structures
+ *   unlink_proc:	remove a process from the lookup structures
+ *   set_parent:	give a process another parent
+ *   set_procgrp:	move a process to another process group
+ *   init_free_slots:	build the list of free process slots
+ *   get_free_slot:	take a free process slot
+ *   put_free_slot:	give back a process slot
  *   nice_to_priority	convert nice level to priority queue
  *   pm_isokendpt:	check the validity of an endpoint
  *   tell_vfs:		send a request to VFS on behalf of a process
@@ -24,31 +34,38 @@
 #include <minix/config.h>
 #include <timers.h>
 #include <string.h>
+#include <assert.h>
 #include <machine/archtypes.h>
 #include "kernel/const.h"
 #include "kernel/config.h"
 #include "kernel/type.h"
 #include "kernel/proc.h"
 
+/* Processes in use are hashed on pid and on process group, and each process
+ * has a list of its children, so that fork, wait and kill do not have to
+ * scan the whole process table. Free slots are kept in a queue, so that a
+ * slot is reused as late as possible.
+ */
+#define PID_HASH(pid)	((unsigned) (pid) % PID_HASH_SIZE)
+
+static struct mproc *pid_hash[PID_HASH_SIZE];
+static struct mproc *grp_hash[PID_HASH_SIZE];
+static struct mproc *free_head, *free_tail;
+
+static void add_child(struct mproc *rmp);
+static void remove_child(struct mproc *rmp);
+
 /*===========================================================================*
  *				get_free_pid				     *
  *===========================================================================*/
 pid_t get_free_pid()
 {
   static pid_t next_pid = INIT_PID + 1;		/* next pid to be assigned */
-  register struct mproc *rmp;			/* check process table */
-  int t;					/* zero if pid still free */
 
-  /* Find a free pid for the child and put it in the table. */
+  /* Find a pid that is neither used by a process nor by a process group. */
   do {
-	t = 0;			
 	next_pid = (next_pid < NR_PIDS ? next_pid + 1 : INIT_PID + 1);
-	for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++)
-		if (rmp->mp_pid == next_pid || rmp->mp_procgrp == next_pid) {
-			t = 1;
-			break;
-		}
-  } while (t);					/* 't' = 0 means pid free */
+  } while (find_proc(next_pid) != NULL || find_procgrp(next_pid) != NULL);
   return(next_pid);
 }
 
@@ -90,13 +107,225 @@ pid_t lpid;
 {
   register struct mproc *rmp;
 
-  for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++)
-	if ((rmp->mp_flags & IN_USE) && rmp->mp_pid == lpid)
+  for (rmp = pid_hash[PID_HASH(lpid)]; rmp != NULL; rmp = rmp->mp_pidnext)
+	if (rmp->mp_pid == lpid)
+		return(rmp);
+
+  return(NULL);
+}
+
+/*===========================================================================*
+ *				find_proc_ep  				     *
+ *===========================================================================*/
+struct mproc *find_proc_ep(endpoint_t ep)
+{
+/* An endpoint holds the slot number of its process, so no search is needed.
+ * Only a process in use with exactly this endpoint matches.
+ */
+  int proc_nr;
+
+  if (pm_isokendpt(ep, &proc_nr) != OK || proc_nr < 0)
+	return(NULL);
+
+  return(&mproc[proc_nr]);
+}
+
+/*===========================================================================*
+ *				find_procgrp  				     *
+ *===========================================================================*/
+struct mproc *find_procgrp(pid_t procgrp)
+{
+  register struct mproc *rmp;
+
+  for (rmp = grp_hash[PID_HASH(procgrp)]; rmp != NULL; rmp = rmp->mp_grpnext)
+	if (rmp->mp_procgrp == procgrp)
+		return(rmp);
+
+  return(NULL);
+}
+
+/*===========================================================================*
+ *				next_procgrp  				     *
+ *===========================================================================*/
+struct mproc *next_procgrp(struct mproc *rmp)
+{
+/* Return the next process in the same process group as 'rmp', or NULL. */
+  pid_t procgrp;
+
+  procgrp = rmp->mp_procgrp;
+  for (rmp = rmp->mp_grpnext; rmp != NULL; rmp = rmp->mp_grpnext)
+	if (rmp->mp_procgrp == procgrp)
 		return(rmp);
 
   return(NULL);
 }
 
+/*===========================================================================*
+ *				link_proc  				     *
+ *===========================================================================*/
+void link_proc(struct mproc *rmp)
+{
+/* A process has been given its pid, process group and parent. Enter it in the
+ * hashes and in the child list of its parent. Its own child list must have
+ * been set up by the caller.
+ */
+  unsigned h;
+
+  h = PID_HASH(rmp->mp_pid);
+  rmp->mp_pidnext = pid_hash[h];
+  pid_hash[h] = rmp;
+
+  h = PID_HASH(rmp->mp_procgrp);
+  rmp->mp_grpnext = grp_hash[h];
+  grp_hash[h] = rmp;
+
+  add_child(rmp);
+}
+
+/*===========================================================================*
+ *				unlink_proc  				     *
+ *===========================================================================*/
+void unlink_proc(struct mproc *rmp)
+{
+/* The process table entry of a process is about to be released. A process
+ * that had children has given them away to INIT on exit, so only the links
+ * to this process have to be removed.
+ */
+  struct mproc **rmpp;
+
+  assert(rmp->mp_child == NULL);
+
+  for (rmpp = &pid_hash[PID_HASH(rmp->mp_pid)]; *rmpp != rmp;
+	rmpp = &(*rmpp)->mp_pidnext)
+	assert(*rmpp != NULL);
+  *rmpp = rmp->mp_pidnext;
+
+  for (rmpp = &grp_hash[PID_HASH(rmp->mp_procgrp)]; *rmpp != rmp;
+	rmpp = &(*rmpp)->mp_grpnext)
+	assert(*rmpp != NULL);
+  *rmpp = rmp->mp_grpnext;
+
+  remove_child(rmp);
+}
+
+/*===========================================================================*
+ *				set_parent  				     *
+ *===========================================================================*/
+void set_parent(struct mproc *rmp, int parent)
+{
+  remove_child(rmp);
+  rmp->mp_parent = parent;
+  add_child(rmp);
+  proc_changed(rmp);
+}
+
+/*===========================================================================*
+ *				set_procgrp  				     *
+ *===========================================================================*/
+void set_procgrp(struct mproc *rmp, pid_t procgrp)
+{
+  struct mproc **rmpp;
+  unsigned h;
+
+  for (rmpp = &grp_hash[PID_HASH(rmp->mp_procgrp)]; *rmpp != rmp;
+	rmpp = &(*rmpp)->mp_grpnext)
+	assert(*rmpp != NULL);
+  *rmpp = rmp->mp_grpnext;
+
+  rmp->mp_procgrp = procgrp;
+
+  h = PID_HASH(procgrp);
+  rmp->mp_grpnext = grp_hash[h];
+  grp_hash[h] = rmp;
+  proc_changed(rmp);
+}
+
+/*===========================================================================*
+ *				add_child  				     *
+ *===========================================================================*/
+static void add_child(struct mproc *rmp)
+{
+  struct mproc *parent;
+
+  /* INIT is its own parent, but not its own child. */
+  parent = &mproc[rmp->mp_parent];
+  rmp->mp_sibprev = NULL;
+  if (parent == rmp) {
+	rmp->mp_sibling = NULL;
+	return;
+  }
+
+  rmp->mp_sibling = parent->mp_child;
+  if (parent->mp_child != NULL)
+	parent->mp_child->mp_sibprev = rmp;
+  parent->mp_child = rmp;
+}
+
+/*===========================================================================*
+ *				remove_child  				     *
+ *===========================================================================*/
+static void remove_child(struct mproc *rmp)
+{
+  struct mproc *parent;
+
+  parent = &mproc[rmp->mp_parent];
+  if (parent == rmp)
+	return;
+
+  if (rmp->mp_sibprev != NULL)
+	rmp->mp_sibprev->mp_sibling = rmp->mp_sibling;
+  else
+	parent->mp_child = rmp->mp_sibling;
+  if (rmp->mp_sibling != NULL)
+	rmp->mp_sibling->mp_sibprev = rmp->mp_sibprev;
+  rmp->mp_sibling = rmp->mp_sibprev = NULL;
+}
+
+/*===========================================================================*
+ *				init_free_slots				     *
+ *===========================================================================*/
+void init_free_slots(void)
+{
+/* Queue all slots not taken by boot image processes. */
+  struct mproc *rmp;
+
+  free_head = free_tail = NULL;
+  for (rmp = &mproc[0]; rmp < &mproc[NR_PROCS]; rmp++)
+	if (!(rmp->mp_flags & IN_USE))
+		put_free_slot(rmp);
+}
+
+/*===========================================================================*
+ *				get_free_slot				     *
+ *===========================================================================*/
+struct mproc *get_free_slot(void)
+{
+  struct mproc *rmp;
+
+  if ((rmp = free_head) == NULL)
+	return(NULL);
+
+  free_head = rmp->mp_freenext;
+  if (free_head == NULL)
+	free_tail = NULL;
+
+  assert(!(rmp->mp_flags & IN_USE));
+  return(rmp);
+}
+
+/*===========================================================================*
+ *				put_free_slot				     *
+ *===========================================================================*/
+void put_free_slot(struct mproc *rmp)
+{
+  rmp->mp_freenext = NULL;
+  if (free_tail != NULL)
+	free_tail->mp_freenext = rmp;
+  else
+	free_head = rmp;
+  free_tail = rmp;
+}
+
 /*===========================================================================*
  *				nice_to_priority			     *
  *===========================================================================*/
@@ -13,5 +13,6 @@ extern struct file root_files[];
 extern struct proc proc[NR_PROCS + NR_TASKS];	/* process table from kernel */
 extern struct mproc mproc[NR_PROCS];		/* process table from PM */
 extern struct fproc fproc[NR_PROCS];		/* process table from VFS */
+extern struct priv priv[NR_SYS_PROCS];		/* privilege table from kernel */
 
 #endif /* _PROCFS_GLO_H */
@@ -4,6 +4,7 @@
 
 #include <sys/mman.h>
 #include <minix/vm.h>
+#include <minix/priv.h>
 
 #define S_FRAME_SIZE	4096		/* use malloc if larger than this */
 static char s_frame[S_FRAME_SIZE];	/* static storage for process frame */
@@ -13,6 +14,7 @@ static void pid_psinfo(int slot);
 static void pid_cmdline(int slot);
 static void pid_environ(int slot);
 static void pid_map(int slot);
+static void pid_ipcstat(int slot);
 
 /* The files that are dynamically created in each PID directory. The data field
  * contains each file's read function. Subdirectories are not yet supported.
@@ -22,6 +24,7 @@ struct file pid_files[] = {
 	{ "cmdline",	REG_ALL_MODE,	(data_t) pid_cmdline	},
 	{ "environ",	REG_ALL_MODE,	(data_t) pid_environ	},
 	{ "map",	REG_ALL_MODE,	(data_t) pid_map	},
+	{ "ipcstat",	REG_ALL_MODE,	(data_t) pid_ipcstat	},
 	{ NULL,		0,		(data_t) NULL		}
 };
 
@@ -381,3 +384,47 @@ static void pid_map(int slot)
 			return;
 	}
 }
+
+/*===========================================================================*
+ *				pid_ipcstat				     *
+ *===========================================================================*/
+static void pid_ipcstat(int slot)
+{
+	/* Print the IPC statistics of the process, one "name value" pair per
+	 * line. Blocked times are in cpu cycles. System processes also get a
+	 * "kcall <call> <count>" line for each kernel call they have made.
+	 */
+	struct proc *rp;
+	int i, c;
+
+	/* Zombies no longer have a kernel slot. */
+	if (is_zombie(slot))
+		return;
+
+	rp = &proc[slot];
+
+	buf_printf("sent %lu\n", rp->p_ipcstat.sent);
+	buf_printf("received %lu\n", rp->p_ipcstat.received);
+	buf_printf("notified %lu\n", rp->p_ipcstat.notified);
+	buf_printf("kcalls %lu\n", rp->p_ipcstat.kcalls);
+	buf_printf("pagefaults %lu\n", rp->p_ipcstat.pagefaults);
+	buf_printf("send_cycles %llu\n",
+		(unsigned long long) rp->p_ipcstat.send_cycles);
+	buf_printf("receive_cycles %llu\n",
+		(unsigned long long) rp->p_ipcstat.receive_cycles);
+
+	if (rp->p_ipcstat.kcalls == 0 || update_priv_table() != OK)
+		return;
+
+	for (i = 0; i < NR_SYS_PROCS; i++) {
+		if (priv[i].s_proc_nr != rp->p_nr ||
+		    priv[i].s_id == USER_PRIV_ID)
+			continue;
+
+		for (c = 0; c < NR_SYS_CALLS; c++)
+			if (priv[i].s_kcalls[c] != 0)
+				buf_printf("kcall %d %lu\n", c,
+					priv[i].s_kcalls[c]);
+		break;
+	}
+}
@@ -15,6 +15,7 @@ int read_hook(struct inode *inode, off_t offset, char **ptr, size_t
 	*len, cbdata_t cbdata);
 int rdlink_hook(struct inode *inode, char *ptr, size_t max, cbdata_t
 	cbdata);
+int update_priv_table(void);
 
 /* util.c */
 int procfs_getloadavg(struct load *loadavg, int nelem);
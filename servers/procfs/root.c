@@ -19,6 +19,7 @@ static void root_pci(void);
 #endif
 static void root_dmap(void);
 static void root_ipcvecs(void);
+static void root_ipcstat(void);
 
 struct file root_files[] = {
 	{ "hz",		REG_ALL_MODE,	(data_t) root_hz	},
@@ -34,6 +35,7 @@ struct file root_files[] = {
 	{ "cpuinfo",	REG_ALL_MODE,	(data_t) root_cpuinfo	},
 #endif
 	{ "ipcvecs",	REG_ALL_MODE,	(data_t) root_ipcvecs	},
+	{ "ipcstat",	REG_ALL_MODE,	(data_t) root_ipcstat	},
 	{ "mounts",	REG_ALL_MODE,	(data_t) root_mounts	},
 	{ NULL,		0,		NULL			}
 };
@@ -209,3 +211,78 @@ static void root_ipcvecs(void)
 	PRINT_ENTRYPOINT(do_kernel_call);
 }
 
+
+/*===========================================================================*
+ *				root_ipcstat				     *
+ *===========================================================================*/
+static void root_ipcstat(void)
+{
+	/* Print system-wide IPC statistics. The first lines hold the totals
+	 * over all current processes, in the format of /proc/<pid>/ipcstat.
+	 * Then follows one "proc" line per process, with its endpoint, name,
+	 * and the same counters in the same order, so that the busiest servers
+	 * can be found in a single read. Processes that have exited are no
+	 * longer counted.
+	 */
+	unsigned long sent, received, notified, kcalls, pagefaults;
+	unsigned long kcall[NR_SYS_CALLS];
+	u64_t send_cycles, receive_cycles;
+	struct proc *rp;
+	int i, c;
+
+	sent = received = notified = kcalls = pagefaults = 0;
+	send_cycles = receive_cycles = 0;
+
+	for (i = 0; i < NR_TASKS + NR_PROCS; i++) {
+		rp = &proc[i];
+		if (isemptyp(rp))
+			continue;
+
+		sent += rp->p_ipcstat.sent;
+		received += rp->p_ipcstat.received;
+		notified += rp->p_ipcstat.notified;
+		kcalls += rp->p_ipcstat.kcalls;
+		pagefaults += rp->p_ipcstat.pagefaults;
+		send_cycles += rp->p_ipcstat.send_cycles;
+		receive_cycles += rp->p_ipcstat.receive_cycles;
+	}
+
+	buf_printf("sent %lu\n", sent);
+	buf_printf("received %lu\n", received);
+	buf_printf("notified %lu\n", notified);
+	buf_printf("kcalls %lu\n", kcalls);
+	buf_printf("pagefaults %lu\n", pagefaults);
+	buf_printf("send_cycles %llu\n", (unsigned long long) send_cycles);
+	buf_printf("receive_cycles %llu\n",
+		(unsigned long long) receive_cycles);
+
+	/* Kernel calls per call, over all system processes. */
+	if (update_priv_table() == OK) {
+		memset(kcall, 0, sizeof(kcall));
+
+		for (i = 0; i < NR_SYS_PROCS; i++) {
+			if (priv[i].s_proc_nr == NONE)
+				continue;
+
+			for (c = 0; c < NR_SYS_CALLS; c++)
+				kcall[c] += priv[i].s_kcalls[c];
+		}
+
+		for (c = 0; c < NR_SYS_CALLS; c++)
+			if (kcall[c] != 0)
+				buf_printf("kcall %d %lu\n", c, kcall[c]);
+	}
+
+	for (i = 0; i < NR_TASKS + NR_PROCS; i++) {
+		rp = &proc[i];
+		if (isemptyp(rp))
+			continue;
+
+		buf_printf("proc %d %s %lu %lu %lu %lu %lu %llu %llu\n",
+			rp->p_endpoint, rp->p_name, rp->p_ipcstat.sent,
+			rp->p_ipcstat.received, rp->p_ipcstat.notified,
+			rp->p_ipcstat.kcalls, rp->p_ipcstat.pagefaults,
+			(unsigned long long) rp->p_ipcstat.send_cycles,
+			(unsigned long long) rp->p_ipcstat.receive_cycles);
+	}
+}
@@ -5,9 +5,13 @@
 struct proc proc[NR_PROCS + NR_TASKS];
 struct mproc mproc[NR_PROCS];
 struct fproc fproc[NR_PROCS];
+struct priv priv[NR_SYS_PROCS];
 
 static int nr_pid_entries;
 
+/* Generations of our copies of the PM and VFS process tables. */
+static int mproc_gen, fproc_gen;
+
 /*===========================================================================*
  *				slot_in_use				     *
  *===========================================================================*/
@@ -109,17 +113,31 @@ static int update_proc_table(void)
 	return OK;
 }
 
+/*===========================================================================*
+ *				update_priv_table			     *
+ *===========================================================================*/
+int update_priv_table(void)
+{
+	/* Get the privilege table from the kernel. Unlike the process tables,
+	 * this table is not kept up to date on every lookup, as only the files
+	 * with kernel call statistics need it.
+	 */
+
+	return sys_getprivtab(priv);
+}
+
 /*===========================================================================*
  *				update_mproc_table			     *
  *===========================================================================*/
 static int update_mproc_table(void)
 {
-	/* Get the process table from PM.
+	/* Get the process table entries that changed from PM.
 	 * Check the magic number in the table entries.
 	 */
 	int r, slot;
 
-	r = getsysinfo(PM_PROC_NR, SI_PROC_TAB, mproc, sizeof(mproc));
+	r = getsysinfo_delta(PM_PROC_NR, SI_PROC_DELTA, mproc, sizeof(mproc),
+		&mproc_gen);
 	if (r != OK) return r;
 
 	for (slot = 0; slot < NR_PROCS; slot++) {
@@ -138,10 +156,11 @@ static int update_mproc_table(void)
  *===========================================================================*/
 static int update_fproc_table(void)
 {
-	/* Get the process table from VFS.
+	/* Get the process table entries that changed from VFS.
 	 */
 
-	return getsysinfo(VFS_PROC_NR, SI_PROC_TAB, fproc, sizeof(fproc));
+	return getsysinfo_delta(VFS_PROC_NR, SI_PROC_DELTA, fproc,
+		sizeof(fproc), &fproc_gen);
 }
 
 /*===========================================================================*
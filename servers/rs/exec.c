@@ -135,6 +135,7 @@ static int do_exec(int proc_e, char *exec, size_t exec_len, char *progname,
 	execi.clearmem = libexec_clear_sys_memset;
 	execi.allocmem_prealloc = libexec_alloc_mmap_prealloc;
 	execi.allocmem_ondemand = libexec_alloc_mmap_ondemand;
+	execi.allocmem_zeroed = libexec_alloc_mmap_ondemand;
 
 	for(i = 0; exec_loaders[i].load_object != NULL; i++) {
 	    r = (*exec_loaders[i].load_object)(&execi);
@@ -7,6 +7,9 @@
 #define NR_MNTS           16 	/* # slots in mount table */
 #define NR_VNODES        512	/* # slots in vnode table */
 #define NR_WTHREADS	   8	/* # slots in worker thread table */
+#define NR_EXECS  NR_WTHREADS	/* # execs that can be in progress at once */
+
+#define PIPE_SIZE	(64 * 1024)	/* default capacity of a pipe */
 
 #define NR_NONEDEVS	NR_MNTS	/* # slots in nonedev bitmap */
 
@@ -558,6 +558,7 @@ int gen_opcl(
 
   if (op == DEV_OPEN && dp->dmap_style == STYLE_DEVA) {
 	fp->fp_task = dp->dmap_driver;
+	proc_changed(fp);
 	worker_wait();
   }
 
@@ -602,6 +603,7 @@ int tty_opcl(
   /* Did this call make the tty the controlling tty? */
   if (r == 1) {
 	fp->fp_tty = dev;
+	proc_changed(fp);
 	r = OK;
   }
 
@@ -646,6 +648,7 @@ void pm_setsid(endpoint_t proc_e)
   rfp = &fproc[slot];
   rfp->fp_flags |= FP_SESLDR;
   rfp->fp_tty = 0;
+  proc_changed(rfp);
 }
 
 
@@ -892,6 +895,7 @@ int clone_opcl(
   if (op == DEV_OPEN && dev_style_asyn(dp->dmap_style)) {
 	/* Wait for reply when driver is asynchronous */
 	fp->fp_task = dp->dmap_driver;
+	proc_changed(fp);
 	worker_wait();
   }
 
@@ -1154,6 +1158,7 @@ int maj;
 	   rfp->fp_task == driver_e && (rfp->fp_flags & FP_SUSP_REOPEN)) {
 		rfp->fp_flags &= ~FP_SUSP_REOPEN;
 		rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+		proc_changed(rfp);
 		reply(rfp->fp_endpoint, ERESTART);
 	}
   }
@@ -1172,6 +1177,7 @@ int maj;
 	if (!rfilp) {
 		/* Open failed, and automatic reopen was not requested */
 		rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+		proc_changed(rfp);
 		FD_CLR(fd_nr, &rfp->fp_filp_inuse);
 		reply(rfp->fp_endpoint, EIO);
 		continue;
@@ -1183,6 +1189,7 @@ int maj;
 	if (major(vp->v_sdev) != maj) continue;
 
 	rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+	proc_changed(rfp);
 	reply(rfp->fp_endpoint, fd_nr);
   }
 }
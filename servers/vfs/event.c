@@ -0,0 +1,853 @@
+/* This file implements kqueue(2) style event notification. A kqueue is a file
+ * descriptor holding a set of knotes, each of which watches one file
+ * descriptor for reading or writing. Readiness is found out using the same
+ * select machinery that select() uses: a knote keeps a blocking select request
+ * outstanding on its filp, and the select callbacks tell us when the filp
+ * becomes ready. Ready knotes are queued on their kqueue, so that kevent() only
+ * has to look at the knotes that fired, rather than at all the file
+ * descriptors of interest.
+ *
+ * The entry points into this file are
+ *   do_kqueue:		perform the KQUEUE system call
+ *   do_kevent:		perform the KEVENT system call
+ *   kqueue_filp_status: a filp reported ready operations (from select.c)
+ *   kqueue_dev_status:	a device reported ready operations (from select.c)
+ *   kqueue_restart_filps: resend deferred device select requests
+ *   kqueue_close_filp:	forget about a filp that is being closed for good
+ *   kqueue_forget:	a process blocked in kevent() got interrupted
+ *   kqueue_unsuspend_by_endpt: report EOF on devices of an exiting driver
+ *   init_kqueue:	initialize the kqueue tables
+ */
+
+#include "fs.h"
+#include <sys/event.h>
+#include <sys/queue.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <minix/com.h>
+#include <minix/vfsif.h>
+#include <assert.h>
+#include <fcntl.h>
+
+#include "file.h"
+#include "fproc.h"
+#include "dmap.h"
+#include "vnode.h"
+#include "vmnt.h"
+
+#define NR_KQUEUES	64	/* max. number of kqueues in the system */
+#define NR_KNOTES	2048	/* max. number of knotes in the system */
+#define KN_DEV_HASH	64	/* number of device hash chains; power of 2 */
+#define KEV_BATCH	16	/* number of kevents copied in one go */
+
+#define kn_dev_hash(dev)	(&knote_dev[(dev) & (KN_DEV_HASH - 1)])
+
+struct kqueue;
+
+static struct knote {
+  struct kqueue *kn_kq;		/* owning kqueue; NULL if knote is free */
+  struct filp *kn_filp;		/* filp being watched */
+  int kn_fd;			/* file descriptor as given by the user */
+  int kn_type;			/* select type of the filp */
+  dev_t kn_dev;			/* device of the filp, or NO_DEV */
+  uint32_t kn_filter;		/* EVFILT_READ or EVFILT_WRITE */
+  int kn_ops;			/* SEL_RD or SEL_WR, following the filter */
+  int kn_flags;			/* EV_ONESHOT, EV_CLEAR and EV_DISPATCH */
+  int kn_status;		/* KN_* status bits */
+  intptr_t kn_udata;		/* opaque user data */
+  LIST_ENTRY(knote) kn_klink;	/* knotes of the same kqueue */
+  LIST_ENTRY(knote) kn_flink;	/* knotes on the same filp */
+  LIST_ENTRY(knote) kn_dlink;	/* knotes on the same device, or free list */
+  TAILQ_ENTRY(knote) kn_tqe;	/* pending knotes of the kqueue */
+} knotes[NR_KNOTES];
+
+#define KN_ACTIVE	0x01	/* on the pending queue of the kqueue */
+#define KN_DISABLED	0x02	/* event is not to be reported */
+#define KN_RECHECK	0x04	/* reported before; poll again before reporting */
+#define KN_DEFERRED	0x08	/* select request must be sent again */
+#define KN_EOF		0x10	/* an error or end-of-file was reported */
+#define KN_NOTE		0x20	/* device state update pending */
+#define KN_MARKER	0x40	/* not a real knote but a scan marker */
+
+LIST_HEAD(knlist, knote);
+TAILQ_HEAD(kntailq, knote);
+
+static struct kqueue {
+  struct filp *kq_filp;		/* filp of the kqueue; slot is free if NULL */
+  struct knlist kq_knotes;	/* all knotes registered with this kqueue */
+  struct kntailq kq_pending;	/* knotes with events to report */
+  int kq_busy;			/* a scan is in progress */
+  int kq_wakeup;		/* knotes were queued since the last wakeup */
+  endpoint_t kq_waiter;		/* process blocked in kevent(), or NONE */
+  vir_bytes kq_eventlist;	/* event list of the blocked process */
+  int kq_nevents;		/* size of that event list */
+  clock_t kq_expiry;		/* a timer is set if nonzero */
+  timer_t kq_timer;
+} kqtab[NR_KQUEUES];
+
+static struct knlist knote_free;	/* unused knotes */
+static struct knlist filp_knotes[NR_FILPS];	/* knotes per filp */
+static struct knlist knote_dev[KN_DEV_HASH];	/* knotes per device */
+static int nr_deferred;			/* number of KN_DEFERRED knotes */
+
+static int kqueue_kevent(struct kqueue *kq);
+static void kqueue_free(struct kqueue *kq);
+static int kqueue_register(struct kqueue *kq, struct kevent *kev);
+static void kqueue_run_wakeups(void);
+static int kqueue_scan(struct kqueue *kq, endpoint_t endpt, vir_bytes
+	eventlist, int nevents);
+static void kqueue_timeout_check(timer_t *timer);
+static void kqueue_wakeup(struct kqueue *kq);
+static void knote_activate(struct knote *kn, int ops);
+static void knote_arm(struct knote *kn);
+static void knote_detach(struct knote *kn);
+static void knote_drop(struct knote *kn);
+static int knote_request(struct knote *kn);
+
+/*===========================================================================*
+ *				do_kqueue				     *
+ *===========================================================================*/
+int do_kqueue(void)
+{
+/* Perform the kqueue() system call. The new kqueue gets a file descriptor
+ * backed by an unnamed PFS node, so that it can be passed around and closed
+ * like any other file descriptor. The node has no file type, so that fstat()
+ * does not take it for a pipe, and it is never read from or written to.
+ */
+  int r, fd;
+  struct kqueue *kq;
+  struct filp *f;
+  struct vnode *vp;
+  struct vmnt *vmp;
+  struct node_details res;
+
+  for (kq = &kqtab[0]; kq < &kqtab[NR_KQUEUES]; kq++)
+	if (kq->kq_filp == NULL) break;
+  if (kq >= &kqtab[NR_KQUEUES]) return(ENFILE);
+
+  /* Get a lock on PFS */
+  if ((vmp = find_vmnt(PFS_PROC_NR)) == NULL) panic("PFS gone");
+  if ((r = lock_vmnt(vmp, VMNT_READ)) != OK) return(r);
+
+  /* See if a free vnode is available */
+  if ((vp = get_free_vnode()) == NULL) {
+	unlock_vmnt(vmp);
+	return(err_code);
+  }
+  lock_vnode(vp, VNODE_OPCL);
+
+  if ((r = get_fd(0, R_BIT, &fd, &f)) != OK) {
+	unlock_vnode(vp);
+	unlock_vmnt(vmp);
+	return(r);
+  }
+
+  r = req_newnode(PFS_PROC_NR, fp->fp_effuid, fp->fp_effgid,
+		  S_IRUSR | S_IWUSR, NO_DEV, &res);
+  if (r != OK) {
+	unlock_filp(f);
+	unlock_vnode(vp);
+	unlock_vmnt(vmp);
+	return(r);
+  }
+
+  /* Fill in vnode */
+  vp->v_fs_e = res.fs_e;
+  vp->v_mapfs_e = res.fs_e;
+  vp->v_inode_nr = res.inode_nr;
+  vp->v_mapinode_nr = res.inode_nr;
+  vp->v_mode = res.fmode;
+  vp->v_fs_count = 1;
+  vp->v_mapfs_count = 1;
+  vp->v_ref_count = 1;
+  vp->v_size = 0;
+  vp->v_vmnt = NULL;
+  vp->v_dev = NO_DEV;
+
+  /* Fill in filp object and file descriptor */
+  fp->fp_filp[fd] = f;
+  FD_SET(fd, &fp->fp_filp_inuse);
+  f->filp_count = 1;
+  f->filp_vno = vp;
+  f->filp_flags = O_RDONLY;
+  f->filp_kqueue = kq;
+
+  LIST_INIT(&kq->kq_knotes);
+  TAILQ_INIT(&kq->kq_pending);
+  kq->kq_filp = f;
+  kq->kq_busy = FALSE;
+  kq->kq_wakeup = FALSE;
+  kq->kq_waiter = NONE;
+  kq->kq_expiry = 0;
+
+  unlock_filp(f);
+  unlock_vmnt(vmp);
+
+  return(fd);
+}
+
+/*===========================================================================*
+ *				do_kevent				     *
+ *===========================================================================*/
+int do_kevent(void)
+{
+/* Perform the kevent(kq, changelist, nchanges, eventlist, nevents, timeout)
+ * system call. Applying changes and collecting events may block on locks and
+ * drivers, during which another thread may close the kqueue, so we hold a
+ * reference to its filp throughout. If ours turns out to be the last one,
+ * dropping it frees the kqueue, and wakes us up with EBADF if we blocked.
+ */
+  int r;
+  struct kqueue *kq;
+  struct filp *f;
+
+  if ((f = get_filp(job_m_in.KEV_FD, VNODE_READ)) == NULL) return(err_code);
+  if ((kq = f->filp_kqueue) == NULL) {
+	unlock_filp(f);
+	return(EBADF);
+  }
+  f->filp_count++;
+  unlock_filp(f);
+
+  r = kqueue_kevent(kq);
+
+  put_filp(f);
+
+  return(r);
+}
+
+/*===========================================================================*
+ *				kqueue_kevent				     *
+ *===========================================================================*/
+static int kqueue_kevent(struct kqueue *kq)
+{
+/* Do the work of kevent(). First the changes are applied, in order. A change
+ * that fails is reported as an EV_ERROR event if there is room in the event
+ * list, and makes the call fail otherwise. Then the pending events are
+ * collected. If there are none, we block until there are, or until the
+ * timeout expires.
+ */
+  int r, i, j, n, nchanges, nevents, nerrors, ticks;
+  struct kevent kev[KEV_BATCH];
+  struct timespec timeout;
+  vir_bytes changelist, eventlist, vtimeout;
+
+  nchanges = job_m_in.KEV_NCHANGES;
+  nevents = job_m_in.KEV_NEVENTS;
+  changelist = (vir_bytes) job_m_in.KEV_CHANGELIST;
+  eventlist = (vir_bytes) job_m_in.KEV_EVENTLIST;
+  vtimeout = (vir_bytes) job_m_in.KEV_TIMEOUT;
+
+  if (nchanges < 0 || nevents < 0) return(EINVAL);
+
+  /* Did the process set a timeout value? If so, retrieve it. */
+  if (vtimeout != 0) {
+	r = sys_datacopy(who_e, vtimeout, SELF, (vir_bytes) &timeout,
+		sizeof(timeout));
+	if (r != OK) return(r);
+
+	if (timeout.tv_sec < 0 || timeout.tv_nsec < 0 ||
+	    timeout.tv_nsec >= 1000000000L)
+		return(EINVAL);
+  }
+
+  /* Apply the changes */
+  nerrors = 0;
+  for (i = 0; i < nchanges; i += n) {
+	n = nchanges - i;
+	if (n > KEV_BATCH) n = KEV_BATCH;
+
+	r = sys_datacopy(who_e, changelist + i * sizeof(kev[0]), SELF,
+		(vir_bytes) kev, n * sizeof(kev[0]));
+	if (r != OK) return(r);
+
+	for (j = 0; j < n; j++) {
+		if ((r = kqueue_register(kq, &kev[j])) == OK) continue;
+
+		if (nerrors >= nevents) return(r);
+
+		kev[j].flags = EV_ERROR;
+		kev[j].data = -r;	/* error codes are negative here */
+		r = sys_datacopy(SELF, (vir_bytes) &kev[j], who_e,
+			eventlist + nerrors * sizeof(kev[0]), sizeof(kev[0]));
+		if (r != OK) return(r);
+		nerrors++;
+	}
+  }
+
+  if (nerrors > 0) return(nerrors);
+  if (nevents == 0) return(0);
+
+  /* Collect the pending events. Knotes that got queued while the scan was
+   * blocked on a lock or device end up behind the scan marker, so retry if
+   * any are left over. If another worker thread is scanning the kqueue, it
+   * has to finish first; it wakes us up if it leaves anything behind. */
+  r = 0;
+  while (!kq->kq_busy) {
+	r = kqueue_scan(kq, who_e, eventlist, nevents);
+	if (r != 0 || TAILQ_EMPTY(&kq->kq_pending)) break;
+  }
+
+  /* Our scan may have been keeping another waiter from its events */
+  kqueue_run_wakeups();
+
+  if (r != 0) return(r);
+
+  /* A zero timeout effects a poll */
+  if (vtimeout != 0 && timeout.tv_sec == 0 && timeout.tv_nsec == 0)
+	return(0);
+
+  /* Only one process at a time can wait for events on a kqueue */
+  if (kq->kq_waiter != NONE) return(EBUSY);
+
+  kq->kq_waiter = who_e;
+  kq->kq_eventlist = eventlist;
+  kq->kq_nevents = nevents;
+
+  if (vtimeout != 0) {
+	/* Round the timeout up to the next clock tick */
+	ticks = timeout.tv_sec * system_hz +
+		((timeout.tv_nsec + 999) / 1000 * system_hz + 999999) / 1000000;
+	kq->kq_expiry = ticks;
+	set_timer(&kq->kq_timer, ticks, kqueue_timeout_check, kq - kqtab);
+  }
+
+  /* process now blocked */
+  suspend(FP_BLOCKED_ON_SELECT);
+  return(SUSPEND);
+}
+
+/*===========================================================================*
+ *				kqueue_register				     *
+ *===========================================================================*/
+static int kqueue_register(struct kqueue *kq, struct kevent *kev)
+{
+/* Apply one change to a kqueue */
+  int fd, ops, type;
+  struct filp *f;
+  struct knote *kn;
+
+  if (kev->filter == EVFILT_READ)
+	ops = SEL_RD;
+  else if (kev->filter == EVFILT_WRITE)
+	ops = SEL_WR;
+  else
+	return(EINVAL);
+
+  if (kev->ident >= OPEN_MAX) return(EBADF);
+  fd = (int) kev->ident;
+
+  if ((f = get_filp(fd, VNODE_READ)) == NULL) return(err_code);
+
+  LIST_FOREACH(kn, &filp_knotes[f - filp], kn_flink) {
+	if (kn->kn_kq == kq && kn->kn_fd == fd &&
+	    kn->kn_filter == kev->filter)
+		break;
+  }
+
+  if (kn == NULL) {
+	if (!(kev->flags & EV_ADD)) {
+		unlock_filp(f);
+		return(ENOENT);
+	}
+
+	/* Kqueues cannot be watched themselves */
+	if (f->filp_kqueue != NULL || (type = select_filp_type(f)) < 0) {
+		unlock_filp(f);
+		return(EINVAL);
+	}
+
+	if ((kn = LIST_FIRST(&knote_free)) == NULL) {
+		unlock_filp(f);
+		return(ENOMEM);
+	}
+	LIST_REMOVE(kn, kn_dlink);
+
+	kn->kn_kq = kq;
+	kn->kn_filp = f;
+	kn->kn_fd = fd;
+	kn->kn_type = type;
+	kn->kn_filter = kev->filter;
+	kn->kn_ops = ops;
+	kn->kn_status = KN_DISABLED;	/* enabled and armed below */
+
+	LIST_INSERT_HEAD(&kq->kq_knotes, kn, kn_klink);
+	LIST_INSERT_HEAD(&filp_knotes[f - filp], kn, kn_flink);
+	if (S_ISCHR(f->filp_vno->v_mode)) {
+		kn->kn_dev = f->filp_vno->v_sdev;
+		LIST_INSERT_HEAD(kn_dev_hash(kn->kn_dev), kn, kn_dlink);
+	} else {
+		kn->kn_dev = NO_DEV;
+	}
+
+	f->filp_selectors++;
+  } else if (kev->flags & EV_DELETE) {
+	unlock_filp(f);
+	knote_drop(kn);
+	return(OK);
+  }
+
+  if (kev->flags & EV_ADD) {
+	kn->kn_flags = kev->flags & (EV_ONESHOT | EV_CLEAR | EV_DISPATCH);
+	kn->kn_udata = kev->udata;
+  }
+
+  unlock_filp(f);
+
+  if (kev->flags & EV_DISABLE) {
+	if (kn->kn_status & KN_ACTIVE)
+		TAILQ_REMOVE(&kq->kq_pending, kn, kn_tqe);
+	kn->kn_status &= ~(KN_ACTIVE | KN_RECHECK);
+	kn->kn_status |= KN_DISABLED;
+  } else if ((kev->flags & (EV_ADD | EV_ENABLE)) &&
+	     (kn->kn_status & KN_DISABLED)) {
+	kn->kn_status &= ~KN_DISABLED;
+	knote_arm(kn);
+  }
+
+  return(OK);
+}
+
+/*===========================================================================*
+ *				kqueue_scan				     *
+ *===========================================================================*/
+static int kqueue_scan(struct kqueue *kq, endpoint_t endpt, vir_bytes
+	eventlist, int nevents)
+{
+/* Copy up to nevents pending events to the given event list. Return the
+ * number of events copied, or an error. Knotes that are level-triggered go
+ * back on the pending queue after they have been reported, but are polled
+ * again before being reported the next time.
+ */
+  int r, n, nbuf, ops;
+  struct knote marker, *kn;
+  struct filp *f;
+  struct kevent kev[KEV_BATCH];
+
+  if (kq->kq_busy) return(0);
+  kq->kq_busy = TRUE;
+
+  /* Knotes queued behind the marker are left for the next scan */
+  marker.kn_status = KN_MARKER;
+  TAILQ_INSERT_TAIL(&kq->kq_pending, &marker, kn_tqe);
+
+  r = OK;
+  n = nbuf = 0;
+  while (n < nevents && (kn = TAILQ_FIRST(&kq->kq_pending)) != &marker) {
+	TAILQ_REMOVE(&kq->kq_pending, kn, kn_tqe);
+	kn->kn_status &= ~KN_ACTIVE;
+
+	if (kn->kn_status & KN_RECHECK) {
+		kn->kn_status &= ~KN_RECHECK;
+		f = kn->kn_filp;
+		ops = knote_request(kn);
+
+		/* The knote may have been deleted while we were blocked */
+		if (kn->kn_kq != kq || kn->kn_filp != f) continue;
+		if (kn->kn_status & (KN_ACTIVE | KN_DISABLED)) continue;
+		if (ops == 0) continue;	/* Not ready anymore; armed again */
+		if (ops < 0) kn->kn_status |= KN_EOF;
+	}
+
+	kev[nbuf].ident = kn->kn_fd;
+	kev[nbuf].filter = kn->kn_filter;
+	kev[nbuf].flags = kn->kn_flags;
+	if (kn->kn_status & KN_EOF) kev[nbuf].flags |= EV_EOF;
+	kev[nbuf].fflags = 0;
+	kev[nbuf].data = 0;
+	kev[nbuf].udata = kn->kn_udata;
+	nbuf++;
+	n++;
+
+	if (nbuf == KEV_BATCH) {
+		r = sys_datacopy(SELF, (vir_bytes) kev, endpt,
+			eventlist + (n - nbuf) * sizeof(kev[0]),
+			nbuf * sizeof(kev[0]));
+		nbuf = 0;
+		if (r != OK) break;
+	}
+
+	if (kn->kn_flags & EV_ONESHOT) {
+		knote_drop(kn);
+	} else if (kn->kn_flags & EV_DISPATCH) {
+		kn->kn_status |= KN_DISABLED;
+	} else if (!(kn->kn_flags & EV_CLEAR) ||
+		   !S_ISREG(kn->kn_filp->filp_vno->v_mode)) {
+		/* Devices and pipes report their state rather than state
+		 * changes, so they are level-triggered even with EV_CLEAR.
+		 * Regular files are always ready, so EV_CLEAR reports them
+		 * only once. */
+		kn->kn_status |= KN_ACTIVE | KN_RECHECK;
+		TAILQ_INSERT_TAIL(&kq->kq_pending, kn, kn_tqe);
+	}
+  }
+
+  TAILQ_REMOVE(&kq->kq_pending, &marker, kn_tqe);
+
+  if (r == OK && nbuf > 0) {
+	r = sys_datacopy(SELF, (vir_bytes) kev, endpt,
+		eventlist + (n - nbuf) * sizeof(kev[0]), nbuf * sizeof(kev[0]));
+  }
+
+  kq->kq_busy = FALSE;
+
+  /* Knotes queued during the scan could not be handed to a waiter */
+  if (!TAILQ_EMPTY(&kq->kq_pending)) kq->kq_wakeup = TRUE;
+
+  return(r != OK ? r : n);
+}
+
+/*===========================================================================*
+ *				kqueue_wakeup				     *
+ *===========================================================================*/
+static void kqueue_wakeup(struct kqueue *kq)
+{
+/* Knotes were queued on a kqueue. If a process is waiting for them, hand them
+ * over and revive it. */
+  int r;
+  endpoint_t endpt;
+
+  if (kq->kq_waiter == NONE || kq->kq_busy) return;
+
+  do {
+	r = kqueue_scan(kq, kq->kq_waiter, kq->kq_eventlist,
+		kq->kq_nevents);
+  } while (r == 0 && !TAILQ_EMPTY(&kq->kq_pending) &&
+	   kq->kq_waiter != NONE && !kq->kq_busy);
+
+  if (r == 0 || kq->kq_waiter == NONE) return;
+
+  endpt = kq->kq_waiter;
+  kq->kq_waiter = NONE;
+  if (kq->kq_expiry > 0) {
+	cancel_timer(&kq->kq_timer);
+	kq->kq_expiry = 0;
+  }
+
+  revive(endpt, r);
+}
+
+/*===========================================================================*
+ *				kqueue_run_wakeups			     *
+ *===========================================================================*/
+static void kqueue_run_wakeups(void)
+{
+/* Wake up the waiters of all kqueues that had knotes queued. This is done
+ * separately from queueing the knotes, as scanning may drop knotes from the
+ * lists that the callers are walking. A kqueue that is being scanned keeps
+ * its flag; the scanning thread runs the wakeups when it is done. */
+  struct kqueue *kq;
+
+  for (kq = &kqtab[0]; kq < &kqtab[NR_KQUEUES]; kq++) {
+	if (kq->kq_filp == NULL || !kq->kq_wakeup || kq->kq_busy) continue;
+	kq->kq_wakeup = FALSE;
+	kqueue_wakeup(kq);
+  }
+}
+
+/*===========================================================================*
+ *				kqueue_timeout_check			     *
+ *===========================================================================*/
+static void kqueue_timeout_check(timer_t *timer)
+{
+  int s;
+  endpoint_t endpt;
+  struct kqueue *kq;
+
+  s = tmr_arg(timer)->ta_int;
+  if (s < 0 || s >= NR_KQUEUES) return;	/* Entry does not exist */
+
+  kq = &kqtab[s];
+  if (kq->kq_filp == NULL || kq->kq_waiter == NONE) return;
+  if (kq->kq_expiry <= 0) return;	/* Strange, did we ask for a timeout? */
+  kq->kq_expiry = 0;
+
+  endpt = kq->kq_waiter;
+  kq->kq_waiter = NONE;
+  revive(endpt, 0);
+}
+
+/*===========================================================================*
+ *				kqueue_free				     *
+ *===========================================================================*/
+static void kqueue_free(struct kqueue *kq)
+{
+/* The last reference to a kqueue is gone. Drop all of its knotes. */
+  endpoint_t endpt;
+  struct knote *kn;
+
+  endpt = kq->kq_waiter;
+  kq->kq_waiter = NONE;
+  if (kq->kq_expiry > 0) {
+	cancel_timer(&kq->kq_timer);
+	kq->kq_expiry = 0;
+  }
+
+  while ((kn = LIST_FIRST(&kq->kq_knotes)) != NULL)
+	knote_drop(kn);
+
+  kq->kq_filp = NULL;
+
+  if (endpt != NONE) revive(endpt, EBADF);
+}
+
+/*===========================================================================*
+ *				knote_request				     *
+ *===========================================================================*/
+static int knote_request(struct knote *kn)
+{
+/* Send a blocking select request for a knote. Return the operations that are
+ * ready now, 0 if none are (in which case we will be told later on), or -1 if
+ * the filp reported an error. */
+  int r, wantops;
+  struct filp *f;
+
+  f = kn->kn_filp;
+  wantops = (f->filp_select_ops |= kn->kn_ops);
+  r = select_filp_request(f, kn->kn_type, &wantops, TRUE);
+
+  if (r == SUSPEND) {
+	/* If the request could not be sent to the driver yet, it has to be
+	 * sent again once the driver is done with the previous one. */
+	if ((f->filp_select_flags & FSF_UPDATE) &&
+	    !(kn->kn_status & KN_DEFERRED) && kn->kn_kq != NULL) {
+		kn->kn_status |= KN_DEFERRED;
+		nr_deferred++;
+	}
+	return(0);
+  }
+  if (r != OK) return(-1);
+
+  return(wantops & kn->kn_ops);
+}
+
+/*===========================================================================*
+ *				knote_arm				     *
+ *===========================================================================*/
+static void knote_arm(struct knote *kn)
+{
+/* Start watching the filp of a knote, and report it if it is ready already */
+  int ops;
+
+  if ((ops = knote_request(kn)) != 0 && kn->kn_kq != NULL)
+	knote_activate(kn, ops);
+}
+
+/*===========================================================================*
+ *				knote_activate				     *
+ *===========================================================================*/
+static void knote_activate(struct knote *kn, int ops)
+{
+/* Queue a knote on its kqueue, as its filp reported ready operations (or an
+ * error, if ops is negative). The kqueue is woken up by kqueue_run_wakeups. */
+
+  if (ops < 0) kn->kn_status |= KN_EOF;
+  if (kn->kn_status & KN_DISABLED) return;
+
+  if (kn->kn_status & KN_ACTIVE) {
+	/* Already queued; no need to poll it again */
+	kn->kn_status &= ~KN_RECHECK;
+	return;
+  }
+
+  kn->kn_status |= KN_ACTIVE;
+  TAILQ_INSERT_TAIL(&kn->kn_kq->kq_pending, kn, kn_tqe);
+  kn->kn_kq->kq_wakeup = TRUE;
+}
+
+/*===========================================================================*
+ *				knote_detach				     *
+ *===========================================================================*/
+static void knote_detach(struct knote *kn)
+{
+/* Unlink a knote from all lists and put it on the free list */
+
+  if (kn->kn_status & KN_ACTIVE)
+	TAILQ_REMOVE(&kn->kn_kq->kq_pending, kn, kn_tqe);
+  if (kn->kn_status & KN_DEFERRED)
+	nr_deferred--;
+
+  LIST_REMOVE(kn, kn_klink);
+  LIST_REMOVE(kn, kn_flink);
+  if (kn->kn_dev != NO_DEV)
+	LIST_REMOVE(kn, kn_dlink);
+
+  kn->kn_kq = NULL;
+  kn->kn_filp = NULL;
+  kn->kn_status = 0;
+  LIST_INSERT_HEAD(&knote_free, kn, kn_dlink);
+}
+
+/*===========================================================================*
+ *				knote_drop				     *
+ *===========================================================================*/
+static void knote_drop(struct knote *kn)
+{
+/* Delete a knote and stop selecting on its filp */
+  struct filp *f;
+
+  f = kn->kn_filp;
+  knote_detach(kn);
+  select_cancel_filp(f);
+}
+
+/*===========================================================================*
+ *				kqueue_filp_status			     *
+ *===========================================================================*/
+void kqueue_filp_status(struct filp *f, int status)
+{
+/* A filp reported its status. Queue the knotes interested in it. */
+  struct knote *kn;
+
+  if (status == 0) return;
+
+  LIST_FOREACH(kn, &filp_knotes[f - filp], kn_flink) {
+	if (status < 0 || (status & kn->kn_ops))
+		knote_activate(kn, status);
+  }
+
+  kqueue_run_wakeups();
+}
+
+/*===========================================================================*
+ *				kqueue_dev_status			     *
+ *===========================================================================*/
+void kqueue_dev_status(dev_t dev, int status)
+{
+/* A device reported ready operations after a blocking select request. Queue
+ * the knotes watching it, and update the select state of their filps. */
+  struct knote *kn;
+  int found;
+
+  found = FALSE;
+  LIST_FOREACH(kn, kn_dev_hash(dev), kn_dlink) {
+	if (kn->kn_dev != dev) continue;
+	if (status < 0 || (status & kn->kn_ops))
+		knote_activate(kn, status);
+	kn->kn_status |= KN_NOTE;
+	found = TRUE;
+  }
+  if (!found) return;
+
+  /* Updating the select state requires locking the filp, which may block, so
+   * start over after each filp. */
+  for (;;) {
+	LIST_FOREACH(kn, kn_dev_hash(dev), kn_dlink)
+		if (kn->kn_status & KN_NOTE) break;
+	if (kn == NULL) break;
+
+	kn->kn_status &= ~KN_NOTE;
+	select_note_ready(kn->kn_filp, status);
+  }
+
+  kqueue_run_wakeups();
+}
+
+/*===========================================================================*
+ *				kqueue_restart_filps			     *
+ *===========================================================================*/
+void kqueue_restart_filps(void)
+{
+/* A driver replied to a select request. Send the requests that had to wait
+ * for that. */
+  int h, ops;
+  struct knote *kn;
+
+  while (nr_deferred > 0) {
+	kn = NULL;
+	for (h = 0; h < KN_DEV_HASH && kn == NULL; h++) {
+		LIST_FOREACH(kn, &knote_dev[h], kn_dlink) {
+			if ((kn->kn_status & KN_DEFERRED) &&
+			    !(kn->kn_filp->filp_select_flags & FSF_BUSY))
+				break;
+		}
+	}
+	if (kn == NULL) break;	/* The rest is still waiting for a reply */
+
+	kn->kn_status &= ~KN_DEFERRED;
+	nr_deferred--;
+	if ((ops = knote_request(kn)) != 0 && kn->kn_kq != NULL)
+		knote_activate(kn, ops);
+  }
+
+  kqueue_run_wakeups();
+}
+
+/*===========================================================================*
+ *				kqueue_close_filp			     *
+ *===========================================================================*/
+void kqueue_close_filp(struct filp *f)
+{
+/* The last reference to a filp is going away. Forget about the knotes
+ * watching it, and if it is a kqueue, free the kqueue. */
+  struct kqueue *kq;
+  struct knote *kn;
+
+  while ((kn = LIST_FIRST(&filp_knotes[f - filp])) != NULL)
+	knote_detach(kn);
+
+  if ((kq = f->filp_kqueue) != NULL) {
+	f->filp_kqueue = NULL;
+	kqueue_free(kq);
+  }
+}
+
+/*===========================================================================*
+ *				kqueue_forget				     *
+ *===========================================================================*/
+void kqueue_forget(endpoint_t proc_e)
+{
+/* A process blocked in kevent() got interrupted. Stop waiting for it. */
+  struct kqueue *kq;
+
+  for (kq = &kqtab[0]; kq < &kqtab[NR_KQUEUES]; kq++) {
+	if (kq->kq_filp == NULL || kq->kq_waiter != proc_e) continue;
+
+	kq->kq_waiter = NONE;
+	if (kq->kq_expiry > 0) {
+		cancel_timer(&kq->kq_timer);
+		kq->kq_expiry = 0;
+	}
+  }
+}
+
+/*===========================================================================*
+ *				kqueue_unsuspend_by_endpt		     *
+ *===========================================================================*/
+void kqueue_unsuspend_by_endpt(endpoint_t proc_e)
+{
+/* A driver has disappeared. Report EOF on the devices it handled. */
+  int h;
+  struct knote *kn;
+
+  for (h = 0; h < KN_DEV_HASH; h++) {
+	LIST_FOREACH(kn, &knote_dev[h], kn_dlink) {
+		if (dmap_driver_match(proc_e, major(kn->kn_dev)))
+			knote_activate(kn, -1);
+	}
+  }
+
+  kqueue_run_wakeups();
+}
+
+/*===========================================================================*
+ *				init_kqueue				     *
+ *===========================================================================*/
+void init_kqueue(void)
+{
+  int i;
+
+  LIST_INIT(&knote_free);
+  for (i = NR_KNOTES - 1; i >= 0; i--)
+	LIST_INSERT_HEAD(&knote_free, &knotes[i], kn_dlink);
+
+  for (i = 0; i < NR_FILPS; i++)
+	LIST_INIT(&filp_knotes[i]);
+
+  for (i = 0; i < KN_DEV_HASH; i++)
+	LIST_INIT(&knote_dev[i]);
+
+  for (i = 0; i < NR_KQUEUES; i++)
+	init_timer(&kqtab[i].kq_timer);
+}
@@ -26,6 +26,7 @@
 #include <string.h>
 #include <dirent.h>
 #include <sys/param.h>
+#include <sys/mman.h>
 #include "fproc.h"
 #include "path.h"
 #include "param.h"
@@ -38,6 +39,24 @@
 #define _KERNEL	/* for ELF_AUX_ENTRIES */
 #include <libexec.h>
 
+/* Execs of different processes run in parallel; what keeps them apart is
+ * that each one works in its own set of buffers, taken from a small pool.
+ * The executable itself is only ever locked for reading, so any number of
+ * processes can exec the same binary at the same time. The stack image can
+ * be ARG_MAX bytes, so its buffer is only mapped while an exec uses the set;
+ * VM gives it pages as they are touched, which for most execs is one or two.
+ */
+struct exec_buf {
+    mutex_t eb_lock;			/* Held while the buffers are in use */
+    char *eb_stack;			/* Stack image, ARG_MAX bytes mapped */
+    char eb_path[PATH_MAX];		/* Path being looked up */
+    char eb_interp[PATH_MAX];		/* ELF interpreter path */
+    char eb_final[PATH_MAX];		/* Path of the main executable */
+    char eb_hdr[PAGE_SIZE];		/* Header; assumed to fit in a page */
+};
+
+static struct exec_buf exec_bufs[NR_EXECS];
+
 /* fields only used by elf and in VFS */
 struct vfs_exec_info {
     struct exec_info args;		/* libexec exec args */
@@ -48,10 +67,11 @@ struct vfs_exec_info {
     int is_dyn;				/* Dynamically linked executable */
     int elf_main_fd;			/* Dyn: FD of main program execuatble */
     char execname[PATH_MAX];		/* Full executable invocation */
+    struct exec_buf *buf;		/* Buffers of this exec */
 };
 
-static void lock_exec(void);
-static void unlock_exec(void);
+static struct exec_buf *lock_exec(int slot);
+static void unlock_exec(struct exec_buf *eb);
 static int patch_stack(struct vnode *vp, char stack[ARG_MAX],
 	size_t *stk_bytes, char path[PATH_MAX]);
 static int is_script(struct vfs_exec_info *execi);
@@ -79,34 +99,77 @@ static const struct exec_loaders exec_loaders[] = {
 	{ NULL, NULL }
 };
 
+/*===========================================================================*
+ *				init_exec				     *
+ *===========================================================================*/
+void init_exec(void)
+{
+  int i;
+
+  for (i = 0; i < NR_EXECS; i++) {
+	if (mutex_init(&exec_bufs[i].eb_lock, NULL) != 0)
+		panic("VFS: couldn't initialize exec lock");
+	exec_bufs[i].eb_stack = MAP_FAILED;
+  }
+}
+
 /*===========================================================================*
  *				lock_exec				     *
  *===========================================================================*/
-static void lock_exec(void)
+static struct exec_buf *lock_exec(int slot)
 {
+/* Get a set of exec buffers for the process in the given fproc slot, or
+ * NULL if there is no memory for its stack buffer.
+ */
   struct fproc *org_fp;
   struct worker_thread *org_self;
+  struct exec_buf *eb;
+  int i;
+
+  /* First try to get any free set right off the bat */
+  for (i = 0; i < NR_EXECS; i++) {
+	eb = &exec_bufs[(slot + i) % NR_EXECS];
+	if (mutex_trylock(&eb->eb_lock) == 0)
+		break;
+  }
 
-  /* First try to get it right off the bat */
-  if (mutex_trylock(&exec_lock) == 0)
-	return;
+  if (i == NR_EXECS) {
+	/* All sets are in use; queue up behind the one this process maps
+	 * to.
+	 */
+	eb = &exec_bufs[slot % NR_EXECS];
 
-  org_fp = fp;
-  org_self = self;
+	org_fp = fp;
+	org_self = self;
 
-  if (mutex_lock(&exec_lock) != 0)
-	panic("Could not obtain lock on exec");
+	if (mutex_lock(&eb->eb_lock) != 0)
+		panic("Could not obtain lock on exec");
 
-  fp = org_fp;
-  self = org_self;
+	fp = org_fp;
+	self = org_self;
+  }
+
+  eb->eb_stack = minix_mmap(0, ARG_MAX, PROT_READ|PROT_WRITE, MAP_ANON, -1, 0);
+  if (eb->eb_stack == MAP_FAILED) {
+	unlock_exec(eb);
+	return(NULL);
+  }
+
+  return(eb);
 }
 
 /*===========================================================================*
  *				unlock_exec				     *
  *===========================================================================*/
-static void unlock_exec(void)
+static void unlock_exec(struct exec_buf *eb)
 {
-  if (mutex_unlock(&exec_lock) != 0)
+  if (eb->eb_stack != MAP_FAILED) {
+	if (minix_munmap(eb->eb_stack, ARG_MAX) != OK)
+		panic("Could not unmap exec stack buffer");
+	eb->eb_stack = MAP_FAILED;
+  }
+
+  if (mutex_unlock(&eb->eb_lock) != 0)
 	panic("Could not release lock on exec");
 }
 
@@ -200,26 +263,32 @@ int pm_exec(endpoint_t proc_e, vir_bytes path, size_t path_len,
   vir_bytes vsp;
   struct fproc *rfp;
   int extrabase = 0;
-  static char mbuf[ARG_MAX];	/* buffer for stack and zeroes */
+  char *mbuf;			/* buffer for stack and zeroes */
   struct vfs_exec_info execi;
   int i;
-  static char fullpath[PATH_MAX],
-  	elf_interpreter[PATH_MAX],
-	finalexec[PATH_MAX];
+  char *fullpath, *elf_interpreter, *finalexec;
+  struct exec_buf *eb;
   struct lookup resolve;
   stackhook_t makestack = NULL;
 
-  lock_exec();
+  okendpt(proc_e, &slot);
+
+  if ((eb = lock_exec(slot)) == NULL)
+	return(ENOMEM);
+  mbuf = eb->eb_stack;
+  fullpath = eb->eb_path;
+  elf_interpreter = eb->eb_interp;
+  finalexec = eb->eb_final;
 
   /* unset execi values are 0. */
   memset(&execi, 0, sizeof(execi));
+  execi.buf = eb;
 
   /* passed from exec() libc code */
   execi.userflags = user_exec_flags;
   execi.args.stack_high = kinfo.user_sp;
   execi.args.stack_size = DEFAULT_STACK_LIMIT;
 
-  okendpt(proc_e, &slot);
   rfp = fp = &fproc[slot];
 
   lookup_init(&resolve, fullpath, PATH_NOFLAGS, &execi.vmp, &execi.vp);
@@ -273,7 +342,7 @@ int pm_exec(endpoint_t proc_e, vir_bytes path, size_t path_len,
    * fd for the current process.
    */
   if(elf_has_interpreter(execi.args.hdr, execi.args.hdr_len,
-	elf_interpreter, sizeof(elf_interpreter))) {
+	elf_interpreter, PATH_MAX)) {
 	/* Switch the executable vnode to the interpreter */
 	execi.is_dyn = 1;
 
@@ -308,6 +377,7 @@ int pm_exec(endpoint_t proc_e, vir_bytes path, size_t path_len,
   execi.args.clearmem = libexec_clear_sys_memset;
   execi.args.allocmem_prealloc = libexec_alloc_mmap_prealloc;
   execi.args.allocmem_ondemand = libexec_alloc_mmap_ondemand;
+  execi.args.allocmem_zeroed = libexec_alloc_mmap_ondemand;
   execi.args.opaque = &execi;
 
   execi.args.proc_e = proc_e;
@@ -351,13 +421,14 @@ int pm_exec(endpoint_t proc_e, vir_bytes path, size_t path_len,
 
   /* Remember the new name of the process */
   strlcpy(rfp->fp_name, execi.args.progname, PROC_NAME_LEN);
+  proc_changed(rfp);
 
 pm_execfinal:
   if (execi.vp != NULL) {
 	unlock_vnode(execi.vp);
 	put_vnode(execi.vp);
   }
-  unlock_exec();
+  unlock_exec(eb);
   return(r);
 }
 
@@ -662,12 +733,12 @@ static int map_header(struct vfs_exec_info *execi)
   u64_t new_pos;
   unsigned int cum_io;
   off_t pos;
-  static char hdr[PAGE_SIZE]; /* Assume that header is not larger than a page */
+  char *hdr = execi->buf->eb_hdr;
 
   pos = 0;	/* Read from the start of the file */
 
   /* How much is sensible to read */
-  execi->args.hdr_len = MIN(execi->vp->v_size, sizeof(hdr));
+  execi->args.hdr_len = MIN(execi->vp->v_size, sizeof(execi->buf->eb_hdr));
   execi->args.hdr = hdr;
 
   r = req_readwrite(execi->vp->v_fs_e, execi->vp->v_inode_nr,
@@ -26,6 +26,8 @@ EXTERN struct filp {
 
   /* following are for fd-type-specific select() */
   int filp_pipe_select_ops;
+
+  struct kqueue *filp_kqueue;	/* if not NULL, this filp is a kqueue */
 } filp[NR_FILPS];
 
 #define FILP_CLOSED	0	/* filp_mode: associated device closed */
@@ -185,6 +185,7 @@ int get_fd(int start, mode_t bits, int *k, struct filp **fpt)
 		f->filp_state = FS_NORMAL;
 		f->filp_select_flags = 0;
 		f->filp_softlock = NULL;
+		f->filp_kqueue = NULL;
 		*fpt = f;
 		return(OK);
 	}
@@ -667,6 +668,8 @@ struct filp *f;
 		truncate_vnode(vp, vp->v_size);
 	}
 
+	kqueue_close_filp(f);	/* Drop knotes and kqueue, if any */
+
 	unlock_vnode(f->filp_vno);
 	put_vnode(f->filp_vno);
 	f->filp_vno = NULL;
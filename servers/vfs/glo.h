@@ -38,7 +38,6 @@ EXTERN message m_out;		/* the output message used for reply */
 EXTERN struct worker_thread *self;
 EXTERN int force_sync;		/* toggle forced synchronous communication */
 EXTERN int deadlock_resolving;
-EXTERN mutex_t exec_lock;
 EXTERN mutex_t bsf_lock;/* Global lock for access to block special files */
 EXTERN struct worker_thread workers[NR_WTHREADS];
 EXTERN struct worker_thread sys_worker;
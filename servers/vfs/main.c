@@ -570,8 +570,6 @@ static int sef_cb_init_fresh(int UNUSED(type), sef_init_info_t *info)
   /* Initialize global locks */
   if (mthread_mutex_init(&pm_lock, NULL) != 0)
 	panic("VFS: couldn't initialize pm lock mutex");
-  if (mthread_mutex_init(&exec_lock, NULL) != 0)
-	panic("VFS: couldn't initialize exec lock");
   if (mthread_mutex_init(&bsf_lock, NULL) != 0)
 	panic("VFS: couldn't initialize block special file lock");
 
@@ -586,9 +584,11 @@ static int sef_cb_init_fresh(int UNUSED(type), sef_init_info_t *info)
   }
 
   init_dmap_locks();		/* init dmap locks */
+  init_exec();			/* init exec buffers */
   init_vnodes();		/* init vnodes */
   init_vmnts();			/* init vmnt structures */
   init_select();		/* init select() structures */
+  init_kqueue();		/* init kqueue() structures */
   init_filps();			/* Init filp structures */
   mount_pfs();			/* mount Pipe File Server */
   worker_start(do_init_root);	/* mount initial ramdisk as file system root */
@@ -1073,6 +1073,7 @@ struct fproc *rfp;
 
   rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;	/* no longer blocked */
   rfp->fp_flags &= ~FP_REVIVED;
+  proc_changed(rfp);
   reviving--;
   assert(reviving >= 0);
 
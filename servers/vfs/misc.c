@@ -14,6 +14,7 @@
  *   do_revive:	  revive a process that was waiting for something (e.g. TTY)
  *   do_svrctl:	  file system control
  *   do_getsysinfo:	request copy of FS data structure
+ *   proc_changed: note a change to a process slot for SI_PROC_DELTA
  *   pm_dumpcore: create a core dump
  */
 
@@ -27,9 +28,12 @@
 #include <minix/endpoint.h>
 #include <minix/com.h>
 #include <minix/sysinfo.h>
+#include <stddef.h>
 #include <minix/u64.h>
 #include <sys/ptrace.h>
 #include <sys/svrctl.h>
+#include <sys/param.h>
+#include <machine/vmparam.h>
 #include "file.h"
 #include "fproc.h"
 #include "scratchpad.h"
@@ -46,6 +50,11 @@
 unsigned long calls_stats[NCALLS];
 #endif
 
+/* The process table, handed out in deltas by SI_PROC_DELTA. */
+static struct sysinfo_delta fproc_delta = {
+  fproc, sizeof(struct fproc), NR_PROCS, offsetof(struct fproc, fp_gen), 0
+};
+
 static void free_proc(struct fproc *freed, int flags);
 /*
 static int dumpcore(int proc_e, struct mem_map *seg_ptr);
@@ -80,6 +89,9 @@ int do_getsysinfo()
 	src_addr = (vir_bytes) fproc;
 	len = sizeof(struct fproc) * NR_PROCS;
 	break;
+    case SI_PROC_DELTA:
+	return sysinfo_delta_copy(&fproc_delta, who_e, dst_addr, buf_size,
+		job_m_in.SI_GEN);
     case SI_DMAP_TAB:
 	src_addr = (vir_bytes) dmap;
 	len = sizeof(struct dmap) * NR_DEVICES;
@@ -105,6 +117,17 @@ int do_getsysinfo()
   return sys_datacopy(SELF, src_addr, who_e, dst_addr, len);
 }
 
+/*===========================================================================*
+ *				proc_changed				     *
+ *===========================================================================*/
+void proc_changed(struct fproc *rfp)
+{
+/* A process slot changed in a way that procfs can see. Give it a new
+ * generation, so that it is part of the next SI_PROC_DELTA copy.
+ */
+  sysinfo_delta_touch(&fproc_delta, (int) (rfp - fproc));
+}
+
 /*===========================================================================*
  *				do_fcntl				     *
  *===========================================================================*/
@@ -242,6 +265,33 @@ int do_fcntl()
 	fl = (O_NOSIGPIPE);
 	f->filp_flags = (f->filp_flags & ~fl) | (fcntl_argx & fl);
 	break;
+    case F_GETPIPE_SZ:
+	if (!S_ISFIFO(f->filp_vno->v_mode)) r = EINVAL;
+	else r = (int) f->filp_vno->v_pipe_size;
+	break;
+    case F_SETPIPE_SZ:
+     {
+	struct vnode *vp = f->filp_vno;
+	off_t size;
+
+	if (!S_ISFIFO(vp->v_mode) || fcntl_argx < 0 ||
+	    fcntl_argx > PIPE_MAX_SIZE) {
+		r = EINVAL;
+		break;
+	}
+
+	/* Whole pages, and room for at least one atomic write */
+	size = roundup(MAX(fcntl_argx, PIPE_BUF), PAGE_SIZE);
+	if (size < vp->v_size) {
+		r = EBUSY;	/* The data would not fit anymore */
+		break;
+	}
+
+	vp->v_pipe_size = size;
+	release(vp, WRITE, susp_count);	/* Writers may fit now */
+	r = (int) size;
+	break;
+     }
     default:
 	r = EINVAL;
   }
@@ -411,6 +461,7 @@ void pm_fork(endpoint_t pproc, endpoint_t cproc, pid_t cpid)
 
   /* A child is not a process leader, not being revived, etc. */
   cp->fp_flags = FP_NOFLAGS;
+  proc_changed(cp);
 
   /* Record the fact that both root and working dir have another user. */
   if (cp->fp_rd) dup_vnode(cp->fp_rd);
@@ -470,7 +521,10 @@ static void free_proc(struct fproc *exiter, int flags)
       dev = exiter->fp_tty;
       for (rfp = &fproc[0]; rfp < &fproc[NR_PROCS]; rfp++) {
 	  if(rfp->fp_pid == PID_FREE) continue;
-          if (rfp->fp_tty == dev) rfp->fp_tty = 0;
+          if (rfp->fp_tty == dev) {
+		rfp->fp_tty = 0;
+		proc_changed(rfp);
+	  }
 
           for (i = 0; i < OPEN_MAX; i++) {
 		if ((rfilp = rfp->fp_filp[i]) == NULL) continue;
@@ -493,6 +547,7 @@ static void free_proc(struct fproc *exiter, int flags)
   if (exiter->fp_flags & FP_PENDING)
 	pending--;	/* No longer pending job, not going to do it */
   exiter->fp_flags = FP_NOFLAGS;
+  proc_changed(exiter);
 }
 
 /*===========================================================================*
@@ -526,6 +581,7 @@ int rgid;
 
   tfp->fp_effgid =  egid;
   tfp->fp_realgid = rgid;
+  proc_changed(tfp);
 }
 
 
@@ -547,6 +603,7 @@ gid_t *groups;
   if (sys_datacopy(who_e, (vir_bytes) groups, SELF, (vir_bytes) rfp->fp_sgroups,
 		   ngroups * sizeof(gid_t)) == OK) {
 	rfp->fp_ngroups = ngroups;
+	proc_changed(rfp);
   } else
 	panic("VFS: pm_setgroups: datacopy failed");
 }
@@ -568,6 +625,7 @@ int ruid;
 
   tfp->fp_effuid =  euid;
   tfp->fp_realuid = ruid;
+  proc_changed(tfp);
 }
 
 /*===========================================================================*
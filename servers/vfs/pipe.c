@@ -265,8 +265,10 @@ int notouch		/* check only */
 	return(EPIPE);
   }
 
-  /* Calculate how many bytes can be written. */
-  if (pos + bytes > PIPE_BUF) {
+  /* Calculate how many bytes can be written. Writes of up to PIPE_BUF bytes
+   * are atomic; the pipe may hold more than that.
+   */
+  if (pos + bytes > vp->v_pipe_size) {
 	if (oflags & O_NONBLOCK) {
 		if (bytes <= PIPE_BUF) {
 			/* Write has to be atomic */
@@ -274,7 +276,7 @@ int notouch		/* check only */
 		}
 
 		/* Compute available space */
-		bytes = PIPE_BUF - pos;
+		bytes = vp->v_pipe_size - pos;
 
 		if (bytes > 0)  {
 			/* Do a partial write. Need to wakeup reader */
@@ -289,7 +291,7 @@ int notouch		/* check only */
 
 	if (bytes > PIPE_BUF) {
 		/* Compute available space */
-		bytes = PIPE_BUF - pos;
+		bytes = vp->v_pipe_size - pos;
 
 		if (bytes > 0) {
 			/* Do a partial write. Need to wakeup reader
@@ -331,6 +333,7 @@ void suspend(int why)
 	susp_count++;
 
   fp->fp_blocked_on = why;
+  proc_changed(fp);
   assert(fp->fp_grant == GRANT_INVALID || !GRANT_VALID(fp->fp_grant));
   fp->fp_block_callnr = job_call_nr;
   fp->fp_flags &= ~FP_SUSP_REOPEN;		/* Clear this flag. The caller
@@ -493,6 +496,7 @@ void revive(endpoint_t proc_e, int returned)
 	reviving++;		/* process was waiting on pipe or lock */
   } else if (blocked_on == FP_BLOCKED_ON_DOPEN) {
 	rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+	proc_changed(rfp);
 	scratch(rfp).file.fd_nr = 0;
 	if (returned < 0) {
 		fil_ptr = rfp->fp_filp[fd_nr];
@@ -513,6 +517,7 @@ void revive(endpoint_t proc_e, int returned)
 	}
   } else {
 	rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+	proc_changed(rfp);
 	scratch(rfp).file.fd_nr = 0;
 	if (blocked_on == FP_BLOCKED_ON_POPEN) {
 		/* process blocked in open or create */
@@ -635,6 +640,7 @@ void unpause(endpoint_t proc_e)
   }
 
   rfp->fp_blocked_on = FP_BLOCKED_ON_NONE;
+  proc_changed(rfp);
 
   if ((blocked_on == FP_BLOCKED_ON_PIPE || blocked_on == FP_BLOCKED_ON_POPEN)&&
 	!wasreviving) {
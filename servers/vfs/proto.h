@@ -12,6 +12,7 @@
 /* Structs used in prototypes must be declared as such first. */
 struct filp;
 struct fproc;
+struct iovec;
 struct vmnt;
 struct vnode;
 struct lookup;
@@ -76,6 +77,7 @@ int map_service(struct rprocpub *rpub);
 void write_elf_core_file(struct filp *f, int csig, char *exe_name);
 
 /* exec.c */
+void init_exec(void);
 int pm_exec(endpoint_t proc_e, vir_bytes path, size_t path_len, vir_bytes frame,
 	size_t frame_len, vir_bytes *pc, vir_bytes *newsp, int flags);
 
@@ -141,6 +143,7 @@ int do_fsync(void);
 void pm_reboot(void);
 int do_svrctl(void);
 int do_getsysinfo(void);
+void proc_changed(struct fproc *rfp);
 int pm_dumpcore(endpoint_t proc_e, int sig, vir_bytes exe_name);
 void * ds_event(void *arg);
 
@@ -206,11 +209,15 @@ int read_only(struct vnode *vp);
 
 /* read.c */
 int do_read(void);
+int do_pread(void);
+int do_readv(void);
 int do_getdents(void);
 void lock_bsf(void);
 void unlock_bsf(void);
 void check_bsf_lock(void);
 int do_read_write_peek(int rw_flag, int fd, char *buf, size_t bytes);
+int do_pread_pwrite(int rw_flag);
+int do_readv_writev(int rw_flag);
 int read_write(int rw_flag, struct filp *f, char *buffer, size_t nbytes,
 	endpoint_t for_e);
 int rw_pipe(int rw_flag, endpoint_t usr, struct filp *f, char *buf,
@@ -252,6 +259,9 @@ int req_readsuper(endpoint_t fs_e, char *driver_name, dev_t dev, int readonly,
 int req_readwrite(endpoint_t fs_e, ino_t inode_nr, u64_t pos, int rw_flag,
 	endpoint_t user_e, char *user_addr, unsigned int num_of_bytes,
 	u64_t *new_posp, unsigned int *cum_iop);
+int req_readwritev(endpoint_t fs_e, ino_t inode_nr, u64_t pos, int rw_flag,
+	endpoint_t user_e, struct iovec *iov, int iovcnt, u64_t *new_posp,
+	unsigned int *cum_iop);
 int req_rename(endpoint_t fs_e, ino_t old_dir, char *old_name, ino_t new_dir,
 	char *new_name);
 int req_rmdir(endpoint_t fs_e, ino_t inode_nr, char *lastc);
@@ -334,6 +344,8 @@ void upgrade_vnode_lock(struct vnode *vp);
 
 /* write.c */
 int do_write(void);
+int do_pwrite(void);
+int do_writev(void);
 
 /* gcov.c */
 int do_gcov_flush(void);
@@ -345,12 +357,27 @@ int do_gcov_flush(void);
 int do_select(void);
 void init_select(void);
 void select_callback(struct filp *, int ops);
+void select_cancel_filp(struct filp *f);
+int select_filp_request(struct filp *f, int type, int *ops, int block);
+int select_filp_type(struct filp *f);
 void select_forget(endpoint_t proc_e);
+void select_note_ready(struct filp *f, int status);
 void select_reply1(endpoint_t driver_e, int minor, int status);
 void select_reply2(endpoint_t driver_e, int minor, int status);
 void select_timeout_check(timer_t *);
 void select_unsuspend_by_endpt(endpoint_t proc);
 
+/* event.c */
+int do_kevent(void);
+int do_kqueue(void);
+void init_kqueue(void);
+void kqueue_close_filp(struct filp *f);
+void kqueue_dev_status(dev_t dev, int status);
+void kqueue_filp_status(struct filp *f, int status);
+void kqueue_forget(endpoint_t proc_e);
+void kqueue_restart_filps(void);
+void kqueue_unsuspend_by_endpt(endpoint_t proc_e);
+
 /* worker.c */
 int worker_available(void);
 struct worker_thread *worker_get(thread_t worker_tid);
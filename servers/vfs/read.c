@@ -5,8 +5,12 @@
  *
  * The entry points into this file are
  *   do_read:	 perform the READ system call by calling read_write
+ *   do_pread:	 perform the PREAD system call
+ *   do_readv:	 perform the READV system call
  *   do_getdents: read entries from a directory (GETDENTS)
  *   read_write: actually do the work of READ and WRITE
+ *   do_pread_pwrite: do the work of PREAD and PWRITE
+ *   do_readv_writev: do the work of READV and WRITEV
  *
  */
 
@@ -22,9 +26,16 @@
 #include <dirent.h>
 #include <assert.h>
 #include <minix/vfsif.h>
+#include <sys/uio.h>
 #include "vnode.h"
 #include "vmnt.h"
 
+static int read_write_pos(int rw_flag, struct filp *f, char *buf, size_t
+	size, endpoint_t for_e, u64_t *posp);
+static int rw_iovec(int rw_flag, struct vnode *vp, struct iovec *iov, int
+	iovcnt, u64_t position, u64_t *new_posp, unsigned int *cum_iop);
+static int rw_vector(int rw_flag, struct filp *f, vir_bytes iov_addr, int
+	iovcnt, u64_t *posp);
 
 /*===========================================================================*
  *				do_read					     *
@@ -36,6 +47,24 @@ int do_read()
 }
 
 
+/*===========================================================================*
+ *				do_pread				     *
+ *===========================================================================*/
+int do_pread()
+{
+  return(do_pread_pwrite(READING));
+}
+
+
+/*===========================================================================*
+ *				do_readv				     *
+ *===========================================================================*/
+int do_readv()
+{
+  return(do_readv_writev(READING));
+}
+
+
 /*===========================================================================*
  *				lock_bsf				     *
  *===========================================================================*/
@@ -118,18 +147,269 @@ int do_read_write_peek(int rw_flag, int io_fd, char *io_buf, size_t io_nbytes)
   return(r);
 }
 
+/*===========================================================================*
+ *				do_pread_pwrite				     *
+ *===========================================================================*/
+int do_pread_pwrite(int rw_flag)
+{
+/* Perform pread(fd, buffer, nbytes, position) or pwrite(fd, buffer, nbytes,
+ * position): read or write at the given position, without using or changing
+ * the file position.
+ */
+  struct filp *f;
+  tll_access_t locktype;
+  u64_t position;
+  size_t size;
+  int r;
+
+  size = (size_t) job_m_in.PRW_NBYTES;
+  if (job_m_in.PRW_POS_HI < 0) return(EINVAL);
+  position = make64(job_m_in.PRW_POS_LO, job_m_in.PRW_POS_HI);
+
+  locktype = (rw_flag == READING) ? VNODE_READ : VNODE_WRITE;
+  if ((f = get_filp(job_m_in.PRW_FD, locktype)) == NULL)
+	return(err_code);
+
+  if (((f->filp_mode) & (rw_flag == READING ? R_BIT : W_BIT)) == 0)
+	r = (f->filp_mode == FILP_CLOSED ? EIO : EBADF);
+  else if (S_ISFIFO(f->filp_vno->v_mode))
+	r = ESPIPE;
+  else if (size == 0)
+	r = 0;
+  else
+	r = read_write_pos(rw_flag, f, job_m_in.PRW_BUFFER, size, who_e,
+		&position);
+
+  unlock_filp(f);
+  return(r);
+}
+
+/*===========================================================================*
+ *				do_readv_writev				     *
+ *===========================================================================*/
+int do_readv_writev(int rw_flag)
+{
+/* Perform readv(fd, iov, iovcnt) or writev(fd, iov, iovcnt), or preadv and
+ * pwritev if PRW_AT_POS is set. Vectors are handled natively on regular and
+ * block special files only. On other files, which may suspend the caller
+ * halfway, we return ENOSYS and the C library falls back to an intermediate
+ * buffer.
+ */
+  struct filp *f;
+  struct vnode *vp;
+  tll_access_t locktype;
+  u64_t position;
+  int r, iovcnt, at_pos;
+
+  iovcnt = job_m_in.PRW_IOVCNT;
+  at_pos = (job_m_in.PRW_FLAGS & PRW_AT_POS);
+
+  if (iovcnt < 0 || iovcnt > IOV_MAX) return(EINVAL);
+  if (at_pos && job_m_in.PRW_POS_HI < 0) return(EINVAL);
+
+  locktype = (rw_flag == READING) ? VNODE_READ : VNODE_WRITE;
+  if ((f = get_filp(job_m_in.PRW_FD, locktype)) == NULL)
+	return(err_code);
+  vp = f->filp_vno;
+
+  if (((f->filp_mode) & (rw_flag == READING ? R_BIT : W_BIT)) == 0)
+	r = (f->filp_mode == FILP_CLOSED ? EIO : EBADF);
+  else if (at_pos && S_ISFIFO(vp->v_mode))
+	r = ESPIPE;
+  else if (!S_ISREG(vp->v_mode) && !S_ISBLK(vp->v_mode))
+	r = ENOSYS;
+  else {
+	if (at_pos)
+		position = make64(job_m_in.PRW_POS_LO, job_m_in.PRW_POS_HI);
+	else
+		position = f->filp_pos;
+
+	r = rw_vector(rw_flag, f, (vir_bytes) job_m_in.PRW_BUFFER, iovcnt,
+		&position);
+
+	if (!at_pos) f->filp_pos = position;
+  }
+
+  unlock_filp(f);
+  return(r);
+}
+
+/*===========================================================================*
+ *				rw_vector				     *
+ *===========================================================================*/
+static int rw_vector(int rw_flag, struct filp *f, vir_bytes iov_addr, int
+	iovcnt, u64_t *posp)
+{
+/* Read or write a vector of buffers on a regular or block special file. The
+ * iovec array is copied in batches of NR_IOREQS entries, each of which takes
+ * a single request to the file server.
+ */
+  struct iovec iov[NR_IOREQS];
+  struct vnode *vp;
+  u64_t position, new_pos;
+  size_t total, size;
+  unsigned int cum_io, cum_io_incr;
+  int i, j, n, r;
+
+  vp = f->filp_vno;
+
+  /* Check the whole vector before doing any I/O. If it does not fit in one
+   * batch, that means copying it in twice. */
+  total = 0;
+  for (i = 0; i < iovcnt; i += n) {
+	n = MIN(iovcnt - i, NR_IOREQS);
+	r = sys_datacopy(who_e, iov_addr + i * sizeof(iov[0]), SELF,
+		(vir_bytes) iov, n * sizeof(iov[0]));
+	if (r != OK) return(r);
+
+	for (j = 0; j < n; j++) {
+		if (iov[j].iov_len > SSIZE_MAX - total) return(EINVAL);
+		total += iov[j].iov_len;
+	}
+  }
+  if (total == 0) return(0);
+
+  position = *posp;
+  if (rw_flag == WRITING && S_ISREG(vp->v_mode) && (f->filp_flags & O_APPEND))
+	position = cvul64(vp->v_size);
+
+  cum_io = 0;
+  r = OK;
+  for (i = 0; i < iovcnt; i += n) {
+	n = MIN(iovcnt - i, NR_IOREQS);
+	if (iovcnt > NR_IOREQS) {
+		r = sys_datacopy(who_e, iov_addr + i * sizeof(iov[0]), SELF,
+			(vir_bytes) iov, n * sizeof(iov[0]));
+		if (r != OK) break;
+	}
+
+	for (size = 0, j = 0; j < n; j++)
+		size += iov[j].iov_len;
+	if (size == 0) continue;
+
+	r = rw_iovec(rw_flag, vp, iov, n, position, &new_pos, &cum_io_incr);
+	if (r != OK) break;
+
+	position = new_pos;
+	cum_io += cum_io_incr;
+	if (cum_io_incr < size) break;	/* End of file or short write */
+  }
+
+  /* On write, update file size. */
+  if (rw_flag == WRITING && S_ISREG(vp->v_mode) &&
+      cmp64ul(position, vp->v_size) > 0) {
+	if (ex64hi(position) != 0)
+		panic("rw_vector: file size too big");
+	vp->v_size = ex64lo(position);
+  }
+
+  *posp = position;
+
+  /* Report what was transferred before any error */
+  return(cum_io > 0 ? (int) cum_io : r);
+}
+
+/*===========================================================================*
+ *				rw_iovec				     *
+ *===========================================================================*/
+static int rw_iovec(int rw_flag, struct vnode *vp, struct iovec *iov, int
+	iovcnt, u64_t position, u64_t *new_posp, unsigned int *cum_iop)
+{
+/* Transfer one batch of a vector. File servers that do not know about
+ * vectored requests get one request per buffer; we find out the first time
+ * we try. A file server that says ENOSYS does not do them. One that says
+ * EINVAL may be rejecting the request type or its arguments; it is only
+ * marked if it then accepts the same transfer as a plain request.
+ */
+  struct vmnt *vmp;
+  unsigned int cum_io, cum_io_incr;
+  int i, r, probe;
+
+  probe = FALSE;
+  if (S_ISREG(vp->v_mode)) {
+	if (ex64hi(position) != 0) {
+		/* The file servers cannot handle such positions */
+		*new_posp = position;
+		*cum_iop = 0;
+		return(rw_flag == READING ? OK : EFBIG);
+	}
+
+	vmp = vp->v_vmnt;
+	if (vmp != NULL && !(vmp->m_flags & VMNT_NOVECTOR)) {
+		r = req_readwritev(vp->v_fs_e, vp->v_inode_nr, position,
+			rw_flag, who_e, iov, iovcnt, new_posp, cum_iop);
+		if (r == ENOSYS)
+			vmp->m_flags |= VMNT_NOVECTOR;
+		else if (r == EINVAL)
+			probe = TRUE;
+		else
+			return(r);
+	}
+  }
+
+  cum_io = 0;
+  r = OK;
+  for (i = 0; i < iovcnt; i++) {
+	if (iov[i].iov_len == 0) continue;
+
+	if (S_ISREG(vp->v_mode)) {
+		r = req_readwrite(vp->v_fs_e, vp->v_inode_nr, position,
+			rw_flag, who_e, iov[i].iov_base, iov[i].iov_len,
+			new_posp, &cum_io_incr);
+		if (probe) {
+			/* Only the vectored request was refused */
+			if (r == OK) vmp->m_flags |= VMNT_NOVECTOR;
+			probe = FALSE;
+		}
+	} else {
+		lock_bsf();
+		r = req_breadwrite(vp->v_bfs_e, who_e, vp->v_sdev, position,
+			iov[i].iov_len, iov[i].iov_base, rw_flag, new_posp,
+			&cum_io_incr);
+		unlock_bsf();
+	}
+	if (r != OK) break;
+
+	position = *new_posp;
+	cum_io += cum_io_incr;
+	if (cum_io_incr < iov[i].iov_len) break;
+  }
+
+  *new_posp = position;
+  *cum_iop = cum_io;
+
+  return(cum_io > 0 ? OK : r);
+}
+
 /*===========================================================================*
  *				read_write				     *
  *===========================================================================*/
 int read_write(int rw_flag, struct filp *f, char *buf, size_t size,
 		      endpoint_t for_e)
+{
+/* Read or write at the file position, and advance it */
+  u64_t position;
+  int r;
+
+  position = f->filp_pos;
+  r = read_write_pos(rw_flag, f, buf, size, for_e, &position);
+  f->filp_pos = position;
+
+  return(r);
+}
+
+/*===========================================================================*
+ *				read_write_pos				     *
+ *===========================================================================*/
+static int read_write_pos(int rw_flag, struct filp *f, char *buf, size_t
+	size, endpoint_t for_e, u64_t *posp)
 {
   register struct vnode *vp;
   u64_t position, res_pos, new_pos;
   unsigned int cum_io, cum_io_incr, res_cum_io;
   int op, r;
 
-  position = f->filp_pos;
+  position = *posp;
   vp = f->filp_vno;
   r = OK;
   cum_io = 0;
@@ -189,10 +469,12 @@ int read_write(int rw_flag, struct filp *f, char *buf, size_t size,
 	}
 
 	/* Issue request */
-	r = req_readwrite(vp->v_fs_e, vp->v_inode_nr, position, rw_flag, for_e,
-			  buf, size, &new_pos, &cum_io_incr);
-
-	if (r >= 0) {
+	if (ex64hi(position) != 0) {
+		/* The file servers cannot handle such positions */
+		if (rw_flag == WRITING) r = EFBIG;
+	} else if ((r = req_readwrite(vp->v_fs_e, vp->v_inode_nr, position,
+			rw_flag, for_e, buf, size, &new_pos,
+			&cum_io_incr)) >= 0) {
 		if (ex64hi(new_pos))
 			panic("read_write: bad new pos");
 
@@ -202,7 +484,7 @@ int read_write(int rw_flag, struct filp *f, char *buf, size_t size,
   }
 
   /* On write, update file size and access time. */
-  if (rw_flag == WRITING) {
+  if (rw_flag == WRITING && r == OK) {
 	if (S_ISREG(vp->v_mode) || S_ISDIR(vp->v_mode)) {
 		if (cmp64ul(position, vp->v_size) > 0) {
 			if (ex64hi(position) != 0) {
@@ -213,7 +495,7 @@ int read_write(int rw_flag, struct filp *f, char *buf, size_t size,
 	}
   }
 
-  f->filp_pos = position;
+  *posp = position;
 
   if (r == EPIPE && rw_flag == WRITING) {
 	/* Process is writing, but there is no reader. Tell the kernel to
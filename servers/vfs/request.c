@@ -11,6 +11,7 @@
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/statvfs.h>
+#include <sys/uio.h>
 #include <minix/vfsif.h>
 #include <minix/com.h>
 #include <minix/const.h>
@@ -819,6 +820,78 @@ unsigned int *cum_iop;
 }
 
 
+/*===========================================================================*
+ *				req_readwritev				     *
+ *===========================================================================*/
+int req_readwritev(fs_e, inode_nr, pos, rw_flag, user_e, iov, iovcnt,
+	new_posp, cum_iop)
+endpoint_t fs_e;
+ino_t inode_nr;
+u64_t pos;
+int rw_flag;
+endpoint_t user_e;
+struct iovec *iov;
+int iovcnt;
+u64_t *new_posp;
+unsigned int *cum_iop;
+{
+/* Like req_readwrite, but for a vector of user buffers. The FS gets a grant
+ * for each buffer, and a grant for the array holding those grants.
+ */
+  int r, i, grantflag;
+  cp_grant_id_t grant_id;
+  iovec_s_t giov[NR_IOREQS];
+  unsigned int num_of_bytes;
+  message m;
+
+  if (ex64hi(pos) != 0)
+	  panic("req_readwritev: pos too large");
+
+  assert(rw_flag == READING || rw_flag == WRITING);
+  assert(iovcnt > 0 && iovcnt <= NR_IOREQS);
+
+  grantflag = (rw_flag == READING ? CPF_WRITE : CPF_READ);
+
+  num_of_bytes = 0;
+  for (i = 0; i < iovcnt; i++) {
+	giov[i].iov_grant = cpf_grant_magic(fs_e, user_e,
+		(vir_bytes) iov[i].iov_base, iov[i].iov_len, grantflag);
+	if (giov[i].iov_grant == -1)
+		panic("req_readwritev: cpf_grant_magic failed");
+	giov[i].iov_size = iov[i].iov_len;
+	num_of_bytes += iov[i].iov_len;
+  }
+
+  grant_id = cpf_grant_direct(fs_e, (vir_bytes) giov,
+	iovcnt * sizeof(giov[0]), CPF_READ);
+  if (grant_id == -1)
+	panic("req_readwritev: cpf_grant_direct failed");
+
+  /* Fill in request message */
+  m.m_type = (rw_flag == READING ? REQ_READV : REQ_WRITEV);
+  m.REQ_INODE_NR = inode_nr;
+  m.REQ_GRANT = grant_id;
+  m.REQ_IOVCNT = iovcnt;
+  m.REQ_SEEK_POS_LO = ex64lo(pos);
+  m.REQ_SEEK_POS_HI = 0;	/* Not used for now, so clear it. */
+  m.REQ_NBYTES = num_of_bytes;
+
+  /* Send/rec request */
+  r = fs_sendrec(fs_e, &m);
+  cpf_revoke(grant_id);
+  for (i = 0; i < iovcnt; i++)
+	cpf_revoke(giov[i].iov_grant);
+
+  if (r == OK) {
+	/* Fill in response structure */
+	*new_posp = cvul64(m.RES_SEEK_POS_LO);
+	*cum_iop = m.RES_NBYTES;
+  }
+
+  return(r);
+}
+
+
 /*===========================================================================*
  *				req_rename	     			     *
  *===========================================================================*/
@@ -4,6 +4,12 @@
  *   do_select:	       perform the SELECT system call
  *   select_callback:  notify select system of possible fd operation
  *   select_unsuspend_by_endpt: cancel a blocking select on exiting driver
+ *
+ * The kqueue code in event.c shares the per-filp select state, and uses
+ *   select_filp_type:   find the select type of a filp
+ *   select_filp_request: send a (blocking) select request for a filp
+ *   select_note_ready:  record that a filp reported ready operations
+ *   select_cancel_filp: reduce the number of select users of a filp
  */
 
 #include "fs.h"
@@ -58,7 +64,6 @@ static int select_request_major(struct filp *f, int *ops, int block);
 static int select_request_pipe(struct filp *f, int *ops, int block);
 static int select_request_sync(struct filp *f, int *ops, int block);
 static void select_cancel_all(struct selectentry *e);
-static void select_cancel_filp(struct filp *f);
 static void select_return(struct selectentry *);
 static void select_restart_filps(void);
 static int tab2ops(int fd, struct selectentry *e);
@@ -611,7 +616,7 @@ static void select_cancel_all(struct selectentry *se)
 /*===========================================================================*
  *				select_cancel_filp			     *
  *===========================================================================*/
-static void select_cancel_filp(struct filp *f)
+void select_cancel_filp(struct filp *f)
 {
 /* Reduce number of select users of this filp */
 
@@ -664,6 +669,64 @@ void select_callback(struct filp *f, int status)
   filp_status(f, status);
 }
 
+/*===========================================================================*
+ *				select_filp_type			     *
+ *===========================================================================*/
+int select_filp_type(struct filp *f)
+{
+/* Return the select type of a locked filp, or -1 if it cannot be selected on */
+  unsigned int type;
+
+  for (type = 0; type < SEL_FDS; type++)
+	if (fdtypes[type].type_match(f))
+		return(type);
+
+  return(-1);
+}
+
+/*===========================================================================*
+ *				select_filp_request			     *
+ *===========================================================================*/
+int select_filp_request(struct filp *f, int type, int *ops, int block)
+{
+/* Perform a select request on a filp of the given type. Like
+ * do_select_request, but for callers without a select table entry. */
+  int r;
+
+  select_lock_filp(f, *ops);
+  r = fdtypes[type].select_request(f, ops, block);
+  unlock_filp(f);
+
+  return(r);
+}
+
+/*===========================================================================*
+ *				select_note_ready			     *
+ *===========================================================================*/
+void select_note_ready(struct filp *f, int status)
+{
+/* A secondary DEV_SELECT reply for the device of this filp came in. Update the
+ * select state of the filp accordingly. */
+
+  select_lock_filp(f, f->filp_select_ops);
+  if (status > 0) {	/* Operations ready */
+	/* Clear the replied bits from the request mask unless FSF_UPDATE is
+	 * set.
+	 */
+	if (!(f->filp_select_flags & FSF_UPDATE))
+		f->filp_select_ops &= ~status;
+	if (status & SEL_RD)
+		f->filp_select_flags &= ~FSF_RD_BLOCK;
+	if (status & SEL_WR)
+		f->filp_select_flags &= ~FSF_WR_BLOCK;
+	if (status & SEL_ERR)
+		f->filp_select_flags &= ~FSF_ERR_BLOCK;
+  } else {
+	f->filp_select_flags &= ~FSF_BLOCKED;
+  }
+  unlock_filp(f);
+}
+
 /*===========================================================================*
  *				init_select  				     *
  *===========================================================================*/
@@ -687,6 +750,8 @@ void select_forget(endpoint_t proc_e)
   int slot;
   struct selectentry *se;
 
+  kqueue_forget(proc_e);	/* The process may be blocked in kevent() */
+
   for (slot = 0; slot < MAXSELECTS; slot++) {
 	se = &selecttab[slot];
 	if (se->requestor != NULL && se->req_endpt == proc_e)
@@ -759,6 +824,8 @@ void select_unsuspend_by_endpt(endpoint_t proc_e)
 	if (wakehim && !is_deferred(se))
 		select_return(se);
   }
+
+  kqueue_unsuspend_by_endpt(proc_e);
 }
 
 /*===========================================================================*
@@ -896,30 +963,18 @@ int status;
 		if (!S_ISCHR(vp->v_mode)) continue;
 		if (vp->v_sdev != dev) continue;
 
-		select_lock_filp(f, f->filp_select_ops);
-		if (status > 0) {	/* Operations ready */
-			/* Clear the replied bits from the request
-			 * mask unless FSF_UPDATE is set.
-			 */
-			if (!(f->filp_select_flags & FSF_UPDATE))
-				f->filp_select_ops &= ~status;
-			if (status & SEL_RD)
-				f->filp_select_flags &= ~FSF_RD_BLOCK;
-			if (status & SEL_WR)
-				f->filp_select_flags &= ~FSF_WR_BLOCK;
-			if (status & SEL_ERR)
-				f->filp_select_flags &= ~FSF_ERR_BLOCK;
-
+		select_note_ready(f, status);
+		if (status > 0)
 			ops2tab(status, fd, se);
-		} else {
-			f->filp_select_flags &= ~FSF_BLOCKED;
+		else
 			ops2tab(SEL_RD|SEL_WR|SEL_ERR, fd, se);
-		}
-		unlock_filp(f);
 		if (se->nreadyfds > 0) restart_proc(se);
 	}
   }
 
+  /* Let kqueues watching this device know as well */
+  kqueue_dev_status(dev, status);
+
   select_restart_filps();
 }
 
@@ -963,6 +1018,8 @@ static void select_restart_filps()
 		if (wantops & ops) ops2tab(wantops, fd, se);
 	}
   }
+
+  kqueue_restart_filps();
 }
 
 /*===========================================================================*
@@ -1016,6 +1073,8 @@ int status;
 		restart_proc(se);
 	}
   }
+
+  kqueue_filp_status(f, status);
 }
 
 /*===========================================================================*
@@ -84,8 +84,8 @@ int (*call_vec[])(void) = {
 	do_fstat, 	/* 66 = fstat - badly numbered, being phased out */
 	do_lstat,	/* 67 = lstat - badly numbered, being phased out */
 	no_sys,		/* 68 = (setmcontext) */
-	no_sys,		/* 69 = unused  */
-	no_sys,		/* 70 = unused  */
+	do_kqueue,	/* 69 = kqueue	*/
+	do_kevent,	/* 70 = kevent	*/
 	no_sys,		/* 71 = (sigaction) */
 	no_sys,		/* 72 = (sigsuspend) */
 	no_sys,		/* 73 = (sigpending) */
@@ -94,7 +94,7 @@ int (*call_vec[])(void) = {
 	no_sys,		/* 76 = (reboot) */
 	do_svrctl,	/* 77 = svrctl */
 	no_sys,		/* 78 = (sysuname) */
-	no_sys,		/* 79 = unused */
+	do_pread,	/* 79 = pread */
 	do_getdents,	/* 80 = getdents */
 	do_llseek,	/* 81 = llseek */
 	do_fstatfs,	/* 82 = fstatfs */
@@ -112,19 +112,19 @@ int (*call_vec[])(void) = {
 	do_ftruncate,	/* 94 = truncate */
 	do_chmod,	/* 95 = fchmod */
 	do_chown,	/* 96 = fchown */
-	no_sys,		/* 97 = unused */
+	do_pwrite,	/* 97 = pwrite */
 	no_sys,		/* 98 = (sprofile) */
 	no_sys,		/* 99 = (cprofile) */
 	no_sys,		/* 100 = (newexec) */
 	no_sys,		/* 101 = (srv_fork) */
 	no_sys,		/* 102 = (exec_restart) */
-	no_sys,		/* 103 = unused */
+	no_sys,		/* 103 = (ipctrace) */
 	no_sys,		/* 104 = (getprocnr) */
 	no_sys,		/* 105 = unused */
 	no_sys,		/* 106 = unused */
 	no_sys,		/* 107 = (getepinfo) */
-	no_sys,		/* 108 = unused */
-	no_sys,		/* 109 = unused */
+	do_readv,	/* 108 = readv */
+	do_writev,	/* 109 = writev */
 	no_sys,		/* 110 = unused */
 	no_sys,		/* 111 = (srv_kill) */
 	do_gcov_flush,	/* 112 = gcov_flush */
@@ -22,6 +22,7 @@ EXTERN struct vmnt {
 #define VMNT_CALLBACK		02	/* FS did back call */
 #define VMNT_MOUNTING		04	/* Device is being mounted */
 #define VMNT_FORCEROOTBSF	010	/* Force usage of none-device */
+#define VMNT_NOVECTOR		020	/* FS does not do REQ_READV/REQ_WRITEV */
 
 /* vmnt lock types mapping */
 #define VMNT_READ TLL_READ
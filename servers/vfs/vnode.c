@@ -95,6 +95,7 @@ struct vnode *get_free_vnode()
 		vp->v_mapfs_e = NONE;
 		vp->v_mapfs_count = 0;
 		vp->v_mapinode_nr = 0;
+		vp->v_pipe_size = PIPE_SIZE;
 		return(vp);
 	}
   }
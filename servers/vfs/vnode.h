@@ -10,6 +10,7 @@ EXTERN struct vnode {
   uid_t v_uid;			/* uid of inode. */
   gid_t v_gid;			/* gid of inode. */
   off_t v_size;			/* current file size in bytes */
+  off_t v_pipe_size;		/* capacity if the vnode is a pipe */
   int v_ref_count;		/* # times vnode used; 0 means slot is free */
   int v_fs_count;		/* # reference at the underlying FS */
   int v_mapfs_count;		/* # reference at the underlying mapped FS */
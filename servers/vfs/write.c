@@ -3,6 +3,8 @@
  *
  * The entry points into this file are
  *   do_write:     call read_write to perform the WRITE system call
+ *   do_pwrite:    perform the PWRITE system call
+ *   do_writev:    perform the WRITEV system call
  */
 
 #include "fs.h"
@@ -19,3 +21,24 @@ int do_write()
   return(do_read_write_peek(WRITING, job_m_in.fd,
   	job_m_in.buffer, (size_t) job_m_in.nbytes));
 }
+
+
+/*===========================================================================*
+ *				do_pwrite				     *
+ *===========================================================================*/
+int do_pwrite()
+{
+/* Perform the pwrite(fd, buffer, nbytes, position) system call. */
+  return(do_pread_pwrite(WRITING));
+}
+
+
+/*===========================================================================*
+ *				do_writev				     *
+ *===========================================================================*/
+int do_writev()
+{
+/* Perform the writev(fd, iov, iovcnt) or pwritev(fd, iov, iovcnt, position)
+ * system call. */
+  return(do_readv_writev(WRITING));
+}
@@ -0,0 +1,100 @@
+/*	$NetBSD: event.h,v 1.23 2011/06/26 16:43:12 christos Exp $	*/
+
+/*-
+ * Copyright (c) 1999,2000,2001 Jonathan Lemon <jlemon@FreeBSD.org>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ *	$FreeBSD: src/sys/sys/event.h,v 1.12 2001/02/24 01:44:03 jlemon Exp $
+ */
+
+#ifndef _SYS_EVENT_H_
+#define	_SYS_EVENT_H_
+
+#include <sys/featuretest.h>
+#include <sys/types.h>			/* for size_t */
+#include <sys/inttypes.h>		/* for uintptr_t */
+
+#define	EVFILT_READ		0U
+#define	EVFILT_WRITE		1U
+#ifndef __minix
+#define	EVFILT_AIO		2U	/* attached to aio requests */
+#define	EVFILT_VNODE		3U	/* attached to vnodes */
+#define	EVFILT_PROC		4U	/* attached to struct proc */
+#define	EVFILT_SIGNAL		5U	/* attached to struct proc */
+#define	EVFILT_TIMER		6U	/* arbitrary timer (in ms) */
+#define	EVFILT_SYSCOUNT		7U	/* number of filters */
+#else /* __minix */
+#define	EVFILT_SYSCOUNT		2U	/* number of filters */
+#endif /* __minix */
+
+#define	EV_SET(kevp, a, b, c, d, e, f)					\
+do {									\
+	(kevp)->ident = (a);						\
+	(kevp)->filter = (b);						\
+	(kevp)->flags = (c);						\
+	(kevp)->fflags = (d);						\
+	(kevp)->data = (e);						\
+	(kevp)->udata = (f);						\
+} while (/* CONSTCOND */ 0)
+
+struct kevent {
+	uintptr_t	ident;		/* identifier for this event */
+	uint32_t	filter;		/* filter for event */
+	uint32_t	flags;		/* action flags for kqueue */
+	uint32_t	fflags;		/* filter flag value */
+	int64_t		data;		/* filter data value */
+	intptr_t	udata;		/* opaque user data identifier */
+};
+
+/* actions */
+#define	EV_ADD		0x0001		/* add event to kq (implies ENABLE) */
+#define	EV_DELETE	0x0002		/* delete event from kq */
+#define	EV_ENABLE	0x0004		/* enable event */
+#define	EV_DISABLE	0x0008		/* disable event (not reported) */
+
+/* flags */
+#define	EV_ONESHOT	0x0010		/* only report one occurrence */
+#define	EV_CLEAR	0x0020		/* clear event state after reporting */
+#define	EV_DISPATCH	0x0080		/* disable event after reporting */
+
+#define	EV_SYSFLAGS	0xF000		/* reserved by system */
+#define	EV_FLAG1	0x2000		/* filter-specific flag */
+
+/* returned values */
+#define	EV_EOF		0x8000		/* EOF detected */
+#define	EV_ERROR	0x4000		/* error, data contains errno */
+
+#ifndef _KERNEL
+
+struct timespec;
+
+__BEGIN_DECLS
+int	kqueue(void);
+int	kevent(int, const struct kevent *, size_t, struct kevent *, size_t,
+		    const struct timespec *);
+__END_DECLS
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_EVENT_H_ */
@@ -131,6 +131,10 @@
 #if defined(_NETBSD_SOURCE)
 #define F_GETNOSIGPIPE     9
 #define F_SETNOSIGPIPE    10
+#ifdef __minix
+#define F_GETPIPE_SZ      11	/* get the capacity of a pipe */
+#define F_SETPIPE_SZ      12	/* set the capacity of a pipe */
+#endif /* __minix */
 #endif
 
 /* File descriptor flags used for fcntl().  POSIX Table 6-2. */
@@ -35,8 +35,14 @@
 #define	_SYS_UIO_H_
 
 #include <machine/ansi.h>
+#include <sys/ansi.h>
 #include <sys/featuretest.h>
 
+#ifndef	off_t
+typedef	__off_t		off_t;	/* file offset */
+#define	off_t		__off_t
+#endif
+
 #ifdef	_BSD_SIZE_T_
 typedef	_BSD_SIZE_T_	size_t;
 #undef	_BSD_SIZE_T_
@@ -65,6 +71,10 @@ struct iovec {
 __BEGIN_DECLS
 ssize_t	readv(int, const struct iovec *, int);
 ssize_t	writev(int, const struct iovec *, int);
+#if defined(_NETBSD_SOURCE)
+ssize_t	preadv(int, const struct iovec *, int, off_t);
+ssize_t	pwritev(int, const struct iovec *, int, off_t);
+#endif /* _NETBSD_SOURCE */
 __END_DECLS
 
 #endif /* !_SYS_UIO_H_ */
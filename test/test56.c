@@ -77,6 +77,9 @@
 /* buffer for send/recv */
 #define BUFSIZE (128)
 
+/* largest send and receive buffer size */
+#define UDS_BUF_MAX (1024 * 1024)
+
 #define ISO8601_FORMAT "%Y-%m-%dT%H:%M:%S"
 
 /* socket types supported */
@@ -733,6 +736,10 @@ void test_sockopts(void)
 	int sd;
 	int option_value;
 	socklen_t option_len;
+	int socket_vector[2];
+	size_t size, total;
+	char *big;
+	char buf[BUFSIZE];
 
 	debug("entering test_sockopts()");
 
@@ -798,6 +805,179 @@ void test_sockopts(void)
 	CLOSE(sd);
 
 
+	debug("Test that larger buffers allow larger atomic writes");
+
+	rc = socketpair(PF_UNIX, SOCK_STREAM, 0, socket_vector);
+	if (rc == -1) {
+		test_fail("socketpair() should have worked");
+	}
+
+	size = 4 * PIPE_BUF;
+	rc = setsockopt(socket_vector[0], SOL_SOCKET, SO_SNDBUF, &size,
+								sizeof(size));
+	if (rc != 0) {
+		test_fail("setsockopt(SO_SNDBUF) should have worked");
+	}
+
+	rc = setsockopt(socket_vector[1], SOL_SOCKET, SO_RCVBUF, &size,
+								sizeof(size));
+	if (rc != 0) {
+		test_fail("setsockopt(SO_RCVBUF) should have worked");
+	}
+
+	size = 0;
+	option_len = sizeof(size);
+	rc = getsockopt(socket_vector[1], SOL_SOCKET, SO_RCVBUF, &size,
+								&option_len);
+	if (rc != 0 || size != 4 * PIPE_BUF) {
+		test_fail("SO_RCVBUF didn't seem to change.");
+	}
+
+	big = malloc(size);
+	if (big == NULL) {
+		test_fail("malloc() failed");
+	} else {
+		for (total = 0; total < size; total++)
+			big[total] = (char) total;
+
+		rc = write(socket_vector[0], big, size);
+		if (rc != (int) size) {
+			test_fail("write() should have written everything");
+		}
+
+		memset(big, '\0', size);
+		for (total = 0; total < size; total += rc) {
+			rc = read(socket_vector[1], big + total, size - total);
+			if (rc <= 0) {
+				test_fail("read() failed unexpectedly");
+				break;
+			}
+		}
+
+		for (total = 0; total < size; total++) {
+			if (big[total] != (char) total) {
+				test_fail("We did not read what we wrote");
+				break;
+			}
+		}
+
+		free(big);
+	}
+
+	debug("Test a full buffer of the largest size");
+
+	size = UDS_BUF_MAX;
+	rc = setsockopt(socket_vector[0], SOL_SOCKET, SO_SNDBUF, &size,
+								sizeof(size));
+	if (rc != 0) {
+		test_fail("setsockopt(SO_SNDBUF) should have worked");
+	}
+
+	rc = setsockopt(socket_vector[1], SOL_SOCKET, SO_RCVBUF, &size,
+								sizeof(size));
+	if (rc != 0) {
+		test_fail("setsockopt(SO_RCVBUF) should have worked");
+	}
+
+	big = malloc(size + 100);
+	if (big == NULL) {
+		test_fail("malloc() failed");
+	} else {
+		for (total = 0; total < size + 100; total++)
+			big[total] = (char) (total % 251);
+
+		/* move the start of the data into the middle of a page, so
+		 * that filling the buffer wraps around to that page
+		 */
+		rc = write(socket_vector[0], big, 100);
+		if (rc != 100) {
+			test_fail("write() should have worked");
+		}
+
+		rc = read(socket_vector[1], buf, 50);
+		if (rc != 50) {
+			test_fail("read() should have worked");
+		}
+
+		rc = write(socket_vector[0], big + 100, size - 50);
+		if (rc != (int) (size - 50)) {
+			test_fail("write() should have filled the buffer");
+		}
+
+		memset(big, '\0', size);
+		for (total = 0; total < size; total += rc) {
+			rc = read(socket_vector[1], big + total, size - total);
+			if (rc <= 0) {
+				test_fail("read() failed unexpectedly");
+				break;
+			}
+		}
+
+		for (total = 0; total < size; total++) {
+			if (big[total] != (char) ((total + 50) % 251)) {
+				test_fail("We did not read what we wrote");
+				break;
+			}
+		}
+
+		free(big);
+	}
+
+	size = 1024 * 1024 * 1024;
+	rc = setsockopt(socket_vector[0], SOL_SOCKET, SO_SNDBUF, &size,
+								sizeof(size));
+	if (!(rc == -1 && errno == ENOBUFS)) {
+		test_fail("setsockopt(SO_SNDBUF) should have failed");
+	}
+
+	CLOSE(socket_vector[0]);
+	CLOSE(socket_vector[1]);
+
+
+	debug("Test that message boundaries survive the buffer");
+
+	rc = socketpair(PF_UNIX, SOCK_SEQPACKET, 0, socket_vector);
+	if (rc == -1) {
+		test_fail("socketpair() should have worked");
+	}
+
+	rc = write(socket_vector[0], "abc", 3);
+	if (rc != 3) {
+		test_fail("write() should have worked");
+	}
+
+	rc = write(socket_vector[0], "de", 2);
+	if (rc != 2) {
+		test_fail("write() should have worked");
+	}
+
+	/* the rest of a message that doesn't fit is discarded */
+	rc = read(socket_vector[1], buf, 2);
+	if (rc != 2 || strncmp(buf, "ab", 2) != 0) {
+		test_fail("read() should have returned the first message");
+	}
+
+	rc = read(socket_vector[1], buf, sizeof(buf));
+	if (rc != 2 || strncmp(buf, "de", 2) != 0) {
+		test_fail("read() should have returned the second message");
+	}
+
+	size = PIPE_BUF;
+	big = malloc(size + 1);
+	if (big == NULL) {
+		test_fail("malloc() failed");
+	} else {
+		rc = write(socket_vector[0], big, size + 1);
+		if (!(rc == -1 && errno == EMSGSIZE)) {
+			test_fail("write() should have failed with EMSGSIZE");
+		}
+		free(big);
+	}
+
+	CLOSE(socket_vector[0]);
+	CLOSE(socket_vector[1]);
+
+
 	debug("leaving test_sockopts()");
 }
 
@@ -1,16 +1,20 @@
-/* Test 69. clock_getres(), clock_gettime(), clock_settime(), adjtime().
+/* Test 69. clock_getres(), clock_gettime(), clock_settime(), adjtime(),
+ * gettimeofday().
  *
  * Note, any type of ntpd or software that calls adjtime() or settimeofday()
- * should be disabled while running this test. This test takes ~40s to run.
+ * should be disabled while running this test. This test takes ~45s to run.
  */
 
 #include <time.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <minix/u64.h>
+#include <minix/minlib.h>
 
 #define TRIALS 100
 #define MAX_ERROR 4
@@ -26,6 +30,8 @@ int main(void);
 void quit(void);
 static void test_clock_getres();
 static void test_clock_gettime();
+static void test_clock_steps();
+static void test_clock_idle();
 static void test_clock_settime();
 static void test_adjtime();
 static void show_timespec(char *msg, struct timespec *ts);
@@ -70,6 +76,93 @@ static void test_clock_gettime()
   if (clock_gettime(-1, &ts) == 0) e(31);
 }
 
+static void test_clock_steps()
+{
+  struct timespec ts, ts2;
+  struct timeval tv;
+  int i;
+
+  /* back to back reads never go backwards, even within a clock tick */
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1) e(35);
+  for (i = 0; i < TRIALS * 100; i++) {
+	if (clock_gettime(CLOCK_MONOTONIC, &ts2) == -1) e(36);
+	if (ts2.tv_nsec < 0 || ts2.tv_nsec >= 1000000000) e(37);
+	if (ts2.tv_sec < ts.tv_sec ||
+	    (ts2.tv_sec == ts.tv_sec && ts2.tv_nsec < ts.tv_nsec)) e(38);
+	ts = ts2;
+  }
+
+  /* gettimeofday() and CLOCK_REALTIME tell the same time */
+  if (clock_gettime(CLOCK_REALTIME, &ts) == -1) e(39);
+  if (gettimeofday(&tv, NULL) == -1) e(40);
+  if (tv.tv_usec < 0 || tv.tv_usec >= 1000000) e(41);
+  if (tv.tv_sec < ts.tv_sec || tv.tv_sec > ts.tv_sec + 1) e(42);
+}
+
+static long elapsed_ms(struct timespec *from, struct timespec *to)
+{
+  return (to->tv_sec - from->tv_sec) * 1000 +
+	(to->tv_nsec - from->tv_nsec) / 1000000;
+}
+
+static int cpu_mhz(void)
+{
+/* Get the frequency of the cycle counter, or 0 if it is not known */
+  FILE *fp;
+  char line[80];
+  int mhz = 0;
+
+  if ((fp = fopen("/proc/cpuinfo", "r")) == NULL) return(0);
+  while (fgets(line, sizeof(line), fp) != NULL)
+	if (sscanf(line, "cpu MHz : %d", &mhz) == 1) break;
+  fclose(fp);
+  return(mhz);
+}
+
+static void test_clock_idle()
+{
+  struct timespec mono, mono2, real, real2;
+  u64_t tsc, tsc2;
+  long ms, cycle_ms;
+  int i, mhz;
+
+  /* While everything sleeps, the clock may stop ticking; the time that
+   * passed must be accounted for when it wakes up again.
+   */
+  for (i = 0; i < 4; i++) {
+	if (clock_gettime(CLOCK_MONOTONIC, &mono) == -1) e(45);
+	if (usleep(250000) != 0) e(46);
+	if (clock_gettime(CLOCK_MONOTONIC, &mono2) == -1) e(47);
+	ms = elapsed_ms(&mono, &mono2);
+	if (ms < 240 || ms > 1250) e(48);
+  }
+
+  mhz = cpu_mhz();
+  read_tsc_64(&tsc);
+  if (clock_gettime(CLOCK_MONOTONIC, &mono) == -1) e(49);
+  if (clock_gettime(CLOCK_REALTIME, &real) == -1) e(50);
+  sleep(3);
+  if (clock_gettime(CLOCK_MONOTONIC, &mono2) == -1) e(51);
+  if (clock_gettime(CLOCK_REALTIME, &real2) == -1) e(52);
+  read_tsc_64(&tsc2);
+
+  ms = elapsed_ms(&mono, &mono2);
+  if (ms < 2990 || ms > 5000) e(53);
+
+  /* The clock must not merely agree with itself. The cycle counter runs on
+   * while the clock does not tick, so a clock that did not catch up after
+   * waking up falls behind it.
+   */
+  if (mhz > 0) {
+	cycle_ms = (long) ((tsc2 - tsc) / ((u64_t) mhz * 1000));
+	if (ms < cycle_ms - 100 || ms > cycle_ms + 100) e(44);
+  }
+
+  /* wall time was carried along */
+  ms -= elapsed_ms(&real, &real2);
+  if (ms < -1000 || ms > 1000) e(54);
+}
+
 static void test_clock_settime(void)
 {
   struct timespec ts;
@@ -157,6 +250,8 @@ int main()
 
   test_clock_getres();
   test_clock_gettime();
+  test_clock_steps();
+  test_clock_idle();
   test_clock_settime();
   test_adjtime();
 
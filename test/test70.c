@@ -0,0 +1,241 @@
+/* Test 70. kqueue(), kevent().
+ *
+ * Watch pipes for reading and writing through a kqueue, and check that
+ * changes, errors, one-shot events, timeouts and blocking waits behave.
+ */
+
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+
+int subtest = 1;
+
+#include "common.c"
+
+int main(void);
+static void test_kqueue_basic(void);
+static void test_kqueue_errors(void);
+static void test_kqueue_oneshot(void);
+static void test_kqueue_wait(void);
+
+static struct timespec zero_ts = { 0, 0 };
+
+static void test_kqueue_basic(void)
+{
+  struct kevent kev[4];
+  int kq, fds[2], r;
+  char c = 'k';
+
+  subtest = 1;
+
+  if ((kq = kqueue()) < 0) e(1);
+  if (pipe(fds) != 0) e(2);
+
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ADD, 0, 0, 10);
+  EV_SET(&kev[1], fds[1], EVFILT_WRITE, EV_ADD, 0, 0, 11);
+  if (kevent(kq, kev, 2, NULL, 0, NULL) != 0) e(3);
+
+  /* Only the write end is ready */
+  r = kevent(kq, NULL, 0, kev, 4, &zero_ts);
+  if (r != 1) e(4);
+  if (kev[0].ident != (uintptr_t) fds[1] || kev[0].filter != EVFILT_WRITE)
+	e(5);
+  if (kev[0].udata != 11) e(6);
+
+  /* Now the read end is ready as well */
+  if (write(fds[1], &c, 1) != 1) e(7);
+  r = kevent(kq, NULL, 0, kev, 4, &zero_ts);
+  if (r != 2) e(8);
+  if (kev[0].filter == kev[1].filter) e(9);
+  if (kev[0].filter == EVFILT_READ && kev[0].udata != 10) e(10);
+  if (kev[1].filter == EVFILT_READ && kev[1].udata != 10) e(11);
+
+  /* Events are level-triggered: they stay until the data is read */
+  r = kevent(kq, NULL, 0, kev, 4, &zero_ts);
+  if (r != 2) e(12);
+  if (read(fds[0], &c, 1) != 1) e(13);
+  r = kevent(kq, NULL, 0, kev, 4, &zero_ts);
+  if (r != 1) e(14);
+  if (kev[0].filter != EVFILT_WRITE) e(15);
+
+  /* A smaller event list gets the rest on the next call */
+  if (write(fds[1], &c, 1) != 1) e(16);
+  if (kevent(kq, NULL, 0, kev, 1, &zero_ts) != 1) e(17);
+  if (kevent(kq, NULL, 0, &kev[1], 1, &zero_ts) != 1) e(18);
+  if (kev[0].filter == kev[1].filter) e(19);
+  if (read(fds[0], &c, 1) != 1) e(20);
+
+  /* Deleted and disabled events are no longer reported */
+  EV_SET(&kev[0], fds[1], EVFILT_WRITE, EV_DELETE, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != 0) e(21);
+  if (kevent(kq, NULL, 0, kev, 4, &zero_ts) != 0) e(22);
+
+  if (write(fds[1], &c, 1) != 1) e(23);
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_DISABLE, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != 0) e(24);
+  if (kevent(kq, NULL, 0, kev, 4, &zero_ts) != 0) e(25);
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ENABLE, 0, 0, 0);
+  if (kevent(kq, kev, 1, kev, 4, &zero_ts) != 1) e(26);
+  if (kev[0].filter != EVFILT_READ) e(27);
+
+  if (close(kq) != 0) e(28);
+  if (close(fds[0]) != 0) e(29);
+  if (close(fds[1]) != 0) e(30);
+}
+
+static void test_kqueue_errors(void)
+{
+  struct kevent kev[2];
+  struct stat st;
+  int kq, fds[2];
+
+  subtest = 2;
+
+  if ((kq = kqueue()) < 0) e(1);
+  if (pipe(fds) != 0) e(2);
+
+  /* kevent() only works on kqueues */
+  if (kevent(fds[0], NULL, 0, kev, 2, &zero_ts) != -1) e(3);
+  if (errno != EBADF) e(4);
+
+  /* Without room in the event list, a bad change fails the call */
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_DELETE, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != -1) e(5);
+  if (errno != ENOENT) e(6);
+
+  EV_SET(&kev[0], OPEN_MAX - 1, EVFILT_READ, EV_ADD, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != -1) e(7);
+  if (errno != EBADF) e(8);
+
+  /* With room, it is reported as an EV_ERROR event */
+  EV_SET(&kev[0], OPEN_MAX - 1, EVFILT_READ, EV_ADD, 0, 0, 0);
+  EV_SET(&kev[1], fds[1], EVFILT_WRITE, EV_ADD, 0, 0, 0);
+  if (kevent(kq, kev, 2, kev, 2, &zero_ts) != 1) e(9);
+  if (!(kev[0].flags & EV_ERROR)) e(10);
+  if (kev[0].data != EBADF) e(11);
+  if (kev[0].ident != OPEN_MAX - 1) e(12);
+
+  /* Unknown filters and kqueues watching kqueues are not supported */
+  EV_SET(&kev[0], fds[0], 42, EV_ADD, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != -1) e(13);
+  if (errno != EINVAL) e(14);
+  EV_SET(&kev[0], kq, EVFILT_READ, EV_ADD, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != -1) e(15);
+  if (errno != EINVAL) e(16);
+
+  /* A kqueue cannot be written to */
+  if (write(kq, "x", 1) != -1) e(17);
+  if (errno != EBADF) e(18);
+
+  /* Nor is it taken for a pipe */
+  if (fstat(kq, &st) != 0) e(22);
+  if (S_ISFIFO(st.st_mode)) e(23);
+
+  if (close(kq) != 0) e(19);
+  if (close(fds[0]) != 0) e(20);
+  if (close(fds[1]) != 0) e(21);
+}
+
+static void test_kqueue_oneshot(void)
+{
+  struct kevent kev[2];
+  int kq, fds[2];
+  char c = 'o';
+
+  subtest = 3;
+
+  if ((kq = kqueue()) < 0) e(1);
+  if (pipe(fds) != 0) e(2);
+  if (write(fds[1], &c, 1) != 1) e(3);
+
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, 0);
+  if (kevent(kq, kev, 1, kev, 2, &zero_ts) != 1) e(4);
+  if (kev[0].filter != EVFILT_READ) e(5);
+  if (!(kev[0].flags & EV_ONESHOT)) e(6);
+
+  /* The event is gone after it was reported */
+  if (kevent(kq, NULL, 0, kev, 2, &zero_ts) != 0) e(7);
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_DELETE, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != -1) e(8);
+  if (errno != ENOENT) e(9);
+
+  /* Dispatched events are disabled after they were reported */
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ADD | EV_DISPATCH, 0, 0, 0);
+  if (kevent(kq, kev, 1, kev, 2, &zero_ts) != 1) e(10);
+  if (kevent(kq, NULL, 0, kev, 2, &zero_ts) != 0) e(11);
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ENABLE, 0, 0, 0);
+  if (kevent(kq, kev, 1, kev, 2, &zero_ts) != 1) e(12);
+
+  if (close(kq) != 0) e(13);
+  if (close(fds[0]) != 0) e(14);
+  if (close(fds[1]) != 0) e(15);
+}
+
+static void test_kqueue_wait(void)
+{
+  struct kevent kev[2];
+  struct timespec ts;
+  struct timeval start, end;
+  int kq, fds[2], status;
+  pid_t pid;
+  char c = 'w';
+
+  subtest = 4;
+
+  if ((kq = kqueue()) < 0) e(1);
+  if (pipe(fds) != 0) e(2);
+
+  EV_SET(&kev[0], fds[0], EVFILT_READ, EV_ADD, 0, 0, 0);
+  if (kevent(kq, kev, 1, NULL, 0, NULL) != 0) e(3);
+
+  /* Nothing happens; wait for the timeout */
+  ts.tv_sec = 0;
+  ts.tv_nsec = 500000000;
+  if (gettimeofday(&start, NULL) != 0) e(4);
+  if (kevent(kq, NULL, 0, kev, 2, &ts) != 0) e(5);
+  if (gettimeofday(&end, NULL) != 0) e(6);
+  if ((end.tv_sec - start.tv_sec) * 1000000 +
+      (end.tv_usec - start.tv_usec) < 400000) e(7);
+
+  /* Block until a child writes to the pipe */
+  if ((pid = fork()) < 0) e(8);
+  if (pid == 0) {
+	sleep(1);
+	if (write(fds[1], &c, 1) != 1) exit(1);
+	exit(0);
+  }
+
+  if (kevent(kq, NULL, 0, kev, 2, NULL) != 1) e(9);
+  if (kev[0].ident != (uintptr_t) fds[0] || kev[0].filter != EVFILT_READ)
+	e(10);
+  if (read(fds[0], &c, 1) != 1 || c != 'w') e(11);
+
+  if (waitpid(pid, &status, 0) != pid) e(12);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) e(13);
+
+  if (close(kq) != 0) e(14);
+  if (close(fds[0]) != 0) e(15);
+  if (close(fds[1]) != 0) e(16);
+}
+
+int main(void)
+{
+  start(70);
+
+  test_kqueue_basic();
+  test_kqueue_errors();
+  test_kqueue_oneshot();
+  test_kqueue_wait();
+
+  quit();
+  return(-1);			/* impossible */
+}
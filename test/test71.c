@@ -0,0 +1,229 @@
+/* Test 71. pread(), pwrite(), readv(), writev(), preadv(), pwritev().
+ *
+ * Check that positioned calls leave the file position alone, that vectors
+ * are split and gathered correctly on regular files, and that pipes still
+ * work through the vectored calls but refuse positioned ones.
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#define MAX_ERROR 4
+
+int subtest = 1;
+
+#include "common.c"
+
+#define TESTFILE	"test71.file"
+#define NVEC		100	/* more than one batch of vectors in VFS */
+
+int main(void);
+static void test_pread_pwrite(void);
+static void test_readv_writev(void);
+static void test_preadv_pwritev(void);
+static void test_pipe(void);
+
+static char buf[NVEC * 13], buf2[NVEC * 13];
+
+static void fill(char *b, size_t len, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < len; i++)
+	b[i] = (char) ((i * 7 + seed) & 0xff);
+}
+
+static void test_pread_pwrite(void)
+{
+  int fd;
+
+  subtest = 1;
+
+  if ((fd = open(TESTFILE, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) e(1);
+  fill(buf, 4096, 1);
+  if (write(fd, buf, 4096) != 4096) e(2);
+  if (lseek(fd, 100, SEEK_SET) != 100) e(3);
+
+  /* Positioned calls do not use or move the file position */
+  if (pread(fd, buf2, 1000, 2000) != 1000) e(4);
+  if (memcmp(buf2, buf + 2000, 1000) != 0) e(5);
+  if (lseek(fd, 0, SEEK_CUR) != 100) e(6);
+
+  fill(buf2, 500, 2);
+  if (pwrite(fd, buf2, 500, 3800) != 500) e(7);
+  if (lseek(fd, 0, SEEK_CUR) != 100) e(8);
+  if (lseek(fd, 0, SEEK_END) != 4300) e(9);
+  if (pread(fd, buf, 600, 3800) != 500) e(10);
+  if (memcmp(buf, buf2, 500) != 0) e(11);
+
+  /* Reading at or past the end returns nothing */
+  if (pread(fd, buf, 10, 4300) != 0) e(12);
+  if (pread(fd, buf, 10, 100000) != 0) e(13);
+
+  /* Zero bytes, bad positions and bad descriptors */
+  if (pread(fd, buf, 0, 0) != 0) e(14);
+  if (pread(fd, buf, 10, -1) != -1) e(15);
+  if (errno != EINVAL) e(16);
+  if (pwrite(fd, buf, 10, -1) != -1) e(17);
+  if (errno != EINVAL) e(18);
+  if (close(fd) != 0) e(19);
+  if (pread(fd, buf, 10, 0) != -1) e(20);
+  if (errno != EBADF) e(21);
+
+  /* Writing to a read-only file descriptor fails */
+  if ((fd = open(TESTFILE, O_RDONLY)) < 0) e(22);
+  if (pwrite(fd, buf, 10, 0) != -1) e(23);
+  if (errno != EBADF) e(24);
+  if (close(fd) != 0) e(25);
+
+  if (unlink(TESTFILE) != 0) e(26);
+}
+
+static void test_readv_writev(void)
+{
+  struct iovec iov[NVEC];
+  int fd, i;
+  size_t off;
+
+  subtest = 2;
+
+  if ((fd = open(TESTFILE, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) e(1);
+
+  /* Scatter buffers of different sizes, some of them empty */
+  fill(buf, sizeof(buf), 3);
+  for (i = 0, off = 0; i < NVEC; i++) {
+	iov[i].iov_base = buf + off;
+	iov[i].iov_len = (i % 5 == 0) ? 0 : (i % 13) + 1;
+	off += iov[i].iov_len;
+  }
+  if (writev(fd, iov, NVEC) != (ssize_t) off) e(2);
+  if (lseek(fd, 0, SEEK_CUR) != (off_t) off) e(3);
+
+  if (lseek(fd, 0, SEEK_SET) != 0) e(4);
+  if (read(fd, buf2, sizeof(buf2)) != (ssize_t) off) e(5);
+  if (memcmp(buf, buf2, off) != 0) e(6);
+
+  /* Gather it back in differently sized pieces */
+  memset(buf2, 0, sizeof(buf2));
+  for (i = 0; i < NVEC; i++) {
+	iov[i].iov_base = buf2 + i * 13;
+	iov[i].iov_len = 13;
+  }
+  if (lseek(fd, 0, SEEK_SET) != 0) e(7);
+  if (readv(fd, iov, NVEC) != (ssize_t) off) e(8);
+  if (memcmp(buf, buf2, off) != 0) e(9);
+  if (lseek(fd, 0, SEEK_CUR) != (off_t) off) e(10);
+
+  /* At end of file, nothing is read */
+  if (readv(fd, iov, NVEC) != 0) e(11);
+
+  /* Bad vectors */
+  if (readv(fd, iov, -1) != -1) e(12);
+  if (errno != EINVAL) e(13);
+  if (readv(fd, iov, IOV_MAX + 1) != -1) e(14);
+  if (errno != EINVAL) e(15);
+
+  if (close(fd) != 0) e(16);
+  if (unlink(TESTFILE) != 0) e(17);
+}
+
+static void test_preadv_pwritev(void)
+{
+  struct iovec iov[3];
+  int fd;
+
+  subtest = 3;
+
+  if ((fd = open(TESTFILE, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) e(1);
+  fill(buf, 8192, 4);
+  if (write(fd, buf, 8192) != 8192) e(2);
+  if (lseek(fd, 10, SEEK_SET) != 10) e(3);
+
+  /* A vector that crosses block boundaries in the middle of its buffers */
+  fill(buf2, 5000, 5);
+  iov[0].iov_base = buf2;
+  iov[0].iov_len = 1000;
+  iov[1].iov_base = buf2 + 1000;
+  iov[1].iov_len = 3000;
+  iov[2].iov_base = buf2 + 4000;
+  iov[2].iov_len = 1000;
+  if (pwritev(fd, iov, 3, 3000) != 5000) e(4);
+  if (lseek(fd, 0, SEEK_CUR) != 10) e(5);
+
+  memset(buf, 0, 5000);
+  iov[0].iov_base = buf + 3000;
+  iov[0].iov_len = 2000;
+  iov[1].iov_base = buf;
+  iov[1].iov_len = 1;
+  iov[2].iov_base = buf + 1;
+  iov[2].iov_len = 2999;
+  if (preadv(fd, iov, 3, 3000) != 5000) e(6);
+  if (memcmp(buf + 3000, buf2, 2000) != 0) e(7);
+  if (memcmp(buf, buf2 + 2000, 3000) != 0) e(8);
+  if (lseek(fd, 0, SEEK_CUR) != 10) e(9);
+
+  /* A short read at the end of the file */
+  if (preadv(fd, iov, 3, 7000) != 1192) e(10);
+
+  if (preadv(fd, iov, 3, -1) != -1) e(11);
+  if (errno != EINVAL) e(12);
+
+  if (close(fd) != 0) e(13);
+  if (unlink(TESTFILE) != 0) e(14);
+}
+
+static void test_pipe(void)
+{
+  struct iovec iov[2];
+  int fds[2];
+  char a[3], b[4];
+
+  subtest = 4;
+
+  if (pipe(fds) != 0) e(1);
+
+  /* Vectors on pipes still work */
+  iov[0].iov_base = "abc";
+  iov[0].iov_len = 3;
+  iov[1].iov_base = "defg";
+  iov[1].iov_len = 4;
+  if (writev(fds[1], iov, 2) != 7) e(2);
+
+  iov[0].iov_base = a;
+  iov[0].iov_len = sizeof(a);
+  iov[1].iov_base = b;
+  iov[1].iov_len = sizeof(b);
+  if (readv(fds[0], iov, 2) != 7) e(3);
+  if (memcmp(a, "abc", 3) != 0 || memcmp(b, "defg", 4) != 0) e(4);
+
+  /* But pipes cannot seek */
+  if (pwrite(fds[1], "x", 1, 0) != -1) e(5);
+  if (errno != ESPIPE) e(6);
+  if (pread(fds[0], a, 1, 0) != -1) e(7);
+  if (errno != ESPIPE) e(8);
+  if (preadv(fds[0], iov, 2, 0) != -1) e(9);
+  if (errno != ESPIPE) e(10);
+
+  if (close(fds[0]) != 0) e(11);
+  if (close(fds[1]) != 0) e(12);
+}
+
+int main(void)
+{
+  start(71);
+
+  test_pread_pwrite();
+  test_readv_writev();
+  test_preadv_pwritev();
+  test_pipe();
+
+  quit();
+  return(-1);			/* impossible */
+}
@@ -0,0 +1,331 @@
+/* Test 72. The timers library.
+ *
+ * Run the timing wheel of libtimers next to a reference queue, which is a
+ * plain list sorted by expiration time, and check that every timer fires on
+ * the tick it is due: not a tick early, not a tick late, and in the order of
+ * the reference list. Timers go on all levels of the wheel and beyond its
+ * reach, are set for the current tick or for ticks gone by, are cleared and
+ * set again, and set themselves again when they fire.
+ */
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <timers.h>
+
+#define MAX_ERROR 4
+
+int subtest = 1;
+
+#include "common.c"
+
+#define NR_TIMERS	1000
+#define SPAN		(1L << (TMRS_BITS * TMRS_LEVELS))	/* wheel reach */
+
+int main(void);
+static void test_levels(void);
+static void test_current(void);
+static void test_churn(void);
+
+/* The reference queue. A timer is due at its expiration time, or at the
+ * tick on which it was set if that time has already gone by.
+ */
+static struct ref {
+  struct ref *r_next;		/* next in the sorted list */
+  clock_t r_exp;		/* expiration time as set */
+  clock_t r_due;		/* tick on which it must fire */
+  int r_active;			/* set while in the list */
+  int r_rearm;			/* ticks ahead to set it again, or -1 */
+} ref[NR_TIMERS];
+
+static struct ref *ref_head;
+static timers_t queue;
+static timer_t timer[NR_TIMERS];
+static clock_t clock_now;	/* tick of the last tmrs_exptimers() */
+static clock_t call_now;	/* tick of the running tmrs_exptimers() */
+static int running, fired;
+
+static void expired(timer_t *tp);
+
+static void ref_remove(struct ref *rp)
+{
+  struct ref **rpp;
+
+  if (!rp->r_active) return;
+
+  for (rpp = &ref_head; *rpp != rp; rpp = &(*rpp)->r_next)
+	if (*rpp == NULL) e(900);
+  *rpp = rp->r_next;
+  rp->r_active = 0;
+}
+
+static void ref_insert(struct ref *rp, clock_t exp, clock_t now)
+{
+  struct ref **rpp;
+
+  ref_remove(rp);
+  rp->r_exp = exp;
+  rp->r_due = (exp < now ? now : exp);
+
+  /* Behind all timers due on the same tick */
+  for (rpp = &ref_head; *rpp != NULL && (*rpp)->r_due <= rp->r_due;
+	rpp = &(*rpp)->r_next)
+	;
+  rp->r_next = *rpp;
+  *rpp = rp;
+  rp->r_active = 1;
+}
+
+static clock_t ref_earliest(void)
+{
+  struct ref *rp;
+  clock_t head;
+
+  if (ref_head == NULL) return(0);
+
+  head = ref_head->r_exp;
+  for (rp = ref_head; rp != NULL; rp = rp->r_next)
+	if (rp->r_exp < head) head = rp->r_exp;
+  return(head);
+}
+
+static void set(int i, clock_t exp)
+{
+  clock_t old, head;
+
+  old = tmrs_settimer(&queue, &timer[i], exp, expired, &head);
+
+  /* While the wheel turns, its idea of the earliest timer is its own. Timers
+   * set by a watchdog are due no earlier than the tick being run.
+   */
+  if (!running && old != ref_earliest()) e(1);
+  ref_insert(&ref[i], exp, running ? call_now : clock_now);
+  if (!running && head != ref_earliest()) e(2);
+}
+
+static void clear(int i)
+{
+  clock_t old, head;
+
+  old = tmrs_clrtimer(&queue, &timer[i], &head);
+
+  if (old != ref_earliest()) e(3);
+  ref_remove(&ref[i]);
+  if (head != ref_earliest()) e(4);
+  if (*tmr_exp_time(&timer[i]) != TMR_NEVER) e(5);
+}
+
+static void expired(timer_t *tp)
+{
+  struct ref *rp;
+
+  rp = &ref[tp - timer];
+  fired++;
+
+  /* It must be active, due by now, and first in line */
+  if (!rp->r_active) e(10);
+  if (rp->r_due > call_now) e(11);
+  if (ref_head == NULL || rp->r_due != ref_head->r_due) e(12);
+  if (*tmr_exp_time(tp) != TMR_NEVER) e(13);
+  ref_remove(rp);
+
+  if (rp->r_rearm >= 0)
+	set(tp - timer, call_now + rp->r_rearm);
+  if (rp->r_rearm == 0)
+	rp->r_rearm = -1;	/* once, or it would never stop */
+}
+
+static void run(clock_t now)
+{
+  clock_t head;
+
+  call_now = now;
+  running = 1;
+  tmrs_exptimers(&queue, now, &head);
+  running = 0;
+  clock_now = now;
+
+  /* Nothing that is due may be left over */
+  if (ref_head != NULL && ref_head->r_due <= now) e(20);
+  if (head != ref_earliest()) e(21);
+}
+
+static void advance(clock_t until)
+{
+/* Move the clock on to 'until'. Skip the ticks on which nothing is due, as a
+ * tickless caller would, but stop on the tick before and the tick on which a
+ * timer is due, so that firing early or late is noticed.
+ */
+  clock_t due;
+
+  while (clock_now < until) {
+	due = (ref_head != NULL ? ref_head->r_due : until);
+	if (due > until) due = until;
+	if (due - 1 > clock_now) run(due - 1);
+	run(due > clock_now ? due : clock_now + 1);
+  }
+}
+
+static void reset(void)
+{
+  int i;
+
+  memset(&queue, 0, sizeof(queue));
+  for (i = 0; i < NR_TIMERS; i++) {
+	tmr_inittimer(&timer[i]);
+	ref[i].r_active = 0;
+	ref[i].r_rearm = -1;
+  }
+  ref_head = NULL;
+  clock_now = 0;
+}
+
+static void test_levels(void)
+{
+/* Timers around the edges of every level of the wheel, and past its reach */
+  static const long dist[] = { 1, 2, 30, 31, 32, 33, 63, 64, 65, 1023, 1024,
+	1025, 2047, 2048, 32767, 32768, 32769, 1048575, 1048576, 1048577,
+	33554431, 33554432, 33554433, SPAN - 1, SPAN, SPAN + 1, SPAN + 7 };
+  int i, n, start;
+
+  subtest = 1;
+
+  n = sizeof(dist) / sizeof(dist[0]);
+  for (start = 0; start < 3; start++) {
+	reset();
+
+	/* Start the wheel at an odd tick, so that levels turn at odd times */
+	run(start * 12345 + start);
+	fired = 0;
+
+	for (i = 0; i < n; i++)
+		set(i, clock_now + dist[i]);
+	for (i = 0; i < n; i++)		/* the same times again, reversed */
+		set(n + i, clock_now + dist[n - 1 - i]);
+
+	advance(clock_now + SPAN + 8);
+	if (fired != 2 * n) e(1);
+	if (ref_head != NULL) e(2);
+  }
+}
+
+static void test_current(void)
+{
+  int f;
+
+  subtest = 2;
+  reset();
+  run(100);
+
+  /* A timer for the current tick, or for one gone by, fires on the next
+   * run, even if the clock did not move.
+   */
+  set(0, clock_now);
+  set(1, clock_now - 50);
+  fired = 0;
+  run(clock_now);
+  if (fired != 2) e(1);
+
+  set(0, clock_now);
+  set(1, clock_now + 1);
+  fired = 0;
+  run(clock_now + 1);
+  if (fired != 2) e(2);
+
+  /* A watchdog that sets its timer for the tick being run fires again in
+   * the same run; one that sets it for the next tick does not.
+   */
+  ref[0].r_rearm = 0;
+  set(0, clock_now + 1);
+  ref[1].r_rearm = 1;
+  set(1, clock_now + 1);
+  fired = 0;
+  run(clock_now + 1);
+  if (fired != 3) e(3);
+  if (!ref[1].r_active) e(4);
+  ref[0].r_rearm = ref[1].r_rearm = -1;
+
+  /* A cleared timer does not fire; one set again fires at its new time */
+  set(2, clock_now + 40);
+  set(3, clock_now + 40);
+  clear(2);
+  set(3, clock_now + 2000);
+  f = fired;
+  advance(clock_now + 2001);
+  if (fired != f + 2) e(5);	/* timer 1 and timer 3 */
+  if (ref_head != NULL) e(6);
+
+  /* Clearing an inactive timer is harmless */
+  clear(2);
+}
+
+static void test_churn(void)
+{
+/* Many timers, set, cleared and set again at random, with the clock moving
+ * on by single ticks and by leaps.
+ */
+  int i, op;
+  long range;
+
+  subtest = 3;
+  reset();
+  srandom(72);
+
+  for (i = 0; i < NR_TIMERS; i++) {
+	if (i % 4 == 0) ref[i].r_rearm = random() % 100;
+	set(i, clock_now + random() % 5000);
+  }
+
+  for (op = 0; op < 200000; op++) {
+	switch (random() % 8) {
+	case 0: range = 2; break;
+	case 1: range = TMRS_SLOTS; break;
+	case 2: range = 70000; break;
+	case 3: range = SPAN / 4; break;
+	default: range = 2000;
+	}
+
+	i = random() % NR_TIMERS;
+	switch (random() % 10) {
+	case 0:
+	case 1:
+		clear(i);
+		break;
+	case 2:
+		set(i, clock_now - random() % 10);	/* due at once */
+		break;
+	case 3:
+		/* Leap, but keep the clock well below overflowing */
+		run(clock_now + random() % (range < 70000 ? range : 70000));
+		break;
+	case 4:
+		advance(clock_now + 1 + random() % 64);
+		break;
+	default:
+		set(i, clock_now + random() % range);
+	}
+
+	if (errct > 0) break;
+  }
+
+  /* Let everything run out */
+  for (i = 0; i < NR_TIMERS; i++)
+	ref[i].r_rearm = -1;
+  advance(clock_now + SPAN + 1);
+  if (ref_head != NULL) e(1);
+  if (tmrs_settimer(&queue, &timer[0], clock_now + 1, expired, NULL) != 0)
+	e(2);
+}
+
+int main(void)
+{
+  start(72);
+
+  test_levels();
+  test_current();
+  test_churn();
+
+  quit();
+  return(-1);			/* impossible */
+}
@@ -14,6 +14,7 @@
 
 #define MAX_ERROR	4
 #define ITERATIONS     60
+#define PIPE_SIZE_MAX	(1024 * 1024)	/* largest pipe capacity */
 
 #define Fstat(a,b)	if (fstat(a,b) != 0) printf("Can't fstat %d\n", a)
 #define Time(t)		if (time(t) == (time_t)-1) printf("Time error\n")
@@ -24,6 +25,7 @@ int subtest;
 
 void test8a(void);
 void test8b(void);
+void test8c(void);
 
 int main(int argc, char *argv[])
 {
@@ -34,6 +36,7 @@ int main(int argc, char *argv[])
   for (i = 0; i < ITERATIONS; i++) {
 	if (m & 0001) test8a();
 	if (m & 0002) test8b();
+	if (m & 0004) test8c();
   }
   quit();
   return(-1);	/* Unreachable */
@@ -226,3 +229,57 @@ void test8b()
   for (i = 3; i < OPEN_MAX; i++) (void) close(i);
 }
 
+void test8c()
+{				/* Test a full pipe of the largest size. */
+  int tube[2], size, chunk, n, i;
+  long in, out;
+  char buf[4096];
+
+  subtest = 3;
+
+  if (pipe(tube) != 0) e(1);
+  if ((size = fcntl(tube[1], F_SETPIPE_SZ, PIPE_SIZE_MAX)) < 0) e(2);
+  if (size != PIPE_SIZE_MAX) e(3);
+  if (fcntl(tube[0], F_GETPIPE_SZ) != size) e(4);
+  if (fcntl(tube[1], F_SETFL, O_NONBLOCK) != 0) e(5);
+
+  /* Move the head of the data into the middle of a page, then fill the
+   * pipe, so that the data wraps around to the page holding the head.
+   */
+  in = out = 0;
+  for (i = 0; i < 100; i++) buf[i] = (char) (in++ % 251);
+  if (write(tube[1], buf, 100) != 100) e(6);
+  if (read(tube[0], buf, 50) != 50) e(7);
+  out = 50;
+
+  chunk = sizeof(buf);
+  for (;;) {
+	for (i = 0; i < chunk; i++) buf[i] = (char) ((in + i) % 251);
+	if ((n = write(tube[1], buf, chunk)) < 0) {
+		if (errno != EAGAIN) e(8);
+		if (chunk == 1) break;
+		chunk = 1;	/* Fill up the last bit */
+		continue;
+	}
+	in += n;
+  }
+  if (in - out != size) e(9);
+
+  /* Read it all back, a little at a time, and check every byte. */
+  while (out < in) {
+	if ((n = read(tube[0], buf, 3000)) <= 0) {
+		e(10);
+		break;
+	}
+	for (i = 0; i < n; i++)
+		if (buf[i] != (char) ((out + i) % 251)) {
+			e(11);
+			break;
+		}
+	out += n;
+  }
+
+  if (close(tube[1]) != 0) e(12);
+  if (read(tube[0], buf, 1) != 0) e(13);
+  if (close(tube[0]) != 0) e(14);
+}